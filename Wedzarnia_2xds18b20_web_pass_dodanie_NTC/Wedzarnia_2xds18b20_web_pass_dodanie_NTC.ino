@@ -1,5 +1,6 @@
 // Wedzarnia_optimized_v3.3.ino - Uproszczona wersja testów
 #include "config.h"
+#include "hal.h"
 #include "state.h"
 #include "hardware.h"
 #include "storage.h"
@@ -7,11 +8,16 @@
 #include "tasks.h"
 #include "outputs.h"
 #include "ui.h"
+#include "bench.h"
+#include "boot_prof.h"
 #include <esp_task_wdt.h>
+#include <esp_heap_caps.h>
 
 void setup() {
+    // [NEW] Start rdzenia ESP-IDF do wejścia w setup()
+    boot_prof_stage("startup", 0);
+    uint32_t t = boot_prof_now();
     Serial.begin(115200);
-    delay(100);
     
     Serial.println("\n==========================================================");
     Serial.println("     WEDZARNIA ESP32 v3.4 (Simplified Tests)   ");
@@ -20,104 +26,58 @@ void setup() {
     
     log_msg(LOG_LEVEL_INFO, "Starting initialization sequence...");
     
-    // 1. Inicjalizacja NVS
-    nvs_init();
-    esp_task_wdt_reset();
+    // [NEW] Ścieżka krytyczna: tylko to, czego potrzebuje sterowanie.
+    // Ekran, SD, WiFi, WWW, GitHub i MQTT startują w tle (tasks_create_all)
+    
+    // 1. Piny GPIO – wyjścia w stanie niskim przed czymkolwiek innym
+    hardware_init_pins();
+    boot_prof_stage("serial+pins", t);
     
-    // 2. Inicjalizacja mutexow stanu
+    // 2. Inicjalizacja NVS, blokady karty SD i mutexow stanu
+    t = boot_prof_now();
+    nvs_init();
+    hal_fs_init();
     init_state();
     esp_task_wdt_reset();
+    boot_prof_stage("nvs+state", t);
     
-    // 3. Inicjalizacja pinow GPIO
-    hardware_init_pins();
-    esp_task_wdt_reset();
-
-    // 4. Inicjalizacja UI
+    // 3. UI w RAM (bufor ramki) i PWM/LEDC + SSR – wszystko wyłączone
+    t = boot_prof_now();
     ui_init();
-    esp_task_wdt_reset();
-   
-    // 5. Inicjalizacja PWM/LEDC
     hardware_init_ledc();
     esp_task_wdt_reset();
+    boot_prof_stage("outputs", t);
     
-    // 6. Inicjalizacja wyswietlacza
-    hardware_init_display();
+    // 4. Wczytaj konfiguracje z NVS
+    t = boot_prof_now();
+    storage_load_config_nvs();
     esp_task_wdt_reset();
+    boot_prof_stage("config", t);
     
-    // 7. Inicjalizacja czujnikow temperatury
+    // 5. Inicjalizacja czujnikow temperatury
+    t = boot_prof_now();
     hardware_init_sensors();
     esp_task_wdt_reset();
+    boot_prof_stage("sensors", t);
     
-    // 8. Inicjalizacja karty SD (z retry)
-    hardware_init_sd();
-    esp_task_wdt_reset();
-
-    // 9. Wczytaj konfiguracje z NVS
-    storage_load_config_nvs();
-    esp_task_wdt_reset();
-    
-    // 10. Identyfikacja i przypisanie czujnikow
-    log_msg(LOG_LEVEL_INFO, "Starting sensor identification...");
-    
-    // 11. Uruchom uproszczona diagnostyke startowa
+    // 6. Uproszczona diagnostyka startowa (bez blokującej konwersji)
+    t = boot_prof_now();
     runStartupSelfTest();
     esp_task_wdt_reset();
+    boot_prof_stage("self-test", t);
     
-    // 12. Inicjalizacja WiFi
-    hardware_init_wifi();
-    esp_task_wdt_reset();
-    
-    // Debug: Sprawdz czy WiFi dziala
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.printf("\nWiFi Connected! IP: %s\n", WiFi.localIP().toString().c_str());
-    } else {
-        Serial.println("\nWiFi in AP mode only");
-        Serial.printf("AP IP: %s\n", WiFi.softAPIP().toString().c_str());
+    // [NEW] Opcjonalne mikrobenchmarki – przed startem tasków, SSR wyłączone
+    if (CFG_BENCH_ON_BOOT) {
+        bench_run_serial();
+        esp_task_wdt_reset();
     }
-    
-    esp_task_wdt_reset();
-    
-    // 13. Inicjalizacja serwera WWW
-    web_server_init();
-    esp_task_wdt_reset();
-    
-    // Sygnal dzwiekowy - gotowe
-    buzzerBeep(2, 100, 100);
-    
-    // Wyswietl informacje o systemie na Serial
-    Serial.println("\n==========================================================");
-    Serial.println("     SYSTEM READY - DETAILED INFO              ");
-    Serial.println("==========================================================");
-    Serial.printf("Free heap: %d bytes\n", ESP.getFreeHeap());
-    Serial.printf("Min free heap: %d bytes\n", ESP.getMinFreeHeap());
-    Serial.printf("CPU freq: %d MHz\n", ESP.getCpuFreqMHz());
-    Serial.printf("SD Card: %s\n", SD.cardType() != CARD_NONE ? "OK" : "ERROR");
-    Serial.printf("Sensors found: %d\n", sensors.getDeviceCount());
-    Serial.printf("WiFi: %s\n", WiFi.status() == WL_CONNECTED ? "CONNECTED" : "AP MODE");
-    Serial.println("==========================================================\n");
-    
-    log_msg(LOG_LEVEL_INFO, "==========================================================");
-    log_msg(LOG_LEVEL_INFO, "     SETUP COMPLETE - STARTING TASKS           ");
-    log_msg(LOG_LEVEL_INFO, "==========================================================");
-    
-    // 14. Uruchom zadania FreeRTOS
+
+    // 7. Zadania FreeRTOS: sterowanie od razu, ekran/SD i sieć w tle
+    t = boot_prof_now();
     tasks_create_all();
+    boot_prof_stage("tasks", t);
     
-    // Wyswietl informacje o systemie w logach
-    log_msg(LOG_LEVEL_INFO, "[SYS] Free heap: " + String(ESP.getFreeHeap()) + " bytes");
-    log_msg(LOG_LEVEL_INFO, "[SYS] Min free heap: " + String(ESP.getMinFreeHeap()) + " bytes");
-    log_msg(LOG_LEVEL_INFO, "[SYS] CPU freq: " + String(ESP.getCpuFreqMHz()) + " MHz");
-    log_msg(LOG_LEVEL_INFO, "[SYS] SD Card: " + String(SD.cardType() != CARD_NONE ? "OK" : "ERROR"));
-    log_msg(LOG_LEVEL_INFO, "[SYS] Sensors: " + String(sensors.getDeviceCount()));
-    log_msg(LOG_LEVEL_INFO, "[SYS] WiFi: " + String(WiFi.status() == WL_CONNECTED ? "CONNECTED" : "AP MODE"));
-    log_msg(LOG_LEVEL_INFO, "\nSystem ready!\n");
-    
-    Serial.println("\nV System initialization complete!");
-    Serial.println("V ESP32 Wedzarnia Ready!");
-    Serial.println("\nGo to http://" + WiFi.softAPIP().toString() + " for web interface");
-    
-    // Finalny sygnal
-    buzzerBeep(3, 150, 100);
+    log_msg(LOG_LEVEL_INFO, "Control path ready - details in [BOOT] log and /api/boot");
 }
 
 void loop() {
@@ -132,12 +92,11 @@ void loop() {
     static unsigned long lastButtonDebug = 0;
     if (millis() - lastButtonDebug > 60000) {
         lastButtonDebug = millis();
-        log_msg(LOG_LEVEL_DEBUG, 
-            "Button States: UP=" + String(digitalRead(PIN_BTN_UP)) +
-            " DOWN=" + String(digitalRead(PIN_BTN_DOWN)) +
-            " ENTER=" + String(digitalRead(PIN_BTN_ENTER)) +
-            " EXIT=" + String(digitalRead(PIN_BTN_EXIT)) +
-            " DOOR=" + String(digitalRead(PIN_DOOR)));
+        // [FIX] LOG_FMT zamiast sklejania String co minutę (sterta)
+        LOG_FMT(LOG_LEVEL_DEBUG, "Button States: UP=%d DOWN=%d ENTER=%d EXIT=%d DOOR=%d",
+                digitalRead(PIN_BTN_UP), digitalRead(PIN_BTN_DOWN),
+                digitalRead(PIN_BTN_ENTER), digitalRead(PIN_BTN_EXIT),
+                digitalRead(PIN_DOOR));
     }
     
     // Pusta petla - wszystko dzieje sie w zadaniach RTOS
@@ -148,8 +107,14 @@ void loop() {
     loopCounter++;
     if (loopCounter % 10 == 0) {
         uint32_t freeHeap = ESP.getFreeHeap();
-        if (freeHeap < 20000) { // Zwiększony próg z 15KB do 20KB
-            log_msg(LOG_LEVEL_WARN, "Low heap memory: " + String(freeHeap) + " bytes");
+        if (freeHeap < HEAP_WARNING_THRESHOLD) { // Zwiększony próg z 15KB do 20KB
+            LOG_FMT(LOG_LEVEL_WARN, "Low heap memory: %u bytes", freeHeap);
+        }
+        // [NEW] Fragmentacja – wolnej pamięci dość, ale brak ciągłego bloku
+        uint32_t largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+        if (largestBlock < HEAP_LARGEST_BLOCK_WARNING) {
+            LOG_FMT(LOG_LEVEL_WARN, "Heap fragmented: largest block %u of %u bytes free",
+                    largestBlock, freeHeap);
         }
     }
 }
@@ -0,0 +1,431 @@
+// alloc_track.cpp - [NEW] Śledzenie alokacji sterty i fragmentacji
+// Host: przechwycenie malloc/free w programie (soak.cpp), tablica wskaźników
+// w pamięci z mmap – sama nie alokuje ze śledzonej sterty.
+// ESP32: heap_caps + opcjonalnie heap_trace (CONFIG_HEAP_TRACING_STANDALONE).
+#include "alloc_track.h"
+#include "config.h"
+
+#ifdef ARDUINO
+#include <esp_heap_caps.h>
+#if CONFIG_HEAP_TRACING_STANDALONE
+#include <esp_heap_trace.h>
+#endif
+#else
+#include <atomic>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#endif
+
+static constexpr int ALLOC_TRACK_MAX_SITES = 256;
+
+uint8_t alloc_track_fragmentation_pct(const HeapSnapshot& snap) {
+    if (snap.freeBytes == 0 || snap.largestFreeBlock >= snap.freeBytes) return 0;
+    return (uint8_t)(100 - (snap.largestFreeBlock * 100) / snap.freeBytes);
+}
+
+// Sortowanie przez wstawianie – max ALLOC_TRACK_MAX_SITES wpisów, bez alokacji
+static void sortSitesByLiveBytes(AllocSite* sites, int count) {
+    for (int i = 1; i < count; i++) {
+        AllocSite s = sites[i];
+        int j = i - 1;
+        while (j >= 0 && sites[j].liveBytes < s.liveBytes) {
+            sites[j + 1] = sites[j];
+            j--;
+        }
+        sites[j + 1] = s;
+    }
+}
+
+#ifdef ARDUINO
+// ======================================================
+// ESP32 – heap_caps / heap_trace
+// ======================================================
+
+static bool trackActive = false;
+static size_t peakLiveBytes = 0;
+
+#if CONFIG_HEAP_TRACING_STANDALONE
+// Rekordy muszą leżeć w wewnętrznym RAM; po zapełnieniu nowe alokacje nie są
+// rejestrowane (summary.has_overflowed)
+static constexpr size_t ALLOC_TRACE_RECORDS = 300;
+static heap_trace_record_t traceRecords[ALLOC_TRACE_RECORDS];
+static bool traceInitialized = false;
+#endif
+
+bool alloc_track_start() {
+#if CONFIG_HEAP_TRACING_STANDALONE
+    if (!traceInitialized) {
+        if (heap_trace_init_standalone(traceRecords, ALLOC_TRACE_RECORDS) != ESP_OK) {
+            log_msg(LOG_LEVEL_ERROR, "Heap trace init failed");
+            return false;
+        }
+        traceInitialized = true;
+    }
+    if (heap_trace_start(HEAP_TRACE_LEAKS) != ESP_OK) return false;
+#endif
+    peakLiveBytes = 0;
+    trackActive = true;
+    return true;
+}
+
+void alloc_track_stop() {
+#if CONFIG_HEAP_TRACING_STANDALONE
+    heap_trace_stop();
+#endif
+    trackActive = false;
+}
+
+bool alloc_track_active() {
+    return trackActive;
+}
+
+void alloc_track_snapshot(HeapSnapshot& out) {
+    out = {};
+    out.freeBytes        = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    out.minFreeBytes     = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    out.largestFreeBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+
+#if CONFIG_HEAP_TRACING_STANDALONE
+    if (!traceInitialized) return;
+    heap_trace_summary_t summary;
+    if (heap_trace_summary(&summary) == ESP_OK) {
+        out.allocCount = summary.total_allocations;
+        out.liveCount  = summary.count;
+    }
+    heap_trace_record_t rec;
+    for (size_t i = 0; i < out.liveCount; i++) {
+        if (heap_trace_get(i, &rec) == ESP_OK) out.liveBytes += rec.size;
+    }
+    // Szczyt próbkowany przy odczycie (heap_trace nie liczy szczytu bajtów)
+    if (out.liveBytes > peakLiveBytes) peakLiveBytes = out.liveBytes;
+    out.peakLiveBytes = peakLiveBytes;
+#endif
+}
+
+int alloc_track_top_sites(AllocSite* out, int maxSites) {
+#if CONFIG_HEAP_TRACING_STANDALONE
+    if (!traceInitialized || maxSites <= 0) return 0;
+    static AllocSite sites[ALLOC_TRACK_MAX_SITES];
+    int siteCount = 0;
+
+    heap_trace_record_t rec;
+    size_t count = heap_trace_get_count();
+    for (size_t i = 0; i < count; i++) {
+        if (heap_trace_get(i, &rec) != ESP_OK) continue;
+        uintptr_t pc = (uintptr_t)rec.alloced_by[0];
+        int idx = 0;
+        while (idx < siteCount && sites[idx].pc != pc) idx++;
+        if (idx == siteCount) {
+            if (siteCount >= ALLOC_TRACK_MAX_SITES) continue;
+            sites[siteCount++] = {pc, 0, 0, 0, 0};
+        }
+        sites[idx].allocCount++;
+        sites[idx].liveCount++;
+        sites[idx].liveBytes += rec.size;
+        sites[idx].peakLiveBytes = sites[idx].liveBytes;
+    }
+
+    sortSitesByLiveBytes(sites, siteCount);
+    int n = siteCount < maxSites ? siteCount : maxSites;
+    memcpy(out, sites, n * sizeof(AllocSite));
+    return n;
+#else
+    (void)out;
+    (void)maxSites;
+    return 0;
+#endif
+}
+
+void alloc_track_site_name(uintptr_t pc, char* out, size_t outSize) {
+    snprintf(out, outSize, "0x%08lx", (unsigned long)pc);
+}
+
+#else
+// ======================================================
+// HOST – przechwycenie malloc/free (glibc)
+// ======================================================
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void  __libc_free(void* p);
+}
+
+static constexpr size_t ALLOC_TABLE_SIZE = 1UL << 20;   // potęga 2, ~24 MB wirtualnie
+static constexpr size_t ALLOC_TABLE_LIMIT = ALLOC_TABLE_SIZE / 10 * 9;
+static constexpr int ALLOC_FRAME_CACHE_SIZE = 4096;
+static constexpr int ALLOC_BACKTRACE_DEPTH = 12;
+static constexpr uint16_t ALLOC_SITE_UNKNOWN = 0;
+
+struct AllocEntry {
+    uintptr_t ptr;             // 0 = wolne
+    uint32_t size;
+    uint16_t site;
+};
+
+struct FrameClass {
+    uintptr_t pc;
+    bool user;                 // false = biblioteka / std:: / String – szukaj dalej
+};
+
+static AllocEntry* allocTable = nullptr;
+static AllocSite sites[ALLOC_TRACK_MAX_SITES];      // [0] = nieznane miejsce
+static int siteCount = 1;
+static FrameClass frameCache[ALLOC_FRAME_CACHE_SIZE];
+static uintptr_t exeBase = 0;
+
+static std::atomic<bool> trackActive{false};
+static std::atomic_flag tableLock = ATOMIC_FLAG_INIT;
+static thread_local bool inTrack = false;
+
+static size_t liveBytes = 0;
+static size_t peakLiveBytes = 0;
+static uint32_t liveCount = 0;
+static uint32_t allocCount = 0;
+
+struct TableGuard {
+    TableGuard()  { while (tableLock.test_and_set(std::memory_order_acquire)) {} }
+    ~TableGuard() { tableLock.clear(std::memory_order_release); }
+};
+
+static inline size_t hashPtr(uintptr_t p) {
+    return (size_t)((p >> 4) * 0x9E3779B97F4A7C15ULL) & (ALLOC_TABLE_SIZE - 1);
+}
+
+// Ramki z biblioteki standardowej, zamiennika String i samego malloc nie są
+// miejscem wywołania – wynik dladdr zapamiętany na pc
+static bool isUserFrame(uintptr_t pc) {
+    FrameClass& fc = frameCache[(pc >> 2) & (ALLOC_FRAME_CACHE_SIZE - 1)];
+    if (fc.pc == pc) return fc.user;
+
+    static const char* const skipPrefixes[] = {
+        "_ZNSt", "_ZNKSt", "_ZSt", "_ZN9__gnu_cxx", "_Znw", "_Zna",
+        "_ZN6String", "_ZNK6String", "_ZplRK6String", "malloc", "calloc", "realloc"
+    };
+    Dl_info info;
+    bool user = false;
+    if (dladdr((void*)pc, &info) && (uintptr_t)info.dli_fbase == exeBase) {
+        user = true;
+        if (info.dli_sname) {
+            for (const char* prefix : skipPrefixes) {
+                if (strncmp(info.dli_sname, prefix, strlen(prefix)) == 0) { user = false; break; }
+            }
+        }
+    }
+    fc.pc = pc;
+    fc.user = user;
+    return user;
+}
+
+static uint16_t findSite(uintptr_t pc) {
+    for (int i = 1; i < siteCount; i++) {
+        if (sites[i].pc == pc) return (uint16_t)i;
+    }
+    if (siteCount >= ALLOC_TRACK_MAX_SITES) return ALLOC_SITE_UNKNOWN;
+    sites[siteCount] = {pc, 0, 0, 0, 0};
+    return (uint16_t)siteCount++;
+}
+
+// always_inline: ramka [0] backtrace to zawsze malloc/calloc/realloc
+__attribute__((always_inline))
+static inline uintptr_t captureSite() {
+    void* frames[ALLOC_BACKTRACE_DEPTH];
+    int depth = backtrace(frames, ALLOC_BACKTRACE_DEPTH);
+    for (int i = 1; i < depth; i++) {
+        uintptr_t pc = (uintptr_t)frames[i];
+        if (isUserFrame(pc)) return pc;
+    }
+    return 0;
+}
+
+static void recordAlloc(void* p, size_t size, uint16_t site) {
+    if (liveCount >= ALLOC_TABLE_LIMIT) return;
+    size_t i = hashPtr((uintptr_t)p);
+    while (allocTable[i].ptr) i = (i + 1) & (ALLOC_TABLE_SIZE - 1);
+    allocTable[i] = {(uintptr_t)p, (uint32_t)size, site};
+
+    allocCount++;
+    liveCount++;
+    liveBytes += size;
+    if (liveBytes > peakLiveBytes) peakLiveBytes = liveBytes;
+
+    AllocSite& s = sites[site];
+    s.allocCount++;
+    s.liveCount++;
+    s.liveBytes += size;
+    if (s.liveBytes > s.peakLiveBytes) s.peakLiveBytes = s.liveBytes;
+}
+
+// Usunięcie z przesunięciem wstecz (linear probing bez znaczników usunięcia –
+// tablica nie degraduje się przy milionach malloc/free w soak)
+static bool removeAlloc(uintptr_t p, AllocEntry* removed) {
+    size_t i = hashPtr(p);
+    while (allocTable[i].ptr != p) {
+        if (!allocTable[i].ptr) return false;
+        i = (i + 1) & (ALLOC_TABLE_SIZE - 1);
+    }
+    *removed = allocTable[i];
+
+    size_t hole = i;
+    for (size_t j = (i + 1) & (ALLOC_TABLE_SIZE - 1); allocTable[j].ptr;
+         j = (j + 1) & (ALLOC_TABLE_SIZE - 1)) {
+        size_t home = hashPtr(allocTable[j].ptr);
+        // Wpis j może wypełnić dziurę, jeśli jego pozycja domowa nie leży w (hole, j]
+        bool movable = (hole <= j) ? (home <= hole || home > j)
+                                   : (home <= hole && home > j);
+        if (movable) {
+            allocTable[hole] = allocTable[j];
+            hole = j;
+        }
+    }
+    allocTable[hole].ptr = 0;
+
+    liveCount--;
+    liveBytes -= removed->size;
+    AllocSite& s = sites[removed->site];
+    s.liveCount--;
+    s.liveBytes -= removed->size;
+    return true;
+}
+
+static inline void trackFree(void* p) {
+    if (!p || !allocTable || inTrack) return;
+    TableGuard guard;
+    if (liveCount == 0) return;
+    AllocEntry removed;
+    removeAlloc((uintptr_t)p, &removed);
+}
+
+static inline void trackAlloc(void* p, size_t size, uintptr_t pc) {
+    TableGuard guard;
+    recordAlloc(p, size, pc ? findSite(pc) : ALLOC_SITE_UNKNOWN);
+}
+
+extern "C" void* malloc(size_t size) {
+    if (!trackActive.load(std::memory_order_relaxed) || inTrack) return __libc_malloc(size);
+    inTrack = true;
+    void* p = __libc_malloc(size);
+    if (p) trackAlloc(p, size, captureSite());
+    inTrack = false;
+    return p;
+}
+
+extern "C" void* calloc(size_t n, size_t size) {
+    if (!trackActive.load(std::memory_order_relaxed) || inTrack) return __libc_calloc(n, size);
+    inTrack = true;
+    void* p = __libc_calloc(n, size);
+    if (p) trackAlloc(p, n * size, captureSite());
+    inTrack = false;
+    return p;
+}
+
+extern "C" void* realloc(void* old, size_t size) {
+    if (inTrack) return __libc_realloc(old, size);
+    trackFree(old);
+    if (!trackActive.load(std::memory_order_relaxed)) return __libc_realloc(old, size);
+    inTrack = true;
+    void* p = __libc_realloc(old, size);
+    // Błąd realloc zostawia stary blok – od tej chwili nieśledzony (rzadkie)
+    if (p) trackAlloc(p, size, captureSite());
+    inTrack = false;
+    return p;
+}
+
+extern "C" void free(void* p) {
+    trackFree(p);
+    __libc_free(p);
+}
+
+bool alloc_track_start() {
+    inTrack = true;
+    if (!allocTable) {
+        void* mem = mmap(nullptr, ALLOC_TABLE_SIZE * sizeof(AllocEntry),
+                         PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            inTrack = false;
+            return false;
+        }
+        allocTable = (AllocEntry*)mem;
+    }
+    // Pierwsze backtrace() ładuje libgcc_s (malloc) – przed włączeniem śledzenia
+    Dl_info info;
+    if (dladdr((void*)&alloc_track_start, &info)) exeBase = (uintptr_t)info.dli_fbase;
+    void* warm[2];
+    backtrace(warm, 2);
+    {
+        TableGuard guard;
+        peakLiveBytes = liveBytes;
+        for (int i = 0; i < siteCount; i++) sites[i].peakLiveBytes = sites[i].liveBytes;
+    }
+    trackActive = true;
+    inTrack = false;
+    return true;
+}
+
+void alloc_track_stop() {
+    trackActive = false;
+}
+
+bool alloc_track_active() {
+    return trackActive;
+}
+
+void alloc_track_snapshot(HeapSnapshot& out) {
+    out = {};
+    // Sterta hosta nie ma "największego bloku" – szczyt areny (keepcost) to
+    // ciągły wolny obszar, rosnący gdy nic nie blokuje jej końca
+    struct mallinfo2 mi = mallinfo2();
+    out.freeBytes        = mi.fordblks;
+    out.largestFreeBlock = mi.keepcost;
+
+    TableGuard guard;
+    out.liveBytes     = liveBytes;
+    out.peakLiveBytes = peakLiveBytes;
+    out.allocCount    = allocCount;
+    out.liveCount     = liveCount;
+}
+
+int alloc_track_top_sites(AllocSite* out, int maxSites) {
+    if (maxSites <= 0) return 0;
+    static AllocSite sorted[ALLOC_TRACK_MAX_SITES];
+    int count;
+    {
+        TableGuard guard;
+        count = siteCount;
+        memcpy(sorted, sites, count * sizeof(AllocSite));
+    }
+    sortSitesByLiveBytes(sorted, count);
+
+    int n = 0;
+    for (int i = 0; i < count && n < maxSites; i++) {
+        if (sorted[i].allocCount == 0) continue;
+        out[n++] = sorted[i];
+    }
+    return n;
+}
+
+void alloc_track_site_name(uintptr_t pc, char* out, size_t outSize) {
+    if (pc == 0) {
+        snprintf(out, outSize, "(unknown)");
+        return;
+    }
+    Dl_info info;
+    if (dladdr((void*)pc, &info) && info.dli_sname) {
+        // Bufor __cxa_demangle poza śledzeniem (inTrack)
+        inTrack = true;
+        int status = -1;
+        char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        snprintf(out, outSize, "%s+0x%lx", status == 0 ? demangled : info.dli_sname,
+                 (unsigned long)(pc - (uintptr_t)info.dli_saddr));
+        free(demangled);
+        inTrack = false;
+    } else {
+        snprintf(out, outSize, "exe+0x%lx", (unsigned long)(pc - exeBase));
+    }
+}
+
+#endif // ARDUINO
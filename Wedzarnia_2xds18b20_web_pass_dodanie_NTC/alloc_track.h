@@ -0,0 +1,45 @@
+// alloc_track.h - [NEW] Śledzenie alokacji sterty i fragmentacji
+// Przypisuje żywe/szczytowe bajty i liczbę alokacji do miejsc wywołania.
+// – host:  własne malloc/free/calloc/realloc (glibc __libc_*), miejsce =
+//          pierwsza ramka backtrace w programie poza std:: (budowa z -rdynamic
+//          daje nazwy funkcji, bez niej adres do addr2line)
+// – ESP32: heap_caps_* (wolne, największy blok, minimum); miejsca wywołań
+//          tylko gdy sdkconfig ma CONFIG_HEAP_TRACING_STANDALONE
+//          (adresy do xtensa-esp32-elf-addr2line)
+// Używane przez soak.cpp (długie wsady) i taskMonitor (trend największego bloku).
+#pragma once
+#include "hal.h"
+
+struct HeapSnapshot {
+    size_t freeBytes;          // wolna sterta (host: wolne w arenie malloc)
+    size_t minFreeBytes;       // minimum od startu (host: 0 – brak)
+    size_t largestFreeBlock;   // największy ciągły blok (host: szczyt areny, przybliżenie)
+    size_t liveBytes;          // żywe bajty śledzonych alokacji
+    size_t peakLiveBytes;      // szczyt liveBytes od alloc_track_start()
+    uint32_t allocCount;       // alokacje od alloc_track_start()
+    uint32_t liveCount;        // żywe bloki
+};
+
+struct AllocSite {
+    uintptr_t pc;              // adres miejsca wywołania
+    uint32_t allocCount;
+    uint32_t liveCount;
+    size_t liveBytes;
+    size_t peakLiveBytes;
+};
+
+// Start/stop rejestracji (stop zostawia zebrane dane do odczytu)
+bool alloc_track_start();
+void alloc_track_stop();
+bool alloc_track_active();
+
+void alloc_track_snapshot(HeapSnapshot& out);
+
+// Miejsca posortowane malejąco po liveBytes; zwraca liczbę wpisów w out
+int alloc_track_top_sites(AllocSite* out, int maxSites);
+
+// Nazwa miejsca: "funkcja+0x1c" albo "0x400d1234"
+void alloc_track_site_name(uintptr_t pc, char* out, size_t outSize);
+
+// Fragmentacja w % = 100 - największy blok / wolne
+uint8_t alloc_track_fragmentation_pct(const HeapSnapshot& snap);
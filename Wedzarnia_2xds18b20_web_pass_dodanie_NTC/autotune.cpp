@@ -0,0 +1,244 @@
+// autotune.cpp - [NEW] Autotune PID metodą przekaźnikową (opis w autotune.h)
+#include "autotune.h"
+#include "config.h"
+#include "state.h"
+#include "outputs.h"
+#include "gain_sched.h"
+
+static constexpr double AUTOTUNE_OUTPUT_MAX = 100.0;       // % – zakres wyjścia PID
+static constexpr double AUTOTUNE_MIN_AMPLITUDE = 1.05;     // x histereza – mniej = szum
+
+static const char* phaseName(AutotunePhase p) {
+    switch (p) {
+        case AutotunePhase::HEATING: return "heating";
+        case AutotunePhase::RELAY:   return "relay";
+        case AutotunePhase::DONE:    return "done";
+        case AutotunePhase::FAILED:  return "failed";
+        default:                     return "none";
+    }
+}
+
+static bool withinTolerance(double a, double b, double tol) {
+    return a > 0 && b > 0 && fabs(a - b) <= tol * max(a, b);
+}
+
+static GainSet gainsFromUltimate(double ku, double tuSec, AutotuneRule rule) {
+    double kp, ti, td;
+    if (rule == AutotuneRule::ZIEGLER_NICHOLS) {
+        kp = 0.6 * ku;
+        ti = tuSec / 2.0;
+        td = tuSec / 8.0;
+    } else {
+        kp = ku / 2.2;
+        ti = 2.2 * tuSec;
+        td = tuSec / 6.3;
+    }
+    GainSet g;
+    g.kp = kp;
+    g.ki = kp / ti;
+    g.kd = kp * td;
+    return g;
+}
+
+// Wyjścia OFF, IDLE, sygnał; wynik zostaje w c.autotune dla WWW/TFT
+static void finish(Chamber& c, bool ok, const char* message) {
+    if (state_lock()) {
+        if (c.currentState == ProcessState::AUTOTUNE) c.currentState = ProcessState::IDLE;
+        c.autotune.phase = ok ? AutotunePhase::DONE : AutotunePhase::FAILED;
+        c.autotune.message = message;
+        c.autotune.endMs = millis();
+        state_unlock();
+    }
+    c.pidOutput = 0;
+    chamberOutputsOff(c);
+    if (ok) {
+        buzzerBeep(2, 300, 150);
+    } else {
+        buzzerBeep(3, 200, 200);
+        LOG_FMT(LOG_LEVEL_WARN, "Autotune K%u failed: %s", (unsigned)c.id, message);
+    }
+}
+
+// Koniec pełnego cyklu (przełączenie na ON): Ku, Tu, korekta bias.
+// true = wynik zbieżny (lub ostatni dopuszczalny cykl), r.ku/r.tuSec = średnia
+static bool closeCycle(AutotuneRun& r, unsigned long now, bool& failed) {
+    unsigned long highMs = r.fallMs - r.riseMs;
+    unsigned long lowMs = now - r.fallMs;
+    unsigned long periodMs = now - r.riseMs;
+    double amplitude = (r.tMax - r.tMin) / 2.0;
+
+    // Cykl zbyt krótki lub płaski (drgania odczytu na progu) – nie liczy się
+    if (periodMs < CFG_AUTOTUNE_PERIOD_MIN_MS ||
+        amplitude < CFG_AUTOTUNE_HYST_C * AUTOTUNE_MIN_AMPLITUDE) {
+        return false;
+    }
+
+    double ku = 4.0 * r.d / (M_PI * sqrt(amplitude * amplitude -
+                                          CFG_AUTOTUNE_HYST_C * CFG_AUTOTUNE_HYST_C));
+    double tuSec = periodMs / 1000.0;
+    r.cycles++;
+    r.amplitude = amplitude;
+    r.prevKu = r.ku;
+    r.prevTuSec = r.tuSec;
+    r.ku = ku;
+    r.tuSec = tuSec;
+
+    LOG_FMT(LOG_LEVEL_INFO, "Autotune cycle %u: a=%.2f C Tu=%.0f s Ku=%.2f bias=%.0f d=%.0f",
+            (unsigned)r.cycles, amplitude, tuSec, ku, r.bias, r.d);
+
+    // Równe czasy ON/OFF = przekaźnik symetryczny względem mocy utrzymania
+    r.bias += r.d * ((double)highMs - (double)lowMs) / (double)(highMs + lowMs);
+    r.bias = constrain(r.bias, CFG_AUTOTUNE_BIAS_MIN, CFG_AUTOTUNE_BIAS_MAX);
+    r.d = min(r.bias, AUTOTUNE_OUTPUT_MAX - r.bias);
+
+    if (r.cycles < CFG_AUTOTUNE_MIN_CYCLES) return false;
+
+    bool converged = withinTolerance(r.ku, r.prevKu, CFG_AUTOTUNE_TOLERANCE) &&
+                     withinTolerance(r.tuSec, r.prevTuSec, CFG_AUTOTUNE_TOLERANCE);
+    if (!converged && r.cycles >= CFG_AUTOTUNE_MAX_CYCLES) {
+        // Ostatnia szansa: luźniejsza zgodność, inaczej brak wyniku
+        converged = withinTolerance(r.ku, r.prevKu, 2 * CFG_AUTOTUNE_TOLERANCE) &&
+                    withinTolerance(r.tuSec, r.prevTuSec, 2 * CFG_AUTOTUNE_TOLERANCE);
+        failed = !converged;
+    }
+    if (converged) {
+        r.ku = (r.ku + r.prevKu) / 2.0;
+        r.tuSec = (r.tuSec + r.prevTuSec) / 2.0;
+    }
+    return converged;
+}
+
+bool autotune_start(uint8_t chamberIdx, double setpoint, int powerMode, AutotuneRule rule) {
+    Chamber& c = chamber_get(chamberIdx);
+    if (!state_lock()) return false;
+    if (c.currentState != ProcessState::IDLE || autotune_active(c.autotune.phase)) {
+        state_unlock();
+        log_msg(LOG_LEVEL_WARN, "Autotune: chamber busy");
+        return false;
+    }
+
+    AutotuneRun r;
+    r.rule = rule;
+    r.setpoint = constrain(setpoint, CFG_T_MIN_SET, CFG_T_MAX_SET);
+    r.powerMode = constrain(powerMode, CFG_POWERMODE_MIN, CFG_POWERMODE_MAX);
+    r.phase = AutotunePhase::HEATING;
+    r.startMs = millis();
+    // Start powyżej setpointu: najpierw stygnięcie, cykl od pierwszego ON
+    r.outputHigh = c.tChamber < r.setpoint;
+    r.tMax = r.tMin = c.tChamber;
+    c.autotune = r;
+
+    c.tSet = r.setpoint;
+    c.powerMode = r.powerMode;
+    c.fanMode = 1;              // obieg ciągły – jednorodna komora
+    c.manualSmokePwm = 0;
+    c.currentState = ProcessState::AUTOTUNE;
+    state_unlock();
+
+    initHeaterEnable(c);
+    LOG_FMT(LOG_LEVEL_INFO, "Autotune K%u started: %.1f C, pm=%d, %s",
+            (unsigned)c.id, r.setpoint, r.powerMode,
+            rule == AutotuneRule::ZIEGLER_NICHOLS ? "Ziegler-Nichols" : "Tyreus-Luyben");
+    return true;
+}
+
+void autotune_process(Chamber& c, unsigned long now) {
+    // [FIX] Praca na kopii – WWW/TFT czytają c.autotune pod lockiem
+    if (!state_lock()) return;
+    AutotuneRun r = c.autotune;
+    double temp = c.tChamber;
+    bool door = c.doorOpen;
+    bool sensorError = c.errorSensor;
+    state_unlock();
+
+    if (!autotune_active(r.phase)) return;
+
+    const char* abortReason = nullptr;
+    if (door) abortReason = "drzwi otwarte";
+    else if (sensorError) abortReason = "blad czujnika";
+    else if (temp > r.setpoint + CFG_AUTOTUNE_MAX_OVERSHOOT_C) abortReason = "przegrzanie";
+    else if (now - r.startMs > CFG_AUTOTUNE_TIMEOUT_MS) abortReason = "limit czasu";
+    if (abortReason) {
+        finish(c, false, abortReason);
+        return;
+    }
+
+    bool done = false;
+    bool failed = false;
+    if (r.outputHigh && temp > r.setpoint + CFG_AUTOTUNE_HYST_C) {
+        r.outputHigh = false;
+        r.fallMs = now;
+    } else if (!r.outputHigh && temp < r.setpoint - CFG_AUTOTUNE_HYST_C) {
+        r.outputHigh = true;
+        if (r.phase == AutotunePhase::RELAY) {
+            done = closeCycle(r, now, failed);
+        } else {
+            r.phase = AutotunePhase::RELAY;
+        }
+        // Okno cyklu: ON → OFF → ON, zawiera jedno minimum i jedno maksimum
+        r.riseMs = now;
+        r.tMax = r.tMin = temp;
+    }
+    if (temp > r.tMax) r.tMax = temp;
+    if (temp < r.tMin) r.tMin = temp;
+
+    if (state_lock()) {
+        c.autotune = r;
+        state_unlock();
+    }
+
+    if (failed) {
+        finish(c, false, "brak stabilnych oscylacji");
+        return;
+    }
+    if (done) {
+        GainSet g = gainsFromUltimate(r.ku, r.tuSec, r.rule);
+        gain_table_seed(c.id, r.setpoint, r.powerMode, g);
+        if (state_lock()) {
+            c.autotune.ku = r.ku;
+            c.autotune.tuSec = r.tuSec;
+            c.autotune.kp = g.kp;
+            c.autotune.ki = g.ki;
+            c.autotune.kd = g.kd;
+            state_unlock();
+        }
+        LOG_FMT(LOG_LEVEL_INFO, "Autotune K%u done: Ku=%.2f Tu=%.0f s -> Kp=%.2f Ki=%.4f Kd=%.1f",
+                (unsigned)c.id, r.ku, r.tuSec, g.kp, g.ki, g.kd);
+        finish(c, true, "OK");
+        return;
+    }
+
+    c.pidOutput = r.outputHigh ? r.bias + r.d : r.bias - r.d;
+}
+
+void autotune_abandon(Chamber& c) {
+    finish(c, false, "przerwany");
+}
+
+String autotune_status_json(uint8_t chamberIdx) {
+    const Chamber& c = chamber_get(chamberIdx);
+    if (!state_lock()) return String("{}");
+    AutotuneRun r = c.autotune;
+    state_unlock();
+
+    unsigned long elapsedSec = 0;
+    if (r.phase != AutotunePhase::NONE) {
+        elapsedSec = ((autotune_active(r.phase) ? millis() : r.endMs) - r.startMs) / 1000;
+    }
+
+    char json[512];
+    snprintf(json, sizeof(json),
+        "{\"chamber\":%u,\"phase\":\"%s\",\"message\":\"%s\","
+        "\"rule\":\"%s\",\"setpoint\":%.1f,\"pm\":%d,\"elapsedSec\":%lu,"
+        "\"cycle\":%u,\"minCycles\":%u,\"maxCycles\":%u,"
+        "\"output\":%.0f,\"bias\":%.1f,\"d\":%.1f,"
+        "\"amplitude\":%.2f,\"ku\":%.3f,\"tu\":%.0f,"
+        "\"kp\":%.3f,\"ki\":%.5f,\"kd\":%.2f}",
+        (unsigned)c.id, phaseName(r.phase), r.message,
+        r.rule == AutotuneRule::ZIEGLER_NICHOLS ? "zn" : "tl",
+        r.setpoint, r.powerMode, elapsedSec,
+        (unsigned)r.cycles, (unsigned)CFG_AUTOTUNE_MIN_CYCLES, (unsigned)CFG_AUTOTUNE_MAX_CYCLES,
+        autotune_active(r.phase) ? (r.outputHigh ? r.bias + r.d : r.bias - r.d) : 0.0,
+        r.bias, r.d, r.amplitude, r.ku, r.tuSec, r.kp, r.ki, r.kd);
+    return String(json);
+}
@@ -0,0 +1,39 @@
+// autotune.h - [NEW] Autotune PID metodą przekaźnikową (Åström–Hägglund)
+// Stan ProcessState::AUTOTUNE: zamiast PID wyjście przełączane między
+// bias+d i bias-d wokół wybranego setpointu (histereza CFG_AUTOTUNE_HYST_C),
+// na grzałkach trybu mocy jak w procesie. Komora wpada w oscylacje:
+//   Ku = 4d / (pi * sqrt(a^2 - hyst^2)),  Tu = okres cyklu
+// bias przesuwany co cykl tak, by czasy ON i OFF były równe (obiekt
+// grzejny jest niesymetryczny – sam przekaźnik 0/100% dałby zawyżone Ku).
+//
+// Koniec, gdy dwa ostatnie cykle (min. CFG_AUTOTUNE_MIN_CYCLES) zgadzają się
+// co do Ku i Tu w CFG_AUTOTUNE_TOLERANCE. Nastawy:
+//   Tyreus–Luyben (domyślnie): Kp = Ku/2.2, Ti = 2.2 Tu, Td = Tu/6.3
+//   Ziegler–Nichols:           Kp = 0.6 Ku, Ti = Tu/2,  Td = Tu/8
+// Wynik trafia do tablicy nastaw (gain_table_seed – granice tablicy, NVS).
+//
+// Przerwanie (wyjścia OFF, IDLE): drzwi, błąd czujnika, temperatura ponad
+// setpoint + CFG_AUTOTUNE_MAX_OVERSHOOT_C, CFG_AUTOTUNE_TIMEOUT_MS, stop
+// z WWW/TFT/MQTT albo pauza przegrzania z sensors.cpp.
+//
+// Test na hoście: replay --plant ze zdarzeniem "autotune,setpoint,tryb".
+#pragma once
+#include "chamber.h"
+#include "hal.h"
+
+inline bool autotune_active(AutotunePhase p) {
+    return p == AutotunePhase::HEATING || p == AutotunePhase::RELAY;
+}
+
+// Start z IDLE; false = proces w toku lub poprzedni autotune niezamknięty
+bool autotune_start(uint8_t chamberIdx, double setpoint, int powerMode,
+                    AutotuneRule rule = AutotuneRule::TYREUS_LUYBEN);
+
+// Co takt w stanie AUTOTUNE (chamber_run_control_logic) – ustawia pidOutput
+void autotune_process(Chamber& c, unsigned long now);
+
+// Stan procesu zmieniony z zewnątrz (stop, pauza) – zamknięcie eksperymentu
+void autotune_abandon(Chamber& c);
+
+// Postęp i wynik dla /api/autotune
+String autotune_status_json(uint8_t chamberIdx);
@@ -0,0 +1,598 @@
+// bench.cpp - [NEW] Mikrobenchmarki gorących ścieżek
+// Przypadki: parseProfileLine, storage_get_profile_as_json, mapPowerToHeaters,
+// adaptPidParameters, updateProcessStats (co 100 ms w taskControl),
+// getStatusJSON (web_status.cpp), na ESP32 dodatkowo getSysInfoJSON (WiFi/SD/ESP),
+// na hoście pełny krok pętli sterowania dla 1/2/4 komór (skalowanie liniowe).
+//
+// Liczba iteracji jak w Google Benchmark: partia rośnie, aż trwa co najmniej
+// BENCH_MIN_TIME_NS; wynik = najlepsza z BENCH_REPETITIONS partii / iteracje.
+//
+// Host (CMakeLists.txt, cel bench):
+//   ./bench [--filter nazwa] [--baseline bench_baseline.csv] [--save plik.csv]
+//           [--threshold 15] [--scaling 30]
+// Kod wyjścia 1, gdy ns/op wzrósł o więcej niż threshold % (także po
+// BENCH_CONFIRM_RUNS ponownych pomiarach), wzrosła liczba alokacji/op albo
+// przypadek nie ma wiersza w bazie. ns/op porównuj tylko z bazą z tej samej
+// maszyny (--threshold 0 = tylko alokacje); alokacje/op są deterministyczne.
+// Także kod 1, gdy koszt control_tick na komorę (2 i 4 komory) odbiega od
+// 1 komory o więcej niż --scaling %.
+#include "bench.h"
+#include "config.h"
+#include "state.h"
+#include "process.h"
+#include "outputs.h"
+#include "storage.h"
+#include "web_server.h"
+#ifdef ARDUINO
+#include <esp_task_wdt.h>
+#else
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#endif
+
+#ifdef ARDUINO
+static constexpr uint32_t BENCH_MIN_TIME_NS = 20UL * 1000UL * 1000UL;    // 20 ms – WDT
+#else
+static constexpr uint32_t BENCH_MIN_TIME_NS = 200UL * 1000UL * 1000UL;   // 200 ms
+#endif
+
+static constexpr int BENCH_REPETITIONS = 3;
+
+static constexpr const char* BENCH_PROFILE_NAME = "_bench.prof";
+static constexpr const char* BENCH_PROFILE_PATH = "/profiles/_bench.prof";
+
+// Typowy profil – 10 kroków (MAX_STEPS), pełne pola jak w plikach .prof
+static const char* const BENCH_PROFILE_LINES[] = {
+    "Osuszanie;55;0;60;2;0;1;10;60;0",
+    "Podgrzew;60;0;30;2;0;2;10;60;0",
+    "Wedzenie 1;65;0;90;2;180;2;15;45;0",
+    "Wedzenie 2;70;0;90;3;200;2;15;45;0",
+    "Wedzenie 3;72;0;60;3;220;2;20;40;0",
+    "Parzenie;78;68;45;3;0;1;10;60;1",
+    "Dojrzewanie;80;70;30;3;0;1;10;60;1",
+    "Stabilizacja;75;0;20;2;0;2;10;90;0",
+    "Chlodzenie;50;0;20;1;0;1;30;30;0",
+    "Koniec;40;0;10;1;0;0;10;60;0"
+};
+static constexpr int BENCH_PROFILE_LINE_COUNT =
+    sizeof(BENCH_PROFILE_LINES) / sizeof(BENCH_PROFILE_LINES[0]);
+
+// Zapobiega wyrzuceniu wyników przez optymalizator
+static volatile uint32_t benchSink = 0;
+
+// ======================================================
+// POMIAR CZASU I ALOKACJI
+// ======================================================
+
+#ifdef ARDUINO
+static inline uint32_t benchTicks() { return ESP.getCycleCount(); }
+// Licznik 32-bit – przepełnienie co ~18 s przy 240 MHz, partia trwa ~30 ms
+static inline uint64_t benchElapsed(uint32_t t0) { return (uint32_t)(benchTicks() - t0); }
+static inline double benchTicksToNs(uint64_t ticks) {
+    return (double)ticks * 1000.0 / ESP.getCpuFreqMHz();
+}
+static inline uint32_t benchAllocCount() { return 0; }
+#else
+static std::atomic<uint32_t> benchAllocs{0};
+
+static inline uint64_t benchTicks() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+static inline uint64_t benchElapsed(uint64_t t0) { return benchTicks() - t0; }
+static inline double benchTicksToNs(uint64_t ticks) { return (double)ticks; }
+static inline uint32_t benchAllocCount() { return benchAllocs.load(std::memory_order_relaxed); }
+#endif
+
+// ======================================================
+// STAN PROCESU – kopia przed i przywrócenie po benchmarku
+// ======================================================
+
+struct BenchStateBackup {
+    Step profile[MAX_STEPS];
+    int stepCount;
+    int currentStep;
+    ProcessState state;
+    unsigned long stepStartTime;
+    unsigned long processStartTime;
+    ProcessStats stats;
+    int powerMode;
+    double pidIn, pidOut, pidSet;
+};
+
+static BenchStateBackup benchBackup;
+static bool benchFileReady = false;
+
+static bool benchSetup() {
+    if (!state_lock()) return false;
+    memcpy(benchBackup.profile, g_profile, sizeof(g_profile));
+    benchBackup.stepCount        = g_stepCount;
+    benchBackup.currentStep      = g_currentStep;
+    benchBackup.state            = g_currentState;
+    benchBackup.stepStartTime    = g_stepStartTime;
+    benchBackup.processStartTime = g_processStartTime;
+    benchBackup.stats            = g_processStats;
+    benchBackup.powerMode        = g_powerMode;
+    benchBackup.pidIn  = pidInput;
+    benchBackup.pidOut = pidOutput;
+    benchBackup.pidSet = pidSetpoint;
+
+    // Najgorszy przypadek dla updateProcessStats: AUTO w połowie 10 kroków
+    int steps = 0;
+    for (int i = 0; i < BENCH_PROFILE_LINE_COUNT && steps < MAX_STEPS; i++) {
+        char line[128];
+        strncpy(line, BENCH_PROFILE_LINES[i], sizeof(line) - 1);
+        line[sizeof(line) - 1] = '\0';
+        if (parseProfileLine(line, g_profile[steps])) steps++;
+    }
+    g_stepCount        = steps;
+    g_currentStep      = steps / 2;
+    g_currentState     = ProcessState::RUNNING_AUTO;
+    g_powerMode        = 3;
+    g_stepStartTime    = millis();
+    g_processStartTime = millis();
+    state_unlock();
+
+    // Plik profilu dla storage_get_profile_as_json
+    benchFileReady = false;
+    if (!hal_fs_exists("/profiles")) hal_fs_mkdir("/profiles");
+    hal_file_t f = hal_fs_open(BENCH_PROFILE_PATH, HalFileMode::WRITE);
+    if (f >= 0) {
+        for (int i = 0; i < BENCH_PROFILE_LINE_COUNT; i++) {
+            hal_fs_write(f, BENCH_PROFILE_LINES[i], strlen(BENCH_PROFILE_LINES[i]));
+            hal_fs_write(f, "\n", 1);
+        }
+        hal_fs_close(f);
+        benchFileReady = true;
+    }
+    return true;
+}
+
+static void benchTeardown() {
+    if (benchFileReady) hal_fs_remove(BENCH_PROFILE_PATH);
+
+    if (state_lock()) {
+        memcpy(g_profile, benchBackup.profile, sizeof(g_profile));
+        g_stepCount        = benchBackup.stepCount;
+        g_currentStep      = benchBackup.currentStep;
+        g_currentState     = benchBackup.state;
+        g_stepStartTime    = benchBackup.stepStartTime;
+        g_processStartTime = benchBackup.processStartTime;
+        g_processStats     = benchBackup.stats;
+        g_powerMode        = benchBackup.powerMode;
+        pidInput    = benchBackup.pidIn;
+        pidOutput   = benchBackup.pidOut;
+        pidSetpoint = benchBackup.pidSet;
+        state_unlock();
+    }
+    resetAdaptivePid();
+    allOutputsOff();
+}
+
+// ======================================================
+// PRZYPADKI
+// ======================================================
+
+static void benchParseProfileLine(uint32_t iters) {
+    Step step;
+    char line[128];
+    for (uint32_t i = 0; i < iters; i++) {
+        strcpy(line, BENCH_PROFILE_LINES[i % BENCH_PROFILE_LINE_COUNT]);
+        benchSink += parseProfileLine(line, step);
+    }
+}
+
+static void benchProfileAsJson(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        String json = storage_get_profile_as_json(BENCH_PROFILE_NAME);
+        benchSink += json.length();
+    }
+}
+
+static void benchMapPowerToHeaters(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+#ifdef ARDUINO
+        // Na sprzęcie SSR zostają wyłączone – ta sama ścieżka z mocą 0
+        pidOutput = 0;
+#else
+        pidOutput = (double)((i * 7) % 101);
+#endif
+        mapPowerToHeaters(g_chambers[0]);
+    }
+}
+
+static void benchAdaptPidParameters(uint32_t iters) {
+    static unsigned long now = 0;
+    pidSetpoint = 70.0;
+    for (uint32_t i = 0; i < iters; i++) {
+        pidInput = 70.0 + (double)(i % 5) * 0.3;
+        now += PID_ADAPTATION_INTERVAL;     // każde wywołanie liczy adaptację
+        adaptPidParameters(g_chambers[0], now);
+    }
+}
+
+static void benchUpdateProcessStats(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        updateProcessStats(g_chambers[0]);
+    }
+}
+
+#ifndef ARDUINO
+// [NEW] chamber_run_control_logic dla N komór w MANUAL – ns/op ma rosnąć
+// liniowo z N (komory bez wspólnego stanu poza mutexami)
+static Chamber benchChambers[4];
+
+static void benchControlTick(uint32_t iters, uint8_t n) {
+    for (uint8_t k = 0; k < n; k++) {
+        Chamber& c = benchChambers[k];
+        if (c.currentState != ProcessState::RUNNING_MANUAL) {
+            chamber_init(c, 0, &CFG_CHAMBER_HW[0]);
+            c.currentState = ProcessState::RUNNING_MANUAL;
+            c.lastSeenState = ProcessState::RUNNING_MANUAL;
+            c.processStartTime = millis();
+            initHeaterEnable(c);
+        }
+    }
+    for (uint32_t i = 0; i < iters; i++) {
+        for (uint8_t k = 0; k < n; k++) {
+            benchChambers[k].tChamber = 60.0 + (double)((i + k) % 20);
+            chamber_run_control_logic(benchChambers[k]);
+        }
+    }
+}
+
+static void benchControlTick1(uint32_t iters) { benchControlTick(iters, 1); }
+static void benchControlTick2(uint32_t iters) { benchControlTick(iters, 2); }
+static void benchControlTick4(uint32_t iters) { benchControlTick(iters, 4); }
+#endif
+
+static void benchStatusJson(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        benchSink += strlen(getStatusJSON());
+    }
+}
+
+#ifdef ARDUINO
+static void benchSysInfoJson(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        benchSink += strlen(getSysInfoJSON());
+    }
+}
+#endif
+
+struct BenchCase {
+    const char* name;
+    void (*fn)(uint32_t iters);
+    bool needsFile;
+};
+
+static const BenchCase benchCases[] = {
+    {"parse_profile_line",    benchParseProfileLine,   false},
+    {"profile_as_json",       benchProfileAsJson,      true},
+    {"status_json",           benchStatusJson,         false},
+#ifdef ARDUINO
+    {"sysinfo_json",          benchSysInfoJson,        false},
+#endif
+    {"map_power_to_heaters",  benchMapPowerToHeaters,  false},
+    {"adapt_pid_parameters",  benchAdaptPidParameters, false},
+    {"update_process_stats",  benchUpdateProcessStats, false},
+#ifndef ARDUINO
+    {"control_tick_1ch",      benchControlTick1,       false},
+    {"control_tick_2ch",      benchControlTick2,       false},
+    {"control_tick_4ch",      benchControlTick4,       false},
+#endif
+};
+
+// ======================================================
+// RUNNER
+// ======================================================
+
+static BenchResult runCase(const BenchCase& c) {
+    BenchResult r = {};
+    r.name = c.name;
+
+    // Dobór liczby iteracji
+    uint32_t iters = 1;
+    for (;;) {
+        auto t0 = benchTicks();
+        c.fn(iters);
+        double ns = benchTicksToNs(benchElapsed(t0));
+        if (ns >= BENCH_MIN_TIME_NS || iters >= (1UL << 28)) break;
+
+        // Następna partia celuje w 1.4x czasu minimalnego (max x10)
+        double mult = (ns > 0) ? (BENCH_MIN_TIME_NS * 1.4 / ns) : 10.0;
+        if (mult > 10.0) mult = 10.0;
+        if (mult < 2.0)  mult = 2.0;
+        iters = (uint32_t)(iters * mult);
+#ifdef ARDUINO
+        esp_task_wdt_reset();
+#endif
+    }
+
+    // Powtórzenia – najlepsza partia (szum schedulera/przerwań tylko dodaje czas)
+    uint64_t bestTicks = UINT64_MAX;
+    uint32_t allocs = 0;
+    for (int rep = 0; rep < BENCH_REPETITIONS; rep++) {
+        uint32_t allocs0 = benchAllocCount();
+        auto t0 = benchTicks();
+        c.fn(iters);
+        uint64_t ticks = benchElapsed(t0);
+        allocs = benchAllocCount() - allocs0;
+        if (ticks < bestTicks) bestTicks = ticks;
+#ifdef ARDUINO
+        esp_task_wdt_reset();
+#endif
+    }
+
+    r.iterations = iters;
+    r.nsPerOp    = benchTicksToNs(bestTicks) / iters;
+#ifdef ARDUINO
+    r.cyclesPerOp = (double)bestTicks / iters;
+    r.allocsPerOp = -1;
+    (void)allocs;
+#else
+    r.cyclesPerOp = 0;
+    r.allocsPerOp = (double)allocs / iters;
+#endif
+    return r;
+}
+
+int bench_run(const char* filter, bench_report_fn report, void* ctx) {
+    if (!benchSetup()) {
+        log_msg(LOG_LEVEL_ERROR, "Bench: state_lock failed");
+        return 0;
+    }
+
+    int count = 0;
+    for (const BenchCase& c : benchCases) {
+        if (filter && !strstr(c.name, filter)) continue;
+        if (c.needsFile && !benchFileReady) {
+            LOG_FMT(LOG_LEVEL_WARN, "Bench %s skipped: no SD", c.name);
+            continue;
+        }
+        report(runCase(c), ctx);
+        count++;
+    }
+
+    benchTeardown();
+    return count;
+}
+
+// ======================================================
+// ESP32 – wynik na Serial
+// ======================================================
+#ifdef ARDUINO
+
+static void reportSerial(const BenchResult& r, void*) {
+    Serial.printf("%-24s %12.1f %12.1f %10lu\n",
+                  r.name, r.cyclesPerOp, r.nsPerOp, (unsigned long)r.iterations);
+}
+
+void bench_run_serial() {
+    Serial.println("\n==========================================================");
+    Serial.printf("     BENCH (CPU %u MHz)\n", ESP.getCpuFreqMHz());
+    Serial.println("==========================================================");
+    Serial.printf("%-24s %12s %12s %10s\n", "Benchmark", "cycles/op", "ns/op", "iters");
+    bench_run(nullptr, reportSerial, nullptr);
+    Serial.println("==========================================================\n");
+}
+
+#else
+// ======================================================
+// HOST – licznik alokacji, baza odniesienia, main()
+// ======================================================
+
+void* operator new(size_t size) {
+    benchAllocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+struct BaselineEntry {
+    char name[32];
+    double nsPerOp;
+    double allocsPerOp;
+    uint32_t iterations;
+};
+
+// [FIX] Przekroczenie progu musi się powtórzyć: przypadek z regresją jest
+// mierzony ponownie (najlepszy wynik wygrywa) – szum tylko dodaje czas
+static constexpr int BENCH_CONFIRM_RUNS = 2;
+
+struct HostReport {
+    std::vector<BaselineEntry> baseline;
+    std::vector<BaselineEntry> results;
+    double thresholdPct;              // 0 = ns/op bez porównania (inna maszyna)
+    double scalingPct;                // dopuszczalna odchyłka kosztu na komorę
+};
+
+static bool loadBaseline(const char* path, std::vector<BaselineEntry>& out) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        BaselineEntry e = {};
+        if (sscanf(line, "%31[^,],%lf,%lf", e.name, &e.nsPerOp, &e.allocsPerOp) == 3) {
+            out.push_back(e);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+// Zbiera wyniki; przy ponownym pomiarze zostaje szybsza partia
+static void collectHost(const BenchResult& r, void* ctx) {
+    HostReport* rep = (HostReport*)ctx;
+    for (BaselineEntry& e : rep->results) {
+        if (strcmp(e.name, r.name) != 0) continue;
+        if (r.nsPerOp < e.nsPerOp) {
+            e.nsPerOp = r.nsPerOp;
+            e.iterations = r.iterations;
+        }
+        if (r.allocsPerOp < e.allocsPerOp) e.allocsPerOp = r.allocsPerOp;
+        return;
+    }
+    BaselineEntry e = {};
+    strncpy(e.name, r.name, sizeof(e.name) - 1);
+    e.nsPerOp = r.nsPerOp;
+    e.allocsPerOp = r.allocsPerOp;
+    e.iterations = r.iterations;
+    rep->results.push_back(e);
+}
+
+static const BaselineEntry* findEntry(const std::vector<BaselineEntry>& v, const char* name) {
+    for (const BaselineEntry& e : v) {
+        if (strcmp(e.name, name) == 0) return &e;
+    }
+    return nullptr;
+}
+
+// Porównanie z bazą; cmp = kolumna raportu. Brak wiersza w bazie to też
+// błąd – nowy przypadek bez bazy nigdy nie byłby sprawdzany.
+static bool compareEntry(const HostReport& rep, const BaselineEntry& r, char* cmp, size_t cmpSize) {
+    cmp[0] = '\0';
+    if (rep.baseline.empty()) return true;
+    const BaselineEntry* b = findEntry(rep.baseline, r.name);
+    if (!b) {
+        snprintf(cmp, cmpSize, "  NO BASELINE");
+        return false;
+    }
+    double deltaPct = (b->nsPerOp > 0) ? (r.nsPerOp - b->nsPerOp) * 100.0 / b->nsPerOp : 0;
+    bool slower = rep.thresholdPct > 0 && deltaPct > rep.thresholdPct;
+    bool moreAllocs = r.allocsPerOp > b->allocsPerOp + 0.01;
+    snprintf(cmp, cmpSize, "%+7.1f%%%s%s", deltaPct,
+             slower ? "  SLOWER" : "", moreAllocs ? "  ALLOCS" : "");
+    return !slower && !moreAllocs;
+}
+
+// [FIX] Skalowanie liniowe: control_tick_Nch / N w granicach scalingPct od
+// control_tick_1ch (iloraz z jednego przebiegu – niezależny od maszyny).
+// Bez przypadków control_tick (--filter) nic nie sprawdza.
+static bool checkScaling(const HostReport& rep, bool print) {
+    const BaselineEntry* one = findEntry(rep.results, "control_tick_1ch");
+    if (!one || one->nsPerOp <= 0) return true;
+    bool ok = true;
+    static const uint8_t counts[] = {2, 4};
+    for (uint8_t n : counts) {
+        char name[32];
+        snprintf(name, sizeof(name), "control_tick_%uch", (unsigned)n);
+        const BaselineEntry* e = findEntry(rep.results, name);
+        if (!e) continue;
+        double ratio = e->nsPerOp / n / one->nsPerOp;
+        bool within = fabs(ratio - 1.0) * 100.0 <= rep.scalingPct;
+        if (!within) ok = false;
+        if (print) {
+            printf("scaling %uch: %.1f ns per chamber, x%.2f of 1ch%s\n", (unsigned)n,
+                   e->nsPerOp / n, ratio, within ? "" : "  NOT LINEAR");
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    const char* filter = nullptr;
+    const char* baselinePath = nullptr;
+    const char* savePath = nullptr;
+    HostReport rep;
+    rep.thresholdPct = 15.0;
+    rep.scalingPct = 30.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)         filter = argv[++i];
+        else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)  baselinePath = argv[++i];
+        else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)      savePath = argv[++i];
+        else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) rep.thresholdPct = atof(argv[++i]);
+        else if (strcmp(argv[i], "--scaling") == 0 && i + 1 < argc)   rep.scalingPct = atof(argv[++i]);
+        else {
+            fprintf(stderr, "usage: bench [--filter nazwa] [--baseline plik.csv] "
+                            "[--save plik.csv] [--threshold %%] [--scaling %%]\n");
+            return 2;
+        }
+    }
+
+    if (baselinePath && !loadBaseline(baselinePath, rep.baseline)) {
+        fprintf(stderr, "Cannot read baseline: %s\n", baselinePath);
+        return 2;
+    }
+
+    // Karta SD w katalogu tymczasowym, zegar wirtualny dla soft-enable grzałek
+    char sdDir[] = "/tmp/wedzarnia_bench_XXXXXX";
+    if (!mkdtemp(sdDir)) {
+        fprintf(stderr, "Cannot create temp dir\n");
+        return 2;
+    }
+    hal_posix_set_fs_root(sdDir);
+    hal_posix_set_time_ms(0);
+    init_state();
+    initHeaterEnable(g_chambers[0]);
+    hal_posix_advance_ms(4000);
+    applySoftEnable(g_chambers[0]);
+
+    bench_run(filter, collectHost, &rep);
+    char cmp[48];
+    for (int run = 0; run < BENCH_CONFIRM_RUNS; run++) {
+        bool again = false;
+        for (const BaselineEntry& r : rep.results) {
+            if (compareEntry(rep, r, cmp, sizeof(cmp)) || !findEntry(rep.baseline, r.name)) continue;
+            bench_run(r.name, collectHost, &rep);
+            again = true;
+        }
+        if (!checkScaling(rep, false)) {
+            bench_run("control_tick", collectHost, &rep);
+            again = true;
+        }
+        if (!again) break;
+    }
+    rmdir((std::string(sdDir) + "/profiles").c_str());
+    rmdir(sdDir);
+
+    printf("%-24s %12s %10s %12s  %s\n", "Benchmark", "ns/op", "allocs/op", "iters",
+           baselinePath ? "vs baseline" : "");
+    int regressions = 0;
+    for (const BaselineEntry& r : rep.results) {
+        if (!compareEntry(rep, r, cmp, sizeof(cmp))) regressions++;
+        printf("%-24s %12.1f %10.2f %12lu  %s\n",
+               r.name, r.nsPerOp, r.allocsPerOp, (unsigned long)r.iterations, cmp);
+    }
+
+    if (!checkScaling(rep, true)) {
+        printf("control tick cost per chamber outside +-%g%%\n", rep.scalingPct);
+        regressions++;
+    }
+
+    if (savePath) {
+        FILE* f = fopen(savePath, "w");
+        if (!f) {
+            fprintf(stderr, "Cannot write: %s\n", savePath);
+            return 2;
+        }
+        fprintf(f, "# name,ns_per_op,allocs_per_op\n");
+        for (const BaselineEntry& e : rep.results) {
+            fprintf(f, "%s,%.1f,%.2f\n", e.name, e.nsPerOp, e.allocsPerOp);
+        }
+        fclose(f);
+    }
+
+    if (regressions > 0) {
+        if (baselinePath) {
+            printf("%d regression(s) vs %s (threshold %g%%)\n", regressions, baselinePath, rep.thresholdPct);
+        } else {
+            printf("%d regression(s)\n", regressions);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+#endif // ARDUINO
@@ -0,0 +1,26 @@
+// bench.h - [NEW] Mikrobenchmarki gorących ścieżek (parsowanie, JSON, sterowanie)
+// Host: osobny program (bench.cpp + rdzeń, jak replay.cpp) – ns/op,
+// alokacje/op i porównanie z bench_baseline.csv.
+// ESP32: CFG_BENCH_ON_BOOT – licznik cykli CPU, wynik na Serial przed
+// startem tasków (wyjścia SSR pozostają wyłączone).
+#pragma once
+#include "hal.h"
+
+struct BenchResult {
+    const char* name;
+    uint32_t iterations;
+    double nsPerOp;
+    double cyclesPerOp;      // tylko ESP32 (0 na hoście)
+    double allocsPerOp;      // tylko host (< 0 = brak pomiaru)
+};
+
+typedef void (*bench_report_fn)(const BenchResult& result, void* ctx);
+
+// Uruchamia przypadki, których nazwa zawiera filter (nullptr = wszystkie).
+// Stan procesu (profil, kroki, statystyki) jest przywracany po zakończeniu.
+int bench_run(const char* filter, bench_report_fn report, void* ctx);
+
+#ifdef ARDUINO
+// Tabela wyników na Serial (wołane z setup())
+void bench_run_serial();
+#endif
@@ -0,0 +1,90 @@
+// boot_prof.cpp - [NEW] Czasy etapów startu (opis w boot_prof.h)
+#include "boot_prof.h"
+#include "config.h"
+
+struct BootStage {
+    const char* name;
+    uint32_t startUs;
+    uint32_t endUs;
+    uint8_t core;
+};
+
+static BootStage stages[CFG_BOOT_STAGE_COUNT];
+static uint8_t stageCount = 0;
+static uint32_t controlUs = 0;          // 0 = pętla sterowania jeszcze nie ruszyła
+static uint32_t finishUs = 0;
+static portMUX_TYPE bootMux = portMUX_INITIALIZER_UNLOCKED;
+
+uint32_t boot_prof_now() {
+    return micros();
+}
+
+void boot_prof_stage(const char* name, uint32_t startUs) {
+    uint32_t now = micros();
+    portENTER_CRITICAL(&bootMux);
+    if (stageCount < CFG_BOOT_STAGE_COUNT) {
+        stages[stageCount++] = {name, startUs, now, (uint8_t)xPortGetCoreID()};
+    }
+    portEXIT_CRITICAL(&bootMux);
+    LOG_FMT(LOG_LEVEL_INFO, "[BOOT] %s: %lu ms (at %lu ms)", name,
+            (unsigned long)((now - startUs) / 1000), (unsigned long)(now / 1000));
+}
+
+void boot_prof_control_ready() {
+    uint32_t now = micros();
+    portENTER_CRITICAL(&bootMux);
+    bool first = controlUs == 0;
+    if (first) controlUs = now;
+    portEXIT_CRITICAL(&bootMux);
+    if (!first) return;
+
+    if (now / 1000 > CFG_BOOT_CONTROL_TARGET_MS) {
+        LOG_FMT(LOG_LEVEL_WARN, "[BOOT] Control loop after %lu ms (target %lu ms)",
+                (unsigned long)(now / 1000), (unsigned long)CFG_BOOT_CONTROL_TARGET_MS);
+    } else {
+        LOG_FMT(LOG_LEVEL_INFO, "[BOOT] Control loop after %lu ms", (unsigned long)(now / 1000));
+    }
+}
+
+void boot_prof_finish() {
+    uint32_t now = micros();
+    portENTER_CRITICAL(&bootMux);
+    finishUs = now;
+    uint8_t count = stageCount;
+    portEXIT_CRITICAL(&bootMux);
+
+    // Etapy dopisane przed finishUs już się nie zmieniają – tabela bez locka
+    log_msg(LOG_LEVEL_INFO, "[BOOT] stage             start ms   duration ms  core");
+    for (uint8_t i = 0; i < count; i++) {
+        const BootStage& s = stages[i];
+        LOG_FMT(LOG_LEVEL_INFO, "[BOOT] %-16s %9lu %13lu %5u", s.name,
+                (unsigned long)(s.startUs / 1000), (unsigned long)((s.endUs - s.startUs) / 1000),
+                (unsigned)s.core);
+    }
+    LOG_FMT(LOG_LEVEL_INFO, "[BOOT] Control loop at %lu ms, fully up at %lu ms",
+            (unsigned long)(controlUs / 1000), (unsigned long)(now / 1000));
+}
+
+String boot_prof_json() {
+    BootStage copy[CFG_BOOT_STAGE_COUNT];
+    portENTER_CRITICAL(&bootMux);
+    uint8_t count = stageCount;
+    memcpy(copy, stages, sizeof(BootStage) * count);
+    uint32_t control = controlUs;
+    uint32_t finish = finishUs;
+    portEXIT_CRITICAL(&bootMux);
+
+    char json[1536];
+    int offset = snprintf(json, sizeof(json),
+        "{\"controlMs\":%lu,\"targetMs\":%lu,\"finishedMs\":%lu,\"stages\":[",
+        (unsigned long)(control / 1000), (unsigned long)CFG_BOOT_CONTROL_TARGET_MS,
+        (unsigned long)(finish / 1000));
+    for (uint8_t i = 0; i < count && offset < (int)sizeof(json); i++) {
+        offset += snprintf(json + offset, sizeof(json) - offset,
+            "%s{\"name\":\"%s\",\"startMs\":%lu,\"durationMs\":%lu,\"core\":%u}",
+            i ? "," : "", copy[i].name, (unsigned long)(copy[i].startUs / 1000),
+            (unsigned long)((copy[i].endUs - copy[i].startUs) / 1000), (unsigned)copy[i].core);
+    }
+    if (offset < (int)sizeof(json)) snprintf(json + offset, sizeof(json) - offset, "]}");
+    return String(json);
+}
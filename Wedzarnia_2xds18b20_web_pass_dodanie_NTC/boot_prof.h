@@ -0,0 +1,29 @@
+// boot_prof.h - [NEW] Czasy etapów startu
+// setup() szedł sekwencyjnie: ekran z 1,5 s planszą, SD z ponowieniami na
+// 1 MHz, self-test z blokującą konwersją DS18B20, WiFi do 10 s – grzanie
+// wracało po kilkunastu sekundach od resetu. Teraz w setup() tylko ścieżka
+// krytyczna (piny wyłączone, NVS, wyjścia, czujniki, taski sterowania),
+// reszta w dwóch taskach startowych na rdzeniu 0 (tasks.cpp):
+//   Boot-SD:  ekran → karta SD → UI
+//   Boot-Net: WiFi → (po SD) serwer WWW → GitHub → MQTT
+// Każdy etap: początek i koniec (us od startu aplikacji) i rdzeń.
+// Pierwszy takt taskControl = czas do sterowania, ostrzeżenie gdy
+// > CFG_BOOT_CONTROL_TARGET_MS. Po ostatnim etapie tabela w logu,
+// zawsze w /api/boot.
+#pragma once
+#include <Arduino.h>
+
+// Czas do zapamiętania na początku etapu
+uint32_t boot_prof_now();
+
+// Koniec etapu rozpoczętego w startUs (z dowolnego taska)
+void boot_prof_stage(const char* name, uint32_t startUs);
+
+// Pierwszy takt pętli sterowania
+void boot_prof_control_ready();
+
+// Wszystkie etapy w tle skończone – tabela i podsumowanie w logu
+void boot_prof_finish();
+
+// Etapy, czas do sterowania i do pełnego startu dla /api/boot
+String boot_prof_json();
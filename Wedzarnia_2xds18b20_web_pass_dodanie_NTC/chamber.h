@@ -0,0 +1,387 @@
+// chamber.h - [NEW] Komora wędzarni jako obiekt (kilka komór na jednej płytce)
+// Cały stan jednej komory: proces i profil, PID z adaptacją, statystyki,
+// mapa grzałek (piny z CFG_CHAMBER_HW) i role czujników. taskControl
+// przelicza wszystkie CFG_CHAMBER_COUNT komór co 100 ms.
+//
+// Dotychczasowe globalne g_tSet, g_currentState, pid, pidOutput... to
+// aliasy komory 0 (state.h) – moduły jednokomorowe działają bez zmian.
+// Wszystkie komory dzielą stateMutex/outputMutex/heaterMutex i brzęczyk.
+#pragma once
+#include "config.h"
+#include "pid_ctrl.h"
+
+// Adaptacja nastaw PID na podstawie wariancji uchybu (process.cpp)
+struct AdaptivePid {
+    double errorHistory[10] = {0};
+    int historyIndex = 0;
+    unsigned long lastAdaptation = 0;
+    double currentKp = CFG_Kp;
+    double currentKi = CFG_Ki;
+    double currentKd = CFG_Kd;
+    // [NEW] Mnożniki z wariancji uchybu nakładane na nastawy z GainTable
+    double mulKp = 1.0;
+    double mulKi = 1.0;
+    double mulKd = 1.0;
+};
+
+// [NEW] Nastawy PID wg pasma setpointu i trybu mocy (gain_sched.cpp)
+struct GainCell {
+    float kp, ki, kd;
+    uint16_t samples;     // przyjęte odpowiedzi skokowe
+    uint16_t settleSec;   // czas ustalenia ostatniej z nich (0 = brak)
+};
+
+struct GainTable {
+    uint16_t version;
+    GainCell cell[CFG_POWERMODE_MAX - CFG_POWERMODE_MIN + 1][CFG_GAIN_BAND_COUNT];
+};
+
+// Obserwowana odpowiedź na skok setpointu w górę (gain_sched.cpp)
+struct GainStepObserver {
+    bool active = false;
+    double target = 0;
+    double startTemp = 0;
+    int powerMode = 0;
+    unsigned long startMs = 0;
+    unsigned long t90Ms = 0;          // 90% skoku (0 = jeszcze nie)
+    unsigned long reachMs = 0;        // pierwsze wejście w pasmo ustalenia
+    unsigned long inBandSince = 0;    // ostatnie wejście w pasmo
+    unsigned long saturatedMs = 0;    // czas z wyjściem PID ~100% po t90
+    unsigned long lastMs = 0;
+    // Krzywa reakcji w fazie nasycenia (wyjście ~100%): opóźnienie i max nachylenie
+    double u0 = 0;                    // wyjście PID przed skokiem
+    unsigned long deadMs = 0;         // pierwszy wzrost o GAIN_DEAD_RISE_C
+    unsigned long slopeMs = 0;
+    double slopeTemp = 0;
+    double maxSlope = 0;              // C/s
+    double overshoot = 0;
+    uint8_t bandExits = 0;
+    bool inBand = false;
+    // Ostatnio widziane wejścia – wykrycie skoku
+    double lastTSet = 0;
+    int lastPowerMode = 0;
+    bool lastRunning = false;
+};
+
+// [NEW] Autotune przekaźnikowy Åström–Hägglund (autotune.cpp)
+enum class AutotunePhase : uint8_t { NONE, HEATING, RELAY, DONE, FAILED };
+enum class AutotuneRule : uint8_t { TYREUS_LUYBEN, ZIEGLER_NICHOLS };
+
+struct AutotuneRun {
+    AutotunePhase phase = AutotunePhase::NONE;
+    AutotuneRule rule = AutotuneRule::TYREUS_LUYBEN;
+    double setpoint = 0;
+    int powerMode = 0;
+    unsigned long startMs = 0;
+    unsigned long endMs = 0;
+    // Przekaźnik: wyjście bias +/- d, bias korygowany co cykl (równe czasy ON/OFF)
+    bool outputHigh = true;
+    double bias = 50;
+    double d = 50;
+    unsigned long riseMs = 0;         // ostatnie przełączenie na ON (początek cyklu)
+    unsigned long fallMs = 0;         // ostatnie przełączenie na OFF
+    double tMax = 0;
+    double tMin = 0;
+    uint8_t cycles = 0;               // pełne cykle po fazie grzania
+    double amplitude = 0;             // C, połowa międzyszczytowej ostatniego cyklu
+    double ku = 0;                    // %/C
+    double tuSec = 0;
+    double prevKu = 0;
+    double prevTuSec = 0;
+    double kp = 0, ki = 0, kd = 0;    // wynik (po ograniczeniach)
+    const char* message = "";
+};
+
+// [NEW] Model FOPDT komory identyfikowany online (fopdt.cpp): RLS dla
+// każdego kandydata opóźnienia, okno dT = th1*T + th2*u + th3
+struct FopdtRls {
+    double theta[3] = {0, 0, 0};
+    double P[3][3] = {{0}};
+    double errEwma = 0;               // średni kwadrat błędu predykcji
+};
+
+struct FopdtModel {
+    uint8_t uHist[256] = {0};         // moc (% wszystkich grzałek) co 1 s
+    uint8_t uHead = 0;
+    uint8_t uFill = 0;
+    unsigned long lastSampleMs = 0;
+    double winSum = 0;
+    uint8_t winCount = 0;
+    double lastWinMean = 0;
+    bool haveWin = false;
+    double lastWinU = 0;
+    uint8_t exciteLeft = 0;           // okna RLS po ostatnim pobudzeniu
+    uint32_t windows = 0;
+    FopdtRls rls[CFG_FOPDT_DELAY_COUNT];
+    // Najlepszy kandydat (wg errEwma)
+    int best = -1;
+    bool valid = false;
+    double th1 = 0, th2 = 0, th3 = 0; // na okno CFG_FOPDT_WINDOW_S
+    double gainK = 0;                 // C na % mocy wszystkich grzałek
+    double tauS = 0;
+    double ambient = 0;               // temperatura "otoczenia" modelu liniowego
+    // Predyktor Smitha i feed-forward
+    double xm = 0;                    // model bez opóźnienia
+    float xmHist[256] = {0};          // xm co 1 s (indeks jak uHist)
+    double correction = 0;            // xm(t) - xm(t-L), dodawane do wejścia PID
+    double ff = 0;                    // % wyjścia PID
+    bool ffActive = false;
+    // [NEW] Residuum a priori ważnego modelu (heater_diag.cpp): dT okna - predykcja
+    double residual = 0;
+    double residualU = 0;             // moc opóźniona o L użyta w predykcji (%)
+    uint32_t residualSeq = 0;
+};
+
+// [NEW] Prognoza mięsa (meat_eta.cpp): dTm/dt = k * (Tk - Tm), k z ważonej
+// regresji przez zero, pasmo z wariancji k
+struct MeatEta {
+    unsigned long lastSampleMs = 0;
+    unsigned long batchStart = 0;     // processStartTime wsadu – nowy wsad = reset
+    double winChamber = 0;
+    double winMeat = 0;
+    uint8_t winCount = 0;
+    double lastWinMeat = 0;
+    double lastWinDrive = 0;          // średnie Tk - Tm poprzedniego okna
+    bool haveWin = false;
+    // Sumy ważone (zapominanie CFG_ETA_FORGET): x = Tk - Tm, y = dTm/dt
+    double sw = 0, sxx = 0, sxy = 0, syy = 0;
+    uint16_t windows = 0;
+    double k = 0;                     // 1/s
+    double kSigma = 0;
+    bool valid = false;
+    // Prognozy (s, -1 = nieznana / cel nieosiągalny przy tSet kroku)
+    long stepSec = -1, stepLoSec = -1, stepHiSec = -1;
+    long processSec = -1, processLoSec = -1, processHiSec = -1;
+};
+
+// [NEW] Czas ON wyjścia ważony wypełnieniem (wentylator 0/255, dym PWM);
+// aktualizacja tylko przy zmianie wypełnienia (outputs.cpp)
+struct OutputMeter {
+    uint8_t duty = 0;
+    unsigned long sinceMs = 0;
+    uint64_t units = 0;               // ms x wypełnienie 0..255
+};
+
+// [NEW] Liczniki czasu ON wyjść komory (ms, od startu) – migawki energy.cpp
+struct EnergyCounters {
+    uint64_t heaterMs[3] = {0, 0, 0}; // kolejność ssrPins
+    uint64_t fanMs = 0;
+    uint64_t smokeMs = 0;             // ważone wypełnieniem PWM
+};
+
+// [NEW] Energia wsadu (energy.cpp): migawki liczników na starcie wsadu
+// i kroku, Wh zamkniętych kroków; koniec wsadu = stop lub koniec profilu
+struct EnergyMeter {
+    unsigned long lastSampleMs = 0;
+    unsigned long batchStart = 0;     // processStartTime wsadu
+    bool active = false;              // wsad trwa (false = wynik ostatniego)
+    bool autoMode = false;
+    int step = -1;
+    EnergyCounters atBatch;
+    EnergyCounters atStep;
+    EnergyCounters atEnd;             // zamrożone po końcu wsadu
+    unsigned long endMs = 0;
+    float stepWh[MAX_STEPS] = {0};
+};
+
+// [NEW] Harmonogram wentylatora (fan_sched.cpp): trend z odczytów czujnika
+// na ich znacznikach czasu, udział ON korygowany co CFG_FAN_ADAPT_MS
+struct FanSched {
+    float sampleT[CFG_FAN_TREND_SAMPLES] = {0};
+    unsigned long sampleMs[CFG_FAN_TREND_SAMPLES] = {0};
+    uint8_t head = 0;
+    uint8_t fill = 0;
+    unsigned long lastSampleMs = 0;   // tChamberMs ostatniej próbki
+    double slope = 0;                 // C/min
+    bool slopeValid = false;
+    // Cykl kroku (fanOnTime/fanOffTime) i wynik harmonogramu
+    unsigned long baseOnMs = 0;
+    unsigned long baseOffMs = 0;
+    double duty = 0;                  // udział ON w cyklu
+    double target = 0;
+    unsigned long lastAdaptMs = 0;
+    bool active = false;
+    unsigned long onMs = 0;
+    unsigned long offMs = 0;
+};
+
+// [NEW] Diagnostyka grzałek z residuum modelu (heater_diag.cpp): CUSUM
+// brakującego przyrostu, potem próba każdego kanału osobno
+enum class HeaterDiagPhase : uint8_t { WATCH, PROBE };
+
+struct HeaterDiag {
+    HeaterDiagPhase phase = HeaterDiagPhase::WATCH;
+    unsigned long lastMs = 0;         // przerwa (pauza) = próba przerwana
+    uint32_t lastSeq = 0;
+    double cusum = 0;                 // C brakującego przyrostu
+    unsigned long suspectMs = 0;
+    int8_t probe = -1;                // kanał z odchyłką (indeks ssrPins), -1 = odniesienie
+    uint8_t probeStep = 0;            // 0 = odniesienie, potem kolejne kanały czynne
+    uint8_t probeCount = 0;           // kanały czynne w powerMode
+    uint8_t probeOrder[3] = {0, 1, 2};// kanały czynne wg heaterOrder przy podejrzeniu
+    int8_t probeDir = 0;              // +1 kanał przejmuje moc, -1 oddaje, 0 = do wyboru
+    unsigned long probeStart = 0;     // początek kroku
+    double probeM[3][3] = {};         // suma a*a' (a = przyrost od kanału z modelu)
+    double probeV[3] = {};            // suma a * rzeczywisty przyrost
+    double dutySum[3] = {0, 0, 0};    // wypełnienia (%) w bieżącym oknie modelu
+    uint16_t dutyCount = 0;
+    double heatStage[3] = {0, 0, 0};  // wypełnienia po bezwładności grzałki
+    double heatDuty[3] = {0, 0, 0};   //   ... i czujnika (przyrost w oknie)
+    bool heatValid = false;
+    double health[3] = {-1, -1, -1};  // ostatnia próba: 1 = sprawna, -1 = brak
+    uint8_t failedMask = 0;
+    uint16_t suspects = 0;            // alarmy CUSUM od startu
+    uint16_t falseAlarms = 0;         // próby bez awarii kanału
+};
+
+// [NEW] Ochrona przed przegrzaniem (overheat.cpp): przewidywana temperatura
+// po bezwładności grzałek, mnożnik mocy SSR i zapis zdarzeń
+struct OverheatEvent {
+    unsigned long startMs = 0;        // millis() początku redukcji / przekroczenia
+    unsigned long durationMs = 0;
+    float peak = 0;                   // C, najwyższy odczyt komory
+    unsigned long aboveMs = 0;        // czas powyżej CFG_T_MAX_SOFT
+    float minFactor = 1;              // najmniejszy mnożnik mocy
+    bool hardTrip = false;            // doszło do PAUSE_OVERHEAT
+};
+
+struct OverheatGuard {
+    unsigned long lastSampleMs = 0;   // tChamberMs ostatniej próbki
+    double lastT = 0;
+    double slope = 0;                 // C/min, filtrowana
+    bool slopeValid = false;
+    double predicted = 0;             // C po CFG_OVH_LAG_S
+    double factor = 1;                // mnożnik wypełnień SSR (mapPowerToHeaters)
+    unsigned long lastMs = 0;
+    bool active = false;
+    unsigned long calmSinceMs = 0;    // od kiedy bez redukcji i poniżej progu
+    OverheatEvent current;
+    OverheatEvent events[CFG_OVH_EVENT_COUNT];
+    uint8_t head = 0;                 // następny zapis w events
+    uint16_t count = 0;               // zdarzenia od startu
+};
+
+// [NEW] Tryb awaryjny bez czujnika komory (sensor_failover.cpp): estymata
+// z modelu FOPDT korygowana mięsem, ograniczona moc i czas
+struct SensorFailover {
+    bool active = false;
+    unsigned long startMs = 0;
+    unsigned long anchorMs = 0;       // ostatni ważny odczyt komory
+    unsigned long lastStepMs = 0;     // krok estymaty co 1 s
+    double estimate = 0;              // C, podstawiana do tChamber
+    double powerCap = 100;            // limit wyjścia PID
+    bool capApplied = false;          // SetOutputLimits != 0..100
+    bool outputHeld = false;          // cap 0 – PID w MANUAL, wyjście 0
+    uint8_t validStreak = 0;
+    bool meatAided = false;
+    // Pochodna mięsa z okien CFG_FAILOVER_MEAT_WINDOW_S
+    double meatWinSum = 0;
+    uint8_t meatWinCount = 0;
+    double meatPrevMean = 0;
+    bool meatHavePrev = false;
+    double meatSlope = 0;             // C/s
+    bool meatSlopeValid = false;
+    // Od startu
+    uint16_t episodes = 0;
+    uint16_t hardPauses = 0;
+    unsigned long degradedMs = 0;     // zakończone epizody
+};
+
+// Grzałka ON bez wzrostu temperatury → PAUSE_HEATER_FAULT (process.cpp)
+struct HeaterFaultMonitor {
+    double  tempAtWindowStart = 0.0;   // temperatura komory na początku okna pomiarowego
+    unsigned long windowStart = 0;     // millis() kiedy zaczęło się okno
+    bool    monitoring = false;        // czy okno jest aktywne
+};
+
+// Ostatni poprawny odczyt czujnika (sensors.cpp)
+struct CachedReading {
+    double value = 25.0;
+    unsigned long timestamp = 0;
+    bool valid = false;
+    int readAttempts = 0;
+};
+
+struct Chamber {
+    Chamber();
+    Chamber(const Chamber&) = delete;
+    Chamber& operator=(const Chamber&) = delete;
+
+    uint8_t id = 0;
+    const ChamberHw* hw = &CFG_CHAMBER_HW[0];
+
+    // --- Stan procesu (chroniony state_lock) ---
+    volatile ProcessState currentState = ProcessState::IDLE;
+    RunMode lastRunMode = RunMode::MODE_AUTO;
+    volatile double tSet = 70.0;
+    volatile double tChamber = 25.0;
+    volatile unsigned long tChamberMs = 0;  // [NEW] czas ostatniego poprawnego odczytu
+    volatile double tMeat = 25.0;
+    volatile int powerMode = 1;
+    volatile int manualSmokePwm = 0;
+    volatile int fanMode = 1;
+    volatile unsigned long fanOnTime = CFG_FAN_ON_DEFAULT_MS;
+    volatile unsigned long fanOffTime = CFG_FAN_OFF_DEFAULT_MS;
+    volatile bool doorOpen = false;
+    volatile bool errorSensor = false;
+    volatile bool errorOverheat = false;
+    volatile bool errorProfile = false;
+
+    Step profile[MAX_STEPS];
+    int stepCount = 0;
+    int currentStep = 0;
+    unsigned long processStartTime = 0;
+    unsigned long stepStartTime = 0;
+    ProcessStats processStats = {0, 0, 0, 0, 0.0, 0, 0, 0};
+
+    // --- Regulator ---
+    double pidInput = 0;
+    double pidSetpoint = 0;
+    double pidOutput = 0;
+    PidController pid;
+    AdaptivePid adaptive;
+    GainTable gains;
+    GainStepObserver gainObs;
+    AutotuneRun autotune;
+    FopdtModel model;
+    MeatEta eta;
+    EnergyMeter energy;
+    FanSched fan;
+
+    // --- Pętla sterowania (process.cpp) ---
+    HeaterFaultMonitor hfm;
+    HeaterDiag diag;
+    OverheatGuard ovh;
+    SensorFailover failover;
+    ProcessState lastSeenState = ProcessState::IDLE;
+
+    // --- Wyjścia (outputs.cpp; he chronione heaterMutex) ---
+    HeaterEnable he = {false, false, false, 0, 0, 0};
+    uint8_t heaterOrder[3] = {0, 1, 2};   // [NEW] grzałka wiodąca, druga, trzecia (indeks ssrPins)
+    unsigned long heaterRotateMs = 0;
+    volatile bool fanState = true;
+    volatile unsigned long fanTimer = 0;
+    OutputMeter fanMeter;                 // [NEW] energia wentylatora i dymu
+    OutputMeter smokeMeter;
+
+    // --- Czujniki (sensors.cpp) ---
+    int chamberSensor = DEFAULT_CHAMBER_SENSOR;
+    int meatSensor = DEFAULT_MEAT_SENSOR;
+    CachedReading cachedChamber;
+    CachedReading cachedMeat;
+    int sensorErrorCount = 0;
+};
+
+extern Chamber g_chambers[CFG_CHAMBER_COUNT];
+
+// Komora o indeksie idx; poza zakresem – komora 0 (np. ?ch= z WWW)
+Chamber& chamber_get(uint8_t idx);
+
+// Wszystkie komory w IDLE (np. format SD); wołać pod state_lock
+bool chamber_all_idle();
+
+// Id, piny, stałe role czujników i nastawy PID jednej komory
+void chamber_init(Chamber& c, uint8_t id, const ChamberHw* hw);
+
+// chamber_init dla wszystkich komór z CFG_CHAMBER_HW (init_state)
+void chamber_init_all();
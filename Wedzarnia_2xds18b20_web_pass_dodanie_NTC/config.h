@@ -1,8 +1,10 @@
 // config.h - Zoptymalizowana wersja ze stabilnymi timeoutami
 #pragma once
-#include <Arduino.h>
+#include "hal.h"
+#ifdef ARDUINO
 #include <WiFi.h>
 #include <SD.h>
+#endif
 
 // ======================================================
 // 0. METADANE FIRMWARE  ← jedyne miejsce do zmiany wersji/autora
@@ -41,10 +43,31 @@ constexpr int SCREEN_WIDTH = 128;
 constexpr int SCREEN_HEIGHT = 160;
 #define ST77XX_DARKGREY 0x7BEF
 
-// --- LEDC (PWM) ---
+// --- LEDC (PWM) – tylko dymogenerator; grzałki przez ssr_tp ---
 constexpr int LEDC_FREQ = 5000;
 constexpr int LEDC_RESOLUTION = 8;
 
+// --- [NEW] Grzałki: proporcjonowanie czasu SSR (ssr_tp.cpp) ---
+// SSR z detekcją przejścia przez zero przełącza tylko co półokres sieci –
+// wypełnienie realizowane jako liczba półokresów ON w oknie
+constexpr uint32_t CFG_SSR_MAINS_HZ = 50;
+constexpr uint32_t CFG_SSR_WINDOW_MS = 2000;       // okno 1-2 s
+constexpr uint32_t CFG_SSR_TICK_US = 1000000UL / (2 * CFG_SSR_MAINS_HZ);
+constexpr uint32_t CFG_SSR_WINDOW_TICKS = CFG_SSR_WINDOW_MS * 1000UL / CFG_SSR_TICK_US;
+static_assert(CFG_SSR_WINDOW_TICKS >= 50 && CFG_SSR_WINDOW_TICKS <= 1000,
+              "CFG_SSR_WINDOW_MS: okno 0.5-10 s");
+// [NEW] Przeplot okresów ON grzałek w oknie (mniej grzałek naraz, bez
+// wspólnego startu okna) i limit prądu zasilania (0 = bez limitu).
+// Limit jest wspólny dla całej płytki – wszystkie grzałki wszystkich komór
+// (SSR_CHANNELS) liczą się do jednego zasilania.
+constexpr bool CFG_SSR_STAGGER = true;
+constexpr double CFG_SSR_HEATER_AMPS = 4.35;       // 1 kW / 230 V
+constexpr double CFG_SSR_SUPPLY_AMPS = 0.0;        // np. 16.0 (B16), 0 = wył.
+static_assert(CFG_SSR_SUPPLY_AMPS <= 0 || CFG_SSR_SUPPLY_AMPS >= CFG_SSR_HEATER_AMPS,
+              "CFG_SSR_SUPPLY_AMPS: limit mniejszy niż prąd jednej grzałki");
+// Rotacja grzałki wiodącej (najmniej godzin ON pierwsza), 0 = stała kolejność
+constexpr unsigned long CFG_HEATER_ROTATE_MS = 60UL * 60UL * 1000UL;
+
 // --- PID ---
 constexpr double CFG_Kp = 5.0;
 constexpr double CFG_Ki = 0.3;
@@ -76,6 +99,25 @@ constexpr unsigned long CFG_WIFI_RETRY_MAX_DELAY = 60000;
 // --- GitHub Repo for Profiles ---
 constexpr const char* CFG_GITHUB_API_URL = "https://api.github.com/repos/kudys11/wedzarnia-przepisy/contents/profiles";
 constexpr const char* CFG_GITHUB_PROFILES_BASE_URL = "https://raw.githubusercontent.com/kudys11/wedzarnia-przepisy/main/profiles/";
+// [NEW] Kopie pobranych profili + ETagi (tryb offline, If-None-Match)
+constexpr const char* CFG_GITHUB_CACHE_DIR = "/cache/github";
+constexpr uint16_t CFG_GITHUB_TIMEOUT_MS = 15000;
+constexpr uint8_t CFG_GITHUB_LIST_MAX = 32;                    // [FIX] profili na liście (UI / WWW)
+
+// --- [NEW] Telemetria MQTT (mqtt_telemetry.cpp), pusty URI = wyłączona ---
+constexpr const char* CFG_MQTT_BROKER_URI = "";          // np. "mqtt://192.168.1.10:1883"
+constexpr const char* CFG_MQTT_USER = "";
+constexpr const char* CFG_MQTT_PASS = "";
+constexpr const char* CFG_MQTT_TOPIC_PREFIX = "wedzarnia";
+constexpr unsigned long CFG_MQTT_SAMPLE_MS = 1000;
+constexpr uint8_t CFG_MQTT_BATCH_SAMPLES = 10;           // próbek w jednej wiadomości
+constexpr uint16_t CFG_MQTT_PAYLOAD_MAX = 320;
+constexpr uint8_t CFG_MQTT_RING_SLOTS = 12;              // kolejka w RAM (~4,5 KB)
+constexpr uint8_t CFG_MQTT_PUBLISH_PER_SEC = 5;          // limit przy opróżnianiu zaległości
+constexpr uint8_t CFG_MQTT_MAX_INFLIGHT = 4;             // QoS 1 bez PUBACK
+constexpr const char* CFG_MQTT_SPOOL_DIR = "/mqtt";
+constexpr uint16_t CFG_MQTT_SPOOL_SEGMENT_MSGS = 100;
+constexpr uint16_t CFG_MQTT_SPOOL_MAX_SEGMENTS = 100;    // ~3 MB, ~27 h offline dla 1 komory
 
 // --- Watchdog ---
 constexpr int WDT_TIMEOUT = 10;
@@ -93,6 +135,10 @@ constexpr int DEFAULT_CHAMBER_SENSOR = 0;
 constexpr int DEFAULT_MEAT_SENSOR = 1;
 constexpr unsigned long SENSOR_ASSIGNMENT_CHECK = 10000;
 
+// --- [NEW] Write-back cache NVS ---
+constexpr unsigned long CFG_NVS_FLUSH_QUIET_MS   = 3000;
+constexpr unsigned long CFG_NVS_FLUSH_MAX_AGE_MS = 30000;
+
 // --- Profil ---
 constexpr int MAX_STEPS = 10;
 
@@ -106,16 +152,97 @@ constexpr int LOG_LEVEL_WARN = 2;
 constexpr int LOG_LEVEL_ERROR = 3;
 constexpr int CURRENT_LOG_LEVEL = LOG_LEVEL_INFO;
 
+// --- [NEW] Mikrobenchmarki (bench.cpp) na Serial przed startem tasków ---
+constexpr bool CFG_BENCH_ON_BOOT = false;
+
+// --- [NEW] Przyspieszony test długiego wsadu (soak.cpp) – tylko do testów ---
+constexpr bool CFG_SOAK_MODE = false;
+constexpr uint32_t CFG_SOAK_SPEEDUP = 60;      // 72 h ruchu WWW/UI w 72 min
+constexpr uint32_t CFG_SOAK_HOURS = 72;
+
 // --- Adaptive PID ---
 constexpr unsigned long PID_ADAPTATION_INTERVAL = 60000;
 
+// --- [NEW] Harmonogram nastaw PID (gain_sched.cpp), tablica w NVS "pid_gains" ---
+// Komórka = pasmo setpointu x tryb mocy; między środkami pasm interpolacja
+constexpr int CFG_GAIN_BAND_COUNT = 5;
+constexpr double CFG_GAIN_BAND_C[CFG_GAIN_BAND_COUNT] = {30.0, 45.0, 60.0, 75.0, 90.0};
+constexpr double CFG_GAIN_STEP_MIN_C = 5.0;                    // min. skok setpointu do nauki
+constexpr double CFG_GAIN_SETTLE_BAND_C = 1.0;                 // pasmo ustalenia +/-
+constexpr unsigned long CFG_GAIN_SETTLE_HOLD_MS = 300000;      // 5 min w paśmie = ustalone
+constexpr unsigned long CFG_GAIN_SLOW_TAIL_MS = 900000;        // 90% skoku → pasmo dłużej = za wolno
+constexpr unsigned long CFG_GAIN_OBS_TIMEOUT_MS = 3UL * 3600000UL;
+constexpr double CFG_GAIN_SCALE_MIN = 0.02;                    // granice nastaw względem CFG_Kp/Ki/Kd
+constexpr double CFG_GAIN_SCALE_MAX = 20.0;
+
+// --- [NEW] Autotune przekaźnikowy (autotune.cpp), wynik do tablicy nastaw ---
+constexpr double CFG_AUTOTUNE_HYST_C = 0.5;                    // histereza przekaźnika +/-
+constexpr double CFG_AUTOTUNE_BIAS_MIN = 10.0;                 // % – granice środka przekaźnika
+constexpr double CFG_AUTOTUNE_BIAS_MAX = 90.0;
+constexpr uint8_t CFG_AUTOTUNE_MIN_CYCLES = 4;
+constexpr uint8_t CFG_AUTOTUNE_MAX_CYCLES = 12;
+constexpr double CFG_AUTOTUNE_TOLERANCE = 0.10;                // zgodność Ku/Tu dwóch ostatnich cykli
+constexpr unsigned long CFG_AUTOTUNE_PERIOD_MIN_MS = 60000;    // krótszy cykl = zakłócenie
+constexpr double CFG_AUTOTUNE_MAX_OVERSHOOT_C = 15.0;          // ponad setpoint = przerwanie
+constexpr unsigned long CFG_AUTOTUNE_TIMEOUT_MS = 5UL * 3600000UL;
+
+// --- [NEW] Model FOPDT komory (fopdt.cpp): feed-forward + predyktor Smitha ---
+constexpr bool CFG_FOPDT_CONTROL = true;                       // false = tylko identyfikacja
+constexpr uint8_t CFG_FOPDT_WINDOW_S = 10;                     // okres próbki modelu
+constexpr int CFG_FOPDT_DELAY_COUNT = 7;                       // kandydaci opóźnienia
+constexpr uint8_t CFG_FOPDT_DELAY_S[CFG_FOPDT_DELAY_COUNT] = {0, 20, 40, 60, 90, 120, 180};
+constexpr double CFG_FOPDT_FORGET = 0.997;                     // na okno – pamięć ~55 min
+constexpr uint16_t CFG_FOPDT_MIN_WINDOWS = 90;                 // 15 min danych przed użyciem
+constexpr double CFG_FOPDT_MAX_RMS_C = 0.1;                    // błąd predykcji na okno
+constexpr double CFG_FOPDT_INTEGRAL_RANGE = 25.0;              // % – suma I przy feed-forward
+constexpr double CFG_FOPDT_SMITH_MAX_C = 15.0;                 // granica korekty Smitha
+
+// --- [NEW] Prognoza temperatury mięsa (meat_eta.cpp) ---
+constexpr uint8_t CFG_ETA_WINDOW_S = 60;                       // okno próbki (kwantyzacja DS18B20)
+constexpr double CFG_ETA_FORGET = 0.98;                        // na okno – pamięć ~50 min
+constexpr uint16_t CFG_ETA_MIN_WINDOWS = 15;                   // 15 min wsadu przed prognozą
+constexpr double CFG_ETA_MIN_DRIVE_C = 2.0;                    // komora - mięso: mniej = brak informacji
+constexpr double CFG_ETA_CONFIDENCE_Z = 2.0;                   // pasmo +/- 2 sigma stałej czasowej
+constexpr double CFG_ETA_MIN_BAND = 0.05;                      // pasmo co najmniej +/- 5% k
+
+// --- [NEW] Energia wsadu (energy.cpp) – domyślne, zmiana przez /api/energy (NVS) ---
+constexpr float CFG_ENERGY_HEATER_W = 1000.0f;                 // moc każdej grzałki
+constexpr float CFG_ENERGY_FAN_W = 40.0f;
+constexpr float CFG_ENERGY_SMOKE_W = 25.0f;                    // przy PWM 255
+constexpr float CFG_ENERGY_TARIFF = 1.10f;                     // zł / kWh
+constexpr float CFG_ENERGY_MAX_W = 10000.0f;                   // walidacja nastaw
+constexpr const char* CFG_ENERGY_RECORD_PATH = "/batches.csv"; // rekord wsadu na SD
+
+// --- [NEW] Harmonogram wentylatora w trybie cyklicznym (fan_sched.cpp) ---
+constexpr bool CFG_FAN_SCHED = true;                           // false = stałe czasy z kroku
+constexpr uint8_t CFG_FAN_TREND_SAMPLES = 16;                  // ~20 s odczytów DS18B20
+constexpr unsigned long CFG_FAN_TREND_MIN_SPAN_MS = 6000;      // krótsza historia = brak trendu
+constexpr unsigned long CFG_FAN_ADAPT_MS = 20000;              // okres korekty udziału ON
+constexpr double CFG_FAN_DUTY_STEP = 0.05;                     // max zmiana udziału ON na korektę
+constexpr double CFG_FAN_SCALE_MIN = 0.5;                      // udział ON względem kroku: bez grzania
+constexpr double CFG_FAN_SCALE_MAX = 3.0;                      //   ... pełna moc / szybki wzrost
+constexpr double CFG_FAN_TREND_FULL = 1.0;                     // C/min = pełne zapotrzebowanie
+constexpr double CFG_FAN_HORIZON_S = 60.0;                     // przewidywanie przestrzału
+constexpr double CFG_FAN_OVERSHOOT_BAND_C = 2.0;
+constexpr unsigned long CFG_FAN_MIN_ON_MS = 5000;
+constexpr unsigned long CFG_FAN_MIN_OFF_MS = 10000;
+constexpr unsigned long CFG_FAN_MAX_OFF_MS = 120000;
+
 // --- Progi pamięci ---
 constexpr uint32_t HEAP_WARNING_THRESHOLD = 20000;
+// [NEW] Fragmentacja: największy wolny blok (bufor JSON/TLS potrzebuje ciągłej pamięci)
+constexpr uint32_t HEAP_LARGEST_BLOCK_WARNING = 8192;
+constexpr uint8_t HEAP_FRAGMENTATION_WARNING_PCT = 60;
 constexpr uint32_t HEAP_CRITICAL_THRESHOLD = 10000;
 
 // --- Debouncing ---
-constexpr unsigned long DEBOUNCE_DELAY = 100;
+// [FIX] Czas stabilnego poziomu po ostatnim zboczu (inputs.cpp), a nie
+// blokada kolejnego naciśnięcia – 30 ms wystarcza na drgania styków
+constexpr unsigned long DEBOUNCE_DELAY = 30;
 constexpr unsigned long LONG_PRESS_DURATION = 1000;
+constexpr unsigned long CFG_BTN_REPEAT_MS = 150;            // [NEW] autorepeat UP/DOWN
+constexpr unsigned long CFG_DOOR_CLOSE_DEBOUNCE_MS = 200;   // [NEW] stabilne zamknięcie drzwi
+constexpr unsigned long CFG_DOOR_RECHECK_MS = 500;          // [NEW] okresowy odczyt krańcówki
 
 // ======================================================
 // [NEW] AUTORYZACJA HTTP Basic Auth
@@ -132,6 +259,57 @@ constexpr double HEATER_MIN_TEMP_RISE     = 2.0;
 constexpr double HEATER_FAULT_MIN_PID     = 50.0;
 constexpr double HEATER_FAULT_MIN_ERROR   = 10.0;
 
+// --- [NEW] Residuum modelu FOPDT (heater_diag.cpp) – wykrycie w minutach ---
+constexpr bool CFG_HFD_ENABLE = true;
+constexpr double CFG_HFD_MIN_POWER = 10.0;                     // % wszystkich grzałek (opóźnione)
+constexpr double CFG_HFD_DRIFT_C = 0.01;                       // tolerowany błąd modelu na okno
+constexpr double CFG_HFD_DRIFT_FRAC = 0.15;                    //   ... plus ułamek przewidywanego przyrostu
+constexpr double CFG_HFD_ALARM_C = 1.0;                        // CUSUM brakującego przyrostu
+constexpr double CFG_HFD_HOLD_C = 0.25;                        // od tego CUSUM model nie uczy się
+constexpr uint16_t CFG_HFD_PROBE_STEP_S = 30;                  // krok próby (odniesienie / kanał)
+constexpr double CFG_HFD_PROBE_SWING = 100.0;                  // % grzałki przesuwane na / z kanału
+constexpr uint16_t CFG_HFD_HEATER_TAU_S = 60;                  // bezwładność grzałki (próba)
+constexpr uint16_t CFG_HFD_SENSOR_TAU_S = 45;                  //   ... czujnika i okna średniej
+constexpr double CFG_HFD_FAILED_HEALTH = 0.5;                  // sprawność < 50% = awaria kanału
+
+// --- [NEW] Przegrzanie z trendu (overheat.cpp) – redukcja mocy przed CFG_T_MAX_SOFT ---
+constexpr bool CFG_OVH_GUARD = true;
+constexpr double CFG_OVH_SLOPE_TAU_S = 15.0;                   // filtr pochodnej odczytów komory
+constexpr uint16_t CFG_OVH_LAG_S = 90;                         // bezwładność grzałki + czujnika
+constexpr double CFG_OVH_BAND_C = 4.0;                         // redukcja od CFG_T_MAX_SOFT - pasmo
+constexpr unsigned long CFG_OVH_CLOSE_MS = 5UL * 60UL * 1000UL;  // koniec zdarzenia po tylu bez redukcji
+constexpr uint8_t CFG_OVH_EVENT_COUNT = 4;                     // zapamiętane zdarzenia
+
+// --- [NEW] Praca bez czujnika komory (sensor_failover.cpp) zamiast PAUSE_SENSOR ---
+constexpr bool CFG_FAILOVER_ENABLE = true;
+constexpr unsigned long CFG_FAILOVER_ANCHOR_MS = 30000;        // start tylko ze świeżym odczytem
+constexpr unsigned long CFG_FAILOVER_MAX_MS = 30UL * 60UL * 1000UL;        // bez odczytu / epizod, z mięsem
+constexpr unsigned long CFG_FAILOVER_MODEL_MAX_MS = 10UL * 60UL * 1000UL;  //   ... sam model
+constexpr uint8_t CFG_FAILOVER_RECOVER_READS = 5;              // kolejne ważne odczyty = koniec
+constexpr double CFG_FAILOVER_HOLD_MUL = 1.0;                  // limit wyjścia = moc utrzymania x
+constexpr uint16_t CFG_FAILOVER_MEAT_WINDOW_S = 60;            // okno pochodnej mięsa
+constexpr double CFG_FAILOVER_MEAT_TAU_S = 300.0;              // korekta estymaty z mięsa
+
+// --- [NEW] Start: ścieżka krytyczna w setup(), reszta w tle (boot_prof.cpp) ---
+constexpr uint32_t CFG_BOOT_CONTROL_TARGET_MS = 1000;          // cel: pierwszy takt sterowania
+constexpr uint8_t CFG_BOOT_STAGE_COUNT = 20;                   // zapamiętane etapy startu
+constexpr uint32_t CFG_BOOT_STORAGE_WAIT_MS = 30000;           // WWW i MQTT czekają na SD max tyle
+
+// --- [NEW] Zegar SPI karty SD (sd_clock.cpp): negocjacja, spadek po błędach, /sd/bench ---
+constexpr uint32_t CFG_SD_CLOCK_BASE_HZ = 1000000;             // montaż startowy (jak dawniej)
+constexpr uint32_t CFG_SD_CLOCK_STEPS_HZ[] = {4000000, 10000000, 20000000, 40000000};
+constexpr size_t CFG_SD_CLOCK_TEST_BYTES = 16384;              // zapis + odczyt CRC na stopień
+constexpr uint32_t CFG_SD_LOCK_TIMEOUT_MS = 5000;              // [FIX] czekanie na kartę (montaż, pomiar, skan FAT) < WDT_TIMEOUT
+constexpr uint8_t CFG_SD_CLOCK_ERROR_LIMIT = 3;                // błędy I/O w oknie → stopień niżej
+constexpr unsigned long CFG_SD_CLOCK_ERROR_WINDOW_MS = 60000;
+constexpr size_t CFG_SD_BENCH_BYTES = 256UL * 1024UL;          // plik testu sekwencyjnego
+constexpr uint16_t CFG_SD_BENCH_RANDOM_READS = 128;            // odczyty 512 B w losowych miejscach
+
+// --- [NEW] Pojemność i zajętość karty SD z pamięci podręcznej (sd_stats.cpp) ---
+constexpr unsigned long CFG_SD_STATS_RESCAN_MS = 30UL * 60UL * 1000UL;  // pełny skan FAT co tyle
+constexpr uint64_t CFG_SD_STATS_DRIFT_BYTES = 8ULL * 1024ULL * 1024ULL; // zapisy + usunięcia → skan wcześniej
+constexpr unsigned long CFG_SD_STATS_MIN_GAP_MS = 5UL * 60UL * 1000UL;  // min. odstęp skanów z dryfu
+
 // ======================================================
 // 3. DEFINICJE TYPÓW I STRUKTUR
 // ======================================================
@@ -146,7 +324,8 @@ enum class ProcessState {
     PAUSE_USER,
     ERROR_PROFILE,
     SOFT_RESUME,
-    PAUSE_HEATER_FAULT
+    PAUSE_HEATER_FAULT,
+    AUTOTUNE            // [NEW] eksperyment przekaźnikowy (autotune.cpp)
 };
 
 enum class RunMode {
@@ -194,6 +373,27 @@ struct ProcessStats {
     unsigned long remainingProcessTimeSec;
 };
 
+// [NEW] Sprzęt jednej komory (chamber.h) – komora 0 to dotychczasowe piny
+struct ChamberHw {
+    uint8_t ssrPins[3];      // grzałki 1..3 w kolejności załączania (powerMode)
+    uint8_t smokePin;        // PWM dymu (LEDC)
+    uint8_t fanPin;          // wentylator obiegowy
+    uint8_t doorPin;         // krańcówka: komora 0 na przerwaniu (inputs.cpp), pozostałe odpytywane
+    int8_t chamberSensor;    // indeks DS18B20 komory, -1 = identyfikacja / NVS
+    int8_t meatSensor;       // indeks DS18B20 mięsa, -1 = identyfikacja / NVS
+};
+
+// --- [NEW] Liczba komór sterowanych z jednej płytki ---
+constexpr uint8_t CFG_CHAMBER_COUNT = 1;
+constexpr ChamberHw CFG_CHAMBER_HW[] = {
+    {{PIN_SSR1, PIN_SSR2, PIN_SSR3}, PIN_SMOKE_FAN, PIN_FAN, PIN_DOOR, -1, -1},
+    // Druga komora: wolne wyjścia (np. po zdjęciu czytnika SD) i czujniki 2, 3
+    // na tej samej magistrali OneWire:
+    // {{18, 19, 23}, 0, 3, 34, 2, 3},
+};
+static_assert(sizeof(CFG_CHAMBER_HW) / sizeof(CFG_CHAMBER_HW[0]) >= CFG_CHAMBER_COUNT,
+              "CFG_CHAMBER_HW: brak opisu sprzętu dla każdej komory");
+
 // ======================================================
 // 4. FUNKCJE POMOCNICZE
 // ======================================================
@@ -216,4 +416,4 @@ inline void log_msg(int level, const String& msg) {
         snprintf(_log_buf, sizeof(_log_buf), fmt, ##__VA_ARGS__); \
         log_msg(level, _log_buf); \
     } \
-} while(0)
\ No newline at end of file
+} while(0)
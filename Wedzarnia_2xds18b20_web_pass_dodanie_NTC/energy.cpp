@@ -0,0 +1,278 @@
+// energy.cpp - [NEW] Energia i koszt wsadu (opis w energy.h)
+#include "energy.h"
+#include "config.h"
+#include "state.h"
+#include "outputs.h"
+#include "ssr_tp.h"
+#include "storage.h"
+
+static constexpr uint16_t ENERGY_CONFIG_VERSION = 1;
+static constexpr float ENERGY_MAX_TARIFF = 100.0f;
+
+static EnergyConfig config = {
+    ENERGY_CONFIG_VERSION,
+    {CFG_ENERGY_HEATER_W, CFG_ENERGY_HEATER_W, CFG_ENERGY_HEATER_W},
+    CFG_ENERGY_FAN_W, CFG_ENERGY_SMOKE_W, CFG_ENERGY_TARIFF
+};
+static portMUX_TYPE configMux = portMUX_INITIALIZER_UNLOCKED;
+
+// ======================================================
+// LICZNIKI I PRZELICZENIE
+// ======================================================
+
+static EnergyCounters readCounters(const Chamber& c) {
+    EnergyCounters n;
+    for (uint8_t i = 0; i < 3; i++) n.heaterMs[i] = ssr_tp_on_ms(c.hw->ssrPins[i]);
+    n.fanMs = outputs_meter_on_ms(c.fanMeter);
+    n.smokeMs = outputs_meter_on_ms(c.smokeMeter);
+    return n;
+}
+
+static inline float msToWh(uint64_t ms, float watts) {
+    return (float)(ms / 3600000.0 * watts);
+}
+
+// Energia między migawkami a i b; części opcjonalnie
+static float energyWh(const EnergyCounters& a, const EnergyCounters& b, const EnergyConfig& cfg,
+                      EnergySummary* parts = nullptr) {
+    float total = 0;
+    for (uint8_t i = 0; i < 3; i++) {
+        float wh = msToWh(b.heaterMs[i] - a.heaterMs[i], cfg.heaterW[i]);
+        if (parts) parts->heaterWh[i] = wh;
+        total += wh;
+    }
+    float fan = msToWh(b.fanMs - a.fanMs, cfg.fanW);
+    float smoke = msToWh(b.smokeMs - a.smokeMs, cfg.smokeW);
+    if (parts) {
+        parts->fanWh = fan;
+        parts->smokeWh = smoke;
+    }
+    return total + fan + smoke;
+}
+
+// ======================================================
+// WSAD
+// ======================================================
+
+static bool batchState(ProcessState st) {
+    return st != ProcessState::IDLE && st != ProcessState::ERROR_PROFILE &&
+           st != ProcessState::AUTOTUNE;
+}
+
+// Rekord formatowany w takcie sterowania, zapis na SD w tasku Monitor
+static char pendingRecord[CFG_CHAMBER_COUNT][320];
+static bool pendingReady[CFG_CHAMBER_COUNT];
+static portMUX_TYPE recordMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void queueRecord(const Chamber& c, const EnergyMeter& e, int stepCount, const EnergyConfig& cfg) {
+    EnergySummary parts = {};
+    float wh = energyWh(e.atBatch, e.atEnd, cfg, &parts);
+
+    const char* profile = "-";
+    if (e.autoMode) {
+        profile = storage_get_profile_path(c.id);
+        const char* slash = strrchr(profile, '/');
+        if (slash) profile = slash + 1;
+    }
+
+    char line[sizeof(pendingRecord[0])];
+    int offset = snprintf(line, sizeof(line),
+        "%lu,%u,%s,%s,%lu,%.3f,%.2f,%.3f,%.3f,%.3f,%.3f,%.3f,",
+        e.endMs / 1000, (unsigned)c.id + 1, e.autoMode ? "AUTO" : "MANUAL", profile,
+        (e.endMs - e.batchStart) / 1000, wh / 1000.0f, wh / 1000.0f * cfg.tariff,
+        parts.heaterWh[0] / 1000.0f, parts.heaterWh[1] / 1000.0f, parts.heaterWh[2] / 1000.0f,
+        parts.fanWh / 1000.0f, parts.smokeWh / 1000.0f);
+    for (int i = 0; e.autoMode && i < stepCount && i < MAX_STEPS; i++) {
+        offset += snprintf(line + offset, sizeof(line) - offset, "%s%.3f",
+                           i ? ";" : "", e.stepWh[i] / 1000.0f);
+    }
+    snprintf(line + offset, sizeof(line) - offset, "\n");
+
+    portENTER_CRITICAL(&recordMux);
+    memcpy(pendingRecord[c.id], line, sizeof(line));
+    pendingReady[c.id] = true;
+    portEXIT_CRITICAL(&recordMux);
+}
+
+void energy_write_records() {
+    for (uint8_t i = 0; i < CFG_CHAMBER_COUNT; i++) {
+        portENTER_CRITICAL(&recordMux);
+        bool ready = pendingReady[i];
+        portEXIT_CRITICAL(&recordMux);
+        if (!ready) continue;
+        // [FIX] Sprawdzenie nagłówka i dopisanie jako jedna sekcja karty; w
+        // trakcie montażu / zmiany zegara rekord czeka na następny obieg
+        if (!hal_fs_lock(CFG_SD_LOCK_TIMEOUT_MS)) return;
+
+        char line[sizeof(pendingRecord[0])];
+        portENTER_CRITICAL(&recordMux);
+        memcpy(line, pendingRecord[i], sizeof(line));
+        pendingReady[i] = false;
+        portEXIT_CRITICAL(&recordMux);
+
+        bool header = !hal_fs_exists(CFG_ENERGY_RECORD_PATH);
+        hal_file_t f = hal_fs_open(CFG_ENERGY_RECORD_PATH, HalFileMode::APPEND);
+        if (f < 0) {
+            hal_fs_unlock();
+            log_msg(LOG_LEVEL_WARN, "Energy: batch record not written (SD)");
+            continue;
+        }
+        if (header) {
+            const char* h = "uptime_s,chamber,mode,profile,duration_s,kwh,cost,"
+                            "heater1_kwh,heater2_kwh,heater3_kwh,fan_kwh,smoke_kwh,steps_kwh\n";
+            hal_fs_write(f, h, strlen(h));
+        }
+        hal_fs_write(f, line, strlen(line));
+        hal_fs_close(f);
+        hal_fs_unlock();
+    }
+}
+
+void energy_update(Chamber& c, unsigned long now) {
+    EnergyMeter& e = c.energy;
+    if (e.lastSampleMs != 0 && now - e.lastSampleMs < 1000) return;
+    e.lastSampleMs = now;
+
+    // Granice wsadu / kroku ze stanu; liczniki czytane tylko na granicy
+    if (!state_lock()) return;
+    ProcessState st = c.currentState;
+    bool autoMode = c.lastRunMode == RunMode::MODE_AUTO;
+    int step = c.currentStep;
+    int stepCount = c.stepCount;
+    unsigned long start = c.processStartTime;
+    bool inBatch = batchState(st) && !(autoMode && stepCount > 0 && step >= stepCount);
+    bool begin = inBatch && (!e.active || e.batchStart != start);
+    bool stepChange = inBatch && !begin && e.autoMode && step != e.step;
+    bool end = e.active && (!inBatch || e.batchStart != start);   // nowy start bez stopu też zamyka
+    state_unlock();
+    if (!begin && !stepChange && !end) return;
+
+    EnergyCounters counters = readCounters(c);
+    EnergyConfig cfg = energy_get_config();
+    EnergyMeter record;
+
+    if (!state_lock()) return;
+    if (stepChange || end) {
+        if (e.autoMode && e.step >= 0 && e.step < MAX_STEPS) {
+            e.stepWh[e.step] += energyWh(e.atStep, counters, cfg);
+        }
+        e.atStep = counters;
+        e.step = step;
+    }
+    if (end) {
+        e.atEnd = counters;
+        e.endMs = now;
+        e.active = false;
+        record = e;
+    }
+    if (begin) {
+        e = EnergyMeter();
+        e.lastSampleMs = now;
+        e.batchStart = start;
+        e.active = true;
+        e.autoMode = autoMode;
+        e.step = autoMode ? step : -1;
+        e.atBatch = e.atStep = counters;
+    }
+    state_unlock();
+
+    if (end) {
+        float kwh = energyWh(record.atBatch, record.atEnd, cfg) / 1000.0f;
+        LOG_FMT(LOG_LEVEL_INFO, "Energy K%u: batch %.2f kWh, cost %.2f",
+                (unsigned)c.id + 1, kwh, kwh * cfg.tariff);
+        queueRecord(c, record, stepCount, cfg);
+    }
+}
+
+EnergySummary energy_summary(uint8_t chamberIdx) {
+    const Chamber& c = chamber_get(chamberIdx);
+    EnergySummary s = {};
+    s.step = -1;
+    if (!state_lock()) return s;
+    EnergyMeter e = c.energy;
+    state_unlock();
+    if (!e.active && e.endMs == 0) return s;
+
+    EnergyConfig cfg = energy_get_config();
+    EnergyCounters last = e.active ? readCounters(c) : e.atEnd;
+    s.valid = true;
+    s.active = e.active;
+    s.batchWh = energyWh(e.atBatch, last, cfg, &s);
+    s.cost = s.batchWh / 1000.0f * cfg.tariff;
+    if (e.active && e.autoMode) {
+        s.step = e.step;
+        s.stepWh = energyWh(e.atStep, last, cfg);
+    }
+    s.durationSec = ((e.active ? millis() : e.endMs) - e.batchStart) / 1000;
+    return s;
+}
+
+// ======================================================
+// NASTAWY
+// ======================================================
+
+static bool configValid(const EnergyConfig& cfg) {
+    auto okW = [](float w) { return w >= 0 && w <= CFG_ENERGY_MAX_W; };   // NaN = false
+    return okW(cfg.heaterW[0]) && okW(cfg.heaterW[1]) && okW(cfg.heaterW[2]) &&
+           okW(cfg.fanW) && okW(cfg.smokeW) &&
+           cfg.tariff >= 0 && cfg.tariff <= ENERGY_MAX_TARIFF;
+}
+
+EnergyConfig energy_get_config() {
+    portENTER_CRITICAL(&configMux);
+    EnergyConfig cfg = config;
+    portEXIT_CRITICAL(&configMux);
+    return cfg;
+}
+
+bool energy_set_config(const EnergyConfig& cfg) {
+    if (!configValid(cfg)) return false;
+    portENTER_CRITICAL(&configMux);
+    config = cfg;
+    config.version = ENERGY_CONFIG_VERSION;
+    portEXIT_CRITICAL(&configMux);
+    storage_save_energy_config_nvs();
+    LOG_FMT(LOG_LEVEL_INFO, "Energy config: heaters %.0f/%.0f/%.0f W, fan %.0f W, smoke %.0f W, tariff %.2f",
+            cfg.heaterW[0], cfg.heaterW[1], cfg.heaterW[2], cfg.fanW, cfg.smokeW, cfg.tariff);
+    return true;
+}
+
+bool energy_config_restore(const EnergyConfig& cfg) {
+    if (cfg.version != ENERGY_CONFIG_VERSION || !configValid(cfg)) return false;
+    portENTER_CRITICAL(&configMux);
+    config = cfg;
+    portEXIT_CRITICAL(&configMux);
+    return true;
+}
+
+String energy_json(uint8_t chamberIdx) {
+    const Chamber& c = chamber_get(chamberIdx);
+    EnergySummary s = energy_summary(chamberIdx);
+    EnergyConfig cfg = energy_get_config();
+    float stepWh[MAX_STEPS];
+    int stepCount = 0;
+    if (state_lock()) {
+        memcpy(stepWh, c.energy.stepWh, sizeof(stepWh));
+        stepCount = c.energy.autoMode ? min(c.stepCount, MAX_STEPS) : 0;
+        state_unlock();
+    }
+    if (s.active && s.step >= 0 && s.step < MAX_STEPS) stepWh[s.step] += s.stepWh;
+
+    char json[768];
+    int offset = snprintf(json, sizeof(json),
+        "{\"chamber\":%u,\"valid\":%s,\"active\":%s,\"durationSec\":%lu,"
+        "\"kWh\":%.3f,\"cost\":%.2f,\"step\":%d,\"stepKWh\":%.3f,"
+        "\"heaterKWh\":[%.3f,%.3f,%.3f],\"fanKWh\":%.3f,\"smokeKWh\":%.3f,\"steps\":[",
+        (unsigned)c.id, s.valid ? "true" : "false", s.active ? "true" : "false", s.durationSec,
+        s.batchWh / 1000.0f, s.cost, s.step, s.stepWh / 1000.0f,
+        s.heaterWh[0] / 1000.0f, s.heaterWh[1] / 1000.0f, s.heaterWh[2] / 1000.0f,
+        s.fanWh / 1000.0f, s.smokeWh / 1000.0f);
+    for (int i = 0; s.valid && i < stepCount; i++) {
+        offset += snprintf(json + offset, sizeof(json) - offset, "%s%.3f",
+                           i ? "," : "", stepWh[i] / 1000.0f);
+    }
+    snprintf(json + offset, sizeof(json) - offset,
+        "],\"config\":{\"heaterW\":[%.0f,%.0f,%.0f],\"fanW\":%.0f,\"smokeW\":%.0f,\"tariff\":%.2f}}",
+        cfg.heaterW[0], cfg.heaterW[1], cfg.heaterW[2], cfg.fanW, cfg.smokeW, cfg.tariff);
+    return String(json);
+}
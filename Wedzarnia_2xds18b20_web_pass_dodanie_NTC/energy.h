@@ -0,0 +1,51 @@
+// energy.h - [NEW] Energia i koszt wsadu z czasu ON wyjść
+// Grzałki: półokresy ON z ssr_tp (ISR), wentylator i dym: czas ON ważony
+// wypełnieniem liczony przy zmianie wyjścia (outputs.cpp) – pętla
+// sterowania nie liczy nic co takt. Wh = czas ON x moc z EnergyConfig (NVS).
+//
+// Wsad = od processStartTime do stopu (IDLE) albo końca profilu. Migawki
+// liczników na starcie wsadu i każdego kroku AUTO; koniec wsadu dopisuje
+// wiersz do CFG_ENERGY_RECORD_PATH (zapis w tasku Monitor):
+//   uptime_s,komora,tryb,profil,czas_s,kWh,koszt,grzalka1..3_kWh,went_kWh,dym_kWh,kroki_kWh(;)
+// Wynik ostatniego wsadu zostaje w /status i na TFT do startu następnego.
+#pragma once
+#include "chamber.h"
+#include "hal.h"
+
+struct EnergyConfig {
+    uint16_t version;
+    float heaterW[3];                 // kolejność ssrPins (wspólne dla komór)
+    float fanW;
+    float smokeW;                     // przy pełnym PWM
+    float tariff;                     // zł / kWh
+};
+
+struct EnergySummary {
+    bool active;                      // wsad trwa
+    bool valid;                       // był jakiś wsad od startu
+    int step;                         // bieżący krok AUTO, -1 = brak
+    float batchWh;
+    float stepWh;                     // bieżący krok
+    float cost;
+    float heaterWh[3];
+    float fanWh;
+    float smokeWh;
+    unsigned long durationSec;
+};
+
+// Co takt z chamber_run_control_logic – próbka 1 s: start/krok/koniec wsadu
+void energy_update(Chamber& c, unsigned long now);
+
+// Task Monitor: dopisanie rekordów zakończonych wsadów na SD
+void energy_write_records();
+
+EnergySummary energy_summary(uint8_t chamberIdx);
+
+EnergyConfig energy_get_config();
+// false = moce / taryfa poza zakresem; zapis do NVS przez cache
+bool energy_set_config(const EnergyConfig& cfg);
+// Z NVS (setup); false = zła wersja lub wartości
+bool energy_config_restore(const EnergyConfig& cfg);
+
+// GET /api/energy – nastawy, bieżący / ostatni wsad i energia kroków
+String energy_json(uint8_t chamberIdx);
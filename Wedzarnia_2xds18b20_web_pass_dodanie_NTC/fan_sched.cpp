@@ -0,0 +1,150 @@
+// fan_sched.cpp - [NEW] Harmonogram wentylatora (opis w fan_sched.h)
+#include "fan_sched.h"
+#include "config.h"
+#include "state.h"
+
+static bool schedEnabled = CFG_FAN_SCHED;
+
+// ======================================================
+// TREND
+// ======================================================
+
+static void addSample(FanSched& f, unsigned long ms, double t) {
+    // Przerwa w odczytach (błąd czujnika) – trend od nowa
+    if (f.fill > 0 && ms - f.lastSampleMs > 5 * TEMP_REQUEST_INTERVAL) f.fill = 0;
+    f.sampleT[f.head] = (float)t;
+    f.sampleMs[f.head] = ms;
+    f.head = (f.head + 1) % CFG_FAN_TREND_SAMPLES;
+    if (f.fill < CFG_FAN_TREND_SAMPLES) f.fill++;
+    f.lastSampleMs = ms;
+
+    // Najmniejsze kwadraty, czas względem najnowszej próbki (bez utraty precyzji)
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (uint8_t i = 0; i < f.fill; i++) {
+        double x = -(double)(ms - f.sampleMs[i]) / 60000.0;
+        double y = f.sampleT[i];
+        sx += x; sy += y; sxx += x * x; sxy += x * y;
+    }
+    uint8_t oldest = (f.head + CFG_FAN_TREND_SAMPLES - f.fill) % CFG_FAN_TREND_SAMPLES;
+    double den = f.fill * sxx - sx * sx;
+    f.slopeValid = f.fill >= 4 && ms - f.sampleMs[oldest] >= CFG_FAN_TREND_MIN_SPAN_MS && den > 0;
+    f.slope = f.slopeValid ? (f.fill * sxy - sx * sy) / den : 0;
+}
+
+// ======================================================
+// UDZIAŁ ON
+// ======================================================
+
+static double targetDuty(const FanSched& f, double baseDuty, double heat, double t, double tSet) {
+    double need = heat;
+    if (f.slopeValid) {
+        need = max(need, f.slope / CFG_FAN_TREND_FULL);
+        double predicted = t + f.slope * CFG_FAN_HORIZON_S / 60.0;
+        need = max(need, (predicted - tSet) / CFG_FAN_OVERSHOOT_BAND_C);
+    }
+    need = constrain(need, 0.0, 1.0);
+    return baseDuty * (CFG_FAN_SCALE_MIN + (CFG_FAN_SCALE_MAX - CFG_FAN_SCALE_MIN) * need);
+}
+
+// Udział → czasy w okresie kroku, ograniczenia jak dawniej (ON >= 5 s, OFF 10..120 s)
+static void applyDuty(FanSched& f) {
+    unsigned long period = f.baseOnMs + f.baseOffMs;
+    unsigned long on = (unsigned long)(period * f.duty + 0.5);
+    unsigned long maxOn = period > CFG_FAN_MIN_OFF_MS + CFG_FAN_MIN_ON_MS
+                        ? period - CFG_FAN_MIN_OFF_MS : CFG_FAN_MIN_ON_MS;
+    on = constrain(on, CFG_FAN_MIN_ON_MS, maxOn);
+    unsigned long off = period > on ? period - on : 0;
+    f.onMs = on;
+    f.offMs = constrain(off, CFG_FAN_MIN_OFF_MS, CFG_FAN_MAX_OFF_MS);
+}
+
+void fan_sched_update(Chamber& c, unsigned long now) {
+    FanSched& f = c.fan;
+    if (!state_lock()) return;
+    int fm = c.fanMode;
+    unsigned long baseOn = c.fanOnTime;
+    unsigned long baseOff = c.fanOffTime;
+    int pm = c.powerMode;
+    double t = c.tChamber;
+    double tSet = c.tSet;
+    unsigned long sampleMs = c.tChamberMs;
+    state_unlock();
+
+    // Tylko nowy odczyt czujnika jest próbką trendu
+    if (sampleMs != 0 && sampleMs != f.lastSampleMs) addSample(f, sampleMs, t);
+
+    if (!schedEnabled || fm != 2) {
+        if (f.active && state_lock()) {
+            f.active = false;
+            state_unlock();
+        }
+        return;
+    }
+
+    // Start, nowe czasy kroku lub powrót po przerwie (pauza, IDLE) – od cyklu kroku
+    FanSched next = f;
+    if (!f.active || baseOn != f.baseOnMs || baseOff != f.baseOffMs ||
+        now - f.lastAdaptMs > 3 * CFG_FAN_ADAPT_MS) {
+        next.baseOnMs = baseOn;
+        next.baseOffMs = baseOff;
+        next.duty = next.target = (double)baseOn / (baseOn + baseOff);
+        next.lastAdaptMs = now;
+        next.active = true;
+    } else if (now - f.lastAdaptMs >= CFG_FAN_ADAPT_MS) {
+        double baseDuty = (double)baseOn / (baseOn + baseOff);
+        double heat = constrain(c.pidOutput, 0.0, 100.0) / 100.0 * pm / 3.0;   // % wszystkich grzałek
+        next.target = targetDuty(f, baseDuty, heat, t, tSet);
+        next.duty += constrain(next.target - f.duty, -CFG_FAN_DUTY_STEP, CFG_FAN_DUTY_STEP);
+        next.lastAdaptMs = now;
+    } else {
+        return;
+    }
+    applyDuty(next);
+
+    if (!state_lock()) return;
+    f.baseOnMs = next.baseOnMs;
+    f.baseOffMs = next.baseOffMs;
+    f.duty = next.duty;
+    f.target = next.target;
+    f.lastAdaptMs = next.lastAdaptMs;
+    f.active = next.active;
+    f.onMs = next.onMs;
+    f.offMs = next.offMs;
+    state_unlock();
+}
+
+void fan_sched_times(const Chamber& c, unsigned long& onMs, unsigned long& offMs) {
+    if (c.fan.active) {
+        onMs = c.fan.onMs;
+        offMs = c.fan.offMs;
+    } else {
+        onMs = c.fanOnTime;
+        offMs = c.fanOffTime;
+    }
+}
+
+void fan_sched_set_enabled(bool enabled) {
+    schedEnabled = enabled;
+}
+
+String fan_sched_json(uint8_t chamberIdx) {
+    const Chamber& c = chamber_get(chamberIdx);
+    if (!state_lock()) return String("{}");
+    FanSched f = c.fan;
+    int fm = c.fanMode;
+    unsigned long onMs, offMs;
+    fan_sched_times(c, onMs, offMs);
+    state_unlock();
+
+    char json[320];
+    snprintf(json, sizeof(json),
+        "{\"chamber\":%u,\"enabled\":%s,\"mode\":%d,\"active\":%s,"
+        "\"trendValid\":%s,\"trendCPerMin\":%.2f,\"samples\":%u,"
+        "\"baseOnSec\":%.0f,\"baseOffSec\":%.0f,\"duty\":%.3f,\"target\":%.3f,"
+        "\"onSec\":%.1f,\"offSec\":%.1f}",
+        (unsigned)c.id, schedEnabled ? "true" : "false", fm, f.active ? "true" : "false",
+        f.slopeValid ? "true" : "false", f.slope, (unsigned)f.fill,
+        f.baseOnMs / 1000.0, f.baseOffMs / 1000.0, f.duty, f.target,
+        onMs / 1000.0, offMs / 1000.0);
+    return String(json);
+}
@@ -0,0 +1,31 @@
+// fan_sched.h - [NEW] Harmonogram wentylatora w trybie cyklicznym (fanMode 2)
+// Zastępuje predictiveFanControl(): tamten liczył trend z 5 próbek co takt
+// 100 ms (czujnik zmienia się co 1.2 s) i mnożył czasy x1.5 / x0.7 w każdym
+// takcie – po kilku taktach czasy stały na ograniczeniach.
+//
+// Trend: regresja liniowa ostatnich CFG_FAN_TREND_SAMPLES odczytów komory
+// na ich rzeczywistych znacznikach czasu (tChamberMs), C/min.
+//
+// Udział ON w cyklu kroku (fanOnTime + fanOffTime = okres bez zmian):
+//   zapotrzebowanie = max(moc grzałek [% wszystkich], wzrost / CFG_FAN_TREND_FULL,
+//                         przewidywany przestrzał za CFG_FAN_HORIZON_S)
+//   cel = udział kroku x (CFG_FAN_SCALE_MIN .. CFG_FAN_SCALE_MAX)
+// Mieszanie potrzebne jest tam, gdzie grzałki oddają ciepło – przy niskiej
+// mocy i spadku temperatury wentylator chodzi krócej (mniej energii, wolniejsze
+// stygnięcie). Udział zbliża się do celu o max CFG_FAN_DUTY_STEP co
+// CFG_FAN_ADAPT_MS; zmiana czasów kroku (profil, UI, web) = start od nowa.
+#pragma once
+#include "chamber.h"
+#include "hal.h"
+
+// Z handleAutoMode / handleManualMode przed handleFanLogic()
+void fan_sched_update(Chamber& c, unsigned long now);
+
+// Czasy cyklu dla handleFanLogic() – wynik harmonogramu lub czasy kroku
+void fan_sched_times(const Chamber& c, unsigned long& onMs, unsigned long& offMs);
+
+// Harmonogram wł./wył. w czasie pracy (replay --no-fan-sched)
+void fan_sched_set_enabled(bool enabled);
+
+// Trend, udział ON i czasy cyklu dla /api/fan
+String fan_sched_json(uint8_t chamberIdx);
@@ -0,0 +1,314 @@
+// fopdt.cpp - [NEW] Model komory FOPDT, feed-forward i predyktor Smitha (opis w fopdt.h)
+#include "fopdt.h"
+#include "config.h"
+#include "state.h"
+#include "ssr_tp.h"
+#include "energy.h"
+#include "heater_diag.h"
+#include "sensor_failover.h"
+
+// Regresory skalowane do ~1 – lepsze uwarunkowanie RLS
+static constexpr double FOPDT_T_REF = 50.0;
+static constexpr double FOPDT_T_SCALE = 50.0;
+static constexpr double FOPDT_U_SCALE = 100.0;
+static constexpr double FOPDT_P_INIT = 100.0;
+static constexpr double FOPDT_P_TRACE_MAX = 1000.0;       // bez pobudzenia – zapominanie wstrzymane
+static constexpr double FOPDT_ERR_ALPHA = 0.02;           // EWMA błędu ~50 okien
+// Pobudzenie: bez zmian T i mocy (utrzymanie setpointu) regresory są
+// współliniowe – RLS dryfuje po prostej T-u i psuje K/otoczenie
+static constexpr double FOPDT_EXCITE_DT_C = 0.02;         // zmiana T między oknami
+static constexpr double FOPDT_EXCITE_DU = 5.0;            // zmiana mocy między oknami (%)
+static constexpr double FOPDT_SWITCH_RATIO = 0.7;         // zmiana kandydata: błąd^2 < 0.7 x obecny
+// Historia mocy: okno między środkami okien przesunięte o największe L
+static constexpr int FOPDT_UHIST_NEEDED =
+    CFG_FOPDT_WINDOW_S / 2 + CFG_FOPDT_DELAY_S[CFG_FOPDT_DELAY_COUNT - 1] + CFG_FOPDT_WINDOW_S;
+
+// Granice fizyczne – poza nimi model nieważny
+static constexpr double FOPDT_TAU_MIN_S = 60.0;
+static constexpr double FOPDT_TAU_MAX_S = 20000.0;
+static constexpr double FOPDT_K_MIN = 0.05;
+static constexpr double FOPDT_K_MAX = 20.0;
+static constexpr double FOPDT_AMBIENT_MIN = -20.0;
+static constexpr double FOPDT_AMBIENT_MAX = 50.0;
+
+static_assert(FOPDT_UHIST_NEEDED < 255, "CFG_FOPDT_DELAY_S: historia mocy (uHist) za krótka");
+
+static bool controlEnabled = CFG_FOPDT_CONTROL;
+
+static bool heatingState(ProcessState st) {
+    return st == ProcessState::RUNNING_AUTO || st == ProcessState::RUNNING_MANUAL ||
+           st == ProcessState::SOFT_RESUME || st == ProcessState::AUTOTUNE;
+}
+
+// [NEW] Moc zadana grzałek (% wszystkich, ważona mocami z energy.cpp) –
+// faktyczne wypełnienia SSR: miękki start, drzwi i próby kanałów heater_diag
+static double heaterPowerPct(const Chamber& c) {
+    EnergyConfig cfg = energy_get_config();
+    double sum = 0, total = 0;
+    for (uint8_t i = 0; i < 3; i++) total += cfg.heaterW[i];
+    for (uint8_t i = 0; i < 3; i++) {
+        double w = total > 0 ? cfg.heaterW[i] / total : 1.0 / 3.0;
+        sum += ssr_tp_duty(c.hw->ssrPins[i]) / 255.0 * w;
+    }
+    return constrain(sum * 100.0, 0.0, 100.0);
+}
+
+// Moc sprzed secondsAgo s (0 = ostatnia próbka)
+static double uAgo(const FopdtModel& m, int secondsAgo) {
+    return m.uHist[(uint8_t)(m.uHead - 1 - secondsAgo)];
+}
+
+static void rlsReset(FopdtRls& r) {
+    for (int i = 0; i < 3; i++) {
+        r.theta[i] = 0;
+        for (int j = 0; j < 3; j++) r.P[i][j] = (i == j) ? FOPDT_P_INIT : 0;
+    }
+    r.errEwma = 1.0;
+}
+
+static void rlsUpdate(FopdtRls& r, const double phi[3], double y) {
+    double e = y - (r.theta[0] * phi[0] + r.theta[1] * phi[1] + r.theta[2] * phi[2]);
+
+    double Pphi[3];
+    for (int i = 0; i < 3; i++) {
+        Pphi[i] = r.P[i][0] * phi[0] + r.P[i][1] * phi[1] + r.P[i][2] * phi[2];
+    }
+    double trace = r.P[0][0] + r.P[1][1] + r.P[2][2];
+    double lambda = (trace < FOPDT_P_TRACE_MAX) ? CFG_FOPDT_FORGET : 1.0;
+    double den = lambda + phi[0] * Pphi[0] + phi[1] * Pphi[1] + phi[2] * Pphi[2];
+
+    for (int i = 0; i < 3; i++) r.theta[i] += Pphi[i] / den * e;
+    // P symetryczne: P - Pphi*Pphi'/den
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            r.P[i][j] = (r.P[i][j] - Pphi[i] * Pphi[j] / den) / lambda;
+        }
+    }
+    r.errEwma += FOPDT_ERR_ALPHA * (e * e - r.errEwma);
+}
+
+struct FopdtParams {
+    double th1, th2, th3;
+    double gainK, tauS, ambient;
+};
+
+// Parametry fizyczne kandydata; false = poza granicami (zły kierunek, dryf)
+static bool candidateParams(const FopdtRls& r, FopdtParams& p) {
+    p.th1 = r.theta[0] / FOPDT_T_SCALE;
+    p.th2 = r.theta[1] / FOPDT_U_SCALE;
+    p.th3 = r.theta[2] - r.theta[0] * FOPDT_T_REF / FOPDT_T_SCALE;
+    if (p.th1 >= 0) return false;
+    p.gainK = -p.th2 / p.th1;
+    p.tauS = -CFG_FOPDT_WINDOW_S / p.th1;
+    p.ambient = -p.th3 / p.th1;
+    return p.gainK >= FOPDT_K_MIN && p.gainK <= FOPDT_K_MAX &&
+           p.tauS >= FOPDT_TAU_MIN_S && p.tauS <= FOPDT_TAU_MAX_S &&
+           p.ambient >= FOPDT_AMBIENT_MIN && p.ambient <= FOPDT_AMBIENT_MAX;
+}
+
+// Wybór kandydata (tylko fizycznie sensowne, z histerezą); true = ważność się zmieniła
+static bool selectModel(FopdtModel& m, double temp) {
+    FopdtParams params[CFG_FOPDT_DELAY_COUNT];
+    int best = -1;
+    for (int i = 0; i < CFG_FOPDT_DELAY_COUNT; i++) {
+        if (!candidateParams(m.rls[i], params[i])) continue;
+        if (best < 0 || m.rls[i].errEwma < m.rls[best].errEwma) best = i;
+    }
+    // Kandydaci o zbliżonym błędzie zamieniają się w czasie skoku – zmiana
+    // dopiero przy wyraźnie mniejszym błędzie
+    if (best >= 0 && m.best >= 0 && best != m.best &&
+        candidateParams(m.rls[m.best], params[m.best]) &&
+        m.rls[best].errEwma > FOPDT_SWITCH_RATIO * m.rls[m.best].errEwma) {
+        best = m.best;
+    }
+
+    bool valid = best >= 0 && m.windows >= CFG_FOPDT_MIN_WINDOWS &&
+                 sqrt(m.rls[best].errEwma) <= CFG_FOPDT_MAX_RMS_C;
+    bool changed = (valid != m.valid);
+    // Nowy model – predyktor od bieżącej temperatury (korekta 0)
+    if (valid && changed) {
+        m.xm = temp;
+        for (int i = 0; i < 256; i++) m.xmHist[i] = temp;
+        m.correction = 0;
+    }
+    m.valid = valid;
+    if (best >= 0) m.best = best;
+    if (valid) {
+        const FopdtParams& p = params[best];
+        m.th1 = p.th1;
+        m.th2 = p.th2;
+        m.th3 = p.th3;
+        m.gainK = p.gainK;
+        m.tauS = p.tauS;
+        m.ambient = p.ambient;
+    }
+    return changed;
+}
+
+static void processWindow(FopdtModel& m, double mean, bool learn) {
+    double uWin = 0;
+    for (int j = 0; j < CFG_FOPDT_WINDOW_S; j++) uWin += uAgo(m, j);
+    uWin /= CFG_FOPDT_WINDOW_S;
+
+    double dy = mean - m.lastWinMean;
+    // [NEW] Residuum a priori (model sprzed tego okna) – heater_diag.cpp
+    if (m.valid && m.haveWin && m.uFill >= FOPDT_UHIST_NEEDED) {
+        double uSum = 0;
+        for (int j = 0; j < CFG_FOPDT_WINDOW_S; j++) {
+            uSum += uAgo(m, CFG_FOPDT_WINDOW_S / 2 + CFG_FOPDT_DELAY_S[m.best] + j);
+        }
+        m.residualU = uSum / CFG_FOPDT_WINDOW_S;
+        m.residual = dy - (m.th1 * m.lastWinMean + m.th2 * m.residualU + m.th3);
+        m.residualSeq++;
+    }
+    if (m.haveWin && (fabs(dy) >= FOPDT_EXCITE_DT_C || fabs(uWin - m.lastWinU) >= FOPDT_EXCITE_DU)) {
+        // Skutek zmiany mocy widać dopiero po największym L
+        m.exciteLeft = CFG_FOPDT_DELAY_S[CFG_FOPDT_DELAY_COUNT - 1] / CFG_FOPDT_WINDOW_S + 1;
+    }
+    m.lastWinU = uWin;
+
+    if (learn && m.haveWin && m.uFill >= FOPDT_UHIST_NEEDED && m.exciteLeft > 0) {
+        m.exciteLeft--;
+        // Moc między środkami okien (15..5 s temu), przesunięta o L
+        for (int i = 0; i < CFG_FOPDT_DELAY_COUNT; i++) {
+            double uSum = 0;
+            for (int j = 0; j < CFG_FOPDT_WINDOW_S; j++) {
+                uSum += uAgo(m, CFG_FOPDT_WINDOW_S / 2 + CFG_FOPDT_DELAY_S[i] + j);
+            }
+            double phi[3] = {(m.lastWinMean - FOPDT_T_REF) / FOPDT_T_SCALE,
+                             uSum / CFG_FOPDT_WINDOW_S / FOPDT_U_SCALE, 1.0};
+            rlsUpdate(m.rls[i], phi, dy);
+        }
+        m.windows++;
+    }
+    m.lastWinMean = mean;
+    m.haveWin = true;
+}
+
+void fopdt_update(Chamber& c, unsigned long now) {
+    FopdtModel& m = c.model;
+    if (m.lastSampleMs != 0 && now - m.lastSampleMs < 1000) return;
+    if (m.lastSampleMs == 0) {
+        for (int i = 0; i < CFG_FOPDT_DELAY_COUNT; i++) rlsReset(m.rls[i]);
+    }
+    m.lastSampleMs = now;
+
+    bool changed = false;
+    if (!state_lock()) return;
+    double temp = c.tChamber;
+    double u = heatingState(c.currentState) ? heaterPowerPct(c) : 0;
+    bool door = c.doorOpen;
+    bool hold = heater_diag_hold_model(c) || sensor_failover_active(c);
+
+    if (m.valid) {
+        // Euler co 1 s (tau >> 1 s); model z opóźnieniem = historia xm sprzed L
+        m.xm += (m.th1 * m.xm + m.th2 * u + m.th3) / CFG_FOPDT_WINDOW_S;
+        m.xmHist[m.uHead] = (float)m.xm;
+        double xDelayed = m.xmHist[(uint8_t)(m.uHead - CFG_FOPDT_DELAY_S[m.best])];
+        m.correction = constrain(m.xm - xDelayed, -CFG_FOPDT_SMITH_MAX_C, CFG_FOPDT_SMITH_MAX_C);
+    }
+    m.uHist[m.uHead++] = (uint8_t)(u + 0.5);
+    if (m.uFill < 255) m.uFill++;
+
+    if (door) {
+        // Otwarte drzwi = inne straty – okno i różnica do następnego odrzucone
+        m.winSum = 0;
+        m.winCount = 0;
+        m.haveWin = false;
+    } else {
+        m.winSum += temp;
+        if (++m.winCount >= CFG_FOPDT_WINDOW_S) {
+            processWindow(m, m.winSum / m.winCount, !hold);
+            m.winSum = 0;
+            m.winCount = 0;
+            changed = selectModel(m, temp);
+        }
+    }
+    bool valid = m.valid;
+    double gainK = m.gainK, tauS = m.tauS, ambient = m.ambient;
+    int deadS = CFG_FOPDT_DELAY_S[m.best < 0 ? 0 : m.best];
+    state_unlock();
+
+    if (changed && valid) {
+        LOG_FMT(LOG_LEVEL_INFO, "Model K%u: K=%.2f C/%% tau=%.0f s L=%d s Ta=%.1f C",
+                (unsigned)c.id, gainK, tauS, deadS, ambient);
+    } else if (changed) {
+        LOG_FMT(LOG_LEVEL_INFO, "Model K%u invalid - plain PID", (unsigned)c.id);
+    }
+}
+
+// [NEW] Krok 1 s modelu z opóźnioną mocą – estymata komory bez czujnika
+bool fopdt_estimate_step(const Chamber& c, double& t) {
+    const FopdtModel& m = c.model;
+    if (!m.valid || m.uFill < FOPDT_UHIST_NEEDED) return false;
+    double u = uAgo(m, CFG_FOPDT_DELAY_S[m.best]);
+    t += (m.th1 * t + m.th2 * u + m.th3) / CFG_FOPDT_WINDOW_S;
+    return true;
+}
+
+double fopdt_hold_output(const Chamber& c, double tSet, int powerMode) {
+    const FopdtModel& m = c.model;
+    if (!m.valid || m.gainK <= 0 || powerMode <= 0) return -1;
+    return constrain((tSet - m.ambient) / m.gainK * 3.0 / powerMode, 0.0, 100.0);
+}
+
+void fopdt_prepare_pid(Chamber& c) {
+    FopdtModel& m = c.model;
+    if (!controlEnabled || !m.valid) {
+        if (m.ffActive) {
+            c.pid.SetFeedForward(0, true);
+            c.pid.ClearIntegralLimits();
+            m.ffActive = false;
+        }
+        m.ff = 0;
+        return;
+    }
+
+    if (!state_lock()) return;
+    int pm = c.powerMode;
+    state_unlock();
+
+    // Moc utrzymania setpointu: % wszystkich grzałek → % wyjścia w trybie pm
+    double ffTotal = (c.pidSetpoint - m.ambient) / m.gainK;
+    m.ff = constrain(ffTotal * 3.0 / pm, 0.0, 100.0);
+    if (!m.ffActive) {
+        c.pid.SetIntegralLimits(-CFG_FOPDT_INTEGRAL_RANGE, CFG_FOPDT_INTEGRAL_RANGE);
+    }
+    c.pid.SetFeedForward(m.ff, !m.ffActive);
+    m.ffActive = true;
+
+    c.pidInput += m.correction;
+}
+
+void fopdt_set_control(bool enabled) {
+    controlEnabled = enabled;
+}
+
+String fopdt_json(uint8_t chamberIdx) {
+    const Chamber& c = chamber_get(chamberIdx);
+    if (!state_lock()) return String("{}");
+    const FopdtModel& m = c.model;
+    bool valid = m.valid;
+    uint32_t windows = m.windows;
+    int best = m.best;
+    double gainK = m.gainK, tauS = m.tauS, ambient = m.ambient;
+    double correction = m.correction, ff = m.ff;
+    double rms[CFG_FOPDT_DELAY_COUNT];
+    for (int i = 0; i < CFG_FOPDT_DELAY_COUNT; i++) rms[i] = sqrt(m.rls[i].errEwma);
+    state_unlock();
+
+    char json[512];
+    int offset = snprintf(json, sizeof(json),
+        "{\"chamber\":%u,\"valid\":%s,\"control\":%s,\"windows\":%lu,"
+        "\"K\":%.3f,\"tau\":%.0f,\"dead\":%d,\"ambient\":%.1f,"
+        "\"ff\":%.1f,\"smith\":%.2f,\"candidates\":[",
+        (unsigned)c.id, valid ? "true" : "false", controlEnabled ? "true" : "false",
+        (unsigned long)windows, gainK, tauS,
+        best < 0 ? -1 : (int)CFG_FOPDT_DELAY_S[best], ambient, ff, correction);
+    for (int i = 0; i < CFG_FOPDT_DELAY_COUNT; i++) {
+        offset += snprintf(json + offset, sizeof(json) - offset, "%s{\"L\":%u,\"rms\":%.4f}",
+                           i ? "," : "", (unsigned)CFG_FOPDT_DELAY_S[i], rms[i]);
+    }
+    snprintf(json + offset, sizeof(json) - offset, "]}");
+    return String(json);
+}
@@ -0,0 +1,43 @@
+// fopdt.h - [NEW] Model komory FOPDT: feed-forward i predyktor Smitha wokół PID
+// Identyfikacja online z historii mocy i temperatury (każdy stan procesu,
+// także stygnięcie w IDLE i przekaźnik autotune; drzwi otwarte = przerwa):
+//   co CFG_FOPDT_WINDOW_S:  dT = th1*T + th2*u(t-L) + th3
+//   u = moc zadana SSR (% wszystkich grzałek – K nie zależy od trybu;
+//   [NEW] z wypełnień kanałów, nie z wyjścia PID), RLS z zapominaniem
+//   osobno dla każdego L z CFG_FOPDT_DELAY_S,
+//   model = kandydat o najmniejszym błędzie predykcji (z histerezą).
+//   RLS tylko po pobudzeniu (zmiana T lub mocy) – w utrzymaniu setpointu
+//   regresory są współliniowe i estymata by dryfowała. [NEW] Wstrzymany
+//   także przy podejrzeniu awarii grzałki (heater_diag_hold_model()).
+//   K = -th2/th1, tau = -okno/th1, otoczenie = -th3/th1
+//
+// Sterowanie (CFG_FOPDT_CONTROL, model ważny):
+//   - feed-forward: moc utrzymania setpointu (tSet - otoczenie)/K dodawana
+//     do wyjścia PID; suma I tylko na resztę (+/-CFG_FOPDT_INTEGRAL_RANGE) –
+//     bez nasyconej całki po długim narastaniu
+//   - predyktor Smitha: PID widzi T + (model bez opóźnienia - model
+//     z opóźnieniem), czyli skutek mocy, której czujnik jeszcze nie pokazał
+// Model nieważny (za mało danych, błąd > CFG_FOPDT_MAX_RMS_C, nastawy
+// fizycznie bez sensu) = zwykły PID, przejście bez skoku wyjścia.
+#pragma once
+#include "chamber.h"
+#include "hal.h"
+
+// Co takt z chamber_run_control_logic – próbka 1 s, okno, RLS, predyktor
+void fopdt_update(Chamber& c, unsigned long now);
+
+// Przed c.pid.Compute(): korekta Smitha pidInput, feed-forward w PID
+void fopdt_prepare_pid(Chamber& c);
+
+// [NEW] Jeden krok (1 s) modelu od t z mocą sprzed L – estymata komory
+// w sensor_failover.cpp; false = model nieważny
+bool fopdt_estimate_step(const Chamber& c, double& t);
+
+// [NEW] Wyjście PID (% w trybie mocy) utrzymujące tSet wg modelu, -1 = brak
+double fopdt_hold_output(const Chamber& c, double tSet, int powerMode);
+
+// Sterowanie z modelu wł./wył. w czasie pracy (replay --no-model)
+void fopdt_set_control(bool enabled);
+
+// Parametry modelu i błędy kandydatów dla /api/model
+String fopdt_json(uint8_t chamberIdx);
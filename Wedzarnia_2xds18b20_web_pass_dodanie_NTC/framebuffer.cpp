@@ -0,0 +1,301 @@
+// framebuffer.cpp - [NEW] Bufor ramki z wykrywaniem zmienionych kafelków
+// – ekran 128x160 podzielony na kafelki 8x8, dla każdego trzymany jest
+//   skrót FNV-1a z poprzedniego flush; wysyłane są tylko kafelki ze zmienionym
+//   skrótem, sąsiednie w wierszu łączone w jeden prostokąt (jedno okno adresowe)
+// – piksele idą blokiem przez writePixels() w jednej transakcji SPI;
+//   Adafruit_SPITFT na ESP32 nie ma ścieżki DMA, ale writePixels wypełnia
+//   całe 64-bajtowe FIFO sprzętowego SPI zamiast wysyłać piksel po pikselu
+// – glify czcionki wbudowanej są rasteryzowane raz (GFXcanvas1) i kopiowane
+//   do bufora jako maski bitowe zamiast setek wywołań drawPixel/fillRect
+#include "framebuffer.h"
+#include "config.h"
+#include "state.h"
+#include <new>
+
+// ======================================================
+// CACHE GLIFÓW
+// ======================================================
+static constexpr uint8_t GLYPH_FIRST = 32;
+static constexpr uint8_t GLYPH_LAST = 126;
+static constexpr uint8_t GLYPH_COUNT = GLYPH_LAST - GLYPH_FIRST + 1;
+static constexpr uint8_t GLYPH_MAX_SIZE = 3;
+
+struct GlyphSet {
+    uint8_t* masks;                          // GLYPH_COUNT masek, alokowane przy pierwszym użyciu
+    uint8_t ready[(GLYPH_COUNT + 7) / 8];    // bit = glif zrasteryzowany
+};
+
+static GlyphSet glyphSets[GLYPH_MAX_SIZE] = {};
+
+static inline int16_t glyphRowBytes(uint8_t size) {
+    return (6 * size + 7) / 8;
+}
+
+static inline size_t glyphBytes(uint8_t size) {
+    return glyphRowBytes(size) * 8 * size;
+}
+
+static const uint8_t* glyphMask(uint8_t c, uint8_t size) {
+    if (c < GLYPH_FIRST || c > GLYPH_LAST || size < 1 || size > GLYPH_MAX_SIZE) return nullptr;
+
+    GlyphSet& set = glyphSets[size - 1];
+    const size_t bytes = glyphBytes(size);
+    if (!set.masks) {
+        set.masks = (uint8_t*)calloc(GLYPH_COUNT, bytes);
+        if (!set.masks) return nullptr;
+    }
+
+    const uint8_t idx = c - GLYPH_FIRST;
+    uint8_t* mask = set.masks + idx * bytes;
+    if (!(set.ready[idx >> 3] & (1 << (idx & 7)))) {
+        // Rasteryzacja tą samą funkcją co Adafruit_GFX – identyczny wygląd,
+        // łącznie z pustą 6. kolumną i 8. wierszem komórki
+        GFXcanvas1 scratch(6 * size, 8 * size);
+        if (!scratch.getBuffer()) return nullptr;
+        scratch.fillScreen(0);
+        scratch.drawChar(0, 0, c, 1, 0, size);
+        memcpy(mask, scratch.getBuffer(), bytes);
+        set.ready[idx >> 3] |= (1 << (idx & 7));
+    }
+    return mask;
+}
+
+// ======================================================
+// FRAMEBUFFER
+// ======================================================
+
+// CASET(1+4) + RASET(1+4) + RAMWR(1) na każdy wysłany prostokąt
+static constexpr uint32_t ADDR_WINDOW_BYTES = 11;
+
+FrameBuffer::FrameBuffer() : GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT), fullRefresh(true) {
+    memset(tileHash, 0, sizeof(tileHash));
+}
+
+size_t FrameBuffer::write(uint8_t c) {
+    // Czcionki GFX, skalowanie niesymetryczne i obrót – ścieżka biblioteki
+    if (gfxFont || textsize_x != textsize_y || getRotation() != 0) {
+        return GFXcanvas16::write(c);
+    }
+    if (c == '\n') {
+        cursor_x = 0;
+        cursor_y += textsize_y * 8;
+        return 1;
+    }
+    if (c == '\r') return 1;
+
+    const uint8_t size = textsize_x;
+    const uint8_t* mask = glyphMask(c, size);
+    if (!mask) return GFXcanvas16::write(c);
+
+    if (wrap && (cursor_x + size * 6) > _width) {
+        cursor_x = 0;
+        cursor_y += size * 8;
+    }
+    blitGlyph(cursor_x, cursor_y, mask, size);
+    cursor_x += size * 6;
+    return 1;
+}
+
+void FrameBuffer::blitGlyph(int16_t x, int16_t y, const uint8_t* mask, uint8_t size) {
+    uint16_t* buf = getBuffer();
+    const int16_t w = 6 * size;
+    const int16_t h = 8 * size;
+    const int16_t rowBytes = glyphRowBytes(size);
+    // setTextColor(c) ustawia tło = kolor → tekst przezroczysty
+    const bool opaque = (textbgcolor != textcolor);
+
+    for (int16_t r = 0; r < h; r++) {
+        const int16_t py = y + r;
+        if (py < 0 || py >= _height) continue;
+        const uint8_t* bits = mask + r * rowBytes;
+        uint16_t* dst = buf + py * _width;
+        for (int16_t col = 0; col < w; col++) {
+            const int16_t px = x + col;
+            if (px < 0 || px >= _width) continue;
+            if (bits[col >> 3] & (0x80 >> (col & 7))) {
+                dst[px] = textcolor;
+            } else if (opaque) {
+                dst[px] = textbgcolor;
+            }
+        }
+    }
+}
+
+void FrameBuffer::scrollLeft(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dx) {
+    if (x < 0 || y < 0 || x + w > _width || y + h > _height || dx <= 0 || dx >= w) return;
+    uint16_t* buf = getBuffer();
+    for (int16_t r = 0; r < h; r++) {
+        uint16_t* row = buf + (y + r) * _width + x;
+        memmove(row, row + dx, (w - dx) * sizeof(uint16_t));
+    }
+}
+
+void FrameBuffer::invalidate() {
+    fullRefresh = true;
+}
+
+uint32_t FrameBuffer::flush(FrameSink& sink, uint32_t* dirtyTiles) {
+    const uint16_t* buf = getBuffer();
+    uint32_t bytes = 0;
+    uint32_t tiles = 0;
+    bool started = false;
+
+    for (int ty = 0; ty < TILES_Y; ty++) {
+        int runStart = -1;
+        // tx == TILES_X zamyka ostatni ciąg w wierszu
+        for (int tx = 0; tx <= TILES_X; tx++) {
+            bool dirty = false;
+            if (tx < TILES_X) {
+                uint32_t hash = 2166136261u;
+                const uint16_t* p = buf + (ty * TILE) * _width + tx * TILE;
+                for (int r = 0; r < TILE; r++, p += _width) {
+                    for (int c = 0; c < TILE; c++) {
+                        hash = (hash ^ p[c]) * 16777619u;
+                    }
+                }
+                dirty = fullRefresh || hash != tileHash[ty][tx];
+                tileHash[ty][tx] = hash;
+            }
+
+            if (dirty) {
+                tiles++;
+                if (runStart < 0) runStart = tx;
+                continue;
+            }
+            if (runStart >= 0) {
+                if (!started) {
+                    sink.beginFlush();
+                    started = true;
+                }
+                const int16_t x = runStart * TILE;
+                const int16_t y = ty * TILE;
+                const int16_t w = (tx - runStart) * TILE;
+                sink.pushRect(x, y, w, TILE, buf + y * _width + x, _width);
+                bytes += (uint32_t)w * TILE * sizeof(uint16_t) + ADDR_WINDOW_BYTES;
+                runStart = -1;
+            }
+        }
+    }
+
+    if (started) sink.endFlush();
+    fullRefresh = false;
+    if (dirtyTiles) *dirtyTiles = tiles;
+    return bytes;
+}
+
+// ======================================================
+// ODBIORCA ST7735
+// ======================================================
+class TftFrameSink : public FrameSink {
+public:
+    void beginFlush() override {
+        display.startWrite();
+    }
+
+    void pushRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                  const uint16_t* src, int16_t stride) override {
+        display.setAddrWindow(x, y, w, h);
+        // Wiersze prostokąta nie leżą w buforze obok siebie – okno adresowe
+        // przyjmuje je kolejno, więc wystarczy h bloków po w pikseli
+        for (int16_t r = 0; r < h; r++) {
+            display.writePixels(const_cast<uint16_t*>(src + r * stride), w, true, false);
+        }
+    }
+
+    void endFlush() override {
+        display.endWrite();
+    }
+};
+
+static FrameBuffer* fb = nullptr;
+static TftFrameSink tftSink;
+static FrameStats fbStats = {};
+static portMUX_TYPE fbStatsMux = portMUX_INITIALIZER_UNLOCKED;
+static unsigned long fbWindowStart = 0;
+static uint32_t fbWindowBytes = 0;
+
+bool framebuffer_init() {
+    if (fb) return true;
+
+    fb = new (std::nothrow) FrameBuffer();
+    if (!fb || !fb->getBuffer()) {
+        delete fb;
+        fb = nullptr;
+        LOG_FMT(LOG_LEVEL_WARN, "Framebuffer alloc failed (heap %u B) - drawing directly to TFT",
+                ESP.getFreeHeap());
+        return false;
+    }
+
+    // Cyfry i znaki pomiarów rasteryzowane od razu – pierwsza ramka bez narzutu
+    static const char warm[] = "0123456789.:-% C";
+    for (uint8_t size = 1; size <= 2; size++) {
+        for (const char* p = warm; *p; p++) glyphMask((uint8_t)*p, size);
+    }
+
+    fbWindowStart = millis();
+    portENTER_CRITICAL(&fbStatsMux);
+    fbStats.active = true;
+    portEXIT_CRITICAL(&fbStatsMux);
+    LOG_FMT(LOG_LEVEL_INFO, "Framebuffer %dx%d ready (%u B)", SCREEN_WIDTH, SCREEN_HEIGHT,
+            (unsigned)(SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint16_t)));
+    return true;
+}
+
+Adafruit_GFX& framebuffer_gfx() {
+    if (fb) return *fb;
+    return display;
+}
+
+void framebuffer_flush() {
+    if (!fb) return;
+
+    uint32_t tiles = 0;
+    uint32_t bytes = fb->flush(tftSink, &tiles);
+
+    fbWindowBytes += bytes;
+    unsigned long now = millis();
+    unsigned long elapsed = now - fbWindowStart;
+
+    portENTER_CRITICAL(&fbStatsMux);
+    fbStats.lastDirtyTiles = tiles;
+    fbStats.spiBytesTotal += bytes;
+    if (elapsed >= 1000) {
+        fbStats.spiBytesPerSec = (uint32_t)((uint64_t)fbWindowBytes * 1000 / elapsed);
+    }
+    portEXIT_CRITICAL(&fbStatsMux);
+
+    if (elapsed >= 1000) {
+        fbWindowStart = now;
+        fbWindowBytes = 0;
+    }
+}
+
+void framebuffer_end_frame(uint32_t frameStartUs) {
+    framebuffer_flush();
+
+    uint32_t frameUs = micros() - frameStartUs;
+    portENTER_CRITICAL(&fbStatsMux);
+    fbStats.frames++;
+    fbStats.lastFrameUs = frameUs;
+    fbStats.avgFrameUs = (fbStats.frames == 1) ? frameUs
+                       : fbStats.avgFrameUs - (fbStats.avgFrameUs >> 3) + (frameUs >> 3);
+    if (frameUs > fbStats.maxFrameUs) fbStats.maxFrameUs = frameUs;
+    portEXIT_CRITICAL(&fbStatsMux);
+}
+
+void framebuffer_invalidate() {
+    if (fb) fb->invalidate();
+}
+
+bool framebuffer_scroll_left(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dx) {
+    if (!fb) return false;
+    fb->scrollLeft(x, y, w, h, dx);
+    return true;
+}
+
+FrameStats framebuffer_get_stats() {
+    portENTER_CRITICAL(&fbStatsMux);
+    FrameStats copy = fbStats;
+    portEXIT_CRITICAL(&fbStatsMux);
+    return copy;
+}
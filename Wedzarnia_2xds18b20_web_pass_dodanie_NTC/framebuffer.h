@@ -0,0 +1,94 @@
+// framebuffer.h - [NEW] Bufor ramki 128x160 RGB565 dla ST7735
+// UI rysuje do bufora w RAM, a na wyświetlacz trafiają tylko zmienione
+// kafelki 8x8 (porównanie skrótów), więc pełne czyszczenie ekranu przy
+// przerysowaniu nie powoduje migania i nie zajmuje magistrali SPI.
+#pragma once
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+
+struct FrameStats {
+    uint32_t frames;
+    uint32_t lastFrameUs;     // rysowanie + flush ostatniej ramki
+    uint32_t avgFrameUs;      // średnia krocząca (1/8)
+    uint32_t maxFrameUs;
+    uint32_t lastDirtyTiles;  // kafelki wysłane w ostatnim flush
+    uint32_t spiBytesPerSec;  // piksele + polecenia okna adresowego
+    uint32_t spiBytesTotal;
+    bool active;              // false – brak RAM na bufor, rysowanie wprost na TFT
+};
+
+// Odbiorca zmienionych prostokątów (ST7735 na ESP32, pamięć na hoście)
+class FrameSink {
+public:
+    virtual ~FrameSink() {}
+    virtual void beginFlush() {}
+    // src wskazuje lewy górny piksel prostokąta, stride = szerokość bufora
+    virtual void pushRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                          const uint16_t* src, int16_t stride) = 0;
+    virtual void endFlush() {}
+};
+
+class FrameBuffer : public GFXcanvas16 {
+public:
+    FrameBuffer();
+
+    // Tekst czcionką wbudowaną rysowany z cache glifów (rozmiar 1..3)
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    // Przesunięcie prostokąta w lewo o dx pikseli (odsłonięte kolumny bez zmian)
+    void scrollLeft(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dx);
+
+    // Następny flush wyśle cały ekran
+    void invalidate();
+
+    // Wysyła zmienione kafelki, zwraca liczbę bajtów przesłanych do odbiorcy
+    uint32_t flush(FrameSink& sink, uint32_t* dirtyTiles = nullptr);
+
+private:
+    static constexpr int TILE = 8;
+    static constexpr int TILES_X = 128 / TILE;
+    static constexpr int TILES_Y = 160 / TILE;
+
+    uint32_t tileHash[TILES_Y][TILES_X];
+    bool fullRefresh;
+
+    void blitGlyph(int16_t x, int16_t y, const uint8_t* mask, uint8_t size);
+};
+
+#ifndef ARDUINO
+// Backend hosta – kopia ekranu w pamięci, do pomiaru ruchu bez sprzętu
+class MemoryFrameSink : public FrameSink {
+public:
+    uint16_t pixels[128 * 160];
+    uint32_t rects = 0;
+
+    void pushRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                  const uint16_t* src, int16_t stride) override {
+        for (int16_t r = 0; r < h; r++) {
+            memcpy(&pixels[(y + r) * 128 + x], src + r * stride, w * sizeof(uint16_t));
+        }
+        rects++;
+    }
+};
+#endif
+
+// Alokacja bufora (40 KB) – wywołać w ui_init(), przed pierwszym rysowaniem
+bool framebuffer_init();
+
+// Cel rysowania UI: bufor ramki albo (awaryjnie) bezpośrednio display
+Adafruit_GFX& framebuffer_gfx();
+
+// Wysłanie zmian na TFT (np. w trakcie blokujących ekranów ustawień)
+void framebuffer_flush();
+
+// Koniec ramki UI: flush + statystyki czasu ramki (frameStartUs z micros())
+void framebuffer_end_frame(uint32_t frameStartUs);
+
+// Odświeżenie całego TFT bez czyszczenia (odzyskanie po zakłóceniach)
+void framebuffer_invalidate();
+
+// Przesunięcie fragmentu ekranu w lewo; false – brak bufora, trzeba przerysować
+bool framebuffer_scroll_left(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dx);
+
+FrameStats framebuffer_get_stats();
@@ -0,0 +1,335 @@
+// gain_sched.cpp - [NEW] Harmonogram nastaw PID (pasmo setpointu x tryb mocy)
+#include "gain_sched.h"
+#include "config.h"
+#include "state.h"
+#include "storage.h"
+
+// Identyfikacja z krzywej reakcji (faza nasycenia przy dużym skoku):
+// obiekt ~ całkujący z opóźnieniem, k = max nachylenie / skok wyjścia,
+// L = opóźnienie; nastawy SIMC z tau_c = L: Kc = 1/(k*2L), Ti = 8L, Td = L/2
+static constexpr double GAIN_DEAD_RISE_C = 0.5;            // wzrost = koniec opóźnienia
+static constexpr unsigned long GAIN_SLOPE_WINDOW_MS = 60000;
+static constexpr double GAIN_MIN_DEAD_S = 10.0;
+static constexpr double GAIN_MIN_OUTPUT_STEP = 20.0;       // % – mniejszy skok nic nie mówi
+static constexpr double GAIN_LEARN_RATE = 0.5;             // udział nowej identyfikacji
+
+// Korekty po obserwacji – na nastawy już po identyfikacji
+static constexpr double GAIN_OSC_KI = 0.70;                // oscylacje: dłuższe Ti
+static constexpr double GAIN_OSC_KD = 1.20;
+static constexpr double GAIN_SLOW_KP = 1.10;               // powolny ogon: szybsza całka
+static constexpr double GAIN_SLOW_KI = 1.20;
+static constexpr double GAIN_SATURATED_PID = 99.0;         // % wyjścia = grzałki na maksimum
+static constexpr uint8_t GAIN_OSCILLATION_EXITS = 3;       // wyjścia z pasma = oscylacje
+
+static int powerModeIndex(int powerMode) {
+    return constrain(powerMode, CFG_POWERMODE_MIN, CFG_POWERMODE_MAX) - CFG_POWERMODE_MIN;
+}
+
+// Sąsiednie pasma i waga drugiego z nich (poza skrajnymi środkami – jedno pasmo)
+static void bandWeights(double tSet, int& i0, int& i1, double& w1) {
+    i0 = i1 = 0;
+    w1 = 0.0;
+    if (tSet <= CFG_GAIN_BAND_C[0]) return;
+    for (int i = 0; i < CFG_GAIN_BAND_COUNT - 1; i++) {
+        if (tSet <= CFG_GAIN_BAND_C[i + 1]) {
+            i0 = i;
+            i1 = i + 1;
+            w1 = (tSet - CFG_GAIN_BAND_C[i]) / (CFG_GAIN_BAND_C[i + 1] - CFG_GAIN_BAND_C[i]);
+            return;
+        }
+    }
+    i0 = i1 = CFG_GAIN_BAND_COUNT - 1;
+}
+
+static float clampGain(double v, double base) {
+    return (float)constrain(v, base * CFG_GAIN_SCALE_MIN, base * CFG_GAIN_SCALE_MAX);
+}
+
+// NaN/inf z uszkodzonego bloba nie przejdą porównań
+static bool gainInRange(float v, double base) {
+    return v >= base * CFG_GAIN_SCALE_MIN - 1e-6 && v <= base * CFG_GAIN_SCALE_MAX + 1e-6;
+}
+
+void gain_table_defaults(GainTable& t) {
+    t.version = GAIN_TABLE_VERSION;
+    for (int m = 0; m <= CFG_POWERMODE_MAX - CFG_POWERMODE_MIN; m++) {
+        for (int b = 0; b < CFG_GAIN_BAND_COUNT; b++) {
+            GainCell& cell = t.cell[m][b];
+            cell.kp = (float)CFG_Kp;
+            cell.ki = (float)CFG_Ki;
+            cell.kd = (float)CFG_Kd;
+            cell.samples = 0;
+            cell.settleSec = 0;
+        }
+    }
+}
+
+GainSet gain_table_lookup(const GainTable& t, double tSet, int powerMode) {
+    const GainCell* row = t.cell[powerModeIndex(powerMode)];
+    int i0, i1;
+    double w1;
+    bandWeights(tSet, i0, i1, w1);
+    double w0 = 1.0 - w1;
+    GainSet g;
+    g.kp = w0 * row[i0].kp + w1 * row[i1].kp;
+    g.ki = w0 * row[i0].ki + w1 * row[i1].ki;
+    g.kd = w0 * row[i0].kd + w1 * row[i1].kd;
+    return g;
+}
+
+// ======================================================
+// NAUKA Z ODPOWIEDZI SKOKOWEJ
+// ======================================================
+
+static bool identifyGains(const GainStepObserver& o, GainSet& out) {
+    double du = 100.0 - o.u0;
+    if (!o.deadMs || o.maxSlope <= 0.0 || du < GAIN_MIN_OUTPUT_STEP) return false;
+
+    double k = o.maxSlope / du;                                  // C/s na % wyjścia
+    // Styczna: opóźnienie = chwila wzrostu minus czas samego narastania
+    double deadS = (o.deadMs - o.startMs) / 1000.0 - GAIN_DEAD_RISE_C / o.maxSlope;
+    if (deadS < GAIN_MIN_DEAD_S) deadS = GAIN_MIN_DEAD_S;
+
+    double kc = 1.0 / (k * 2.0 * deadS);
+    out.kp = kc;
+    out.ki = kc / (8.0 * deadS);
+    out.kd = kc * deadS / 2.0;
+    return true;
+}
+
+static void learnCell(GainCell& cell, const GainSet* id, double fKp, double fKi, double fKd,
+                      double weight) {
+    if (weight <= 0.0) return;
+    double kp = cell.kp, ki = cell.ki, kd = cell.kd;
+    if (id) {
+        double a = GAIN_LEARN_RATE * weight;
+        kp += a * (id->kp - kp);
+        ki += a * (id->ki - ki);
+        kd += a * (id->kd - kd);
+    }
+    cell.kp = clampGain(kp * pow(fKp, weight), CFG_Kp);
+    cell.ki = clampGain(ki * pow(fKi, weight), CFG_Ki);
+    cell.kd = clampGain(kd * pow(fKd, weight), CFG_Kd);
+}
+
+static void finishObservation(Chamber& c, unsigned long now, bool settled) {
+    GainStepObserver& o = c.gainObs;
+    o.active = false;
+
+    unsigned long settleMs = settled ? o.inBandSince - o.startMs : now - o.startMs;
+    unsigned long tailStart = o.t90Ms ? o.t90Ms : o.startMs;
+    unsigned long tailMs = (settled ? o.inBandSince : now) - tailStart;
+    bool saturated = o.saturatedMs > tailMs / 2;
+
+    GainSet id;
+    bool identified = identifyGains(o, id);
+
+    double fKp = 1.0, fKi = 1.0, fKd = 1.0;
+    const char* verdict = "ok";
+    if (o.bandExits >= GAIN_OSCILLATION_EXITS) {
+        fKi = GAIN_OSC_KI;
+        fKd = GAIN_OSC_KD;
+        verdict = "damp";
+    } else if (!saturated && o.overshoot < CFG_GAIN_SETTLE_BAND_C / 2 &&
+               (!settled || tailMs > CFG_GAIN_SLOW_TAIL_MS)) {
+        fKp = GAIN_SLOW_KP;
+        fKi = GAIN_SLOW_KI;
+        verdict = "faster";
+    } else if (!settled) {
+        verdict = "saturated";
+    }
+
+    int i0, i1;
+    double w1;
+    bandWeights(o.target, i0, i1, w1);
+    int m = powerModeIndex(o.powerMode);
+
+    if (!state_lock()) return;
+    GainCell* row = c.gains.cell[m];
+    learnCell(row[i0], identified ? &id : nullptr, fKp, fKi, fKd, 1.0 - w1);
+    if (i1 != i0) learnCell(row[i1], identified ? &id : nullptr, fKp, fKi, fKd, w1);
+    GainCell& cell = row[w1 > 0.5 ? i1 : i0];
+    if (cell.samples < UINT16_MAX) cell.samples++;
+    cell.settleSec = settled ? (uint16_t)min(settleMs / 1000UL, 65535UL) : 0;
+    state_unlock();
+
+    storage_save_gain_table_nvs(c.id);
+
+    LOG_FMT(LOG_LEVEL_INFO,
+            "Gain K%u pm=%d %.1f->%.1f: %s %lus, overshoot %.1f C, exits %u -> %s",
+            (unsigned)c.id, o.powerMode, o.startTemp, o.target,
+            settled ? "settled" : "not settled", settleMs / 1000UL,
+            o.overshoot, (unsigned)o.bandExits, verdict);
+    if (identified) {
+        LOG_FMT(LOG_LEVEL_INFO, "Gain K%u identified: Kp=%.2f Ki=%.4f Kd=%.1f (slope %.3f C/s)",
+                (unsigned)c.id, id.kp, id.ki, id.kd, o.maxSlope);
+    }
+}
+
+void gain_sched_observe(Chamber& c, ProcessState st, int powerMode, unsigned long now) {
+    GainStepObserver& o = c.gainObs;
+    double tSet = c.pidSetpoint;
+    double temp = c.pidInput;
+
+    bool running = (st == ProcessState::RUNNING_AUTO || st == ProcessState::RUNNING_MANUAL);
+    bool changed = running && (!o.lastRunning || fabs(tSet - o.lastTSet) > 0.05 ||
+                               powerMode != o.lastPowerMode);
+    o.lastTSet = tSet;
+    o.lastPowerMode = powerMode;
+    o.lastRunning = running;
+
+    if (o.active && (!running || changed)) {
+        o.active = false;
+        LOG_FMT(LOG_LEVEL_DEBUG, "Gain K%u: step observation dropped", (unsigned)c.id);
+    }
+
+    if (changed && tSet - temp >= CFG_GAIN_STEP_MIN_C) {
+        o = GainStepObserver{};
+        o.active = true;
+        o.target = tSet;
+        o.startTemp = temp;
+        o.powerMode = powerMode;
+        o.startMs = now;
+        o.lastMs = now;
+        o.u0 = c.pidOutput;   // jeszcze sprzed Compute() z nowym setpointem
+        o.lastTSet = tSet;
+        o.lastPowerMode = powerMode;
+        o.lastRunning = true;
+    }
+    if (!o.active) return;
+
+    unsigned long dt = now - o.lastMs;
+    o.lastMs = now;
+    double err = temp - o.target;
+
+    if (!o.t90Ms && temp >= o.startTemp + 0.9 * (o.target - o.startTemp)) o.t90Ms = now;
+    if (o.t90Ms && c.pidOutput >= GAIN_SATURATED_PID) o.saturatedMs += dt;
+
+    // Krzywa reakcji – tylko dopóki wyjście stoi na 100% przed dojściem do 90%
+    if (!o.deadMs && temp >= o.startTemp + GAIN_DEAD_RISE_C) o.deadMs = now;
+    if (!o.t90Ms && c.pidOutput >= GAIN_SATURATED_PID) {
+        if (!o.slopeMs) {
+            o.slopeMs = now;
+            o.slopeTemp = temp;
+        } else if (now - o.slopeMs >= GAIN_SLOPE_WINDOW_MS) {
+            double slope = (temp - o.slopeTemp) * 1000.0 / (now - o.slopeMs);
+            if (slope > o.maxSlope) o.maxSlope = slope;
+            o.slopeMs = now;
+            o.slopeTemp = temp;
+        }
+    } else {
+        o.slopeMs = 0;
+    }
+
+    bool inBand = fabs(err) <= CFG_GAIN_SETTLE_BAND_C;
+    if (inBand && !o.inBand) {
+        o.inBandSince = now;
+        if (!o.reachMs) o.reachMs = now;
+    } else if (!inBand && o.inBand && o.bandExits < UINT8_MAX) {
+        o.bandExits++;
+    }
+    o.inBand = inBand;
+    if (o.reachMs && err > o.overshoot) o.overshoot = err;
+
+    // Cykl graniczny wokół setpointu nigdy się nie ustali – nie czekamy na timeout
+    if (o.inBand && now - o.inBandSince >= CFG_GAIN_SETTLE_HOLD_MS) {
+        finishObservation(c, now, true);
+    } else if (o.bandExits >= GAIN_OSCILLATION_EXITS ||
+               now - o.startMs >= CFG_GAIN_OBS_TIMEOUT_MS) {
+        finishObservation(c, now, false);
+    }
+}
+
+// ======================================================
+// RESET, NVS, JSON
+// ======================================================
+
+void gain_sched_reset(uint8_t chamberIdx) {
+    Chamber& c = chamber_get(chamberIdx);
+    if (!state_lock()) return;
+    gain_table_defaults(c.gains);
+    state_unlock();
+    storage_save_gain_table_nvs(c.id);
+    LOG_FMT(LOG_LEVEL_INFO, "Gain table K%u reset to defaults", (unsigned)c.id);
+}
+
+void gain_table_seed(uint8_t chamberIdx, double tSet, int powerMode, GainSet& g) {
+    Chamber& c = chamber_get(chamberIdx);
+    g.kp = clampGain(g.kp, CFG_Kp);
+    g.ki = clampGain(g.ki, CFG_Ki);
+    g.kd = clampGain(g.kd, CFG_Kd);
+
+    int i0, i1;
+    double w1;
+    bandWeights(tSet, i0, i1, w1);
+    int nearest = (w1 >= 0.5) ? i1 : i0;
+
+    if (!state_lock()) return;
+    GainCell* row = c.gains.cell[powerModeIndex(powerMode)];
+    for (int b = 0; b < CFG_GAIN_BAND_COUNT; b++) {
+        if (b != nearest && row[b].samples > 0) continue;
+        row[b].kp = (float)g.kp;
+        row[b].ki = (float)g.ki;
+        row[b].kd = (float)g.kd;
+        if (b == nearest && row[b].samples < UINT16_MAX) row[b].samples++;
+    }
+    state_unlock();
+    storage_save_gain_table_nvs(c.id);
+    LOG_FMT(LOG_LEVEL_INFO, "Gain table K%u pm=%d seeded at %.0f C: Kp=%.2f Ki=%.4f Kd=%.1f",
+            (unsigned)c.id, powerMode, CFG_GAIN_BAND_C[nearest], g.kp, g.ki, g.kd);
+}
+
+bool gain_table_copy(uint8_t chamberIdx, GainTable& out) {
+    if (chamberIdx >= CFG_CHAMBER_COUNT || !state_lock()) return false;
+    memcpy(&out, &g_chambers[chamberIdx].gains, sizeof(GainTable));
+    state_unlock();
+    return true;
+}
+
+bool gain_table_restore(uint8_t chamberIdx, const GainTable& t) {
+    if (chamberIdx >= CFG_CHAMBER_COUNT || t.version != GAIN_TABLE_VERSION) return false;
+    for (int m = 0; m <= CFG_POWERMODE_MAX - CFG_POWERMODE_MIN; m++) {
+        for (int b = 0; b < CFG_GAIN_BAND_COUNT; b++) {
+            const GainCell& cell = t.cell[m][b];
+            if (!gainInRange(cell.kp, CFG_Kp) || !gainInRange(cell.ki, CFG_Ki) ||
+                !gainInRange(cell.kd, CFG_Kd)) {
+                return false;
+            }
+        }
+    }
+    if (!state_lock()) return false;
+    memcpy(&g_chambers[chamberIdx].gains, &t, sizeof(GainTable));
+    state_unlock();
+    return true;
+}
+
+String gain_table_json(uint8_t chamberIdx) {
+    const Chamber& c = chamber_get(chamberIdx);
+    GainTable t;
+    if (!gain_table_copy(c.id, t)) return String("{}");
+
+    char json[1600];
+    int offset = snprintf(json, sizeof(json), "{\"chamber\":%u,\"bands\":[", (unsigned)c.id);
+    for (int b = 0; b < CFG_GAIN_BAND_COUNT; b++) {
+        offset += snprintf(json + offset, sizeof(json) - offset, "%s%.0f",
+                           b ? "," : "", CFG_GAIN_BAND_C[b]);
+    }
+    offset += snprintf(json + offset, sizeof(json) - offset, "],\"modes\":[");
+    for (int m = 0; m <= CFG_POWERMODE_MAX - CFG_POWERMODE_MIN; m++) {
+        offset += snprintf(json + offset, sizeof(json) - offset, "%s{\"pm\":%d,\"cells\":[",
+                           m ? "," : "", m + CFG_POWERMODE_MIN);
+        for (int b = 0; b < CFG_GAIN_BAND_COUNT; b++) {
+            const GainCell& cell = t.cell[m][b];
+            offset += snprintf(json + offset, sizeof(json) - offset,
+                "%s{\"kp\":%.2f,\"ki\":%.3f,\"kd\":%.1f,\"n\":%u,\"settle\":%u}",
+                b ? "," : "", cell.kp, cell.ki, cell.kd,
+                (unsigned)cell.samples, (unsigned)cell.settleSec);
+        }
+        offset += snprintf(json + offset, sizeof(json) - offset, "]}");
+    }
+    const GainStepObserver& o = c.gainObs;
+    snprintf(json + offset, sizeof(json) - offset,
+             "],\"observing\":%s,\"target\":%.1f,\"pm\":%d}",
+             o.active ? "true" : "false", o.active ? o.target : 0.0, o.active ? o.powerMode : 0);
+    return String(json);
+}
@@ -0,0 +1,59 @@
+// gain_sched.h - [NEW] Harmonogram nastaw PID uczony z odpowiedzi skokowych
+// Każda komora ma tablicę Kp/Ki/Kd: pasmo setpointu (CFG_GAIN_BAND_C) x tryb
+// mocy (1-3 grzałki). Nastawy bazowe PID = interpolacja liniowa między
+// środkami sąsiednich pasm; adaptPidParameters() mnoży je jeszcze przez
+// korektę z wariancji uchybu.
+//
+// Nauka: skok setpointu w górę o >= CFG_GAIN_STEP_MIN_C (start procesu,
+// nowy krok profilu, zmiana w trybie ręcznym) otwiera obserwację.
+//   - dopóki wyjście PID stoi na 100%, z krzywej reakcji (opóźnienie,
+//     max nachylenie) liczone są nastawy SIMC i wciągane do komórek pasma
+//     (połowa różnicy na obserwację, waga = udział pasma w interpolacji)
+//   - 3 wyjścia z pasma ustalenia (oscylacje) → mniejsze Ki, większe Kd
+//   - powolne dojście bez nasycenia grzałek → większe Kp i Ki
+// Koniec obserwacji: CFG_GAIN_SETTLE_HOLD_MS w paśmie +/-CFG_GAIN_SETTLE_BAND_C,
+// oscylacje albo CFG_GAIN_OBS_TIMEOUT_MS. Pauza, zmiana setpointu lub trybu
+// mocy w trakcie = obserwacja odrzucona. Spadki setpointu nie uczą – komora
+// stygnie sama, nastawy nie mają wpływu.
+//
+// Przeregulowanie po długim narastaniu to głównie całka nasycona w PID
+// (suma I obcinana dopiero na 100%) – samymi nastawami się go nie usunie.
+//
+// Tablica trafia do NVS przez write-back cache (storage_save_gain_table_nvs).
+#pragma once
+#include "chamber.h"
+#include "hal.h"
+
+constexpr uint16_t GAIN_TABLE_VERSION = 1;
+
+struct GainSet {
+    double kp;
+    double ki;
+    double kd;
+};
+
+// Wszystkie komórki = CFG_Kp/Ki/Kd (chamber_init, reset z WWW)
+void gain_table_defaults(GainTable& t);
+
+// Nastawy dla setpointu i trybu mocy – interpolacja między pasmami
+GainSet gain_table_lookup(const GainTable& t, double tSet, int powerMode);
+
+// Obserwacja odpowiedzi i nauka – co takt z chamber_run_control_logic
+// (stan i tryb mocy z migawki pod lockiem, temperatury z pidInput/pidSetpoint)
+void gain_sched_observe(Chamber& c, ProcessState st, int powerMode, unsigned long now);
+
+// Nastawy z autotune: komórka najbliższego pasma i wszystkie jeszcze nieuczone
+// pasma tego trybu mocy; g przycięte do granic tablicy, zapis do NVS
+void gain_table_seed(uint8_t chamberIdx, double tSet, int powerMode, GainSet& g);
+
+// Powrót do nastaw z config.h i zapis do NVS
+void gain_sched_reset(uint8_t chamberIdx);
+
+// Kopia pod state_lock – dla zapisu NVS z taska Monitor
+bool gain_table_copy(uint8_t chamberIdx, GainTable& out);
+
+// Tablica z NVS (setup); false = zła wersja lub nastawy poza zakresem
+bool gain_table_restore(uint8_t chamberIdx, const GainTable& t);
+
+// Tablica i stan obserwacji dla /api/pid/gains
+String gain_table_json(uint8_t chamberIdx);
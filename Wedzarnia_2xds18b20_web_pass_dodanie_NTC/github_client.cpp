@@ -0,0 +1,539 @@
+// github_client.cpp - [NEW] Strumieniowy klient GitHub z cache ETag na SD
+// – odpowiedź HTTP nie jest buforowana w String: lista profili przechodzi
+//   przez parser o stałej pamięci, treść profilu trafia wprost do pliku na SD
+// – If-None-Match z ETagiem zapisanym obok kopii (.etag), 304 = użyj cache
+// – brak WiFi / błąd API: zwracana jest ostatnia kopia z karty SD
+// – adresy http:// są obsługiwane bez TLS, więc CFG_GITHUB_* można wskazać
+//   na lokalny serwer testowy (np. python3 -m http.server w katalogu profili)
+// – sieć, SD i kolejka tylko przez HAL – na hoście test z serwerem zastępczym
+//   (tests/github_client_test.cpp)
+#include "github_client.h"
+#include "config.h"
+#include "state.h"
+#include "storage.h"
+
+enum class GithubJobType : uint8_t {
+    LIST,
+    PROFILE
+};
+
+struct GithubJob {
+    GithubJobType type;
+    bool apply;
+    uint8_t chamberIdx;         // [FIX] komora docelowa dla apply
+    char name[48];
+};
+
+// [FIX] Lista mieści CFG_GITHUB_LIST_MAX najdłuższych nazw ("nazwa",) –
+// wcześniej 512 B obcinało po cichu ~10 profili
+constexpr size_t GITHUB_LIST_JSON_SIZE = CFG_GITHUB_LIST_MAX * (sizeof(GithubJob::name) + 2) + 3;
+
+struct GithubStatus {
+    GithubJobState listState;
+    GithubJobState profileState;
+    uint8_t profileChamber;
+    char profileName[48];
+    char listJson[GITHUB_LIST_JSON_SIZE];
+    bool fromCache;
+    int lastHttpCode;
+};
+
+// Kolejka zadań: pierścień pod ghMutex + sygnał dla workera
+constexpr uint8_t GITHUB_QUEUE_LEN = 4;
+
+static GithubJob jobRing[GITHUB_QUEUE_LEN];
+static uint8_t jobHead = 0;
+static uint8_t jobCount = 0;
+
+static hal_mutex_t ghMutex = nullptr;
+static hal_signal_t jobSignal = nullptr;
+static GithubStatus ghStatus = {GithubJobState::IDLE, GithubJobState::IDLE, 0, "", "[]", false, 0};
+
+static bool gh_lock() {
+    return hal_mutex_take(ghMutex, CFG_MUTEX_TIMEOUT_MS);
+}
+
+static void gh_unlock() {
+    hal_mutex_give(ghMutex);
+}
+
+// Wywołać pod gh_lock
+static bool pushJob(const GithubJob& job) {
+    if (jobCount >= GITHUB_QUEUE_LEN) return false;
+    jobRing[(jobHead + jobCount) % GITHUB_QUEUE_LEN] = job;
+    jobCount++;
+    hal_signal_give(jobSignal);
+    return true;
+}
+
+static bool popJob(GithubJob& job) {
+    if (!gh_lock()) return false;
+    bool got = jobCount > 0;
+    if (got) {
+        job = jobRing[jobHead];
+        jobHead = (jobHead + 1) % GITHUB_QUEUE_LEN;
+        jobCount--;
+    }
+    gh_unlock();
+    return got;
+}
+
+static const char* jobStateName(GithubJobState st) {
+    switch (st) {
+        case GithubJobState::BUSY:   return "busy";
+        case GithubJobState::DONE:   return "done";
+        case GithubJobState::FAILED: return "failed";
+        default:                     return "idle";
+    }
+}
+
+// ======================================================
+// PARSER LISTY – stała pamięć niezależnie od rozmiaru odpowiedzi
+// ======================================================
+// API GitHub zwraca tablicę obiektów (~300 B na plik, z zagnieżdżonym
+// "_links"). Potrzebne jest tylko pole "name" obiektów najwyższego poziomu,
+// więc zamiast StaticJsonDocument<4096> wystarczy prosty automat znakowy.
+class GithubListParser {
+public:
+    GithubListParser(char* out, size_t outSize) : out(out), outSize(outSize) {
+        offset = snprintf(out, outSize, "[");
+    }
+
+    // hal_http_sink_fn – ctx = parser
+    static bool sink(const uint8_t* buf, size_t len, void* ctx) {
+        GithubListParser* parser = static_cast<GithubListParser*>(ctx);
+        for (size_t i = 0; i < len; i++) parser->feed((char)buf[i]);
+        return true;
+    }
+
+    void finish() {
+        snprintf(out + offset, outSize - offset, "]");
+    }
+
+    int count() const { return found; }
+    int dropped() const { return skipped; }
+
+private:
+    static constexpr int MAX_DEPTH = 16;
+
+    char* out;
+    size_t outSize;
+    int offset = 0;
+    int found = 0;
+    int skipped = 0;            // [FIX] ponad CFG_GITHUB_LIST_MAX lub za długa nazwa
+
+    int depth = 0;
+    uint16_t objectMask = 0;    // bit n = poziom n jest obiektem
+    bool inString = false;
+    bool escape = false;
+    bool stringIsKey = false;
+    bool expectKey = false;
+    bool keyIsName = false;
+    char tok[64];
+    int tokLen = 0;
+    bool tokOverflow = false;
+
+    bool inObject() const {
+        return depth > 0 && depth < MAX_DEPTH && (objectMask & (1u << depth));
+    }
+
+    void feed(char c) {
+        if (inString) {
+            if (escape) {
+                escape = false;
+            } else if (c == '\\') {
+                escape = true;
+                return;
+            } else if (c == '"') {
+                inString = false;
+                endString();
+                return;
+            }
+            if (tokLen < (int)sizeof(tok) - 1) tok[tokLen++] = c;
+            else tokOverflow = true;
+            return;
+        }
+
+        switch (c) {
+            case '"':
+                inString = true;
+                tokLen = 0;
+                tokOverflow = false;
+                stringIsKey = inObject() && expectKey;
+                break;
+            case '{':
+            case '[':
+                depth++;
+                if (depth < MAX_DEPTH) {
+                    if (c == '{') objectMask |= (1u << depth);
+                    else          objectMask &= ~(1u << depth);
+                }
+                expectKey = (c == '{');
+                break;
+            case '}':
+            case ']':
+                if (depth > 0) depth--;
+                expectKey = false;
+                break;
+            case ':':
+                expectKey = false;
+                break;
+            case ',':
+                expectKey = inObject();
+                break;
+            default:
+                break;
+        }
+    }
+
+    void endString() {
+        tok[tokLen] = '\0';
+        if (stringIsKey) {
+            keyIsName = (depth == 2 && strcmp(tok, "name") == 0);
+            return;
+        }
+        if (keyIsName && !tokOverflow) addName(tok);
+        keyIsName = false;
+    }
+
+    void addName(const char* name) {
+        int nameLen = strlen(name);
+        if (nameLen <= 5 || strcmp(name + nameLen - 5, ".prof") != 0) return;
+        if (strchr(name, '"') || strchr(name, '\\')) return;
+        // Nazwy, których nie da się pobrać (github_profile_name_valid), i
+        // nadmiar ponad bufor – liczone, runListJob zapisze je w logu
+        if (nameLen >= (int)sizeof(GithubJob::name) || found >= CFG_GITHUB_LIST_MAX ||
+            offset + nameLen + 4 >= (int)outSize) {
+            skipped++;
+            return;
+        }
+        offset += snprintf(out + offset, outSize - offset, "%s\"%s\"", found ? "," : "", name);
+        found++;
+    }
+};
+
+// ======================================================
+// CACHE NA SD
+// ======================================================
+
+bool github_profile_name_valid(const char* profileName) {
+    size_t len = strlen(profileName);
+    if (len <= 5 || len >= sizeof(GithubJob::name)) return false;
+    if (strchr(profileName, '/') || strchr(profileName, '\\') || strstr(profileName, "..")) return false;
+    return strcmp(profileName + len - 5, ".prof") == 0;
+}
+
+void github_cache_path(const char* profileName, char* out, size_t outSize) {
+    snprintf(out, outSize, "%s/%s", CFG_GITHUB_CACHE_DIR, profileName);
+}
+
+static bool ensureCacheDir() {
+    if (!hal_fs_mounted()) return false;
+    if (hal_fs_exists(CFG_GITHUB_CACHE_DIR)) return true;
+    if (!hal_fs_exists("/cache")) hal_fs_mkdir("/cache");
+    if (!hal_fs_mkdir(CFG_GITHUB_CACHE_DIR)) {
+        log_msg(LOG_LEVEL_ERROR, "Cannot create GitHub cache directory");
+        return false;
+    }
+    return true;
+}
+
+static bool readTextFile(const char* path, char* out, size_t outSize) {
+    out[0] = '\0';
+    if (!hal_fs_exists(path)) return false;
+    hal_file_t f = hal_fs_open(path, HalFileMode::READ);
+    if (f < 0) return false;
+    int len = hal_fs_read(f, out, outSize - 1);
+    hal_fs_close(f);
+    if (len < 0) len = 0;
+    out[len] = '\0';
+    while (len > 0 && (out[len - 1] == '\r' || out[len - 1] == '\n')) out[--len] = '\0';
+    return len > 0;
+}
+
+static void writeTextFile(const char* path, const char* text) {
+    hal_file_t f = hal_fs_open(path, HalFileMode::WRITE);
+    if (f < 0) return;
+    hal_fs_write(f, text, strlen(text));
+    hal_fs_close(f);
+}
+
+static void readEtag(const char* cachePath, char* out, size_t outSize) {
+    char etagPath[112];
+    snprintf(etagPath, sizeof(etagPath), "%s.etag", cachePath);
+    readTextFile(etagPath, out, outSize);
+}
+
+static void writeEtag(const char* cachePath, const char* etag) {
+    char etagPath[112];
+    snprintf(etagPath, sizeof(etagPath), "%s.etag", cachePath);
+    if (etag[0] == '\0') {
+        hal_fs_remove(etagPath);
+        return;
+    }
+    writeTextFile(etagPath, etag);
+}
+
+// ======================================================
+// KOPIA PROFILU – treść 200 wprost do pliku tymczasowego
+// ======================================================
+
+struct CacheFileSink {
+    hal_file_t file;
+    size_t size;
+};
+
+// hal_http_sink_fn – niepełny zapis przerywa pobieranie
+static bool cacheFileSink(const uint8_t* data, size_t len, void* ctx) {
+    CacheFileSink* sink = static_cast<CacheFileSink*>(ctx);
+    size_t written = hal_fs_write(sink->file, data, len);
+    sink->size += written;
+    return written == len;
+}
+
+// ======================================================
+// ZADANIA WORKERA
+// ======================================================
+
+static void runListJob() {
+    char listPath[64];
+    snprintf(listPath, sizeof(listPath), "%s/_list.json", CFG_GITHUB_CACHE_DIR);
+
+    // Tylko task Github – statyczny, żeby nie zajmował jego stosu
+    static char json[sizeof(ghStatus.listJson)];
+    bool ok = false;
+    bool fromCache = false;
+    int httpCode = 0;
+
+    if (hal_net_connected()) {
+        bool cacheReady = ensureCacheDir();
+        char etag[80] = "";
+        if (cacheReady && hal_fs_exists(listPath)) readEtag(listPath, etag, sizeof(etag));
+
+        char newEtag[80] = "";
+        GithubListParser parser(json, sizeof(json));
+        httpCode = hal_http_get(CFG_GITHUB_API_URL, etag, GithubListParser::sink, &parser,
+                                newEtag, sizeof(newEtag), CFG_GITHUB_TIMEOUT_MS);
+
+        if (httpCode == HAL_HTTP_OK) {
+            parser.finish();
+            ok = true;
+            if (cacheReady) {
+                writeTextFile(listPath, json);
+                writeEtag(listPath, newEtag);
+            }
+            LOG_FMT(LOG_LEVEL_INFO, "GitHub list: %d profiles", parser.count());
+            if (parser.dropped() > 0) {
+                LOG_FMT(LOG_LEVEL_WARN, "GitHub list truncated: %d profiles not shown (max %u, name < %u chars)",
+                        parser.dropped(), (unsigned)CFG_GITHUB_LIST_MAX, (unsigned)sizeof(GithubJob::name));
+            }
+        } else if (httpCode == HAL_HTTP_NOT_MODIFIED) {
+            log_msg(LOG_LEVEL_INFO, "GitHub list not modified (304)");
+        } else {
+            LOG_FMT(LOG_LEVEL_ERROR, "GitHub API list error: %d", httpCode);
+        }
+    } else {
+        log_msg(LOG_LEVEL_WARN, "WiFi not connected - using cached GitHub list");
+    }
+
+    if (!ok) {
+        ok = readTextFile(listPath, json, sizeof(json));
+        fromCache = ok;
+        if (!ok) strcpy(json, "[]");
+    }
+
+    if (gh_lock()) {
+        strncpy(ghStatus.listJson, json, sizeof(ghStatus.listJson) - 1);
+        ghStatus.listJson[sizeof(ghStatus.listJson) - 1] = '\0';
+        ghStatus.listState    = ok ? GithubJobState::DONE : GithubJobState::FAILED;
+        ghStatus.fromCache    = fromCache;
+        ghStatus.lastHttpCode = httpCode;
+        gh_unlock();
+    } else {
+        // [FIX] Bez tego BUSY zostawał na zawsze i blokował kolejne zlecenia
+        // (zapis enuma jest atomowy – wynik listy przepada, stan nie)
+        log_msg(LOG_LEVEL_ERROR, "GitHub list: status lock timeout");
+        ghStatus.listState = GithubJobState::FAILED;
+    }
+}
+
+static void runProfileJob(const GithubJob& job) {
+    char cachePath[96];
+    github_cache_path(job.name, cachePath, sizeof(cachePath));
+
+    bool haveCache = hal_fs_exists(cachePath);
+    bool ok = false;
+    bool fromCache = false;
+    int httpCode = 0;
+
+    if (hal_net_connected() && ensureCacheDir()) {
+        char url[192];
+        snprintf(url, sizeof(url), "%s%s", CFG_GITHUB_PROFILES_BASE_URL, job.name);
+        // [FIX] Sama nazwa – pełny URL nie mieści się w LOG_BUF_SIZE
+        LOG_FMT(LOG_LEVEL_INFO, "Loading GitHub profile: %s", job.name);
+
+        char etag[80] = "";
+        if (haveCache) readEtag(cachePath, etag, sizeof(etag));
+
+        // Zapis do pliku tymczasowego – przerwany transfer nie psuje kopii
+        char tmpPath[104];
+        snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", cachePath);
+        CacheFileSink sink = {hal_fs_open(tmpPath, HalFileMode::WRITE), 0};
+        if (sink.file >= 0) {
+            char newEtag[80] = "";
+            httpCode = hal_http_get(url, etag, cacheFileSink, &sink,
+                                    newEtag, sizeof(newEtag), CFG_GITHUB_TIMEOUT_MS);
+            hal_fs_close(sink.file);
+
+            if (httpCode == HAL_HTTP_OK && sink.size > 0) {
+                hal_fs_remove(cachePath);
+                ok = hal_fs_rename(tmpPath, cachePath);
+                if (ok) writeEtag(cachePath, newEtag);
+                haveCache = ok;
+            } else {
+                hal_fs_remove(tmpPath);
+                if (httpCode == HAL_HTTP_NOT_MODIFIED) {
+                    LOG_FMT(LOG_LEVEL_INFO, "GitHub profile not modified: %s", job.name);
+                } else {
+                    LOG_FMT(LOG_LEVEL_ERROR, "GitHub GET failed HTTP %d: %s", httpCode, job.name);
+                }
+            }
+        } else {
+            LOG_FMT(LOG_LEVEL_ERROR, "Cannot open cache file: %s", tmpPath);
+        }
+    } else {
+        LOG_FMT(LOG_LEVEL_WARN, "GitHub offline - cached copy of %s: %s",
+                job.name, haveCache ? "yes" : "no");
+    }
+
+    if (!ok && haveCache) {
+        ok = true;
+        fromCache = true;
+    }
+
+    if (job.apply) {
+        if (ok) {
+            ok = storage_load_github_profile(job.name, job.chamberIdx);
+        } else if (state_lock()) {
+            chamber_get(job.chamberIdx).errorProfile = true;
+            state_unlock();
+        }
+    }
+
+    if (gh_lock()) {
+        ghStatus.profileState = ok ? GithubJobState::DONE : GithubJobState::FAILED;
+        ghStatus.fromCache    = fromCache;
+        ghStatus.lastHttpCode = httpCode;
+        gh_unlock();
+    } else {
+        // [FIX] Jak w runListJob – BUSY nie może zostać po timeoucie locka
+        log_msg(LOG_LEVEL_ERROR, "GitHub profile: status lock timeout");
+        ghStatus.profileState = GithubJobState::FAILED;
+    }
+}
+
+// ======================================================
+// API PUBLICZNE
+// ======================================================
+
+void github_client_init() {
+    ghMutex   = hal_mutex_create();
+    jobSignal = hal_signal_create();
+    if (!ghMutex || !jobSignal) {
+        log_msg(LOG_LEVEL_ERROR, "GitHub client init failed!");
+    }
+}
+
+void github_client_process(uint32_t waitMs) {
+    if (!ghMutex || !jobSignal) {
+        hal_delay_ms(waitMs);
+        return;
+    }
+    // Sygnał jest binarny – najpierw zaległe zadania, dopiero potem czekanie
+    GithubJob job;
+    if (!popJob(job) && !(hal_signal_wait(jobSignal, waitMs) && popJob(job))) return;
+
+    if (job.type == GithubJobType::LIST) runListJob();
+    else                                 runProfileJob(job);
+}
+
+bool github_request_list() {
+    if (!jobSignal || !gh_lock()) return false;
+    if (ghStatus.listState == GithubJobState::BUSY) {
+        gh_unlock();
+        return true;    // zlecenie już w kolejce – wynik będzie wspólny
+    }
+    GithubJob job = {GithubJobType::LIST, false, 0, ""};
+    bool queued = pushJob(job);
+    if (queued) ghStatus.listState = GithubJobState::BUSY;
+    gh_unlock();
+    return queued;
+}
+
+bool github_request_profile(const char* profileName, bool apply, uint8_t chamberIdx) {
+    if (!jobSignal || !github_profile_name_valid(profileName) || chamberIdx >= CFG_CHAMBER_COUNT) return false;
+    if (!gh_lock()) return false;
+    if (ghStatus.profileState == GithubJobState::BUSY) {
+        gh_unlock();
+        return false;
+    }
+    GithubJob job = {GithubJobType::PROFILE, apply, chamberIdx, ""};
+    strncpy(job.name, profileName, sizeof(job.name) - 1);
+    bool queued = pushJob(job);
+    if (queued) {
+        ghStatus.profileState = GithubJobState::BUSY;
+        ghStatus.profileChamber = chamberIdx;
+        strncpy(ghStatus.profileName, job.name, sizeof(ghStatus.profileName));
+    }
+    gh_unlock();
+    return queued;
+}
+
+GithubJobState github_list_state() {
+    GithubJobState st = GithubJobState::IDLE;
+    if (gh_lock()) {
+        st = ghStatus.listState;
+        gh_unlock();
+    }
+    return st;
+}
+
+GithubJobState github_profile_state() {
+    GithubJobState st = GithubJobState::IDLE;
+    if (gh_lock()) {
+        st = ghStatus.profileState;
+        gh_unlock();
+    }
+    return st;
+}
+
+String github_list_json() {
+    // [FIX] Kopia prosto do String – bufor listy jest za duży na stos tasku Web
+    String json;
+    if (gh_lock()) {
+        json = ghStatus.listJson;
+        gh_unlock();
+    }
+    return json.length() ? json : String("[]");
+}
+
+bool github_last_from_cache() {
+    bool fromCache = false;
+    if (gh_lock()) {
+        fromCache = ghStatus.fromCache;
+        gh_unlock();
+    }
+    return fromCache;
+}
+
+String github_status_json() {
+    char json[176];
+    if (!gh_lock()) return "{}";
+    snprintf(json, sizeof(json),
+        "{\"list\":\"%s\",\"profile\":\"%s\",\"name\":\"%s\",\"chamber\":%u,\"cache\":%s,\"http\":%d}",
+        jobStateName(ghStatus.listState), jobStateName(ghStatus.profileState),
+        ghStatus.profileName, (unsigned)ghStatus.profileChamber,
+        ghStatus.fromCache ? "true" : "false", ghStatus.lastHttpCode);
+    gh_unlock();
+    return String(json);
+}
@@ -0,0 +1,45 @@
+// github_client.h - [NEW] Asynchroniczny klient profili GitHub
+// Pobieranie odbywa się w osobnym tasku (Github), UI i web tylko zlecają
+// zadanie i odpytują jego stan – żadne wywołanie nie blokuje na HTTPS.
+#pragma once
+#include "hal.h"
+
+enum class GithubJobState {
+    IDLE,
+    BUSY,
+    DONE,
+    FAILED
+};
+
+// Tworzy kolejkę zadań i mutex – wywołać przed tasks_create_all()
+void github_client_init();
+
+// Pętla workera: czeka na zadanie z kolejki (max waitMs) i je wykonuje
+void github_client_process(uint32_t waitMs);
+
+// Zlecenie pobrania listy profili (.prof) z API GitHub
+bool github_request_list();
+
+// Zlecenie pobrania profilu do cache na SD; apply=true – po pobraniu
+// profil jest wczytywany do komory chamberIdx (storage_load_github_profile)
+bool github_request_profile(const char* profileName, bool apply, uint8_t chamberIdx = 0);
+
+// [FIX] Sama nazwa pliku .prof – bez '/', '\' i '..' (ścieżka cache i URL)
+bool github_profile_name_valid(const char* profileName);
+
+GithubJobState github_list_state();
+GithubJobState github_profile_state();
+
+// Ostatnia znana lista profili w formacie JSON ["a.prof","b.prof"]
+// (z sieci lub z cache na SD, gdy brak połączenia), do CFG_GITHUB_LIST_MAX
+// nazw – nadmiar jest zapisywany w logu
+String github_list_json();
+
+// true – ostatni wynik pochodzi z cache (304 Not Modified lub tryb offline)
+bool github_last_from_cache();
+
+// Stan zadań w JSON dla /api/github_status
+String github_status_json();
+
+// Ścieżka kopii profilu w cache na SD
+void github_cache_path(const char* profileName, char* out, size_t outSize);
@@ -0,0 +1,163 @@
+// hal.h - [NEW] Cienka warstwa abstrakcji sprzętu (HAL)
+// Logika sterowania, czujników i zapisu ustawień woła hal_* zamiast
+// ledcWrite/nvs_*/SD/DallasTemperature/xSemaphore/HTTPClient. Dwa backendy:
+// – hal_esp32.cpp  (ARDUINO)   – cienkie wrappery na Arduino/ESP-IDF
+// – hal_posix.cpp  (!ARDUINO)  – zegar wirtualny, wyjścia w RAM, NVS w mapie,
+//                                pliki w katalogu hosta, symulowane czujniki
+// Wyświetlacz jest już abstrakcyjny: Adafruit_GFX + FrameSink (framebuffer.h).
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// ======================================================
+// ZEGAR
+// ======================================================
+uint32_t hal_millis();
+uint32_t hal_micros();
+void hal_delay_ms(uint32_t ms);
+
+// ======================================================
+// GPIO / PWM
+// ======================================================
+void hal_gpio_write(uint8_t pin, bool high);
+bool hal_gpio_read(uint8_t pin);
+
+// Wypełnienie kanału LEDC przypisanego do pinu (0..255, LEDC_RESOLUTION)
+void hal_pwm_write(uint8_t pin, uint32_t duty);
+
+// [NEW] Zapis wyjścia bezpieczny w ISR (bez blokad sterownika GPIO)
+void hal_gpio_write_isr(uint8_t pin, bool high);
+
+// ======================================================
+// [NEW] TIMER OKRESOWY (silnik SSR, ssr_tp.cpp)
+// ======================================================
+typedef void (*hal_timer_fn)();
+
+// Jeden timer sprzętowy: cb w ISR co periodUs. Na hoście cb wołane przy
+// każdym przekroczeniu okresu przez zegar wirtualny.
+bool hal_timer_start(uint32_t periodUs, hal_timer_fn cb);
+
+// ======================================================
+// MUTEX / SYGNAŁ / TASK
+// ======================================================
+typedef void* hal_mutex_t;
+typedef void* hal_signal_t;
+typedef void (*hal_task_fn)(void* arg);
+
+hal_mutex_t hal_mutex_create();
+bool hal_mutex_take(hal_mutex_t m, uint32_t timeoutMs);
+void hal_mutex_give(hal_mutex_t m);
+
+// Semafor binarny: give z dowolnego tasku, wait z timeoutem
+hal_signal_t hal_signal_create();
+void hal_signal_give(hal_signal_t s);
+bool hal_signal_wait(hal_signal_t s, uint32_t timeoutMs);
+
+bool hal_task_create(hal_task_fn fn, const char* name, uint32_t stackBytes,
+                     void* arg, int priority, int core);
+
+// ======================================================
+// KLUCZ-WARTOŚĆ (NVS)
+// ======================================================
+typedef uint32_t hal_kv_t;
+
+bool hal_kv_open(const char* ns, bool writable, hal_kv_t* out);
+void hal_kv_close(hal_kv_t h);
+bool hal_kv_commit(hal_kv_t h);
+bool hal_kv_erase(hal_kv_t h, const char* key);
+
+// len: na wejściu rozmiar bufora, na wyjściu długość (z '\0' dla str)
+bool hal_kv_get_str(hal_kv_t h, const char* key, char* out, size_t* len);
+bool hal_kv_get_blob(hal_kv_t h, const char* key, void* out, size_t* len);
+bool hal_kv_get_i32(hal_kv_t h, const char* key, int32_t* out);
+bool hal_kv_get_u8(hal_kv_t h, const char* key, uint8_t* out);
+
+bool hal_kv_set_str(hal_kv_t h, const char* key, const char* value);
+bool hal_kv_set_blob(hal_kv_t h, const char* key, const void* data, size_t len);
+bool hal_kv_set_i32(hal_kv_t h, const char* key, int32_t value);
+bool hal_kv_set_u8(hal_kv_t h, const char* key, uint8_t value);
+
+// ======================================================
+// SYSTEM PLIKÓW (karta SD)
+// ======================================================
+typedef int hal_file_t;                 // < 0 = błąd
+constexpr int HAL_FS_MAX_OPEN = 4;
+
+enum class HalFileMode : uint8_t {
+    READ,
+    WRITE,                              // nadpisanie
+    APPEND
+};
+
+hal_file_t hal_fs_open(const char* path, HalFileMode mode);
+void hal_fs_close(hal_file_t f);
+int hal_fs_read(hal_file_t f, void* buf, size_t len);
+// Linia bez '\n' (jak readBytesUntil); -1 = koniec pliku
+int hal_fs_read_line(hal_file_t f, char* buf, size_t size);
+size_t hal_fs_write(hal_file_t f, const void* data, size_t len);
+
+bool hal_fs_exists(const char* path);
+bool hal_fs_remove(const char* path);
+bool hal_fs_mkdir(const char* path);
+
+// Wywołuje cb dla każdego pliku (nie katalogu) w dir; cb zwraca false = stop
+typedef bool (*hal_fs_list_cb)(const char* name, void* ctx);
+bool hal_fs_list(const char* dir, hal_fs_list_cb cb, void* ctx);
+
+// Ponowne zamontowanie karty (storage_reinit_sd); odmowa przy otwartych
+// uchwytach – unieważniłby je
+bool hal_fs_remount();
+
+// [FIX] Blokada karty (rekurencyjna): ponowny montaż unieważnia stan FAT i
+// każdy otwarty File. hal_fs_* biorą ją na czas operacji, moduły na SD.*
+// (hardware, web_server, sd_stats, sd_clock) jawnie na całą sekcję, a
+// montaż/negocjacja zegara/formatowanie trzymają ją do końca. Na hoście
+// tylko mutex (brak ponownego montażu). hal_fs_init przed startem tasków.
+void hal_fs_init();
+bool hal_fs_lock(uint32_t timeoutMs);
+void hal_fs_unlock();
+
+// [NEW] Otwarte uchwyty – ponowny montaż tylko przy 0 (sd_clock.cpp)
+int hal_fs_open_count();
+
+// [NEW] Karta obecna i zamontowana
+bool hal_fs_mounted();
+// [NEW] Zamiana pliku tymczasowego na docelowy (cel nie może istnieć)
+bool hal_fs_rename(const char* from, const char* to);
+
+// ======================================================
+// [NEW] SIEĆ / HTTP (github_client.cpp)
+// ======================================================
+constexpr int HAL_HTTP_OK = 200;
+constexpr int HAL_HTTP_NOT_MODIFIED = 304;
+
+bool hal_net_connected();
+
+// Blok treści odpowiedzi; false = przerwij pobieranie (np. błąd zapisu)
+typedef bool (*hal_http_sink_fn)(const uint8_t* data, size_t len, void* ctx);
+
+// GET z If-None-Match (gdy etagIn niepusty). Treść tylko przy 200 – blokami
+// do sink, ETag odpowiedzi w etagOut. Zwraca kod HTTP lub < 0 (błąd
+// połączenia albo przerwany strumień)
+int hal_http_get(const char* url, const char* etagIn, hal_http_sink_fn sink, void* ctx,
+                 char* etagOut, size_t etagOutSize, uint32_t timeoutMs);
+
+// ======================================================
+// MAGISTRALA TEMPERATURY (OneWire / DS18B20)
+// ======================================================
+constexpr double HAL_TEMP_DISCONNECTED = -127.0;
+
+int hal_temp_count();
+bool hal_temp_address(int index, uint8_t addr[8]);
+// Nieblokujące rozpoczęcie konwersji (wynik po TEMP_CONVERSION_TIME)
+bool hal_temp_request();
+double hal_temp_read(int index);
+
+// ======================================================
+// Warstwa języka Arduino (String, millis, portMUX) – na hoście z hal_posix.h
+// ======================================================
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include "hal_posix.h"
+#endif
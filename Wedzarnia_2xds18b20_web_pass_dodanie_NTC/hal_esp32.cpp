@@ -0,0 +1,402 @@
+// hal_esp32.cpp - [NEW] Backend HAL dla ESP32 (Arduino core 3.x + ESP-IDF)
+// Same wrappery – zachowanie identyczne z dotychczasowymi wywołaniami
+// ledcWrite/nvs_*/SD/DallasTemperature w modułach.
+#ifdef ARDUINO
+
+#include "hal.h"
+#include "config.h"
+#include "state.h"
+#include "sd_clock.h"
+#include "sd_stats.h"
+#include <SD.h>
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include <nvs_flash.h>
+#include <nvs.h>
+#include <hal/gpio_ll.h>
+
+// ======================================================
+// ZEGAR / GPIO / PWM
+// ======================================================
+
+uint32_t hal_millis() { return millis(); }
+uint32_t hal_micros() { return micros(); }
+void hal_delay_ms(uint32_t ms) { delay(ms); }
+
+void hal_gpio_write(uint8_t pin, bool high) {
+    digitalWrite(pin, high ? HIGH : LOW);
+}
+
+bool hal_gpio_read(uint8_t pin) {
+    return digitalRead(pin) == HIGH;
+}
+
+void hal_pwm_write(uint8_t pin, uint32_t duty) {
+    ledcWrite(pin, duty);
+}
+
+// [NEW] Bezpośrednio rejestry W1TS/W1TC (inline gpio_ll) – bez blokad, kod w IRAM
+void IRAM_ATTR hal_gpio_write_isr(uint8_t pin, bool high) {
+    gpio_ll_set_level(&GPIO, pin, high ? 1 : 0);
+}
+
+// ======================================================
+// [NEW] TIMER OKRESOWY
+// ======================================================
+
+static hw_timer_t* periodicTimer = nullptr;
+
+bool hal_timer_start(uint32_t periodUs, hal_timer_fn cb) {
+    if (periodicTimer) return false;
+    periodicTimer = timerBegin(1000000);          // 1 tick = 1 us
+    if (!periodicTimer) return false;
+    timerAttachInterrupt(periodicTimer, cb);
+    timerAlarm(periodicTimer, periodUs, true, 0);
+    return true;
+}
+
+// ======================================================
+// MUTEX / SYGNAŁ / TASK
+// ======================================================
+
+hal_mutex_t hal_mutex_create() {
+    return (hal_mutex_t)xSemaphoreCreateMutex();
+}
+
+bool hal_mutex_take(hal_mutex_t m, uint32_t timeoutMs) {
+    return m && xSemaphoreTake((SemaphoreHandle_t)m, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+}
+
+void hal_mutex_give(hal_mutex_t m) {
+    if (m) xSemaphoreGive((SemaphoreHandle_t)m);
+}
+
+hal_signal_t hal_signal_create() {
+    return (hal_signal_t)xSemaphoreCreateBinary();
+}
+
+void hal_signal_give(hal_signal_t s) {
+    if (s) xSemaphoreGive((SemaphoreHandle_t)s);
+}
+
+bool hal_signal_wait(hal_signal_t s, uint32_t timeoutMs) {
+    if (!s) {
+        vTaskDelay(pdMS_TO_TICKS(timeoutMs));
+        return false;
+    }
+    return xSemaphoreTake((SemaphoreHandle_t)s, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+}
+
+bool hal_task_create(hal_task_fn fn, const char* name, uint32_t stackBytes,
+                     void* arg, int priority, int core) {
+    return xTaskCreatePinnedToCore(fn, name, stackBytes, arg, priority, NULL, core) == pdPASS;
+}
+
+// ======================================================
+// NVS
+// ======================================================
+
+bool hal_kv_open(const char* ns, bool writable, hal_kv_t* out) {
+    nvs_handle_t h;
+    if (nvs_open(ns, writable ? NVS_READWRITE : NVS_READONLY, &h) != ESP_OK) return false;
+    *out = (hal_kv_t)h;
+    return true;
+}
+
+void hal_kv_close(hal_kv_t h) { nvs_close((nvs_handle_t)h); }
+bool hal_kv_commit(hal_kv_t h) { return nvs_commit((nvs_handle_t)h) == ESP_OK; }
+bool hal_kv_erase(hal_kv_t h, const char* key) { return nvs_erase_key((nvs_handle_t)h, key) == ESP_OK; }
+
+bool hal_kv_get_str(hal_kv_t h, const char* key, char* out, size_t* len) {
+    return nvs_get_str((nvs_handle_t)h, key, out, len) == ESP_OK;
+}
+
+bool hal_kv_get_blob(hal_kv_t h, const char* key, void* out, size_t* len) {
+    return nvs_get_blob((nvs_handle_t)h, key, out, len) == ESP_OK;
+}
+
+bool hal_kv_get_i32(hal_kv_t h, const char* key, int32_t* out) {
+    return nvs_get_i32((nvs_handle_t)h, key, out) == ESP_OK;
+}
+
+bool hal_kv_get_u8(hal_kv_t h, const char* key, uint8_t* out) {
+    return nvs_get_u8((nvs_handle_t)h, key, out) == ESP_OK;
+}
+
+bool hal_kv_set_str(hal_kv_t h, const char* key, const char* value) {
+    return nvs_set_str((nvs_handle_t)h, key, value) == ESP_OK;
+}
+
+bool hal_kv_set_blob(hal_kv_t h, const char* key, const void* data, size_t len) {
+    return nvs_set_blob((nvs_handle_t)h, key, data, len) == ESP_OK;
+}
+
+bool hal_kv_set_i32(hal_kv_t h, const char* key, int32_t value) {
+    return nvs_set_i32((nvs_handle_t)h, key, value) == ESP_OK;
+}
+
+bool hal_kv_set_u8(hal_kv_t h, const char* key, uint8_t value) {
+    return nvs_set_u8((nvs_handle_t)h, key, value) == ESP_OK;
+}
+
+// ======================================================
+// KARTA SD
+// ======================================================
+
+static File openFiles[HAL_FS_MAX_OPEN];
+static bool fileUsed[HAL_FS_MAX_OPEN] = {false};
+static portMUX_TYPE fileMux = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t sdLock = NULL;
+
+void hal_fs_init() {
+    if (!sdLock) sdLock = xSemaphoreCreateRecursiveMutex();
+}
+
+bool hal_fs_lock(uint32_t timeoutMs) {
+    return sdLock && xSemaphoreTakeRecursive(sdLock, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+}
+
+void hal_fs_unlock() {
+    if (sdLock) xSemaphoreGiveRecursive(sdLock);
+}
+
+// [FIX] Każda operacja pod blokadą karty – montaż nie trafi w jej środek
+struct SdGuard {
+    bool held;
+    SdGuard() : held(hal_fs_lock(CFG_SD_LOCK_TIMEOUT_MS)) {}
+    ~SdGuard() { if (held) hal_fs_unlock(); }
+};
+
+static File* fileAt(hal_file_t f) {
+    if (f < 0 || f >= HAL_FS_MAX_OPEN || !fileUsed[f]) return nullptr;
+    return &openFiles[f];
+}
+
+// [NEW] Rozmiar przed usunięciem / nadpisaniem – bilans zajętości (sd_stats.cpp)
+static size_t fileSizeOf(const char* path) {
+    File f = SD.open(path, FILE_READ);
+    if (!f) return 0;
+    size_t size = f.isDirectory() ? 0 : f.size();
+    f.close();
+    return size;
+}
+
+hal_file_t hal_fs_open(const char* path, HalFileMode mode) {
+    SdGuard guard;
+    if (!guard.held) {
+        LOG_FMT(LOG_LEVEL_WARN, "hal_fs_open: SD busy (%s)", path);
+        return -1;
+    }
+    int slot = -1;
+    portENTER_CRITICAL(&fileMux);
+    for (int i = 0; i < HAL_FS_MAX_OPEN; i++) {
+        if (!fileUsed[i]) {
+            fileUsed[i] = true;
+            slot = i;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&fileMux);
+    if (slot < 0) {
+        log_msg(LOG_LEVEL_WARN, "hal_fs_open: no free file slot");
+        return -1;
+    }
+
+    const char* m = (mode == HalFileMode::READ)  ? FILE_READ :
+                    (mode == HalFileMode::WRITE) ? FILE_WRITE : FILE_APPEND;
+    // FILE_WRITE obcina istniejący plik
+    if (mode == HalFileMode::WRITE) sd_stats_note_remove(fileSizeOf(path));
+    openFiles[slot] = SD.open(path, m);
+    if (!openFiles[slot]) {
+        fileUsed[slot] = false;
+        // [NEW] Zapis nie otwiera pliku – błąd karty (odczyt: zwykle brak pliku)
+        if (mode != HalFileMode::READ) sd_clock_note_error();
+        return -1;
+    }
+    return slot;
+}
+
+void hal_fs_close(hal_file_t f) {
+    SdGuard guard;
+    File* file = fileAt(f);
+    if (!file) return;
+    file->close();
+    *file = File();
+    fileUsed[f] = false;
+}
+
+int hal_fs_read(hal_file_t f, void* buf, size_t len) {
+    SdGuard guard;
+    File* file = fileAt(f);
+    return file && guard.held ? (int)file->read((uint8_t*)buf, len) : -1;
+}
+
+int hal_fs_read_line(hal_file_t f, char* buf, size_t size) {
+    SdGuard guard;
+    File* file = fileAt(f);
+    if (!file || !guard.held || size == 0 || !file->available()) return -1;
+    int len = file->readBytesUntil('\n', buf, size - 1);
+    buf[len] = '\0';
+    return len;
+}
+
+size_t hal_fs_write(hal_file_t f, const void* data, size_t len) {
+    SdGuard guard;
+    File* file = fileAt(f);
+    if (!file || !guard.held) return 0;
+    size_t written = file->write((const uint8_t*)data, len);
+    if (written != len) sd_clock_note_error();
+    sd_stats_note_write(written);
+    return written;
+}
+
+bool hal_fs_exists(const char* path) {
+    SdGuard guard;
+    return guard.held && SD.exists(path);
+}
+
+bool hal_fs_remove(const char* path) {
+    SdGuard guard;
+    if (!guard.held) return false;
+    size_t size = fileSizeOf(path);
+    if (!SD.remove(path)) return false;
+    sd_stats_note_remove(size);
+    return true;
+}
+bool hal_fs_mkdir(const char* path) {
+    SdGuard guard;
+    return guard.held && SD.mkdir(path);
+}
+
+bool hal_fs_list(const char* dir, hal_fs_list_cb cb, void* ctx) {
+    SdGuard guard;
+    if (!guard.held) return false;
+    File root = SD.open(dir);
+    if (!root || !root.isDirectory()) return false;
+    while (File entry = root.openNextFile()) {
+        bool more = true;
+        if (!entry.isDirectory()) more = cb(entry.name(), ctx);
+        entry.close();
+        if (!more) break;
+    }
+    root.close();
+    return true;
+}
+
+bool hal_fs_remount() {
+    SdGuard guard;
+    if (!guard.held || hal_fs_open_count() > 0) {
+        log_msg(LOG_LEVEL_WARN, "SD remount refused - card in use");
+        return false;
+    }
+    SD.end();
+    delay(200);
+    // [NEW] Zegar z negocjacji (sd_clock.cpp), nie domyślne 4 MHz
+    return SD.begin(PIN_SD_CS, SPI, sd_clock_hz());
+}
+
+int hal_fs_open_count() {
+    int count = 0;
+    portENTER_CRITICAL(&fileMux);
+    for (int i = 0; i < HAL_FS_MAX_OPEN; i++) {
+        if (fileUsed[i]) count++;
+    }
+    portEXIT_CRITICAL(&fileMux);
+    return count;
+}
+
+bool hal_fs_mounted() { return SD.cardType() != CARD_NONE; }
+
+bool hal_fs_rename(const char* from, const char* to) {
+    SdGuard guard;
+    return guard.held && SD.rename(from, to);
+}
+
+// ======================================================
+// SIEĆ / HTTP
+// ======================================================
+
+bool hal_net_connected() { return WiFi.status() == WL_CONNECTED; }
+
+// Stream dla HTTPClient::writeToStream – bloki prosto do sink
+class HttpSinkStream : public Stream {
+public:
+    HttpSinkStream(hal_http_sink_fn sink, void* ctx) : sink(sink), ctx(ctx) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t len) override {
+        return sink(buf, len, ctx) ? len : 0;
+    }
+
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+private:
+    hal_http_sink_fn sink;
+    void* ctx;
+};
+
+int hal_http_get(const char* url, const char* etagIn, hal_http_sink_fn sink, void* ctx,
+                 char* etagOut, size_t etagOutSize, uint32_t timeoutMs) {
+    HTTPClient http;
+    WiFiClientSecure secureClient;
+    WiFiClient plainClient;
+
+    if (strncmp(url, "https://", 8) == 0) {
+        secureClient.setInsecure(); // brak CA store na ESP32
+        http.begin(secureClient, url);
+    } else {
+        http.begin(plainClient, url);
+    }
+
+    static const char* headerKeys[] = {"ETag"};
+    http.collectHeaders(headerKeys, 1);
+    http.setTimeout(timeoutMs);
+    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+    http.addHeader("User-Agent", "ESP32-Wedzarnia/3.4");
+    if (etagIn && etagIn[0] != '\0') {
+        http.addHeader("If-None-Match", etagIn);
+    }
+
+    int httpCode = http.GET();
+    if (httpCode == HTTP_CODE_OK) {
+        String etag = http.header("ETag");
+        strncpy(etagOut, etag.c_str(), etagOutSize - 1);
+        etagOut[etagOutSize - 1] = '\0';
+
+        // writeToStream obsługuje chunked i Content-Length, czyta blokami
+        HttpSinkStream stream(sink, ctx);
+        int written = http.writeToStream(&stream);
+        if (written < 0) {
+            LOG_FMT(LOG_LEVEL_ERROR, "HTTP stream error: %s", HTTPClient::errorToString(written).c_str());
+            httpCode = written;
+        } else {
+            LOG_FMT(LOG_LEVEL_DEBUG, "HTTP body: %d bytes", written);
+        }
+    }
+    http.end();
+    return httpCode;
+}
+
+// ======================================================
+// DS18B20
+// ======================================================
+
+int hal_temp_count() { return sensors.getDeviceCount(); }
+
+bool hal_temp_address(int index, uint8_t addr[8]) {
+    return sensors.getAddress(addr, index);
+}
+
+bool hal_temp_request() {
+    sensors.setWaitForConversion(false);
+    return (bool)sensors.requestTemperatures();
+}
+
+double hal_temp_read(int index) {
+    return sensors.getTempCByIndex(index);
+}
+
+#endif // ARDUINO
@@ -0,0 +1,661 @@
+// hal_posix.cpp - [NEW] Backend HAL dla hosta (Linux)
+// – zegar: rzeczywisty (steady_clock) albo wirtualny po hal_posix_set_time_ms
+// – GPIO/PWM: tablice stanów, odczytywane przez replay/testy; czas stanu
+//   wysokiego per pin (wypełnienie dostarczone przez silnik SSR)
+// – timer okresowy: wołany z przesuwania zegara wirtualnego
+// – mutex/sygnał/task: std::timed_mutex, condition_variable, std::thread
+// – NVS: mapa w pamięci z kontrolą typu jak w nvs_get_*
+// – SD: pliki w katalogu hosta (hal_posix_set_fs_root)
+// – HTTP: zwykły http:// po gniazdach (HTTP/1.0, bez TLS), opcjonalnie
+//   przekierowany na lokalny serwer testowy (hal_posix_set_http_server)
+// – DS18B20: temperatury ustawiane przez hal_posix_set_temp
+#ifndef ARDUINO
+
+#include "hal_posix.h"
+#include <chrono>
+#include <condition_variable>
+#include <dirent.h>
+#include <map>
+#include <netdb.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+HostSerial Serial;
+
+// ======================================================
+// ZEGAR
+// ======================================================
+
+static bool clockVirtual = false;
+static uint64_t virtualUs = 0;
+
+// [NEW] Timer okresowy (hal_timer_start) – tylko przy zegarze wirtualnym
+static hal_timer_fn timerCb = nullptr;
+static uint64_t timerPeriodUs = 0;
+static uint64_t timerNextUs = 0;
+
+// Przesuwa zegar do targetUs, odpalając timer w chwilach jego okresów
+// (czas stanów GPIO liczony dokładnie między przerwaniami)
+static void advanceTo(uint64_t targetUs) {
+    while (timerCb && timerNextUs <= targetUs) {
+        if (timerNextUs > virtualUs) virtualUs = timerNextUs;
+        timerNextUs += timerPeriodUs;
+        timerCb();
+    }
+    virtualUs = targetUs;
+}
+// Lokalny static – hal_millis() bywa wołane z konstruktorów obiektów globalnych
+static std::chrono::steady_clock::time_point clockStart() {
+    static const auto start = std::chrono::steady_clock::now();
+    return start;
+}
+
+uint32_t hal_micros() {
+    if (clockVirtual) return (uint32_t)virtualUs;
+    auto d = std::chrono::steady_clock::now() - clockStart();
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+uint32_t hal_millis() {
+    if (clockVirtual) return (uint32_t)(virtualUs / 1000);
+    auto d = std::chrono::steady_clock::now() - clockStart();
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+}
+
+void hal_delay_ms(uint32_t ms) {
+    if (clockVirtual) {
+        advanceTo(virtualUs + (uint64_t)ms * 1000);
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void hal_posix_set_time_ms(uint32_t ms) {
+    clockVirtual = true;
+    uint64_t target = (uint64_t)ms * 1000;
+    if (target < virtualUs) {
+        // Cofnięcie zegara (nowa symulacja) – timer od nowej chwili
+        virtualUs = target;
+        timerNextUs = target + timerPeriodUs;
+        return;
+    }
+    advanceTo(target);
+}
+
+void hal_posix_advance_ms(uint32_t ms) {
+    clockVirtual = true;
+    advanceTo(virtualUs + (uint64_t)ms * 1000);
+}
+
+bool hal_posix_virtual_clock() {
+    return clockVirtual;
+}
+
+// ======================================================
+// GPIO / PWM
+// ======================================================
+
+static constexpr int HOST_PINS = 64;
+static bool gpioLevel[HOST_PINS];
+static uint32_t pwmDuty[HOST_PINS];
+static uint64_t gpioHighUs[HOST_PINS];     // suma czasu w stanie wysokim
+static uint64_t gpioSinceUs[HOST_PINS];    // ostatnia zmiana stanu
+
+static uint64_t nowUs() {
+    return clockVirtual ? virtualUs : hal_micros();
+}
+
+void hal_gpio_write(uint8_t pin, bool high) {
+    if (pin >= HOST_PINS || gpioLevel[pin] == high) return;
+    uint64_t now = nowUs();
+    if (gpioLevel[pin]) gpioHighUs[pin] += now - gpioSinceUs[pin];
+    gpioSinceUs[pin] = now;
+    gpioLevel[pin] = high;
+}
+
+void hal_gpio_write_isr(uint8_t pin, bool high) {
+    hal_gpio_write(pin, high);
+}
+
+bool hal_gpio_read(uint8_t pin) {
+    return pin < HOST_PINS && gpioLevel[pin];
+}
+
+void hal_pwm_write(uint8_t pin, uint32_t duty) {
+    if (pin < HOST_PINS) pwmDuty[pin] = duty;
+}
+
+void hal_posix_set_input(uint8_t pin, bool high) {
+    hal_gpio_write(pin, high);
+}
+
+bool hal_posix_gpio(uint8_t pin) {
+    return hal_gpio_read(pin);
+}
+
+uint32_t hal_posix_pwm(uint8_t pin) {
+    return pin < HOST_PINS ? pwmDuty[pin] : 0;
+}
+
+uint64_t hal_posix_gpio_high_us(uint8_t pin) {
+    if (pin >= HOST_PINS) return 0;
+    uint64_t t = gpioHighUs[pin];
+    if (gpioLevel[pin]) t += nowUs() - gpioSinceUs[pin];
+    return t;
+}
+
+// ======================================================
+// [NEW] TIMER OKRESOWY
+// ======================================================
+
+bool hal_timer_start(uint32_t periodUs, hal_timer_fn cb) {
+    if (timerCb || periodUs == 0) return false;
+    timerPeriodUs = periodUs;
+    timerNextUs = virtualUs + periodUs;
+    timerCb = cb;
+    return true;
+}
+
+// ======================================================
+// MUTEX / SYGNAŁ / TASK
+// ======================================================
+
+struct HostSignal {
+    std::mutex m;
+    std::condition_variable cv;
+    bool given = false;
+};
+
+hal_mutex_t hal_mutex_create() {
+    return new std::timed_mutex();
+}
+
+bool hal_mutex_take(hal_mutex_t m, uint32_t timeoutMs) {
+    return m && static_cast<std::timed_mutex*>(m)->try_lock_for(std::chrono::milliseconds(timeoutMs));
+}
+
+void hal_mutex_give(hal_mutex_t m) {
+    if (m) static_cast<std::timed_mutex*>(m)->unlock();
+}
+
+hal_signal_t hal_signal_create() {
+    return new HostSignal();
+}
+
+void hal_signal_give(hal_signal_t s) {
+    HostSignal* sig = static_cast<HostSignal*>(s);
+    if (!sig) return;
+    {
+        std::lock_guard<std::mutex> lock(sig->m);
+        sig->given = true;
+    }
+    sig->cv.notify_one();
+}
+
+bool hal_signal_wait(hal_signal_t s, uint32_t timeoutMs) {
+    HostSignal* sig = static_cast<HostSignal*>(s);
+    if (!sig) {
+        hal_delay_ms(timeoutMs);
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(sig->m);
+    if (!sig->given) {
+        if (clockVirtual) {
+            // Symulacja jednowątkowa: brak sygnału = upływ całego timeoutu
+            lock.unlock();
+            hal_delay_ms(timeoutMs);
+            lock.lock();
+        } else {
+            sig->cv.wait_for(lock, std::chrono::milliseconds(timeoutMs), [sig] { return sig->given; });
+        }
+    }
+    bool got = sig->given;
+    sig->given = false;
+    return got;
+}
+
+bool hal_task_create(hal_task_fn fn, const char* name, uint32_t stackBytes,
+                     void* arg, int priority, int core) {
+    (void)name; (void)stackBytes; (void)priority; (void)core;
+    std::thread(fn, arg).detach();
+    return true;
+}
+
+// ======================================================
+// NVS – mapa w pamięci
+// ======================================================
+
+enum class KvType : uint8_t { U8, I32, STR, BLOB };
+
+struct KvEntry {
+    KvType type;
+    std::vector<uint8_t> data;
+};
+
+static std::mutex kvMutex;
+static std::map<std::string, std::map<std::string, KvEntry>> kvStore;
+static std::vector<std::string> kvHandles;      // indeks + 1 = uchwyt
+static uint32_t kvCommits = 0;
+
+static std::map<std::string, KvEntry>* kvNamespace(hal_kv_t h) {
+    if (h == 0 || h > kvHandles.size()) return nullptr;
+    return &kvStore[kvHandles[h - 1]];
+}
+
+bool hal_kv_open(const char* ns, bool writable, hal_kv_t* out) {
+    std::lock_guard<std::mutex> lock(kvMutex);
+    // Jak nvs_open: namespace tylko do odczytu musi już istnieć
+    if (!writable && kvStore.find(ns) == kvStore.end()) return false;
+    kvStore[ns];
+    // Jeden uchwyt na namespace – wielokrotne open/close nie rośnie w pamięci
+    auto it = std::find(kvHandles.begin(), kvHandles.end(), ns);
+    if (it == kvHandles.end()) it = kvHandles.insert(kvHandles.end(), ns);
+    *out = (hal_kv_t)(it - kvHandles.begin() + 1);
+    return true;
+}
+
+void hal_kv_close(hal_kv_t h) {
+    (void)h;
+}
+
+bool hal_kv_commit(hal_kv_t h) {
+    std::lock_guard<std::mutex> lock(kvMutex);
+    if (!kvNamespace(h)) return false;
+    kvCommits++;
+    return true;
+}
+
+bool hal_kv_erase(hal_kv_t h, const char* key) {
+    std::lock_guard<std::mutex> lock(kvMutex);
+    auto* ns = kvNamespace(h);
+    return ns && ns->erase(key) > 0;
+}
+
+static bool kvGet(hal_kv_t h, const char* key, KvType type, void* out, size_t* len) {
+    std::lock_guard<std::mutex> lock(kvMutex);
+    auto* ns = kvNamespace(h);
+    if (!ns) return false;
+    auto it = ns->find(key);
+    if (it == ns->end() || it->second.type != type) return false;
+    const std::vector<uint8_t>& d = it->second.data;
+    if (*len < d.size()) return false;
+    memcpy(out, d.data(), d.size());
+    *len = d.size();
+    return true;
+}
+
+static bool kvSet(hal_kv_t h, const char* key, KvType type, const void* data, size_t len) {
+    std::lock_guard<std::mutex> lock(kvMutex);
+    auto* ns = kvNamespace(h);
+    if (!ns) return false;
+    KvEntry& e = (*ns)[key];
+    e.type = type;
+    e.data.assign((const uint8_t*)data, (const uint8_t*)data + len);
+    return true;
+}
+
+bool hal_kv_get_str(hal_kv_t h, const char* key, char* out, size_t* len) {
+    return kvGet(h, key, KvType::STR, out, len);
+}
+
+bool hal_kv_get_blob(hal_kv_t h, const char* key, void* out, size_t* len) {
+    return kvGet(h, key, KvType::BLOB, out, len);
+}
+
+bool hal_kv_get_i32(hal_kv_t h, const char* key, int32_t* out) {
+    size_t len = sizeof(*out);
+    return kvGet(h, key, KvType::I32, out, &len);
+}
+
+bool hal_kv_get_u8(hal_kv_t h, const char* key, uint8_t* out) {
+    size_t len = sizeof(*out);
+    return kvGet(h, key, KvType::U8, out, &len);
+}
+
+bool hal_kv_set_str(hal_kv_t h, const char* key, const char* value) {
+    return kvSet(h, key, KvType::STR, value, strlen(value) + 1);
+}
+
+bool hal_kv_set_blob(hal_kv_t h, const char* key, const void* data, size_t len) {
+    return kvSet(h, key, KvType::BLOB, data, len);
+}
+
+bool hal_kv_set_i32(hal_kv_t h, const char* key, int32_t value) {
+    return kvSet(h, key, KvType::I32, &value, sizeof(value));
+}
+
+bool hal_kv_set_u8(hal_kv_t h, const char* key, uint8_t value) {
+    return kvSet(h, key, KvType::U8, &value, sizeof(value));
+}
+
+void hal_posix_kv_clear() {
+    std::lock_guard<std::mutex> lock(kvMutex);
+    kvStore.clear();
+    kvCommits = 0;
+}
+
+uint32_t hal_posix_kv_commits() {
+    return kvCommits;
+}
+
+// ======================================================
+// SD – katalog hosta
+// ======================================================
+
+static std::string fsRoot = "./sd";
+static FILE* openFiles[HAL_FS_MAX_OPEN];
+static std::mutex fileMutex;
+
+void hal_posix_set_fs_root(const char* dir) {
+    fsRoot = dir;
+}
+
+static std::string hostPath(const char* path) {
+    return fsRoot + (path[0] == '/' ? "" : "/") + path;
+}
+
+static FILE* fileAt(hal_file_t f) {
+    return (f >= 0 && f < HAL_FS_MAX_OPEN) ? openFiles[f] : nullptr;
+}
+
+hal_file_t hal_fs_open(const char* path, HalFileMode mode) {
+    const char* m = (mode == HalFileMode::READ) ? "rb" : (mode == HalFileMode::WRITE) ? "wb" : "ab";
+    FILE* fp = fopen(hostPath(path).c_str(), m);
+    if (!fp) return -1;
+    std::lock_guard<std::mutex> lock(fileMutex);
+    for (int i = 0; i < HAL_FS_MAX_OPEN; i++) {
+        if (!openFiles[i]) {
+            openFiles[i] = fp;
+            return i;
+        }
+    }
+    fclose(fp);
+    return -1;
+}
+
+void hal_fs_close(hal_file_t f) {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    FILE* fp = fileAt(f);
+    if (!fp) return;
+    fclose(fp);
+    openFiles[f] = nullptr;
+}
+
+int hal_fs_read(hal_file_t f, void* buf, size_t len) {
+    FILE* fp = fileAt(f);
+    return fp ? (int)fread(buf, 1, len, fp) : -1;
+}
+
+int hal_fs_read_line(hal_file_t f, char* buf, size_t size) {
+    FILE* fp = fileAt(f);
+    if (!fp || size == 0) return -1;
+    int c = fgetc(fp);
+    if (c == EOF) return -1;
+    size_t len = 0;
+    while (c != EOF && c != '\n') {
+        if (len < size - 1) buf[len++] = (char)c;
+        c = fgetc(fp);
+    }
+    buf[len] = '\0';
+    return (int)len;
+}
+
+size_t hal_fs_write(hal_file_t f, const void* data, size_t len) {
+    FILE* fp = fileAt(f);
+    return fp ? fwrite(data, 1, len, fp) : 0;
+}
+
+bool hal_fs_exists(const char* path) {
+    struct stat st;
+    return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool hal_fs_remove(const char* path) {
+    return ::remove(hostPath(path).c_str()) == 0;
+}
+
+bool hal_fs_mkdir(const char* path) {
+    return ::mkdir(hostPath(path).c_str(), 0755) == 0;
+}
+
+bool hal_fs_list(const char* dir, hal_fs_list_cb cb, void* ctx) {
+    std::string base = hostPath(dir);
+    DIR* d = opendir(base.c_str());
+    if (!d) return false;
+    while (struct dirent* e = readdir(d)) {
+        struct stat st;
+        std::string full = base + "/" + e->d_name;
+        if (stat(full.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        if (!cb(e->d_name, ctx)) break;
+    }
+    closedir(d);
+    return true;
+}
+
+static std::recursive_timed_mutex sdLock;
+
+void hal_fs_init() {}
+
+bool hal_fs_lock(uint32_t timeoutMs) {
+    return sdLock.try_lock_for(std::chrono::milliseconds(timeoutMs));
+}
+
+void hal_fs_unlock() {
+    sdLock.unlock();
+}
+
+bool hal_fs_remount() {
+    std::lock_guard<std::recursive_timed_mutex> lock(sdLock);
+    return hal_fs_open_count() == 0 && hal_fs_exists("/");
+}
+
+int hal_fs_open_count() {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    int count = 0;
+    for (int i = 0; i < HAL_FS_MAX_OPEN; i++) {
+        if (openFiles[i]) count++;
+    }
+    return count;
+}
+
+bool hal_fs_mounted() {
+    return hal_fs_exists("/");
+}
+
+bool hal_fs_rename(const char* from, const char* to) {
+    return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+// ======================================================
+// SIEĆ / HTTP – gniazda, HTTP/1.0 z Connection: close
+// ======================================================
+
+static bool netConnected = false;
+static std::string httpServerHost;      // pusty = host z URL
+static uint16_t httpServerPort = 0;
+
+void hal_posix_set_net_connected(bool connected) {
+    netConnected = connected;
+}
+
+void hal_posix_set_http_server(const char* host, uint16_t port) {
+    httpServerHost = host ? host : "";
+    httpServerPort = port;
+}
+
+bool hal_net_connected() {
+    return netConnected;
+}
+
+static int httpConnect(const std::string& host, uint16_t port, uint32_t timeoutMs) {
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) != 0) return -1;
+
+    int fd = -1;
+    for (addrinfo* a = res; a && fd < 0; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) continue;
+        timeval tv = {(time_t)(timeoutMs / 1000), (suseconds_t)((timeoutMs % 1000) * 1000)};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        if (connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+static bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+// Wartość nagłówka (bez wielkości liter w nazwie) z bloku nagłówków
+static bool headerValue(const std::string& head, const char* name, std::string& out) {
+    size_t nameLen = strlen(name);
+    size_t pos = head.find("\r\n");
+    while (pos != std::string::npos) {
+        size_t start = pos + 2;
+        size_t end = head.find("\r\n", start);
+        if (end == std::string::npos) end = head.size();
+        if (end - start > nameLen && head[start + nameLen] == ':' &&
+            strncasecmp(head.c_str() + start, name, nameLen) == 0) {
+            size_t v = start + nameLen + 1;
+            while (v < end && head[v] == ' ') v++;
+            out = head.substr(v, end - v);
+            return true;
+        }
+        pos = (end < head.size()) ? end : std::string::npos;
+    }
+    return false;
+}
+
+int hal_http_get(const char* url, const char* etagIn, hal_http_sink_fn sink, void* ctx,
+                 char* etagOut, size_t etagOutSize, uint32_t timeoutMs) {
+    if (etagOutSize > 0) etagOut[0] = '\0';
+    const char* hostStart = strstr(url, "://");
+    if (!hostStart) return -1;
+    bool tls = strncmp(url, "https", 5) == 0;
+    hostStart += 3;
+    const char* pathStart = strchr(hostStart, '/');
+    std::string hostPort(hostStart, pathStart ? (size_t)(pathStart - hostStart) : strlen(hostStart));
+    std::string path = pathStart ? pathStart : "/";
+
+    std::string host = hostPort;
+    uint16_t port = tls ? 443 : 80;
+    size_t colon = hostPort.find(':');
+    if (colon != std::string::npos) {
+        host = hostPort.substr(0, colon);
+        port = (uint16_t)atoi(hostPort.c_str() + colon + 1);
+    }
+    std::string connectHost = host;
+    if (!httpServerHost.empty()) {
+        connectHost = httpServerHost;
+        port = httpServerPort;
+    } else if (tls) {
+        return -1;                      // brak TLS na hoście
+    }
+
+    int fd = httpConnect(connectHost, port, timeoutMs);
+    if (fd < 0) return -1;
+
+    std::string req = "GET " + path + " HTTP/1.0\r\nHost: " + hostPort +
+                      "\r\nUser-Agent: ESP32-Wedzarnia/3.4\r\nConnection: close\r\n";
+    if (etagIn && etagIn[0] != '\0') req += std::string("If-None-Match: ") + etagIn + "\r\n";
+    req += "\r\n";
+    if (!sendAll(fd, req)) {
+        close(fd);
+        return -1;
+    }
+
+    // Nagłówki do pustej linii, reszta bufora to początek treści
+    std::string buf;
+    size_t headEnd = std::string::npos;
+    char chunk[1024];
+    while (headEnd == std::string::npos && buf.size() < 8192) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) break;
+        buf.append(chunk, (size_t)n);
+        headEnd = buf.find("\r\n\r\n");
+    }
+    int code = -2;
+    if (headEnd != std::string::npos && sscanf(buf.c_str(), "HTTP/%*d.%*d %d", &code) != 1) code = -2;
+    if (code != HAL_HTTP_OK) {
+        close(fd);
+        return code;
+    }
+
+    std::string head = buf.substr(0, headEnd);
+    std::string value;
+    if (headerValue(head, "ETag", value) && etagOutSize > 0) {
+        strncpy(etagOut, value.c_str(), etagOutSize - 1);
+        etagOut[etagOutSize - 1] = '\0';
+    }
+    long expected = headerValue(head, "Content-Length", value) ? atol(value.c_str()) : -1;
+
+    // Treść: do Content-Length albo do zamknięcia połączenia
+    long received = (long)(buf.size() - headEnd - 4);
+    bool ok = received <= 0 || sink((const uint8_t*)buf.data() + headEnd + 4, (size_t)received, ctx);
+    while (ok && (expected < 0 || received < expected)) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n < 0) ok = false;
+        if (n <= 0) break;
+        received += n;
+        ok = sink((const uint8_t*)chunk, (size_t)n, ctx);
+    }
+    close(fd);
+    if (!ok || (expected >= 0 && received != expected)) return -2;
+    return code;
+}
+
+// ======================================================
+// DS18B20
+// ======================================================
+
+static constexpr int HOST_TEMP_MAX = 8;
+static int tempCount = 2;
+static double tempValue[HOST_TEMP_MAX] = {25.0, 25.0, 25.0, 25.0, 25.0, 25.0, 25.0, 25.0};
+
+void hal_posix_set_temp_count(int count) {
+    tempCount = constrain(count, 0, HOST_TEMP_MAX);
+}
+
+void hal_posix_set_temp(int index, double celsius) {
+    if (index >= 0 && index < HOST_TEMP_MAX) tempValue[index] = celsius;
+}
+
+int hal_temp_count() {
+    return tempCount;
+}
+
+bool hal_temp_address(int index, uint8_t addr[8]) {
+    if (index < 0 || index >= tempCount) return false;
+    const uint8_t a[8] = {0x28, (uint8_t)index, 0, 0, 0, 0, 0, (uint8_t)(0xA0 + index)};
+    memcpy(addr, a, sizeof(a));
+    return true;
+}
+
+bool hal_temp_request() {
+    return tempCount > 0;
+}
+
+double hal_temp_read(int index) {
+    if (index < 0 || index >= tempCount) return HAL_TEMP_DISCONNECTED;
+    return tempValue[index];
+}
+
+#endif // !ARDUINO
@@ -0,0 +1,146 @@
+// hal_posix.h - [NEW] Backend HAL dla hosta (Linux) – część nagłówkowa
+// config.h dołącza ten plik zamiast <Arduino.h>, gdy ARDUINO nie jest
+// zdefiniowane. Dostarcza tylko to, czego używa rdzeń firmware (sterowanie,
+// czujniki, zapis ustawień): String, Serial, millis/delay, constrain,
+// sekcje krytyczne portMUX i typy ticków FreeRTOS (1 tick = 1 ms).
+// Plus funkcje hal_posix_* do sterowania symulacją (zegar, wejścia, czujniki).
+#pragma once
+#ifndef ARDUINO
+
+#include "hal.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+using std::max;
+using std::min;
+
+#define HIGH 1
+#define LOW  0
+#define IRAM_ATTR
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline unsigned long millis() { return hal_millis(); }
+inline unsigned long micros() { return hal_micros(); }
+inline void delay(uint32_t ms) { hal_delay_ms(ms); }
+
+// ======================================================
+// FreeRTOS – tylko typy i sekcje krytyczne
+// ======================================================
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define pdTRUE  1
+#define pdFALSE 0
+
+struct portMUX_TYPE {
+    std::recursive_mutex m;
+};
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux)     (mux)->m.lock()
+#define portEXIT_CRITICAL(mux)      (mux)->m.unlock()
+#define portENTER_CRITICAL_ISR(mux) (mux)->m.lock()
+#define portEXIT_CRITICAL_ISR(mux)  (mux)->m.unlock()
+
+inline void vTaskDelay(TickType_t ticks) { hal_delay_ms(ticks); }
+
+// ======================================================
+// String – podzbiór Arduino String używany przez rdzeń
+// ======================================================
+class String {
+public:
+    String() {}
+    String(const char* s) : s_(s ? s : "") {}
+    String(const std::string& s) : s_(s) {}
+    String(char c) : s_(1, c) {}
+    String(int v) : s_(std::to_string(v)) {}
+    String(unsigned int v) : s_(std::to_string(v)) {}
+    String(long v) : s_(std::to_string(v)) {}
+    String(unsigned long v) : s_(std::to_string(v)) {}
+    String(double v, unsigned int decimals = 2) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+        s_ = buf;
+    }
+
+    const char* c_str() const { return s_.c_str(); }
+    unsigned int length() const { return (unsigned int)s_.size(); }
+    bool isEmpty() const { return s_.empty(); }
+    bool reserve(unsigned int n) { s_.reserve(n); return true; }
+
+    String& operator+=(const String& o) { s_ += o.s_; return *this; }
+    String& operator+=(const char* o) { s_ += o; return *this; }
+    String& operator+=(char c) { s_ += c; return *this; }
+    friend String operator+(String a, const String& b) { a += b; return a; }
+    friend String operator+(String a, const char* b) { a += b; return a; }
+    friend String operator+(const char* a, const String& b) { return String(a) += b; }
+
+    bool operator==(const String& o) const { return s_ == o.s_; }
+    bool operator==(const char* o) const { return s_ == o; }
+    bool operator!=(const String& o) const { return s_ != o.s_; }
+
+private:
+    std::string s_;
+};
+
+// ======================================================
+// Serial – wyjście logów na stdout
+// ======================================================
+struct HostSerial {
+    void begin(unsigned long) {}
+    int printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vprintf(fmt, ap);
+        va_end(ap);
+        return n;
+    }
+    void print(const char* s) { fputs(s, stdout); }
+    void println(const char* s = "") { puts(s); }
+    void print(const String& s) { print(s.c_str()); }
+    void println(const String& s) { println(s.c_str()); }
+};
+extern HostSerial Serial;
+
+// ======================================================
+// Sterowanie symulacją (tylko host)
+// ======================================================
+
+// Zegar wirtualny: po pierwszym set_time/advance czas stoi między wywołaniami,
+// a hal_delay_ms przesuwa go zamiast spać. Domyślnie zegar rzeczywisty.
+void hal_posix_set_time_ms(uint32_t ms);
+void hal_posix_advance_ms(uint32_t ms);
+bool hal_posix_virtual_clock();
+
+// Wejścia (drzwi, przyciski) i podgląd wyjść
+void hal_posix_set_input(uint8_t pin, bool high);
+bool hal_posix_gpio(uint8_t pin);
+uint32_t hal_posix_pwm(uint8_t pin);
+// [NEW] Łączny czas stanu wysokiego pinu (zegar wirtualny) – wypełnienie SSR
+uint64_t hal_posix_gpio_high_us(uint8_t pin);
+
+// Symulowane DS18B20 (adresy 28-xx-..., indeks jak na magistrali)
+void hal_posix_set_temp_count(int count);
+void hal_posix_set_temp(int index, double celsius);
+
+// Katalog hosta udający kartę SD (domyślnie ./sd)
+void hal_posix_set_fs_root(const char* dir);
+
+// [NEW] Stan WiFi (domyślnie brak połączenia) i przekierowanie wszystkich
+// żądań hal_http_get na host:port (np. serwer testowy); pusty host = z URL
+void hal_posix_set_net_connected(bool connected);
+void hal_posix_set_http_server(const char* host, uint16_t port);
+
+// Czyści NVS w pamięci; licznik commitów do porównań (bench/replay)
+void hal_posix_kv_clear();
+uint32_t hal_posix_kv_commits();
+
+#endif // !ARDUINO
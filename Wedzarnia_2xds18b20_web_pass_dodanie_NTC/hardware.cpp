@@ -1,11 +1,17 @@
 // hardware.cpp - [FIX] Naprawiony logToFile, shouldEnterLowPower, snprintf w logach
 // [FIX] SD init: 1MHz SPI, watchdog reset, diagnostyka MISO
+// [NEW] Po montażu na 1 MHz negocjacja szybszego zegara (sd_clock.cpp)
+// [FIX] Montaż, negocjacja i logi na SD pod blokadą karty (hal_fs_lock)
 
 #include "hardware.h"
 #include "config.h"
+#include "hal.h"
 #include "state.h"
 #include "outputs.h"
+#include "ssr_tp.h"
 #include "wifimanager.h"
+#include "sd_clock.h"
+#include "sd_stats.h"
 #include <SD.h>
 #include <nvs_flash.h>
 #include <WiFi.h>
@@ -28,30 +34,38 @@ void hardware_init_pins() {
     pinMode(PIN_BTN_ENTER, INPUT_PULLUP);
     pinMode(PIN_BTN_EXIT, INPUT_PULLUP);
 
+    // [NEW] Kolejne komory (komora 0 = piny powyżej)
+    for (uint8_t i = 1; i < CFG_CHAMBER_COUNT; i++) {
+        const ChamberHw& hw = CFG_CHAMBER_HW[i];
+        for (uint8_t s = 0; s < 3; s++) pinMode(hw.ssrPins[s], OUTPUT);
+        pinMode(hw.fanPin, OUTPUT);
+        pinMode(hw.smokePin, OUTPUT);
+        pinMode(hw.doorPin, INPUT_PULLUP);
+    }
+
     log_msg(LOG_LEVEL_INFO, "GPIO pins initialized");
 }
 
 void hardware_init_ledc() {
     bool success = true;
 
-    if (!ledcAttach(PIN_SSR1, LEDC_FREQ, LEDC_RESOLUTION)) {
-        log_msg(LOG_LEVEL_ERROR, "LEDC SSR1 attach failed!");
-        success = false;
-    }
-    if (!ledcAttach(PIN_SSR2, LEDC_FREQ, LEDC_RESOLUTION)) {
-        log_msg(LOG_LEVEL_ERROR, "LEDC SSR2 attach failed!");
-        success = false;
-    }
-    if (!ledcAttach(PIN_SSR3, LEDC_FREQ, LEDC_RESOLUTION)) {
-        log_msg(LOG_LEVEL_ERROR, "LEDC SSR3 attach failed!");
-        success = false;
-    }
+    // [NEW] Grzałki nie na LEDC – proporcjonowanie czasu (ssr_tp), piny GPIO
     if (!ledcAttach(PIN_SMOKE_FAN, LEDC_FREQ, LEDC_RESOLUTION)) {
         log_msg(LOG_LEVEL_ERROR, "LEDC SMOKE attach failed!");
         success = false;
     }
 
+    // [NEW] Kolejne komory
+    for (uint8_t i = 1; i < CFG_CHAMBER_COUNT; i++) {
+        const ChamberHw& hw = CFG_CHAMBER_HW[i];
+        if (!ledcAttach(hw.smokePin, LEDC_FREQ, LEDC_RESOLUTION)) {
+            LOG_FMT(LOG_LEVEL_ERROR, "LEDC chamber %u attach failed!", (unsigned)i);
+            success = false;
+        }
+    }
+
     allOutputsOff();
+    if (!ssr_tp_init()) success = false;
 
     if (success) {
         log_msg(LOG_LEVEL_INFO, "LEDC/PWM initialized");
@@ -119,6 +133,10 @@ void hardware_init_sd() {
     SPI.begin(18, 19, 23, PIN_SD_CS);
     delay(10);
 
+    // [FIX] Monitor (rekordy energii) i WWW nie dotkną karty między kolejnymi
+    // SD.end()/begin() – ich hal_fs_* czekają do końca montażu i negocjacji
+    bool sdLocked = hal_fs_lock(CFG_SD_LOCK_TIMEOUT_MS);
+
     for (int attempt = 1; attempt <= MAX_RETRIES; attempt++) {
         esp_task_wdt_reset();  // Reset watchdoga przed każdą próbą
         LOG_FMT(LOG_LEVEL_INFO, "SD init attempt %d/%d", attempt, MAX_RETRIES);
@@ -146,6 +164,9 @@ void hardware_init_sd() {
             uint64_t cardSize = SD.cardSize() / (1024 * 1024);
             LOG_FMT(LOG_LEVEL_INFO, "SD card OK: %llu MB", cardSize);
 
+            // [NEW] 1 MHz tylko do montażu – dalej najszybszy zegar z testem CRC
+            sd_clock_negotiate();
+
             if (!SD.exists("/profiles")) {
                 if (SD.mkdir("/profiles")) {
                     log_msg(LOG_LEVEL_INFO, "Created /profiles directory");
@@ -157,6 +178,7 @@ void hardware_init_sd() {
             }
 
             initLoggingSystem();
+            if (sdLocked) hal_fs_unlock();
             return;
         }
 
@@ -172,6 +194,7 @@ void hardware_init_sd() {
         }
     }
 
+    if (sdLocked) hal_fs_unlock();
     LOG_FMT(LOG_LEVEL_ERROR, "SD card init failed after %d attempts", MAX_RETRIES);
     log_msg(LOG_LEVEL_ERROR, "System will run in MANUAL MODE ONLY");
 
@@ -280,11 +303,14 @@ void deleteOldestLog(const char* dirPath) {
 }
 
 void logToFile(const String& message) {
+    if (!hal_fs_lock(CFG_SD_LOCK_TIMEOUT_MS)) return;
     File f = SD.open("/logs/latest.log", FILE_APPEND);
     if (f) {
-        f.printf("[%lu] %s\n", millis() / 1000, message.c_str());
+        size_t written = f.printf("[%lu] %s\n", millis() / 1000, message.c_str());
         f.close();
+        sd_stats_note_write(written);
     }
+    hal_fs_unlock();
 }
 
 void runStartupSelfTest() {
@@ -315,17 +341,15 @@ void runStartupSelfTest() {
 
     log_msg(LOG_LEVEL_INFO, "=== TEMPERATURE SENSORS TEST ===");
 
-    sensors.requestTemperatures();
-    delay(1000);
-
+    // [NEW] Bez requestTemperatures() + delay(1000): obecność i CRC scratchpadu
+    // bez konwersji – wartości sprawdza taskSensors od pierwszego odczytu
     int sensorCount = sensors.getDeviceCount();
     bool sensor1Ok = false;
-    bool sensor2Ok = false;
+    DeviceAddress addr;
 
     if (sensorCount >= 1) {
-        double temp1 = sensors.getTempCByIndex(0);
-        if (temp1 != DEVICE_DISCONNECTED_C && temp1 > -20 && temp1 < 100) {
-            LOG_FMT(LOG_LEVEL_INFO, "Sensor 1: %.1f C - OK", temp1);
+        if (sensors.getAddress(addr, 0) && sensors.isConnected(addr)) {
+            log_msg(LOG_LEVEL_INFO, "Sensor 1: responding - OK");
             sensor1Ok = true;
         } else {
             log_msg(LOG_LEVEL_ERROR, "Sensor 1: FAILED or invalid reading");
@@ -333,10 +357,8 @@ void runStartupSelfTest() {
     }
 
     if (sensorCount >= 2) {
-        double temp2 = sensors.getTempCByIndex(1);
-        if (temp2 != DEVICE_DISCONNECTED_C && temp2 > -20 && temp2 < 100) {
-            LOG_FMT(LOG_LEVEL_INFO, "Sensor 2: %.1f C - OK", temp2);
-            sensor2Ok = true;
+        if (sensors.getAddress(addr, 1) && sensors.isConnected(addr)) {
+            log_msg(LOG_LEVEL_INFO, "Sensor 2: responding - OK");
         } else {
             log_msg(LOG_LEVEL_WARN, "Sensor 2: Not connected or invalid");
         }
@@ -346,24 +368,22 @@ void runStartupSelfTest() {
 
     log_msg(LOG_LEVEL_INFO, "=== OUTPUT TEST ===");
 
-    testOutput(PIN_SSR1, "Heater 1");
-    delay(50);
-    testOutput(PIN_SSR2, "Heater 2");
-    delay(50);
-    testOutput(PIN_SSR3, "Heater 3");
-    delay(50);
+    // [NEW] Bez przerw 50 ms między wyjściami – impuls testOutput() wystarcza
+    // [FIX] Piny SSR należą do ISR ssr_tp (nadpisuje digitalWrite co półokres)
+    bool heatersOk = testHeater(PIN_SSR1, "Heater 1");
+    heatersOk &= testHeater(PIN_SSR2, "Heater 2");
+    heatersOk &= testHeater(PIN_SSR3, "Heater 3");
     testOutput(PIN_FAN, "Fan");
-    delay(50);
 
     allOutputsOff();
 
     log_msg(LOG_LEVEL_INFO, "=== STARTUP SELF-TEST SUMMARY ===");
     LOG_FMT(LOG_LEVEL_INFO, "Buttons: %s", allButtonsOk ? "ALL OK" : "CHECK CONNECTIONS");
     LOG_FMT(LOG_LEVEL_INFO, "Sensors: %s (%d detected)", sensor1Ok ? "OK" : "FAILED", sensorCount);
-    log_msg(LOG_LEVEL_INFO, "Outputs: TESTED");
+    LOG_FMT(LOG_LEVEL_INFO, "Outputs: %s", heatersOk ? "TESTED" : "SSR DRIVE FAILED");
     LOG_FMT(LOG_LEVEL_INFO, "Door: %s", digitalRead(PIN_DOOR) ? "OPEN" : "CLOSED");
 
-    if (allButtonsOk && sensor1Ok) {
+    if (allButtonsOk && sensor1Ok && heatersOk) {
         buzzerBeep(2, 100, 50);
     } else {
         buzzerBeep(4, 150, 100);
@@ -379,6 +399,18 @@ void testOutput(int pin, const char* name) {
     LOG_FMT(LOG_LEVEL_INFO, "%s test: OK", name);
 }
 
+// [FIX] Impuls grzałki przez ssr_tp: pełne wypełnienie na 50 ms, OK gdy
+// ISR faktycznie trzymał pin w ON (licznik półokresów ON wzrósł)
+bool testHeater(uint8_t pin, const char* name) {
+    uint64_t before = ssr_tp_on_ms(pin);
+    ssr_tp_write(pin, 255);
+    delay(50);
+    ssr_tp_write(pin, 0);
+    bool ok = ssr_tp_on_ms(pin) > before;
+    LOG_FMT(ok ? LOG_LEVEL_INFO : LOG_LEVEL_ERROR, "%s test: %s", name, ok ? "OK" : "NO SSR DRIVE");
+    return ok;
+}
+
 void testButton(int pin, const char* name) {
     bool state = digitalRead(pin);
     LOG_FMT(LOG_LEVEL_INFO, "%s: %s", name, state ? "HIGH" : "LOW");
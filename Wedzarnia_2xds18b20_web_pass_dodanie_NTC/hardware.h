@@ -16,5 +16,6 @@ void initLoggingSystem();
 void logToFile(const String& message);
 void runStartupSelfTest();
 void testOutput(int pin, const char* name);
+bool testHeater(uint8_t pin, const char* name);   // [FIX] przez ssr_tp
 void testButton(int pin, const char* name);
 void deleteOldestLog(const char* dirPath);
\ No newline at end of file
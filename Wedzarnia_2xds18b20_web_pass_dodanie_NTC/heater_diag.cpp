@@ -0,0 +1,303 @@
+// heater_diag.cpp - [NEW] Awaria grzałki z residuum modelu (opis w heater_diag.h)
+#include "heater_diag.h"
+#include "config.h"
+#include "state.h"
+#include "outputs.h"
+#include "energy.h"
+#include "ssr_tp.h"
+
+// Udział kanału w mocy wszystkich grzałek (jak u w fopdt.cpp)
+static double channelShare(uint8_t ch) {
+    EnergyConfig cfg = energy_get_config();
+    double total = cfg.heaterW[0] + cfg.heaterW[1] + cfg.heaterW[2];
+    return total > 0 ? cfg.heaterW[ch] / total : 1.0 / 3.0;
+}
+
+// Średnie wypełnienia kanałów w oknie modelu (fresh = okno właśnie
+// zamknięte) przez bezwładność grzałki i czujnika – przyrost rzeczywisty,
+// a nie z opóźnienia L modelu (to dopasowanie całości, nie kanału)
+static void recordDuty(const Chamber& c, HeaterDiag& d, bool fresh) {
+    if (fresh && d.dutyCount > 0) {
+        double alpha = 1.0 - exp(-(double)CFG_FOPDT_WINDOW_S / CFG_HFD_HEATER_TAU_S);
+        double beta = 1.0 - exp(-(double)CFG_FOPDT_WINDOW_S / CFG_HFD_SENSOR_TAU_S);
+        for (uint8_t i = 0; i < 3; i++) {
+            double u = d.dutySum[i] / d.dutyCount;
+            d.heatStage[i] = d.heatValid ? d.heatStage[i] + alpha * (u - d.heatStage[i]) : u;
+            d.heatDuty[i] = d.heatValid ? d.heatDuty[i] + beta * (d.heatStage[i] - d.heatDuty[i]) : u;
+            d.dutySum[i] = 0;
+        }
+        d.dutyCount = 0;
+        d.heatValid = true;
+    }
+    for (uint8_t i = 0; i < 3; i++) d.dutySum[i] += ssr_tp_duty(c.hw->ssrPins[i]) / 2.55;
+    d.dutyCount++;
+}
+
+static void startStep(HeaterDiag& d, uint8_t step, unsigned long now) {
+    d.probeStep = step;
+    d.probe = step == 0 ? -1 : (int8_t)d.probeOrder[step];
+    d.probeDir = 0;
+    d.probeStart = now;
+}
+
+// Kanały czynne = miejsca 1..powerMode w kolejności z chwili podejrzenia
+static void startProbe(Chamber& c, unsigned long now) {
+    HeaterDiag& d = c.diag;
+    int pm = 1;
+    if (state_lock()) {
+        pm = c.powerMode;
+        state_unlock();
+    }
+    d.phase = HeaterDiagPhase::PROBE;
+    d.probeCount = (uint8_t)constrain(pm, 1, 3);
+    memcpy(d.probeOrder, c.heaterOrder, sizeof(d.probeOrder));
+    memset(d.probeM, 0, sizeof(d.probeM));
+    memset(d.probeV, 0, sizeof(d.probeV));
+    startStep(d, 0, now);
+}
+
+// probeM * sprawność = probeV, eliminacja Gaussa z wyborem wiersza;
+// false = kroki nie rozdzieliły kanałów
+static bool solveHealth(const HeaterDiag& d, double x[3]) {
+    uint8_t n = d.probeCount;
+    double a[3][4];
+    double trace = 0;
+    for (uint8_t r = 0; r < n; r++) {
+        for (uint8_t k = 0; k < n; k++) a[r][k] = d.probeM[r][k];
+        a[r][n] = d.probeV[r];
+        trace += d.probeM[r][r];
+    }
+    if (trace <= 0) return false;
+    for (uint8_t k = 0; k < n; k++) {
+        uint8_t piv = k;
+        for (uint8_t r = k + 1; r < n; r++) {
+            if (fabs(a[r][k]) > fabs(a[piv][k])) piv = r;
+        }
+        if (fabs(a[piv][k]) < 1e-3 * trace) return false;
+        for (uint8_t j = 0; j <= n; j++) {
+            double t = a[k][j];
+            a[k][j] = a[piv][j];
+            a[piv][j] = t;
+        }
+        for (uint8_t r = k + 1; r < n; r++) {
+            double f = a[r][k] / a[k][k];
+            for (uint8_t j = k; j <= n; j++) a[r][j] -= f * a[k][j];
+        }
+    }
+    for (int k = n - 1; k >= 0; k--) {
+        double sum = a[k][n];
+        for (uint8_t j = k + 1; j < n; j++) sum -= a[k][j] * x[j];
+        x[k] = sum / a[k][k];
+    }
+    return true;
+}
+
+static void backToWatch(HeaterDiag& d) {
+    d.phase = HeaterDiagPhase::WATCH;
+    d.probe = -1;
+    d.cusum = 0;
+}
+
+// Koniec prób: awaria kanału = pauza jak checkHeaterEfficiency()
+static void finishProbes(Chamber& c) {
+    HeaterDiag& d = c.diag;
+    double health[3] = {1, 1, 1};
+    bool solved = solveHealth(d, health);
+    backToWatch(d);
+    if (!solved) {
+        LOG_FMT(LOG_LEVEL_INFO, "Heater diag K%u: probe inconclusive", (unsigned)c.id);
+        return;
+    }
+    d.failedMask = 0;
+    for (uint8_t k = 0; k < d.probeCount; k++) {
+        uint8_t ch = d.probeOrder[k];
+        d.health[ch] = max(0.0, health[k]);
+        if (d.health[ch] < CFG_HFD_FAILED_HEALTH) d.failedMask |= 1 << ch;
+    }
+
+    if (d.failedMask == 0) {
+        d.falseAlarms++;
+        LOG_FMT(LOG_LEVEL_INFO, "Heater diag K%u: all heaters OK (%.2f/%.2f/%.2f)",
+                (unsigned)c.id, d.health[0], d.health[1], d.health[2]);
+        return;
+    }
+
+    if (state_lock()) {
+        c.currentState = ProcessState::PAUSE_HEATER_FAULT;
+        c.processStats.pauseCount++;
+        state_unlock();
+    }
+    chamberOutputsOff(c);
+    buzzerBeep(5, 300, 200);
+    for (uint8_t i = 0; i < 3; i++) {
+        if (!(d.failedMask & (1 << i))) continue;
+        LOG_FMT(LOG_LEVEL_ERROR, "!!! HEATER FAULT !!! K%u heater %u (pin %u): %.0f%% of expected heat",
+                (unsigned)c.id, (unsigned)i + 1, (unsigned)c.hw->ssrPins[i],
+                d.health[i] * 100.0);
+    }
+}
+
+void heater_diag_update(Chamber& c, unsigned long now) {
+    HeaterDiag& d = c.diag;
+    const FopdtModel& m = c.model;
+    if (!CFG_HFD_ENABLE) return;
+
+    // Pauza / drzwi / model nieważny – residuum bez znaczenia, nadzór od nowa
+    bool gap = d.lastMs != 0 && now - d.lastMs > 1000;
+    d.lastMs = now;
+    if (!state_lock()) return;
+    bool door = c.doorOpen;
+    int pm = c.powerMode;
+    state_unlock();
+    // Zmiana powerMode w czasie próby – inne kanały czynne, kroki nieważne
+    bool modeChanged = d.phase == HeaterDiagPhase::PROBE && pm != d.probeCount;
+    if (gap || door || !m.valid || modeChanged) {
+        if (d.phase == HeaterDiagPhase::PROBE) {
+            LOG_FMT(LOG_LEVEL_INFO, "Heater diag K%u: probe aborted", (unsigned)c.id);
+        }
+        backToWatch(d);
+        d.lastSeq = m.residualSeq;
+        // Filtr wypełnień od nowa – okna nie pokrywają się z oknami modelu
+        d.heatValid = false;
+        d.dutyCount = 0;
+        for (uint8_t i = 0; i < 3; i++) d.dutySum[i] = 0;
+        return;
+    }
+
+    bool fresh = m.residualSeq != d.lastSeq;
+    d.lastSeq = m.residualSeq;
+    recordDuty(c, d, fresh);
+
+    if (d.phase == HeaterDiagPhase::WATCH) {
+        if (!fresh) return;
+        // Tolerancja rośnie z przewidywanym przyrostem – przy pełnej mocy błąd
+        // modelu (straty nieliniowe w T) jest rzędu 10% przyrostu
+        double drive = 0;
+        if (m.residualU >= CFG_HFD_MIN_POWER) {
+            drive = -m.residual - CFG_HFD_DRIFT_FRAC * m.th2 * m.residualU;
+        }
+        d.cusum = max(0.0, d.cusum + drive - CFG_HFD_DRIFT_C);
+        if (d.cusum < CFG_HFD_ALARM_C) return;
+
+        d.suspects++;
+        d.suspectMs = now;
+        for (uint8_t i = 0; i < 3; i++) d.health[i] = -1;
+        LOG_FMT(LOG_LEVEL_WARN, "Heater diag K%u: %.1f C below model at %.0f%% power, probing heaters",
+                (unsigned)c.id, d.cusum, m.residualU);
+        startProbe(c, now);
+        return;
+    }
+
+    // PROBE: każde okno = równanie na sprawność czynnych kanałów
+    // [FIX] Kanał czynny jeszcze wyłączony przez soft-start – krok od nowa,
+    // inaczej odchyłka nie trafiłaby na grzałkę
+    if (!heater_lock()) return;
+    bool enabled[3] = { c.he.h1, c.he.h2, c.he.h3 };
+    heater_unlock();
+    for (uint8_t k = 0; k < d.probeCount; k++) {
+        if (enabled[d.probeOrder[k]]) continue;
+        startStep(d, d.probeStep, now);
+        return;
+    }
+    if (fresh && d.heatValid) {
+        // Rzeczywisty przyrost okna = residuum + przewidywanie modelu;
+        // z kanałów: suma sprawność x przyrost z wypełnienia po bezwładności
+        double a[3];
+        double y = m.residual + m.th2 * m.residualU;
+        for (uint8_t k = 0; k < d.probeCount; k++) {
+            uint8_t ch = d.probeOrder[k];
+            a[k] = m.th2 * channelShare(ch) * d.heatDuty[ch];
+        }
+        for (uint8_t k = 0; k < d.probeCount; k++) {
+            for (uint8_t j = 0; j < d.probeCount; j++) d.probeM[k][j] += a[k] * a[j];
+            d.probeV[k] += a[k] * y;
+        }
+    }
+    // Ostatni krok dłużej o bezwładność – jego wypełnienia muszą dojść do przyrostu
+    unsigned long stepMs = CFG_HFD_PROBE_STEP_S * 1000UL;
+    bool last = d.probeStep + 1 >= d.probeCount;
+    if (last && d.probeCount > 1) stepMs += CFG_HFD_HEATER_TAU_S * 1000UL;
+    if (now - d.probeStart < stepMs) return;
+    if (!last) {
+        startStep(d, d.probeStep + 1, now);
+    } else {
+        finishProbes(c);
+    }
+}
+
+void heater_diag_reset(Chamber& c) {
+    HeaterDiag& d = c.diag;
+    backToWatch(d);
+    d.lastMs = 0;
+    d.lastSeq = c.model.residualSeq;
+    d.heatValid = false;
+    d.dutyCount = 0;
+    for (uint8_t i = 0; i < 3; i++) d.dutySum[i] = 0;
+    d.failedMask = 0;
+    for (uint8_t i = 0; i < 3; i++) d.health[i] = -1;
+}
+
+void heater_diag_probe_duty(Chamber& c, double duty[3]) {
+    HeaterDiag& d = c.diag;
+    if (d.phase != HeaterDiagPhase::PROBE || d.probe < 0) return;
+    uint8_t ch = d.probe;
+    for (uint8_t i = 0; i < 3; i++) duty[i] = min(duty[i], 100.0);
+    double others = 0, room = 0;
+    for (uint8_t k = 0; k < d.probeCount; k++) {
+        uint8_t j = d.probeOrder[k];
+        if (j == ch) continue;
+        others += duty[j];
+        room += 100.0 - duty[j];
+    }
+    // Kierunek raz na krok: kanał poniżej średniej pozostałych przejmuje
+    // moc, powyżej – oddaje (największa różnica względem odniesienia)
+    if (d.probeDir == 0) {
+        d.probeDir = duty[ch] * (d.probeCount - 1) < others ? 1 : -1;
+    }
+    if (d.probeDir > 0) {
+        double delta = min(CFG_HFD_PROBE_SWING, min(100.0 - duty[ch], others));
+        if (delta <= 0) return;
+        duty[ch] += delta;
+        for (uint8_t k = 0; k < d.probeCount; k++) {
+            uint8_t j = d.probeOrder[k];
+            if (j != ch) duty[j] -= delta * duty[j] / others;
+        }
+    } else {
+        double delta = min(CFG_HFD_PROBE_SWING, duty[ch]);
+        duty[ch] -= delta;
+        // Pozostałe na 100% – suma spada o odchyłkę, nigdy ponad PID
+        double give = min(delta, room);
+        if (give <= 0) return;
+        for (uint8_t k = 0; k < d.probeCount; k++) {
+            uint8_t j = d.probeOrder[k];
+            if (j != ch) duty[j] += give * (100.0 - duty[j]) / room;
+        }
+    }
+}
+
+bool heater_diag_hold_model(const Chamber& c) {
+    return c.diag.phase == HeaterDiagPhase::PROBE || c.diag.cusum >= CFG_HFD_HOLD_C;
+}
+
+String heater_diag_json(uint8_t chamberIdx) {
+    const Chamber& c = chamber_get(chamberIdx);
+    if (!state_lock()) return String("{}");
+    HeaterDiag d = c.diag;
+    bool modelValid = c.model.valid;
+    double residual = c.model.residual;
+    state_unlock();
+
+    char json[384];
+    snprintf(json, sizeof(json),
+        "{\"chamber\":%u,\"enabled\":%s,\"modelValid\":%s,\"phase\":\"%s\",\"probe\":%d,"
+        "\"cusum\":%.2f,\"alarm\":%.2f,\"residual\":%.3f,"
+        "\"health\":[%.2f,%.2f,%.2f],\"failedMask\":%u,"
+        "\"suspects\":%u,\"falseAlarms\":%u}",
+        (unsigned)c.id, CFG_HFD_ENABLE ? "true" : "false", modelValid ? "true" : "false",
+        d.phase == HeaterDiagPhase::PROBE ? "probe" : "watch",
+        d.phase == HeaterDiagPhase::PROBE ? d.probe + 1 : 0,
+        d.cusum, CFG_HFD_ALARM_C, residual,
+        d.health[0], d.health[1], d.health[2], (unsigned)d.failedMask,
+        (unsigned)d.suspects, (unsigned)d.falseAlarms);
+    return String(json);
+}
@@ -0,0 +1,48 @@
+// heater_diag.h - [NEW] Awaria grzałki z residuum modelu komory
+// checkHeaterEfficiency() (process.cpp) alarmuje dopiero po 20 min bez
+// wzrostu o 2 C przy PID > 50% – zostaje jako zabezpieczenie, gdy model
+// FOPDT nie jest jeszcze ważny.
+//
+// Wykrycie: co okno modelu (10 s) fopdt.cpp liczy residuum a priori
+// r = dT okna - predykcja z mocy zadanej SSR (opóźnionej o L). Brak grzania
+// z kanału, który ma wypełnienie, daje trwale ujemne r. CUSUM
+//   S = max(0, S - r - CFG_HFD_DRIFT_FRAC x przyrost z modelu - CFG_HFD_DRIFT_C)
+// (tylko gdy moc >= CFG_HFD_MIN_POWER). Jedna z trzech grzałek to ~33%
+// przyrostu, więc dryf ułamkowy nie maskuje awarii przy żadnej mocy.
+// S >= CFG_HFD_ALARM_C = podejrzenie, zwykle 2.5-3.5 min od pierwszego
+// wypełnienia uszkodzonego kanału (kanał bez wypełnienia nie daje sygnału).
+// Od S >= CFG_HFD_HOLD_C RLS modelu stoi – inaczej w kilka okien nauczyłby
+// się mniejszego K i residuum by znikło.
+//
+// Przypisanie: moc z PID zostaje, zmienia się tylko jej podział między
+// kanały czynne w powerMode (miejsca 1..powerMode wg heaterOrder). Krok 0 =
+// odniesienie, potem po kolei każdy następny czynny kanał przejmuje lub
+// oddaje do CFG_HFD_PROBE_SWING % grzałki na CFG_HFD_PROBE_STEP_S (reszta
+// czynnych wyrównuje sumę; przy wszystkich na 100% suma tylko spada),
+// ostatni krok dłużej o CFG_HFD_HEATER_TAU_S. Każde okno modelu to równanie
+// przyrost = suma sprawność_i x th2 x udział_i x wypełnienie_i, gdzie
+// wypełnienie przechodzi przez bezwładność grzałki i czujnika; sprawności
+// z najmniejszych kwadratów. Trzy grzałki ~2.5 min, jedna = samo odniesienie.
+// Kanał < CFG_HFD_FAILED_HEALTH → PAUSE_HEATER_FAULT z numerem grzałki;
+// wszystkie sprawne = fałszywy alarm, powrót do nadzoru.
+#pragma once
+#include "chamber.h"
+#include "hal.h"
+
+// Co takt w RUNNING_AUTO / RUNNING_MANUAL, po mapPowerToHeaters()
+void heater_diag_update(Chamber& c, unsigned long now);
+
+// Start i wznowienie procesu – CUSUM i próby od nowa, wynik skasowany
+void heater_diag_reset(Chamber& c);
+
+// mapPowerToHeaters(): wypełnienia (%, indeks ssrPins) po podziale mocy
+// z PID; w próbie przesuwa część mocy na / z kanału, suma bez zmian
+// (mniejsza tylko, gdy pozostałe kanały są już na 100%)
+void heater_diag_probe_duty(Chamber& c, double duty[3]);
+
+// Podejrzenie lub próba – fopdt.cpp wstrzymuje RLS, żeby model nie
+// nauczył się awarii, zanim CUSUM dojdzie do progu
+bool heater_diag_hold_model(const Chamber& c);
+
+// Stan detektora i sprawność kanałów dla /api/heaters
+String heater_diag_json(uint8_t chamberIdx);
@@ -0,0 +1,17 @@
+// host_stubs.cpp - [NEW] Zamienniki funkcji modułów tylko-ESP32 dla budowy na hoście
+// Rdzeń (process/storage/outputs) woła kilka funkcji z ui.cpp i inputs.cpp
+// – te moduły zależą od TFT/GPIO ISR i na hoście nie są kompilowane.
+// Wspólne dla replay.cpp, bench.cpp i soak.cpp.
+#ifndef ARDUINO
+#include "config.h"
+#include "inputs.h"
+
+// Ekran nie istnieje – wymuszenie odświeżenia jest no-op
+void ui_force_redraw() {}
+
+// Blokada grzałek = stan krańcówki (bez ISR i debounce zamknięcia)
+bool inputs_door_interlock() {
+    return hal_gpio_read(PIN_DOOR);
+}
+
+#endif // !ARDUINO
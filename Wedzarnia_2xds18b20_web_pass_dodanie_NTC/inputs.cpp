@@ -0,0 +1,266 @@
+// inputs.cpp - [NEW] Kolejka zdarzeń przycisków + szybka ścieżka drzwi
+// – ISR przycisków tylko odkłada (przycisk, poziom, millis) do kolejki;
+//   debounce liczony jest w tasku UI z czasów zboczy, więc nie zależy od tego,
+//   jak często task UI zagląda do kolejki
+// – ISR drzwi przy otwarciu ustawia doorInterlock (mapPowerToHeaters nie
+//   włączy SSR) i budzi task Safety, który od razu zeruje SSR, a potem
+//   przechodzi zwykłą ścieżką checkDoor() (PAUSE_DOOR, allOutputsOff)
+// – zamknięcie drzwi wymaga stabilnego stanu przez CFG_DOOR_CLOSE_DEBOUNCE_MS
+#include "inputs.h"
+#include "config.h"
+#include "outputs.h"
+#include "sensors.h"
+#include "state.h"
+
+struct RawEdge {
+    uint8_t idx;
+    bool pressed;
+    uint32_t timeMs;
+};
+
+struct ButtonState {
+    bool stable;           // stan po debounce
+    bool pending;          // ostatni poziom z ISR
+    uint32_t pendingSince;
+    uint32_t pressStart;
+    uint32_t lastRepeat;
+    bool longSent;
+};
+
+static constexpr int BUTTON_COUNT = (int)ButtonId::COUNT;
+static constexpr int EDGE_QUEUE_LEN = 32;
+static constexpr int READY_LEN = 16;
+
+// Bez const – tablica odczytywana w ISR musi leżeć w DRAM, nie we flash
+static uint8_t buttonPins[BUTTON_COUNT] = {PIN_BTN_UP, PIN_BTN_DOWN, PIN_BTN_ENTER, PIN_BTN_EXIT};
+
+static QueueHandle_t edgeQueue = NULL;
+static volatile bool edgesLost = false;
+static ButtonState buttons[BUTTON_COUNT];
+static ButtonEvent ready[READY_LEN];
+static uint8_t readyHead = 0;
+static uint8_t readyCount = 0;
+
+static SemaphoreHandle_t doorSignal = NULL;
+static volatile bool doorInterlock = false;
+static volatile bool doorLatencyPending = false;
+static volatile uint32_t doorEdgeUs = 0;
+static portMUX_TYPE doorMux = portMUX_INITIALIZER_UNLOCKED;
+static DoorStats doorStats = {0, 0, 0};
+static portMUX_TYPE doorStatsMux = portMUX_INITIALIZER_UNLOCKED;
+
+// ======================================================
+// PRZERWANIA
+// ======================================================
+
+static void IRAM_ATTR buttonIsr(void* arg) {
+    uint8_t idx = (uint8_t)(uintptr_t)arg;
+    RawEdge e = {idx, digitalRead(buttonPins[idx]) == LOW, millis()};
+    BaseType_t woken = pdFALSE;
+    if (xQueueSendFromISR(edgeQueue, &e, &woken) != pdTRUE) {
+        edgesLost = true;
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+static void IRAM_ATTR doorIsr() {
+    portENTER_CRITICAL_ISR(&doorMux);
+    if (digitalRead(PIN_DOOR) == HIGH && !doorInterlock) {
+        doorInterlock = true;
+        doorEdgeUs = micros();
+        doorLatencyPending = true;
+    }
+    portEXIT_CRITICAL_ISR(&doorMux);
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(doorSignal, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+void inputs_init() {
+    if (edgeQueue) return;
+
+    edgeQueue = xQueueCreate(EDGE_QUEUE_LEN, sizeof(RawEdge));
+    doorSignal = xSemaphoreCreateBinary();
+    if (!edgeQueue || !doorSignal) {
+        log_msg(LOG_LEVEL_ERROR, "inputs_init: queue/semaphore alloc failed!");
+        return;
+    }
+
+    uint32_t now = millis();
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        bool pressed = (digitalRead(buttonPins[i]) == LOW);
+        buttons[i] = {pressed, pressed, now, now, now, true};   // przytrzymany przy starcie – bez LONG
+        attachInterruptArg(digitalPinToInterrupt(buttonPins[i]), buttonIsr, (void*)(uintptr_t)i, CHANGE);
+    }
+
+    doorInterlock = (digitalRead(PIN_DOOR) == HIGH);
+    attachInterrupt(digitalPinToInterrupt(PIN_DOOR), doorIsr, CHANGE);
+
+    LOG_FMT(LOG_LEVEL_INFO, "Inputs: GPIO interrupts attached (door %s)",
+            doorInterlock ? "OPEN" : "CLOSED");
+}
+
+// ======================================================
+// PRZYCISKI – debounce, długie naciśnięcie, autorepeat
+// ======================================================
+
+static void pushEvent(int idx, ButtonAction action, uint32_t t) {
+    if (readyCount >= READY_LEN) return;
+    ready[(readyHead + readyCount) % READY_LEN] = {(ButtonId)idx, action, t};
+    readyCount++;
+}
+
+// Zatwierdza oczekujący poziom, jeśli utrzymał się DEBOUNCE_DELAY do chwili t
+static void settle(int idx, uint32_t t) {
+    ButtonState& b = buttons[idx];
+    if (b.pending == b.stable || t - b.pendingSince < DEBOUNCE_DELAY) return;
+
+    b.stable = b.pending;
+    if (b.stable) {
+        b.pressStart = b.pendingSince;
+        b.longSent = false;
+        pushEvent(idx, ButtonAction::PRESS, b.pendingSince);
+    } else {
+        pushEvent(idx, ButtonAction::RELEASE, b.pendingSince);
+    }
+}
+
+static void updateButtons() {
+    RawEdge e;
+    while (xQueueReceive(edgeQueue, &e, 0) == pdTRUE) {
+        if (e.idx >= BUTTON_COUNT) continue;
+        settle(e.idx, e.timeMs);
+        ButtonState& b = buttons[e.idx];
+        if (e.pressed != b.pending) {
+            b.pending = e.pressed;
+            b.pendingSince = e.timeMs;
+        }
+    }
+
+    uint32_t now = millis();
+    bool resync = edgesLost;
+    edgesLost = false;
+
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        ButtonState& b = buttons[i];
+        if (resync) {
+            // Przepełniona kolejka – poziom odczytany wprost z pinu
+            bool pressed = (digitalRead(buttonPins[i]) == LOW);
+            if (pressed != b.pending) {
+                b.pending = pressed;
+                b.pendingSince = now;
+            }
+        }
+        settle(i, now);
+
+        if (!b.stable) continue;
+        if (!b.longSent) {
+            if (now - b.pressStart >= LONG_PRESS_DURATION) {
+                b.longSent = true;
+                b.lastRepeat = now;
+                pushEvent(i, ButtonAction::LONG_PRESS, now);
+            }
+        } else if ((i == (int)ButtonId::UP || i == (int)ButtonId::DOWN) &&
+                   now - b.lastRepeat >= CFG_BTN_REPEAT_MS) {
+            b.lastRepeat = now;
+            pushEvent(i, ButtonAction::REPEAT, now);
+        }
+    }
+}
+
+bool inputs_poll(ButtonEvent& ev) {
+    if (!edgeQueue) return false;
+    if (readyCount == 0) updateButtons();
+    if (readyCount == 0) return false;
+
+    ev = ready[readyHead];
+    readyHead = (readyHead + 1) % READY_LEN;
+    readyCount--;
+    return true;
+}
+
+void inputs_discard() {
+    if (!edgeQueue) return;
+    xQueueReset(edgeQueue);
+    readyCount = 0;
+
+    uint32_t now = millis();
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        bool pressed = (digitalRead(buttonPins[i]) == LOW);
+        // Przycisk trzymany po wyjściu z ekranu nie generuje PRESS/LONG
+        buttons[i] = {pressed, pressed, now, now, now, true};
+    }
+}
+
+uint8_t inputs_button_pin(ButtonId id) {
+    return ((int)id < BUTTON_COUNT) ? buttonPins[(int)id] : 0;
+}
+
+// ======================================================
+// DRZWI – task Safety
+// ======================================================
+
+bool inputs_door_interlock() {
+    return doorInterlock;
+}
+
+void inputs_door_process(TickType_t wait) {
+    if (!doorSignal) {
+        vTaskDelay(wait);
+        checkDoor();
+        return;
+    }
+
+    // Timeout = okresowy odczyt na wypadek zgubionego zbocza
+    xSemaphoreTake(doorSignal, wait);
+
+    bool open = (digitalRead(PIN_DOOR) == HIGH);
+    if (open && !doorInterlock) {
+        doorInterlock = true;
+        log_msg(LOG_LEVEL_WARN, "Door open detected by recheck (edge missed)");
+    }
+
+    if (doorInterlock) {
+        // Szybka ścieżka: SSR na 0 przed jakimkolwiek mutexem stanu
+        heatersOffImmediate();
+
+        if (doorLatencyPending) {
+            doorLatencyPending = false;
+            uint32_t latency = micros() - doorEdgeUs;
+            portENTER_CRITICAL(&doorStatsMux);
+            doorStats.openEvents++;
+            doorStats.lastLatencyUs = latency;
+            if (latency > doorStats.maxLatencyUs) doorStats.maxLatencyUs = latency;
+            portEXIT_CRITICAL(&doorStatsMux);
+            LOG_FMT(LOG_LEVEL_INFO, "Door open -> SSR off in %lu us", (unsigned long)latency);
+        }
+
+        // Zapis z taska Control rozpoczęty przed ISR mógł nadpisać szybką ścieżkę –
+        // ponowne zerowanie pod output_lock zamyka to okno
+        if (output_lock()) {
+            heatersOffImmediate();
+            output_unlock();
+        }
+
+        if (!open) {
+            // Zamknięcie: blokada zdjęta dopiero po stabilnym stanie
+            vTaskDelay(pdMS_TO_TICKS(CFG_DOOR_CLOSE_DEBOUNCE_MS));
+            // Odczyt i zdjęcie blokady atomowo względem ISR (ponowne otwarcie)
+            portENTER_CRITICAL(&doorMux);
+            if (digitalRead(PIN_DOOR) == LOW) {
+                doorInterlock = false;
+            }
+            portEXIT_CRITICAL(&doorMux);
+        }
+    }
+
+    // Zmiana stanu procesu (PAUSE_DOOR / SOFT_RESUME) jak dotychczas
+    checkDoor();
+}
+
+DoorStats inputs_get_door_stats() {
+    portENTER_CRITICAL(&doorStatsMux);
+    DoorStats copy = doorStats;
+    portEXIT_CRITICAL(&doorStatsMux);
+    return copy;
+}
@@ -0,0 +1,52 @@
+// inputs.h - [NEW] Przyciski i krańcówka drzwi na przerwaniach GPIO
+// Zbocza trafiają z ISR do kolejki ze znacznikiem czasu, więc krótkie
+// naciśnięcie nie ginie, gdy task UI akurat rysuje. Otwarcie drzwi
+// ustawia blokadę grzałek już w ISR i budzi task Safety.
+#pragma once
+#include "hal.h"
+
+enum class ButtonId : uint8_t {
+    UP,
+    DOWN,
+    ENTER,
+    EXIT,
+    COUNT
+};
+
+enum class ButtonAction : uint8_t {
+    PRESS,        // stabilne wciśnięcie (po DEBOUNCE_DELAY)
+    LONG_PRESS,   // przytrzymanie >= LONG_PRESS_DURATION (raz)
+    REPEAT,       // autorepeat UP/DOWN po długim naciśnięciu
+    RELEASE
+};
+
+struct ButtonEvent {
+    ButtonId id;
+    ButtonAction action;
+    uint32_t timeMs;     // chwila zbocza z ISR (millis)
+};
+
+struct DoorStats {
+    uint32_t openEvents;
+    uint32_t lastLatencyUs;   // zbocze drzwi (ISR) → SSR wyłączone
+    uint32_t maxLatencyUs;
+};
+
+// Kolejka, semafor i przerwania – po hardware_init_pins(), przed tasks_create_all()
+void inputs_init();
+
+// Task UI: następne zdarzenie przycisku (false – brak zdarzeń)
+bool inputs_poll(ButtonEvent& ev);
+
+// Odrzuca zdarzenia zebrane w czasie blokujących ekranów (własne digitalRead)
+void inputs_discard();
+
+uint8_t inputs_button_pin(ButtonId id);
+
+// true od zbocza otwarcia (ISR) do stabilnego zamknięcia – grzałki wyłączone
+bool inputs_door_interlock();
+
+// Pętla taska Safety: czeka na zbocze drzwi (max wait) i obsługuje je
+void inputs_door_process(TickType_t wait);
+
+DoorStats inputs_get_door_stats();
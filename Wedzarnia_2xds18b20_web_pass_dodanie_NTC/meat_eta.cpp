@@ -0,0 +1,123 @@
+// meat_eta.cpp - [NEW] Prognoza temperatury mięsa (opis w meat_eta.h)
+#include "meat_eta.h"
+#include "config.h"
+#include "state.h"
+
+static constexpr double ETA_TARGET_MARGIN_C = 0.5;    // cel tuż pod tSet – dojście w nieskończoności
+
+static bool learningState(ProcessState st) {
+    return st == ProcessState::RUNNING_AUTO || st == ProcessState::RUNNING_MANUAL ||
+           st == ProcessState::SOFT_RESUME;
+}
+
+static void resetBatch(MeatEta& e, unsigned long batchStart) {
+    e = MeatEta();
+    e.batchStart = batchStart;
+}
+
+// Czas dojścia mięsa od tm do target przy komorze na tSet; -1 = nieosiągalny
+static double timeToTarget(double tm, double target, double tSet, double k) {
+    if (tm >= target) return 0;
+    if (k <= 0 || tSet - target < ETA_TARGET_MARGIN_C) return -1;
+    return log((tSet - tm) / (tSet - target)) / k;
+}
+
+// Reszta profilu dla danego k; stepSec = do tMeatTarget bieżącego kroku
+static void project(const Chamber& c, double k, unsigned long now, long& stepSec, long& processSec) {
+    double tm = c.tMeat;
+    double total = 0;
+    stepSec = -1;
+    processSec = -1;
+    for (int i = c.currentStep; i < c.stepCount; i++) {
+        const Step& s = c.profile[i];
+        double dur = s.minTimeMs / 1000.0;
+        if (i == c.currentStep) dur = max(0.0, dur - (now - c.stepStartTime) / 1000.0);
+        if (s.useMeatTemp) {
+            double need = timeToTarget(tm, s.tMeatTarget, s.tSet, k);
+            if (need < 0) return;
+            if (i == c.currentStep) stepSec = (long)need;
+            dur = max(dur, need);
+        }
+        tm = s.tSet - (s.tSet - tm) * exp(-k * dur);
+        total += dur;
+    }
+    processSec = (long)total;
+}
+
+static void processWindow(MeatEta& e, double chamber, double meat) {
+    double drive = chamber - meat;
+    if (e.haveWin) {
+        double x = (drive + e.lastWinDrive) / 2.0;
+        double y = (meat - e.lastWinMeat) / CFG_ETA_WINDOW_S;
+        if (fabs(x) >= CFG_ETA_MIN_DRIVE_C) {
+            e.sw  = CFG_ETA_FORGET * e.sw + 1.0;
+            e.sxx = CFG_ETA_FORGET * e.sxx + x * x;
+            e.sxy = CFG_ETA_FORGET * e.sxy + x * y;
+            e.syy = CFG_ETA_FORGET * e.syy + y * y;
+            if (e.windows < UINT16_MAX) e.windows++;
+
+            e.k = e.sxy / e.sxx;
+            double resVar = (e.syy - e.k * e.sxy) / max(e.sw - 1.0, 1.0);
+            e.kSigma = sqrt(max(resVar, 0.0) / e.sxx);
+        }
+    }
+    e.lastWinMeat = meat;
+    e.lastWinDrive = drive;
+    e.haveWin = true;
+}
+
+void meat_eta_update(Chamber& c, unsigned long now) {
+    MeatEta& e = c.eta;
+    if (e.lastSampleMs != 0 && now - e.lastSampleMs < 1000) return;
+    e.lastSampleMs = now;
+
+    if (!state_lock()) return;
+    ProcessState st = c.currentState;
+    if (!learningState(st) || c.errorSensor) {
+        e.winChamber = e.winMeat = 0;
+        e.winCount = 0;
+        e.haveWin = false;
+        e.stepSec = e.stepLoSec = e.stepHiSec = -1;
+        e.processSec = e.processLoSec = e.processHiSec = -1;
+        state_unlock();
+        return;
+    }
+    if (c.processStartTime != e.batchStart) {
+        resetBatch(e, c.processStartTime);
+        e.lastSampleMs = now;
+    }
+
+    bool wasValid = e.valid;
+    e.winChamber += c.tChamber;
+    e.winMeat += c.tMeat;
+    if (++e.winCount >= CFG_ETA_WINDOW_S) {
+        processWindow(e, e.winChamber / e.winCount, e.winMeat / e.winCount);
+        e.winChamber = e.winMeat = 0;
+        e.winCount = 0;
+        e.valid = e.windows >= CFG_ETA_MIN_WINDOWS && e.k > 0;
+    }
+
+    if (e.valid && st == ProcessState::RUNNING_AUTO) {
+        // Szum modelu (np. plateau parowania) nie jest w resztach – minimalne pasmo
+        double spread = max(CFG_ETA_CONFIDENCE_Z * e.kSigma, CFG_ETA_MIN_BAND * e.k);
+        project(c, e.k, now, e.stepSec, e.processSec);
+        project(c, e.k + spread, now, e.stepLoSec, e.processLoSec);
+        if (e.k - spread > 0) {
+            project(c, e.k - spread, now, e.stepHiSec, e.processHiSec);
+        } else {
+            e.stepHiSec = e.processHiSec = -1;
+        }
+    } else {
+        e.stepSec = e.stepLoSec = e.stepHiSec = -1;
+        e.processSec = e.processLoSec = e.processHiSec = -1;
+    }
+    bool nowValid = e.valid;
+    double tauMin = nowValid ? 1.0 / e.k / 60.0 : 0;
+    double sigmaPct = nowValid ? 100.0 * e.kSigma / e.k : 0;
+    state_unlock();
+
+    if (nowValid && !wasValid) {
+        LOG_FMT(LOG_LEVEL_INFO, "Meat K%u: tau=%.0f min (+/-%.0f%%)",
+                (unsigned)c.id, tauMin, sigmaPct);
+    }
+}
@@ -0,0 +1,18 @@
+// meat_eta.h - [NEW] Prognoza czasu do temperatury docelowej mięsa
+// Mięso dochodzi wykładniczo do temperatury komory:
+//   dTm/dt = k * (Tk - Tm),   stała czasowa 1/k
+// k estymowane online (każdy wsad od nowa): co CFG_ETA_WINDOW_S punkt
+// (x = Tk - Tm, y = przyrost Tm / s), regresja przez zero na sumach ważonych
+// z zapominaniem – O(1) na próbkę, pamięć stała. Wariancja k z reszt daje
+// pasmo +/- CFG_ETA_CONFIDENCE_Z sigma (krótszy / dłuższy wariant).
+//
+// Prognoza w AUTO: od bieżącego kroku do końca profilu, komora na tSet
+// kroku; krok z useMeatTemp trwa max(minTime, dojście mięsa do tMeatTarget),
+// mięso przechodzi między krokami z modelu. Cel <= tSet kroku nie zostanie
+// osiągnięty (asymptota) – prognoza -1, remainingProcessTimeSec naiwne.
+#pragma once
+#include "chamber.h"
+#include "hal.h"
+
+// Co takt z chamber_run_control_logic – próbka 1 s, okno, estymacja, prognoza
+void meat_eta_update(Chamber& c, unsigned long now);
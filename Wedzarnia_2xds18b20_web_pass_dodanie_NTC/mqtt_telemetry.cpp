@@ -0,0 +1,569 @@
+// mqtt_telemetry.cpp - [NEW] Publikacja telemetrii przez esp-mqtt (ESP-IDF)
+// – klient esp-mqtt z rdzenia Arduino 3.x: QoS 1, LWT i własny task sieciowy,
+//   bez dodatkowej biblioteki (PubSubClient publikuje tylko QoS 0)
+// – cała kolejka (pierścień RAM + segmenty SD) należy do taska Mqtt, więc
+//   nie ma własnego mutexu; handler zdarzeń esp-mqtt przekazuje tylko flagi
+//   i komendy (kolejka FreeRTOS)
+// – segment SD jest albo pisany, albo czytany: gdy czytnik otwiera segment,
+//   do którego trafiały zapisy, kolejne wiadomości idą do nowego segmentu
+#include "mqtt_telemetry.h"
+#include "config.h"
+#include "state.h"
+#include "storage.h"
+#include "process.h"
+#include "outputs.h"
+#include "wifimanager.h"
+#include <ArduinoJson.h>
+#include <mqtt_client.h>
+
+struct MqttMsg {
+    char topic[48];
+    char payload[CFG_MQTT_PAYLOAD_MAX];
+    uint8_t qos;
+};
+
+struct MqttCommand {
+    char payload[192];
+};
+
+// Próbki jednej komory czekające na paczkę
+struct TelemetryBatch {
+    uint8_t count;
+    unsigned long firstSampleSec;
+    float tc[CFG_MQTT_BATCH_SAMPLES];
+    float tm[CFG_MQTT_BATCH_SAMPLES];
+    uint8_t out[CFG_MQTT_BATCH_SAMPLES];
+    ProcessState lastState;
+    bool stateKnown;
+};
+
+static esp_mqtt_client_handle_t mqttClient = NULL;
+static QueueHandle_t cmdQueue = NULL;
+static volatile bool mqttConnected = false;
+static volatile bool mqttJustConnected = false;
+static MqttStats stats = {};               // pola taska Mqtt
+static uint32_t qosSent = 0;               // wysłane QoS 1 (task Mqtt)
+static volatile uint32_t ackedCount = 0;   // z handlera esp-mqtt
+static volatile uint32_t droppedCmds = 0;  // z handlera esp-mqtt
+
+static char topicStatus[40];
+static char topicCmd[40];
+static char topicAck[40];
+static char topicNet[40];
+
+static TelemetryBatch batches[CFG_CHAMBER_COUNT];
+static unsigned long lastSample = 0;
+
+// --- Pierścień RAM ---
+static MqttMsg ring[CFG_MQTT_RING_SLOTS];
+static uint8_t ringHead = 0;
+static uint8_t ringCount = 0;
+
+// --- Segmenty SD: istnieją [spoolFirst, spoolNext) ---
+static uint32_t spoolFirst = 0;
+static uint32_t spoolNext = 0;
+static uint16_t spoolWriteCount = 0;       // wiadomości w segmencie spoolNext-1
+static hal_file_t spoolReader = -1;        // otwarty segment spoolFirst
+static MqttMsg spoolMsg;                   // wczytana, jeszcze nie wysłana
+static bool spoolMsgValid = false;
+
+// --- Limit publikacji ---
+static uint8_t publishTokens = CFG_MQTT_PUBLISH_PER_SEC;
+static unsigned long lastTokenRefill = 0;
+
+// ======================================================
+// KOLEJKA: PIERŚCIEŃ RAM + SEGMENTY SD
+// ======================================================
+
+static void spoolPath(uint32_t seg, char* out, size_t size) {
+    snprintf(out, size, "%s/seg_%08lu.txt", CFG_MQTT_SPOOL_DIR, (unsigned long)seg);
+}
+
+static uint16_t spoolSegments() {
+    return (uint16_t)(spoolNext - spoolFirst);
+}
+
+static void spoolDropOldest() {
+    char path[48];
+    if (spoolReader >= 0) {
+        hal_fs_close(spoolReader);
+        spoolReader = -1;
+    }
+    spoolMsgValid = false;
+    spoolPath(spoolFirst, path, sizeof(path));
+    hal_fs_remove(path);
+    spoolFirst++;
+    stats.dropped += CFG_MQTT_SPOOL_SEGMENT_MSGS;
+    log_msg(LOG_LEVEL_WARN, "MQTT spool full - oldest segment dropped");
+}
+
+static bool spoolAppend(const char* topic, const char* payload, uint8_t qos) {
+    // Nowy segment: brak segmentów, bieżący pełny albo właśnie czytany
+    bool readingLast = (spoolReader >= 0 && spoolNext - 1 == spoolFirst);
+    if (spoolSegments() == 0 || spoolWriteCount >= CFG_MQTT_SPOOL_SEGMENT_MSGS || readingLast) {
+        spoolNext++;
+        spoolWriteCount = 0;
+        if (spoolSegments() > CFG_MQTT_SPOOL_MAX_SEGMENTS) spoolDropOldest();
+    }
+
+    char path[48];
+    spoolPath(spoolNext - 1, path, sizeof(path));
+    hal_file_t f = hal_fs_open(path, HalFileMode::APPEND);
+    if (f < 0) return false;
+
+    char head[56];
+    int headLen = snprintf(head, sizeof(head), "%u\t%s\t", (unsigned)qos, topic);
+    bool ok = hal_fs_write(f, head, headLen) == (size_t)headLen;
+    size_t len = strlen(payload);
+    ok = ok && hal_fs_write(f, payload, len) == len;
+    ok = ok && hal_fs_write(f, "\n", 1) == 1;
+    hal_fs_close(f);
+
+    if (ok) {
+        spoolWriteCount++;
+        stats.spooled++;
+    }
+    return ok;
+}
+
+// Następna wiadomość z najstarszego segmentu do spoolMsg
+static bool spoolLoadNext() {
+    if (spoolMsgValid) return true;
+
+    char line[sizeof(MqttMsg::topic) + CFG_MQTT_PAYLOAD_MAX + 8];
+    while (spoolSegments() > 0) {
+        char path[48];
+        spoolPath(spoolFirst, path, sizeof(path));
+        if (spoolReader < 0) {
+            spoolReader = hal_fs_open(path, HalFileMode::READ);
+            if (spoolReader < 0) {
+                spoolFirst++;      // segment zniknął (np. format karty)
+                continue;
+            }
+        }
+
+        int len = hal_fs_read_line(spoolReader, line, sizeof(line));
+        if (len < 0) {
+            hal_fs_close(spoolReader);
+            spoolReader = -1;
+            hal_fs_remove(path);
+            spoolFirst++;
+            if (spoolSegments() == 0) spoolWriteCount = 0;
+            continue;
+        }
+
+        // "qos\ttopic\tpayload"
+        char* tab1 = strchr(line, '\t');
+        char* tab2 = tab1 ? strchr(tab1 + 1, '\t') : NULL;
+        if (!tab2) continue;
+        *tab1 = '\0';
+        *tab2 = '\0';
+        spoolMsg.qos = (uint8_t)atoi(line);
+        strncpy(spoolMsg.topic, tab1 + 1, sizeof(spoolMsg.topic) - 1);
+        spoolMsg.topic[sizeof(spoolMsg.topic) - 1] = '\0';
+        strncpy(spoolMsg.payload, tab2 + 1, sizeof(spoolMsg.payload) - 1);
+        spoolMsg.payload[sizeof(spoolMsg.payload) - 1] = '\0';
+        spoolMsgValid = true;
+        return true;
+    }
+    return false;
+}
+
+struct SpoolScan {
+    uint32_t minSeg;
+    uint32_t maxSeg;
+    bool found;
+};
+
+// Zakres numerów segmentów z poprzedniego uruchomienia
+static bool spoolScanEntry(const char* name, void* ctx) {
+    SpoolScan* scan = (SpoolScan*)ctx;
+    const char* base = strrchr(name, '/');
+    base = base ? base + 1 : name;
+    unsigned long seg;
+    if (sscanf(base, "seg_%lu.txt", &seg) != 1) return true;
+    if (!scan->found || seg < scan->minSeg) scan->minSeg = seg;
+    if (!scan->found || seg > scan->maxSeg) scan->maxSeg = seg;
+    scan->found = true;
+    return true;
+}
+
+// Wiadomość do kolejki: pierścień, a gdy pełny lub SD ma zaległości – SD
+// (kolejność wysyłki: pierścień, potem segmenty od najstarszego)
+static void enqueue(const char* topic, const char* payload, uint8_t qos) {
+    if (spoolSegments() == 0 && ringCount < CFG_MQTT_RING_SLOTS) {
+        MqttMsg& m = ring[(ringHead + ringCount) % CFG_MQTT_RING_SLOTS];
+        strncpy(m.topic, topic, sizeof(m.topic) - 1);
+        m.topic[sizeof(m.topic) - 1] = '\0';
+        strncpy(m.payload, payload, sizeof(m.payload) - 1);
+        m.payload[sizeof(m.payload) - 1] = '\0';
+        m.qos = qos;
+        ringCount++;
+        return;
+    }
+    if (!spoolAppend(topic, payload, qos)) stats.dropped++;
+}
+
+// ======================================================
+// KLIENT MQTT
+// ======================================================
+
+static void mqttEventHandler(void* /*arg*/, esp_event_base_t /*base*/, int32_t eventId, void* eventData) {
+    esp_mqtt_event_handle_t ev = (esp_mqtt_event_handle_t)eventData;
+    switch ((esp_mqtt_event_id_t)eventId) {
+        case MQTT_EVENT_CONNECTED:
+            mqttConnected = true;
+            mqttJustConnected = true;
+            break;
+        case MQTT_EVENT_DISCONNECTED:
+            mqttConnected = false;
+            break;
+        case MQTT_EVENT_PUBLISHED:
+            ackedCount++;
+            break;
+        case MQTT_EVENT_DATA: {
+            // Tylko temat komend, jedna ramka (komenda mieści się w buforze)
+            MqttCommand cmd;
+            bool isCmd = ev->topic_len == (int)strlen(topicCmd) &&
+                         strncmp(ev->topic, topicCmd, ev->topic_len) == 0;
+            if (!isCmd || ev->data_len <= 0 || ev->data_len != ev->total_data_len ||
+                ev->data_len >= (int)sizeof(cmd.payload)) {
+                droppedCmds++;
+                break;
+            }
+            memcpy(cmd.payload, ev->data, ev->data_len);
+            cmd.payload[ev->data_len] = '\0';
+            if (xQueueSend(cmdQueue, &cmd, 0) != pdTRUE) droppedCmds++;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+static void startClient() {
+    esp_mqtt_client_config_t cfg = {};
+    cfg.broker.address.uri = CFG_MQTT_BROKER_URI;
+    if (CFG_MQTT_USER[0]) {
+        cfg.credentials.username = CFG_MQTT_USER;
+        cfg.credentials.authentication.password = CFG_MQTT_PASS;
+    }
+    cfg.session.last_will.topic = topicStatus;
+    cfg.session.last_will.msg = "offline";
+    cfg.session.last_will.qos = 1;
+    cfg.session.last_will.retain = 1;
+    cfg.network.reconnect_timeout_ms = CFG_WIFI_RETRY_MIN_DELAY;
+
+    mqttClient = esp_mqtt_client_init(&cfg);
+    if (!mqttClient) {
+        log_msg(LOG_LEVEL_ERROR, "MQTT client init failed");
+        return;
+    }
+    esp_mqtt_client_register_event(mqttClient, MQTT_EVENT_ANY, mqttEventHandler, NULL);
+    esp_mqtt_client_start(mqttClient);
+    LOG_FMT(LOG_LEVEL_INFO, "MQTT client started: %s", CFG_MQTT_BROKER_URI);
+}
+
+// Wiadomości QoS 1 bez PUBACK; liczniki piszą różne taski, więc bez "inflight--"
+static uint32_t inflight() {
+    uint32_t acked = ackedCount;
+    return qosSent > acked ? qosSent - acked : 0;
+}
+
+static bool publishMsg(const MqttMsg& m) {
+    if (m.qos > 0 && inflight() >= CFG_MQTT_MAX_INFLIGHT) return false;
+    int id = esp_mqtt_client_publish(mqttClient, m.topic, m.payload, 0, m.qos, 0);
+    if (id < 0) return false;
+    if (m.qos > 0) qosSent++;
+    stats.published++;
+    return true;
+}
+
+// Opróżnianie kolejki z limitem CFG_MQTT_PUBLISH_PER_SEC
+static void drainQueue() {
+    unsigned long now = millis();
+    if (now - lastTokenRefill >= 1000) {
+        publishTokens = CFG_MQTT_PUBLISH_PER_SEC;
+        lastTokenRefill = now;
+    }
+
+    while (publishTokens > 0) {
+        if (ringCount > 0) {
+            if (!publishMsg(ring[ringHead])) return;
+            ringHead = (ringHead + 1) % CFG_MQTT_RING_SLOTS;
+            ringCount--;
+        } else if (spoolLoadNext()) {
+            if (!publishMsg(spoolMsg)) return;
+            spoolMsgValid = false;
+        } else {
+            return;
+        }
+        publishTokens--;
+    }
+}
+
+// Po (ponownym) połączeniu: subskrypcja komend, status online, przestój WiFi
+static void onConnected() {
+    qosSent = ackedCount;   // PUBACK sprzed rozłączenia już nie przyjdą
+    esp_mqtt_client_subscribe_single(mqttClient, topicCmd, 1);
+    if (esp_mqtt_client_publish(mqttClient, topicStatus, "online", 0, 1, 1) >= 0) {
+        qosSent++;
+        stats.published++;
+    }
+
+    WiFiStats ws = wifi_get_stats();
+    char payload[160];
+    snprintf(payload, sizeof(payload),
+             "{\"t\":%lu,\"wifiDownSec\":%lu,\"disconnects\":%d,\"ring\":%u,\"spoolSeg\":%u,\"dropped\":%lu}",
+             millis() / 1000, ws.totalDowntime / 1000, ws.disconnectCount,
+             ringCount, spoolSegments(), (unsigned long)stats.dropped);
+    enqueue(topicNet, payload, 1);
+
+    LOG_FMT(LOG_LEVEL_INFO, "MQTT connected, backlog: %u in RAM, %u SD segment(s)",
+            ringCount, spoolSegments());
+}
+
+// ======================================================
+// PRÓBKI I ZDARZENIA
+// ======================================================
+
+static const char* stateName(ProcessState st) {
+    switch (st) {
+        case ProcessState::IDLE:               return "IDLE";
+        case ProcessState::RUNNING_AUTO:       return "RUNNING_AUTO";
+        case ProcessState::RUNNING_MANUAL:     return "RUNNING_MANUAL";
+        case ProcessState::PAUSE_DOOR:         return "PAUSE_DOOR";
+        case ProcessState::PAUSE_SENSOR:       return "PAUSE_SENSOR";
+        case ProcessState::PAUSE_OVERHEAT:     return "PAUSE_OVERHEAT";
+        case ProcessState::PAUSE_HEATER_FAULT: return "PAUSE_HEATER_FAULT";
+        case ProcessState::PAUSE_USER:         return "PAUSE_USER";
+        case ProcessState::ERROR_PROFILE:      return "ERROR_PROFILE";
+        case ProcessState::SOFT_RESUME:        return "SOFT_RESUME";
+        case ProcessState::AUTOTUNE:           return "AUTOTUNE";
+        default:                               return "UNKNOWN";
+    }
+}
+
+static bool isAlarmState(ProcessState st) {
+    return st == ProcessState::PAUSE_SENSOR ||
+           st == ProcessState::PAUSE_OVERHEAT ||
+           st == ProcessState::PAUSE_HEATER_FAULT ||
+           st == ProcessState::ERROR_PROFILE;
+}
+
+static void publishBatch(uint8_t ch, TelemetryBatch& b, double tSet, ProcessState st) {
+    char topic[48];
+    char payload[CFG_MQTT_PAYLOAD_MAX];
+    snprintf(topic, sizeof(topic), "%s/%u/telemetry", CFG_MQTT_TOPIC_PREFIX, (unsigned)ch);
+
+    int n = snprintf(payload, sizeof(payload), "{\"t\":%lu,\"dt\":%lu,\"ts\":%.1f,\"st\":%d,\"tc\":[",
+                     b.firstSampleSec, CFG_MQTT_SAMPLE_MS / 1000, tSet, (int)st);
+    for (uint8_t i = 0; i < b.count && n < (int)sizeof(payload); i++) {
+        n += snprintf(payload + n, sizeof(payload) - n, "%s%.1f", i ? "," : "", b.tc[i]);
+    }
+    if (n < (int)sizeof(payload)) n += snprintf(payload + n, sizeof(payload) - n, "],\"tm\":[");
+    for (uint8_t i = 0; i < b.count && n < (int)sizeof(payload); i++) {
+        n += snprintf(payload + n, sizeof(payload) - n, "%s%.1f", i ? "," : "", b.tm[i]);
+    }
+    if (n < (int)sizeof(payload)) n += snprintf(payload + n, sizeof(payload) - n, "],\"out\":[");
+    for (uint8_t i = 0; i < b.count && n < (int)sizeof(payload); i++) {
+        n += snprintf(payload + n, sizeof(payload) - n, "%s%u", i ? "," : "", b.out[i]);
+    }
+    if (n < (int)sizeof(payload)) n += snprintf(payload + n, sizeof(payload) - n, "]}");
+    if (n >= (int)sizeof(payload)) {
+        log_msg(LOG_LEVEL_ERROR, "MQTT telemetry payload too long");
+        return;
+    }
+    enqueue(topic, payload, 1);
+}
+
+static void publishStateEvent(uint8_t ch, ProcessState st) {
+    char topic[48];
+    char payload[128];
+    snprintf(topic, sizeof(topic), "%s/%u/event", CFG_MQTT_TOPIC_PREFIX, (unsigned)ch);
+    snprintf(payload, sizeof(payload), "{\"t\":%lu,\"state\":\"%s\",\"code\":%d,\"alarm\":%s}",
+             millis() / 1000, stateName(st), (int)st, isAlarmState(st) ? "true" : "false");
+    enqueue(topic, payload, 1);
+}
+
+static void sampleChambers() {
+    unsigned long nowSec = millis() / 1000;
+    for (uint8_t i = 0; i < CFG_CHAMBER_COUNT; i++) {
+        const Chamber& c = g_chambers[i];
+        if (!state_lock()) return;
+        ProcessState st = c.currentState;
+        double tc = c.tChamber;
+        double tm = c.tMeat;
+        double ts = c.tSet;
+        double out = c.pidOutput;
+        state_unlock();
+
+        TelemetryBatch& b = batches[i];
+        if (!b.stateKnown || st != b.lastState) {
+            publishStateEvent(i, st);
+            b.lastState = st;
+            b.stateKnown = true;
+        }
+
+        if (b.count == 0) b.firstSampleSec = nowSec;
+        b.tc[b.count] = (float)tc;
+        b.tm[b.count] = (float)tm;
+        b.out[b.count] = (uint8_t)constrain(out, 0, 100);
+        b.count++;
+        if (b.count >= CFG_MQTT_BATCH_SAMPLES) {
+            publishBatch(i, b, ts, st);
+            b.count = 0;
+        }
+    }
+}
+
+// ======================================================
+// KOMENDY ZDALNE
+// ======================================================
+
+static void publishAck(const char* cmd, uint8_t ch, bool ok) {
+    char payload[96];
+    snprintf(payload, sizeof(payload), "{\"cmd\":\"%.16s\",\"ch\":%u,\"ok\":%s}",
+             cmd, (unsigned)ch, ok ? "true" : "false");
+    enqueue(topicAck, payload, 1);
+}
+
+static void handleCommand(const char* json) {
+    StaticJsonDocument<256> doc;
+    if (deserializeJson(doc, json)) {
+        stats.rejected++;
+        log_msg(LOG_LEVEL_WARN, "MQTT command: invalid JSON");
+        return;
+    }
+
+    const char* user = doc["user"];
+    const char* pass = doc["pass"];
+    const char* cmd  = doc["cmd"];
+    if (!user || !pass || strcmp(user, storage_get_auth_user()) != 0 ||
+        strcmp(pass, storage_get_auth_pass()) != 0) {
+        stats.rejected++;
+        log_msg(LOG_LEVEL_WARN, "MQTT command rejected: bad credentials");
+        publishAck(cmd ? cmd : "", 0, false);
+        return;
+    }
+    if (!cmd) cmd = "";
+
+    int chArg = doc["ch"].isNull() ? 0 : doc["ch"].as<int>();
+    bool ok = false;
+    if (chArg >= 0 && chArg < CFG_CHAMBER_COUNT) {
+        uint8_t ch = (uint8_t)chArg;
+        Chamber& c = chamber_get(ch);
+        if (strcmp(cmd, "start") == 0) {
+            ok = storage_load_profile(ch);
+            if (ok) process_start_auto(ch);
+        } else if (strcmp(cmd, "manual") == 0) {
+            process_start_manual(ch);
+            ok = true;
+        } else if (strcmp(cmd, "stop") == 0) {
+            chamberOutputsOff(c);
+            if (state_lock()) {
+                c.currentState = ProcessState::IDLE;
+                state_unlock();
+            }
+            ok = true;
+        } else if (strcmp(cmd, "setpoint") == 0 && doc["tSet"].is<float>()) {
+            double val = constrain(doc["tSet"].as<double>(), CFG_T_MIN_SET, CFG_T_MAX_SET);
+            if (state_lock()) {
+                c.tSet = val;
+                state_unlock();
+                ok = true;
+            }
+            if (ch == 0) storage_save_manual_settings_nvs();
+        }
+    }
+
+    if (ok) stats.commands++;
+    else stats.rejected++;
+    LOG_FMT(LOG_LEVEL_INFO, "MQTT command '%s' (ch %d): %s", cmd, chArg, ok ? "OK" : "FAILED");
+    publishAck(cmd, chArg < 0 ? 0 : (uint8_t)chArg, ok);
+}
+
+// ======================================================
+// API
+// ======================================================
+
+void mqtt_telemetry_init() {
+    snprintf(topicStatus, sizeof(topicStatus), "%s/status", CFG_MQTT_TOPIC_PREFIX);
+    snprintf(topicCmd, sizeof(topicCmd), "%s/cmd", CFG_MQTT_TOPIC_PREFIX);
+    snprintf(topicAck, sizeof(topicAck), "%s/cmd/ack", CFG_MQTT_TOPIC_PREFIX);
+    snprintf(topicNet, sizeof(topicNet), "%s/net", CFG_MQTT_TOPIC_PREFIX);
+
+    cmdQueue = xQueueCreate(4, sizeof(MqttCommand));
+    if (!cmdQueue) {
+        log_msg(LOG_LEVEL_ERROR, "MQTT command queue creation failed!");
+        return;
+    }
+    if (!CFG_MQTT_BROKER_URI[0]) return;
+
+    // Zaległości z poprzedniego uruchomienia
+    if (!hal_fs_exists(CFG_MQTT_SPOOL_DIR)) {
+        hal_fs_mkdir(CFG_MQTT_SPOOL_DIR);
+    } else {
+        SpoolScan scan = {0, 0, false};
+        hal_fs_list(CFG_MQTT_SPOOL_DIR, spoolScanEntry, &scan);
+        if (scan.found) {
+            spoolFirst = scan.minSeg;
+            spoolNext = scan.maxSeg + 1;
+            spoolWriteCount = CFG_MQTT_SPOOL_SEGMENT_MSGS;   // dopisywanie do nowego
+            LOG_FMT(LOG_LEVEL_INFO, "MQTT spool: %u segment(s) from previous run",
+                    spoolSegments());
+        }
+    }
+}
+
+void mqtt_telemetry_process(uint32_t waitMs) {
+    if (!CFG_MQTT_BROKER_URI[0] || !cmdQueue) {
+        hal_delay_ms(waitMs);
+        return;
+    }
+
+    MqttCommand cmd;
+    if (xQueueReceive(cmdQueue, &cmd, pdMS_TO_TICKS(waitMs)) == pdTRUE) {
+        handleCommand(cmd.payload);
+    }
+
+    if (!mqttClient && wifi_is_connected()) startClient();
+
+    unsigned long now = millis();
+    if (now - lastSample >= CFG_MQTT_SAMPLE_MS) {
+        lastSample = now;
+        sampleChambers();
+    }
+
+    bool online = mqttClient && mqttConnected && wifi_is_connected();
+    if (online && mqttJustConnected) {
+        mqttJustConnected = false;
+        onConnected();
+    }
+    if (online) drainQueue();
+}
+
+MqttStats mqtt_get_stats() {
+    MqttStats s = stats;
+    s.acked = ackedCount;
+    s.rejected += droppedCmds;
+    s.ringCount = ringCount;
+    s.spoolSegments = spoolSegments();
+    s.connected = mqttConnected && wifi_is_connected();
+    return s;
+}
+
+String mqtt_status_json() {
+    MqttStats s = mqtt_get_stats();
+    char json[256];
+    snprintf(json, sizeof(json),
+        "{\"enabled\":%s,\"connected\":%s,\"published\":%lu,\"acked\":%lu,"
+        "\"ring\":%u,\"spoolSegments\":%u,\"spooled\":%lu,\"dropped\":%lu,"
+        "\"commands\":%lu,\"rejected\":%lu}",
+        CFG_MQTT_BROKER_URI[0] ? "true" : "false", s.connected ? "true" : "false",
+        (unsigned long)s.published, (unsigned long)s.acked,
+        (unsigned)s.ringCount, (unsigned)s.spoolSegments,
+        (unsigned long)s.spooled, (unsigned long)s.dropped,
+        (unsigned long)s.commands, (unsigned long)s.rejected);
+    return String(json);
+}
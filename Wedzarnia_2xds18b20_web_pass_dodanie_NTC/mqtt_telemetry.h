@@ -0,0 +1,44 @@
+// mqtt_telemetry.h - [NEW] Telemetria MQTT z paczkowaniem i kolejką offline
+// Task Mqtt co 1 s próbkuje każdą komorę, co CFG_MQTT_BATCH_SAMPLES próbek
+// publikuje jedną wiadomość (QoS 1). Zmiany stanu i alarmy – osobne zdarzenia.
+//
+// Tematy (prefiks CFG_MQTT_TOPIC_PREFIX):
+//   <p>/status          online/offline (retain, LWT)
+//   <p>/net             po połączeniu: przestój WiFi (WiFiStats), zaległości (RAM / segmenty SD)
+//   <p>/<ch>/telemetry  {"t":s,"dt":1,"tc":[..],"tm":[..],"out":[..],"ts":..,"st":..}
+//   <p>/<ch>/event      {"t":s,"state":"PAUSE_DOOR","code":4,"alarm":true}
+//   <p>/cmd             komendy: {"user":..,"pass":..,"cmd":"start|manual|stop|setpoint",
+//                                 "ch":0,"tSet":75} – dane logowania jak do WWW
+//   <p>/cmd/ack         {"cmd":..,"ch":..,"ok":true|false}
+//
+// Bez połączenia wiadomości czekają w pierścieniu RAM, nadmiar w segmentach
+// na SD (CFG_MQTT_SPOOL_DIR, przetrwa restart). Po powrocie sieci kolejka
+// jest opróżniana w kolejności, max CFG_MQTT_PUBLISH_PER_SEC wiadomości/s.
+//
+// Test lokalny: CFG_MQTT_BROKER_URI = "mqtt://<ip-pc>:1883", na PC
+//   mosquitto -v    oraz    mosquitto_sub -t 'wedzarnia/#' -v
+#pragma once
+#include "hal.h"
+
+struct MqttStats {
+    uint32_t published;       // przekazane do klienta MQTT
+    uint32_t acked;           // potwierdzone PUBACK (QoS 1)
+    uint32_t spooled;         // zapisane na SD (pierścień pełny / zaległości)
+    uint32_t dropped;         // utracone (limit segmentów SD, błąd zapisu)
+    uint32_t commands;        // przyjęte komendy
+    uint32_t rejected;        // odrzucone komendy (auth / składnia)
+    uint16_t ringCount;       // wiadomości w RAM
+    uint16_t spoolSegments;   // segmenty na SD
+    bool connected;
+};
+
+// Kolejka komend i odtworzenie kolejki z SD – wywołać przed tasks_create_all()
+void mqtt_telemetry_init();
+
+// Pętla taska Mqtt: próbki, zdarzenia, komendy (czeka max waitMs), publikacja
+void mqtt_telemetry_process(uint32_t waitMs);
+
+MqttStats mqtt_get_stats();
+
+// Stan dla /api/mqtt
+String mqtt_status_json();
@@ -1,7 +1,14 @@
 // outputs.cpp - [FIX] Sprawdzanie wartości zwracanych przez lock()
+// [NEW] Grzałki, dymogenerator i wentylator per komora – piny z c.hw,
+//       soft-enable i timer wentylatora w obiekcie Chamber
 #include "outputs.h"
 #include "config.h"
 #include "state.h"
+#include "inputs.h"
+#include "ssr_tp.h"
+#include "fan_sched.h"
+#include "heater_diag.h"
+#include "overheat.h"
 
 // --- Zmienne dla brzęczyka ---
 static volatile bool buzzerActive = false;
@@ -11,25 +18,78 @@ static volatile uint16_t buzzerOffMs = 100;
 static volatile bool buzzerPhaseOn = false;
 static volatile unsigned long buzzerPhaseEnd = 0;
 
-// --- Zmienne dla grzałek (chronione heaterMutex) ---
-static HeaterEnable he;
+// [NEW] Licznik czasu ON wentylatora / dymu – tylko przy zmianie wypełnienia
+static portMUX_TYPE meterMux = portMUX_INITIALIZER_UNLOCKED;
 
-// --- Zmienne dla wentylatora cyklicznego (atomic) ---
-static volatile bool fanState = true;
-static volatile unsigned long fanTimer = 0;
+static void meterSet(OutputMeter& m, uint8_t duty) {
+    if (m.duty == duty) return;
+    unsigned long now = millis();
+    portENTER_CRITICAL(&meterMux);
+    m.units += (uint64_t)m.duty * (now - m.sinceMs);
+    m.sinceMs = now;
+    m.duty = duty;
+    portEXIT_CRITICAL(&meterMux);
+}
+
+uint64_t outputs_meter_on_ms(const OutputMeter& m) {
+    unsigned long now = millis();
+    portENTER_CRITICAL(&meterMux);
+    uint64_t units = m.units + (uint64_t)m.duty * (now - m.sinceMs);
+    portEXIT_CRITICAL(&meterMux);
+    return units / 255;
+}
+
+static void writeFan(Chamber& c, bool on) {
+    hal_gpio_write(c.hw->fanPin, on);
+    meterSet(c.fanMeter, on ? 255 : 0);
+}
+
+void outputs_write_smoke(Chamber& c, int duty) {
+    duty = constrain(duty, 0, 255);
+    hal_pwm_write(c.hw->smokePin, duty);
+    meterSet(c.smokeMeter, (uint8_t)duty);
+}
+
+static void writeChamberOutputsOff(Chamber& c) {
+    for (uint8_t i = 0; i < 3; i++) {
+        ssr_tp_write(c.hw->ssrPins[i], 0);
+    }
+    writeFan(c, false);
+    outputs_write_smoke(c, 0);
+}
+
+void chamberOutputsOff(Chamber& c) {
+    // [FIX] Sprawdzenie czy udało się zablokować mutex
+    bool locked = output_lock();
+    if (!locked) {
+        log_msg(LOG_LEVEL_ERROR, "chamberOutputsOff: output_lock failed!");
+        // Mimo to spróbuj wyłączyć wyjścia - bezpieczeństwo ważniejsze
+    }
+    writeChamberOutputsOff(c);
+    if (locked) output_unlock();
+}
 
 void allOutputsOff() {
     // [FIX] Sprawdzenie czy udało się zablokować mutex
-    if (!output_lock()) {
+    bool locked = output_lock();
+    if (!locked) {
         log_msg(LOG_LEVEL_ERROR, "allOutputsOff: output_lock failed!");
         // Mimo to spróbuj wyłączyć wyjścia - bezpieczeństwo ważniejsze
     }
-    ledcWrite(PIN_SSR1, 0);
-    ledcWrite(PIN_SSR2, 0);
-    ledcWrite(PIN_SSR3, 0);
-    digitalWrite(PIN_FAN, LOW);
-    ledcWrite(PIN_SMOKE_FAN, 0);
-    output_unlock();
+    for (uint8_t i = 0; i < CFG_CHAMBER_COUNT; i++) {
+        writeChamberOutputsOff(g_chambers[i]);
+    }
+    if (locked) output_unlock();
+}
+
+// [NEW] Szybka ścieżka bezpieczeństwa (drzwi): SSR na 0 bez czekania na
+// output_lock – ssr_tp_write ma własną sekcję krytyczną i zeruje pin od razu.
+// Przerwanie drzwi obsługuje tylko komorę 0 (PIN_DOOR).
+void heatersOffImmediate() {
+    const ChamberHw* hw = g_chambers[0].hw;
+    for (uint8_t i = 0; i < 3; i++) {
+        ssr_tp_write(hw->ssrPins[i], 0);
+    }
 }
 
 void buzzerBeep(uint8_t count, uint16_t onMs, uint16_t offMs) {
@@ -39,7 +99,7 @@ void buzzerBeep(uint8_t count, uint16_t onMs, uint16_t offMs) {
     buzzerOffMs = offMs;
     buzzerPhaseOn = true;
     buzzerPhaseEnd = millis() + onMs;
-    digitalWrite(PIN_BUZZER, HIGH);
+    hal_gpio_write(PIN_BUZZER, true);
     buzzerActive = true;
 }
 
@@ -48,7 +108,7 @@ void handleBuzzer() {
     unsigned long now = millis();
     if (now >= buzzerPhaseEnd) {
         if (buzzerPhaseOn) {
-            digitalWrite(PIN_BUZZER, LOW);
+            hal_gpio_write(PIN_BUZZER, false);
             buzzerBeepsRemaining--;
             if (buzzerBeepsRemaining > 0) {
                 buzzerPhaseOn = false;
@@ -59,52 +119,83 @@ void handleBuzzer() {
         } else {
             buzzerPhaseOn = true;
             buzzerPhaseEnd = now + buzzerOnMs;
-            digitalWrite(PIN_BUZZER, HIGH);
+            hal_gpio_write(PIN_BUZZER, true);
         }
     }
 }
 
-void initHeaterEnable() {
+void initHeaterEnable(Chamber& c) {
     unsigned long now = millis();
     // [FIX] Sprawdzenie locka
     if (!heater_lock()) {
         log_msg(LOG_LEVEL_ERROR, "initHeaterEnable: heater_lock failed!");
         return;
     }
-    he.h1 = he.h2 = he.h3 = false;
-    he.t1 = now;
-    he.t2 = now;
-    he.t3 = now;
+    c.he.h1 = c.he.h2 = c.he.h3 = false;
+    c.he.t1 = now;
+    c.he.t2 = now;
+    c.he.t3 = now;
     heater_unlock();
 }
 
-void applySoftEnable() {
+void applySoftEnable(Chamber& c) {
     unsigned long now = millis();
     // [FIX] Sprawdzenie locka
     if (!heater_lock()) return;
-    if (now - he.t1 > 1000) he.h1 = true;
-    if (now - he.t2 > 2000) he.h2 = true;
-    if (now - he.t3 > 3000) he.h3 = true;
+    if (now - c.he.t1 > 1000) c.he.h1 = true;
+    if (now - c.he.t2 > 2000) c.he.h2 = true;
+    if (now - c.he.t3 > 3000) c.he.h3 = true;
     heater_unlock();
 }
 
-bool areHeatersReady() {
+bool areHeatersReady(Chamber& c) {
     // [FIX] Sprawdzenie locka
     if (!heater_lock()) return false;
-    bool ready = he.h1 && he.h2 && he.h3;
+    bool ready = c.he.h1 && c.he.h2 && c.he.h3;
     heater_unlock();
     return ready;
 }
 
-void mapPowerToHeaters() {
+// [NEW] Rotacja grzałki wiodącej: co CFG_HEATER_ROTATE_MS kolejność wg
+// łącznego czasu ON z ssr_tp (najmniej zużyta pierwsza). Tylko z taktu
+// sterowania – heaterOrder bez blokady.
+static void rotateHeaters(Chamber& c) {
+    if (CFG_HEATER_ROTATE_MS == 0) return;
+    unsigned long now = millis();
+    if (now - c.heaterRotateMs < CFG_HEATER_ROTATE_MS) return;
+    c.heaterRotateMs = now;
+
+    uint64_t onMs[3];
+    for (uint8_t i = 0; i < 3; i++) onMs[i] = ssr_tp_on_ms(c.hw->ssrPins[i]);
+    uint8_t order[3] = {0, 1, 2};
+    for (uint8_t i = 1; i < 3; i++) {
+        for (uint8_t j = i; j > 0 && onMs[order[j]] < onMs[order[j - 1]]; j--) {
+            uint8_t t = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = t;
+        }
+    }
+    if (order[0] != c.heaterOrder[0]) {
+        LOG_FMT(LOG_LEVEL_INFO, "Heaters K%u: primary %u -> %u",
+                (unsigned)c.id, (unsigned)c.heaterOrder[0] + 1, (unsigned)order[0] + 1);
+    }
+    memcpy(c.heaterOrder, order, sizeof(order));
+}
+
+void mapPowerToHeaters(Chamber& c) {
     double p1 = 0, p2 = 0, p3 = 0;
-    double p = constrain(pidOutput, 0, 100);
+    double p = constrain(c.pidOutput, 0, 100);
 
     // [FIX] Sprawdzenie locka
     if (!state_lock()) return;
-    int pm = g_powerMode;
+    int pm = c.powerMode;
+    // [NEW] Redukcja przed przegrzaniem (overheat.cpp) – na wyjściu PID,
+    // więc najpierw gasną grzałki dołączane w trybie 2 / 3
+    double ovhFactor = overheat_power_factor(c);
     state_unlock();
+    p *= ovhFactor;
 
+    rotateHeaters(c);
     if (pm == 1) {
         p1 = p;
     } else if (pm == 2) {
@@ -118,49 +209,74 @@ void mapPowerToHeaters() {
 
     // [FIX] Sprawdzenie locka
     if (!heater_lock()) return;
-    if (!he.h1) p1 = 0;
-    if (!he.h2) p2 = 0;
-    if (!he.h3) p3 = 0;
+    // [FIX] Soft-start dotyczy fizycznych grzałek (h1..h3 = piny 1..3),
+    // p1..p3 to miejsca w kolejności – bramka wg heaterOrder
+    bool enabled[3] = { c.he.h1, c.he.h2, c.he.h3 };
     heater_unlock();
+    if (!enabled[c.heaterOrder[0]]) p1 = 0;
+    if (!enabled[c.heaterOrder[1]]) p2 = 0;
+    if (!enabled[c.heaterOrder[2]]) p3 = 0;
 
     if (!output_lock()) return;
-    ledcWrite(PIN_SSR1, (int)(p1 * 2.55));
-    ledcWrite(PIN_SSR2, (int)(p2 * 2.55));
-    ledcWrite(PIN_SSR3, (int)(p3 * 2.55));
+    // [NEW] Blokada ustawiana w ISR drzwi – SSR zostają wyłączone jeszcze
+    // zanim checkDoor() zmieni stan procesu na PAUSE_DOOR. Pozostałe komory
+    // nie mają przerwania – odczyt krańcówki bezpośrednio.
+    bool doorInterlock = (c.id == 0) ? inputs_door_interlock()
+                                     : hal_gpio_read(c.hw->doorPin);
+    if (doorInterlock) {
+        p1 = p2 = p3 = 0;
+    }
+    // [NEW] Okno półokresów zamiast PWM 5 kHz; p3 > 100 (tryb 3) obcina ssr_tp.
+    // p1..p3 = grzałka wiodąca, druga, trzecia – fizyczny pin wg heaterOrder
+    double duty[3];
+    duty[c.heaterOrder[0]] = p1;
+    duty[c.heaterOrder[1]] = p2;
+    duty[c.heaterOrder[2]] = p3;
+    if (!doorInterlock) {
+        // [FIX] Próba kanału (heater_diag.cpp): odchyłka wokół mocy z PID
+        // tylko na kanałach czynnych; soft-start nadal wyłącza grzałkę
+        heater_diag_probe_duty(c, duty);
+        for (uint8_t i = 0; i < 3; i++) {
+            if (!enabled[i]) duty[i] = 0;
+        }
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+        ssr_tp_write(c.hw->ssrPins[i], (int)(duty[i] * 2.55));
+    }
     output_unlock();
 }
 
-void handleFanLogic() {
+void handleFanLogic(Chamber& c) {
     // [FIX] Sprawdzenie locka
     if (!state_lock()) return;
-    int fm = g_fanMode;
-    unsigned long onT = g_fanOnTime;
-    unsigned long offT = g_fanOffTime;
+    int fm = c.fanMode;
+    unsigned long onT, offT;
+    fan_sched_times(c, onT, offT);     // [NEW] czasy z harmonogramu (fan_sched.cpp)
     state_unlock();
 
     if (fm == 0) {
-        digitalWrite(PIN_FAN, LOW);
+        writeFan(c, false);
 
     } else if (fm == 1) {
-        digitalWrite(PIN_FAN, HIGH);
+        writeFan(c, true);
 
     } else if (fm == 2) {
         unsigned long now = millis();
 
-        bool currentFanState = fanState;
-        unsigned long currentTimer = fanTimer;
+        bool currentFanState = c.fanState;
+        unsigned long currentTimer = c.fanTimer;
 
         if (currentFanState) {
             if (now - currentTimer >= onT) {
-                fanState = false;
-                fanTimer = now;
-                digitalWrite(PIN_FAN, LOW);
+                c.fanState = false;
+                c.fanTimer = now;
+                writeFan(c, false);
             }
         } else {
             if (now - currentTimer >= offT) {
-                fanState = true;
-                fanTimer = now;
-                digitalWrite(PIN_FAN, HIGH);
+                c.fanState = true;
+                c.fanTimer = now;
+                writeFan(c, true);
             }
         }
     }
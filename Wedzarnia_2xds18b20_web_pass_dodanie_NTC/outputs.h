@@ -2,11 +2,18 @@
 #pragma once
 #include <cstdint>
 
-void allOutputsOff();
+struct Chamber;
+struct OutputMeter;
+
+void allOutputsOff();                 // wszystkie komory
+void chamberOutputsOff(Chamber& c);   // [NEW] jedna komora
+void heatersOffImmediate();  // [NEW] drzwi: SSR na 0 bez mutexu (komora 0)
 void buzzerBeep(uint8_t count, uint16_t onMs = 100, uint16_t offMs = 100);
 void handleBuzzer();
-void initHeaterEnable();
-void applySoftEnable();
-void mapPowerToHeaters();
-void handleFanLogic();
-bool areHeatersReady();  // NOWE: sprawdza czy wszystkie grzałki soft-enabled
+void initHeaterEnable(Chamber& c);
+void applySoftEnable(Chamber& c);
+void mapPowerToHeaters(Chamber& c);
+void handleFanLogic(Chamber& c);
+bool areHeatersReady(Chamber& c);  // NOWE: sprawdza czy wszystkie grzałki soft-enabled
+void outputs_write_smoke(Chamber& c, int duty);     // [NEW] PWM dymu z licznikiem czasu ON
+uint64_t outputs_meter_on_ms(const OutputMeter& m); // [NEW] czas ON ważony wypełnieniem (ms)
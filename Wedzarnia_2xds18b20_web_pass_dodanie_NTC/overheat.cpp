@@ -0,0 +1,125 @@
+// overheat.cpp - [NEW] Ochrona przed przegrzaniem z trendu (opis w overheat.h)
+#include "overheat.h"
+#include "config.h"
+#include "state.h"
+
+static bool guardEnabled = CFG_OVH_GUARD;
+
+// Nowy odczyt czujnika → pochodna, filtr 1. rzędu; przerwa = trend od nowa
+static void addSample(OverheatGuard& g, unsigned long ms, double t) {
+    if (g.lastSampleMs != 0 && ms - g.lastSampleMs <= 5 * TEMP_REQUEST_INTERVAL) {
+        double dtS = (ms - g.lastSampleMs) / 1000.0;
+        double raw = (t - g.lastT) / dtS * 60.0;
+        g.slope += (raw - g.slope) * dtS / (CFG_OVH_SLOPE_TAU_S + dtS);
+        g.slopeValid = true;
+    } else {
+        g.slope = 0;
+        g.slopeValid = false;
+    }
+    g.lastT = t;
+    g.lastSampleMs = ms;
+}
+
+void overheat_update(Chamber& c, unsigned long now) {
+    OverheatGuard& g = c.ovh;
+    if (!state_lock()) return;
+    double t = c.tChamber;
+    unsigned long sampleMs = c.tChamberMs;
+    bool tripped = c.currentState == ProcessState::PAUSE_OVERHEAT;
+    int deadS = c.model.valid ? CFG_FOPDT_DELAY_S[c.model.best] : 0;
+    state_unlock();
+
+    if (sampleMs != 0 && sampleMs != g.lastSampleMs) addSample(g, sampleMs, t);
+
+    int lagS = max((int)CFG_OVH_LAG_S, deadS);
+    double predicted = t + (g.slopeValid ? max(0.0, g.slope) : 0.0) * lagS / 60.0;
+    double factor = 1.0;
+    if (guardEnabled) factor = constrain((CFG_T_MAX_SOFT - predicted) / CFG_OVH_BAND_C, 0.0, 1.0);
+
+    unsigned long dt = g.lastMs != 0 ? now - g.lastMs : 0;
+    g.lastMs = now;
+    bool above = t > CFG_T_MAX_SOFT;
+    bool opened = false, closed = false;
+    OverheatEvent& e = g.current;
+
+    // Zdarzenia pod lockiem – /api/overheat kopiuje całą strukturę
+    if (!state_lock()) return;
+    g.predicted = predicted;
+    g.factor = factor;
+    if (!g.active && (factor < 1.0 || above)) {
+        e = OverheatEvent();
+        e.startMs = now;
+        e.peak = (float)t;
+        g.active = opened = true;
+    }
+    if (g.active) {
+        e.durationMs = now - e.startMs;
+        e.peak = max(e.peak, (float)t);
+        if (above) e.aboveMs += dt;
+        e.minFactor = min(e.minFactor, (float)factor);
+        if (tripped) e.hardTrip = true;
+        // Koniec po CFG_OVH_CLOSE_MS spokoju – oscylacja przy progu redukcji
+        // to jedno zdarzenie, nie seria
+        if (above || factor < 1.0 || t >= CFG_T_MAX_SOFT - CFG_OVH_BAND_C) {
+            g.calmSinceMs = now;
+        } else if (now - g.calmSinceMs >= CFG_OVH_CLOSE_MS) {
+            g.events[g.head] = e;
+            g.head = (g.head + 1) % CFG_OVH_EVENT_COUNT;
+            g.count++;
+            g.active = false;
+            closed = true;
+        }
+    }
+    state_unlock();
+
+    if (opened) {
+        LOG_FMT(LOG_LEVEL_WARN, "Overheat K%u: %.1f C, %+.1f C/min, predicted %.1f C - power x%.2f",
+                (unsigned)c.id, t, g.slope, predicted, factor);
+    }
+    if (closed) {
+        LOG_FMT(LOG_LEVEL_WARN, "Overheat K%u: peak %.1f C, %lu s above %.0f C, power x%.2f min%s",
+                (unsigned)c.id, e.peak, e.aboveMs / 1000, CFG_T_MAX_SOFT,
+                e.minFactor, e.hardTrip ? ", hard cutoff" : "");
+    }
+}
+
+double overheat_power_factor(const Chamber& c) {
+    return c.ovh.factor;
+}
+
+void overheat_set_enabled(bool enabled) {
+    guardEnabled = enabled;
+}
+
+String overheat_json(uint8_t chamberIdx) {
+    const Chamber& c = chamber_get(chamberIdx);
+    if (!state_lock()) return String("{}");
+    OverheatGuard g = c.ovh;
+    double t = c.tChamber;
+    state_unlock();
+
+    unsigned long now = millis();
+    char json[768];
+    int offset = snprintf(json, sizeof(json),
+        "{\"chamber\":%u,\"enabled\":%s,\"limit\":%.1f,\"tChamber\":%.2f,"
+        "\"slopeValid\":%s,\"slopeCPerMin\":%.2f,\"predicted\":%.1f,\"factor\":%.2f,"
+        "\"active\":%s,\"count\":%u,\"events\":[",
+        (unsigned)c.id, guardEnabled ? "true" : "false", CFG_T_MAX_SOFT, t,
+        g.slopeValid ? "true" : "false", g.slope, g.predicted, g.factor,
+        g.active ? "true" : "false", (unsigned)g.count);
+    // Od najnowszego; trwające zdarzenie pierwsze
+    int stored = min((int)g.count, (int)CFG_OVH_EVENT_COUNT);
+    for (int i = g.active ? -1 : 0; i < stored; i++) {
+        const OverheatEvent& e = i < 0 ? g.current
+            : g.events[(g.head + CFG_OVH_EVENT_COUNT - 1 - i) % CFG_OVH_EVENT_COUNT];
+        bool first = i == (g.active ? -1 : 0);
+        offset += snprintf(json + offset, sizeof(json) - offset,
+            "%s{\"ageSec\":%lu,\"durationSec\":%lu,\"peak\":%.1f,\"aboveSec\":%lu,"
+            "\"minFactor\":%.2f,\"hardTrip\":%s,\"open\":%s}",
+            first ? "" : ",",
+            (now - e.startMs) / 1000, e.durationMs / 1000, e.peak, e.aboveMs / 1000,
+            e.minFactor, e.hardTrip ? "true" : "false", i < 0 ? "true" : "false");
+    }
+    snprintf(json + offset, sizeof(json) - offset, "]}");
+    return String(json);
+}
@@ -0,0 +1,32 @@
+// overheat.h - [NEW] Ochrona przed przegrzaniem z trendu temperatury
+// readChamberTemperature() (sensors.cpp) ustawia PAUSE_OVERHEAT dopiero po
+// przekroczeniu CFG_T_MAX_SOFT – grzałka i osłona czujnika oddają jeszcze
+// ciepło i komora rośnie dalej. Ten próg zostaje jako ostatnia linia.
+//
+// Trend: pochodna kolejnych odczytów komory (tChamberMs), filtr 1. rzędu
+// CFG_OVH_SLOPE_TAU_S, C/min. Przewidywanie po bezwładności:
+//   T_prz = T + max(0, trend) x max(CFG_OVH_LAG_S, L modelu FOPDT)
+//   mnożnik mocy = (CFG_T_MAX_SOFT - T_prz) / CFG_OVH_BAND_C  (0..1)
+// mapPowerToHeaters() mnoży wyjście PID przed podziałem na grzałki, więc
+// najpierw gasną druga i trzecia. Przy setpoincie <= CFG_T_MAX_SET i
+// zwykłym przestrzale mnożnik zostaje 1.
+//
+// Zdarzenie = od pierwszej redukcji (lub przekroczenia) do CFG_OVH_CLOSE_MS
+// bez redukcji poniżej CFG_T_MAX_SOFT - CFG_OVH_BAND_C: szczyt, czas
+// powyżej progu, najmniejszy mnożnik, czy doszło do PAUSE_OVERHEAT.
+// Ostatnie CFG_OVH_EVENT_COUNT w RAM (/api/overheat), każde w logu.
+#pragma once
+#include "chamber.h"
+#include "hal.h"
+
+// Co takt pętli sterowania, w każdym stanie (zdarzenie trwa też w pauzie)
+void overheat_update(Chamber& c, unsigned long now);
+
+// Mnożnik wyjścia PID dla mapPowerToHeaters(); wołać pod state_lock
+double overheat_power_factor(const Chamber& c);
+
+// Redukcja wł./wył. (replay --no-ovh-guard); zapis zdarzeń działa zawsze
+void overheat_set_enabled(bool enabled);
+
+// Trend, przewidywanie, mnożnik i ostatnie zdarzenia dla /api/overheat
+String overheat_json(uint8_t chamberIdx);
@@ -0,0 +1,122 @@
+// pid_ctrl.cpp - [NEW] Regulator PID (port algorytmu PID_v1 1.2.x na HAL)
+#include "pid_ctrl.h"
+#include <float.h>
+
+PidController::PidController(double* input, double* output, double* setpoint,
+                             double kp_, double ki_, double kd_, Direction dir)
+    : myInput(input), myOutput(output), mySetpoint(setpoint),
+      dispKp(0), dispKi(0), dispKd(0), kp(0), ki(0), kd(0),
+      direction(dir), lastTime(0), sampleTime(100),
+      outputSum(0), lastInput(0), outMin(0), outMax(255),
+      feedForward(0), iMin(-DBL_MAX), iMax(DBL_MAX), inAuto(false) {
+    SetTunings(kp_, ki_, kd_);
+    lastTime = hal_millis() - sampleTime;
+}
+
+bool PidController::Compute() {
+    if (!inAuto) return false;
+
+    uint32_t now = hal_millis();
+    if (now - lastTime < sampleTime) return false;
+
+    double input = *myInput;
+    double error = *mySetpoint - input;
+    double dInput = input - lastInput;
+
+    // Anti-windup: suma I ograniczona do zakresu wyjścia (minus feed-forward)
+    outputSum += ki * error;
+    clampSum();
+
+    // D z pomiaru, nie z uchybu – brak skoku przy zmianie setpointu
+    double output = kp * error + outputSum - kd * dInput + feedForward;
+    if (output > outMax) output = outMax;
+    else if (output < outMin) output = outMin;
+    *myOutput = output;
+
+    lastInput = input;
+    lastTime = now;
+    return true;
+}
+
+void PidController::SetTunings(double kp_, double ki_, double kd_) {
+    if (kp_ < 0 || ki_ < 0 || kd_ < 0) return;
+
+    dispKp = kp_;
+    dispKi = ki_;
+    dispKd = kd_;
+
+    double sampleSec = sampleTime / 1000.0;
+    kp = kp_;
+    ki = ki_ * sampleSec;
+    kd = kd_ / sampleSec;
+
+    if (direction == REVERSE) {
+        kp = -kp;
+        ki = -ki;
+        kd = -kd;
+    }
+}
+
+void PidController::SetSampleTime(uint32_t ms) {
+    if (ms == 0) return;
+    double ratio = (double)ms / (double)sampleTime;
+    ki *= ratio;
+    kd /= ratio;
+    sampleTime = ms;
+}
+
+void PidController::SetOutputLimits(double min, double max) {
+    if (min >= max) return;
+    outMin = min;
+    outMax = max;
+
+    if (inAuto) {
+        if (*myOutput > outMax) *myOutput = outMax;
+        else if (*myOutput < outMin) *myOutput = outMin;
+
+        clampSum();
+    }
+}
+
+void PidController::SetFeedForward(double ff, bool bumpless) {
+    if (bumpless) {
+        outputSum -= ff - feedForward;
+        feedForward = ff;
+        clampSum();
+        return;
+    }
+    feedForward = ff;
+}
+
+void PidController::SetIntegralLimits(double min, double max) {
+    if (min >= max) return;
+    iMin = min;
+    iMax = max;
+}
+
+void PidController::ClearIntegralLimits() {
+    iMin = -DBL_MAX;
+    iMax = DBL_MAX;
+}
+
+void PidController::clampSum() {
+    double hi = outMax - feedForward;
+    double lo = outMin - feedForward;
+    if (iMax < hi) hi = iMax;
+    if (iMin > lo) lo = iMin;
+    if (outputSum > hi) outputSum = hi;
+    else if (outputSum < lo) outputSum = lo;
+}
+
+void PidController::SetMode(Mode mode) {
+    bool newAuto = (mode == AUTOMATIC);
+    if (newAuto && !inAuto) initialize();
+    inAuto = newAuto;
+}
+
+// Przejście MANUAL → AUTOMATIC bez skoku wyjścia
+void PidController::initialize() {
+    outputSum = *myOutput - feedForward;
+    lastInput = *myInput;
+    clampSum();
+}
@@ -0,0 +1,56 @@
+// pid_ctrl.h - [NEW] Regulator PID w drzewie projektu (zamiast biblioteki PID_v1)
+// Ten sam algorytm i API co PID_v1 (P on error, anti-windup na sumie I,
+// D liczone z pomiaru), ale czas z hal_millis(), więc działa też na hoście
+// z zegarem wirtualnym.
+#pragma once
+#include "hal.h"
+
+class PidController {
+public:
+    enum Mode : uint8_t { MANUAL = 0, AUTOMATIC = 1 };
+    enum Direction : uint8_t { DIRECT = 0, REVERSE = 1 };
+
+    PidController(double* input, double* output, double* setpoint,
+                  double kp, double ki, double kd, Direction dir);
+
+    // true – wyjście przeliczone (minął SampleTime)
+    bool Compute();
+
+    void SetMode(Mode mode);
+    void SetOutputLimits(double min, double max);
+    void SetTunings(double kp, double ki, double kd);
+    void SetSampleTime(uint32_t ms);
+
+    // [NEW] Składnik feed-forward dodawany do wyjścia (fopdt.cpp). Suma I
+    // ograniczona tak, by razem z nim mieściła się w granicach wyjścia.
+    // bumpless – suma I przejmuje różnicę, wyjście bez skoku
+    void SetFeedForward(double ff, bool bumpless = false);
+    // [NEW] Dodatkowe granice sumy I (domyślnie brak – tylko granice wyjścia)
+    void SetIntegralLimits(double min, double max);
+    void ClearIntegralLimits();
+
+    double GetKp() const { return dispKp; }
+    double GetKi() const { return dispKi; }
+    double GetKd() const { return dispKd; }
+    Mode GetMode() const { return inAuto ? AUTOMATIC : MANUAL; }
+
+private:
+    void initialize();
+    void clampSum();
+
+    double* myInput;
+    double* myOutput;
+    double* mySetpoint;
+
+    double dispKp, dispKi, dispKd;    // nastawy jak podane (na sekundę)
+    double kp, ki, kd;                // przeliczone na okres próbkowania
+    Direction direction;
+
+    uint32_t lastTime;
+    uint32_t sampleTime;
+    double outputSum, lastInput;
+    double outMin, outMax;
+    double feedForward;
+    double iMin, iMax;
+    bool inAuto;
+};
@@ -4,41 +4,27 @@
 #include "config.h"
 #include "state.h"
 #include "outputs.h"
+#include "storage.h"
 #include "ui.h"
-
-// Struktura dla adaptacyjnego PID
-struct AdaptivePID {
-    double errorHistory[10] = {0};
-    int historyIndex = 0;
-    unsigned long lastAdaptation = 0;
-    double currentKp = CFG_Kp;
-    double currentKi = CFG_Ki;
-    double currentKd = CFG_Kd;
-};
-
-static AdaptivePID adaptivePid;
-
-// Historia temperatury dla predykcyjnego sterowania wentylatorem
-static double tempHistory[5] = {0};
-static int tempHistoryIndex = 0;
+#include "gain_sched.h"
+#include "autotune.h"
+#include "fopdt.h"
+#include "meat_eta.h"
+#include "energy.h"
+#include "fan_sched.h"
+#include "heater_diag.h"
+#include "overheat.h"
+#include "sensor_failover.h"
 
 // ======================================================
-// [NEW] MONITOR AWARII GRZAŁKI
+// [NEW] MONITOR AWARII GRZAŁKI (stan w Chamber::hfm)
 // ======================================================
 
-struct HeaterFaultMonitor {
-    double  tempAtWindowStart = 0.0;   // temperatura komory na początku okna pomiarowego
-    unsigned long windowStart = 0;     // millis() kiedy zaczęło się okno
-    bool    monitoring = false;        // czy okno jest aktywne
-};
-
-static HeaterFaultMonitor hfm;
-
 // Resetuje stan monitora – wywołuj przy każdym starcie i wznowieniu procesu
-void resetHeaterFaultMonitor() {
-    hfm.tempAtWindowStart = 0.0;
-    hfm.windowStart = 0;
-    hfm.monitoring = false;
+void resetHeaterFaultMonitor(Chamber& c) {
+    c.hfm.tempAtWindowStart = 0.0;
+    c.hfm.windowStart = 0;
+    c.hfm.monitoring = false;
     log_msg(LOG_LEVEL_INFO, "Heater fault monitor reset");
 }
 
@@ -58,12 +44,12 @@ void resetHeaterFaultMonitor() {
  * Jeśli wzrosła – okno przesuwa się do przodu (nowy punkt startowy = aktualna temp).
  * Gdy któryś z warunków odpada (np. temp doszła do celu) → monitoring wyłączany, reset.
  */
-static void checkHeaterEfficiency() {
+static void checkHeaterEfficiency(Chamber& c) {
     if (!state_lock()) return;
-    double currentTemp  = g_tChamber;
-    double setpoint     = g_tSet;
-    double pid          = pidOutput;
-    ProcessState st     = g_currentState;
+    double currentTemp  = c.tChamber;
+    double setpoint     = c.tSet;
+    double pid          = c.pidOutput;
+    ProcessState st     = c.currentState;
     state_unlock();
 
     bool isRunning = (st == ProcessState::RUNNING_AUTO ||
@@ -74,41 +60,41 @@ static void checkHeaterEfficiency() {
                         && (setpoint - currentTemp) > HEATER_FAULT_MIN_ERROR
                         && pid > HEATER_FAULT_MIN_PID;
 
-    if (shouldBeHeating && !hfm.monitoring) {
+    if (shouldBeHeating && !c.hfm.monitoring) {
         // --- START nowego okna pomiarowego ---
-        hfm.tempAtWindowStart = currentTemp;
-        hfm.windowStart       = millis();
-        hfm.monitoring        = true;
+        c.hfm.tempAtWindowStart = currentTemp;
+        c.hfm.windowStart       = millis();
+        c.hfm.monitoring        = true;
         LOG_FMT(LOG_LEVEL_DEBUG,
                 "HeaterFault: monitoring started (T=%.1f, set=%.1f, PID=%.0f%%)",
                 currentTemp, setpoint, pid);
 
-    } else if (!shouldBeHeating && hfm.monitoring) {
+    } else if (!shouldBeHeating && c.hfm.monitoring) {
         // --- Warunki przestały być spełnione – reset bez alarmu ---
         // Normalne sytuacje: temp doszła blisko celu, PID zredukował moc,
         // drzwi, pauza, itp.
-        hfm.monitoring = false;
+        c.hfm.monitoring = false;
         LOG_FMT(LOG_LEVEL_DEBUG,
                 "HeaterFault: monitoring stopped (T=%.1f, set=%.1f, PID=%.0f%%)",
                 currentTemp, setpoint, pid);
 
-    } else if (shouldBeHeating && hfm.monitoring) {
+    } else if (shouldBeHeating && c.hfm.monitoring) {
         // --- Okno pomiarowe trwa – sprawdź po upływie czasu ---
-        unsigned long elapsed = millis() - hfm.windowStart;
+        unsigned long elapsed = millis() - c.hfm.windowStart;
 
         if (elapsed >= HEATER_NO_RISE_TIMEOUT_MS) {
-            double rise = currentTemp - hfm.tempAtWindowStart;
+            double rise = currentTemp - c.hfm.tempAtWindowStart;
 
             if (rise < HEATER_MIN_TEMP_RISE) {
                 // ========================================
                 // AWARIA POTWIERDZONA
                 // ========================================
                 if (state_lock()) {
-                    g_currentState = ProcessState::PAUSE_HEATER_FAULT;
-                    g_processStats.pauseCount++;
+                    c.currentState = ProcessState::PAUSE_HEATER_FAULT;
+                    c.processStats.pauseCount++;
                     state_unlock();
                 }
-                allOutputsOff();
+                chamberOutputsOff(c);
                 // 5 sygnałów: wyraźnie różny od innych alarmów (2-3 sygnały)
                 buzzerBeep(5, 300, 200);
 
@@ -116,7 +102,7 @@ static void checkHeaterEfficiency() {
                         "!!! HEATER FAULT !!! No temp rise in %lu min",
                         HEATER_NO_RISE_TIMEOUT_MS / 60000UL);
                 LOG_FMT(LOG_LEVEL_ERROR,
-                        "  T at window start: %.1f C", hfm.tempAtWindowStart);
+                        "  T at window start: %.1f C", c.hfm.tempAtWindowStart);
                 LOG_FMT(LOG_LEVEL_ERROR,
                         "  T now:             %.1f C", currentTemp);
                 LOG_FMT(LOG_LEVEL_ERROR,
@@ -126,15 +112,15 @@ static void checkHeaterEfficiency() {
                         "  Setpoint:          %.1f C, PID output: %.0f%%",
                         setpoint, pid);
 
-                hfm.monitoring = false;
+                c.hfm.monitoring = false;
 
             } else {
                 // Temperatura rośnie prawidłowo – przesuń okno do przodu
                 LOG_FMT(LOG_LEVEL_DEBUG,
                         "HeaterFault: window OK (rise=%.1f C), advancing window",
                         rise);
-                hfm.tempAtWindowStart = currentTemp;
-                hfm.windowStart       = millis();
+                c.hfm.tempAtWindowStart = currentTemp;
+                c.hfm.windowStart       = millis();
             }
         }
     }
@@ -144,75 +130,97 @@ static void checkHeaterEfficiency() {
 // STATYSTYKI I ADAPTACJA PID
 // ======================================================
 
-static void updateProcessStats() {
+void updateProcessStats(Chamber& c) {
     if (!state_lock()) return;
 
     unsigned long now = millis();
-    unsigned long elapsed = now - g_processStats.lastUpdate;
+    unsigned long elapsed = now - c.processStats.lastUpdate;
 
-    if (g_currentState == ProcessState::RUNNING_AUTO ||
-        g_currentState == ProcessState::RUNNING_MANUAL) {
-        g_processStats.totalRunTime += elapsed;
+    if (c.currentState == ProcessState::RUNNING_AUTO ||
+        c.currentState == ProcessState::RUNNING_MANUAL) {
+        c.processStats.totalRunTime += elapsed;
 
-        if (pidOutput > 5.0) {
-            g_processStats.activeHeatingTime += elapsed;
+        if (c.pidOutput > 5.0) {
+            c.processStats.activeHeatingTime += elapsed;
         }
 
-        if (g_processStats.avgTemp == 0.0) {
-            g_processStats.avgTemp = g_tChamber;
+        if (c.processStats.avgTemp == 0.0) {
+            c.processStats.avgTemp = c.tChamber;
         } else {
             constexpr double alpha = 0.1;
-            g_processStats.avgTemp = alpha * g_tChamber + (1.0 - alpha) * g_processStats.avgTemp;
+            c.processStats.avgTemp = alpha * c.tChamber + (1.0 - alpha) * c.processStats.avgTemp;
         }
 
-        if (g_currentState == ProcessState::RUNNING_AUTO) {
-            unsigned long elapsedTotal = (now - g_processStartTime) / 1000;
-
-            unsigned long completedTime = 0;
-            for (int i = 0; i < g_currentStep; i++) {
-                if (i < g_stepCount) {
-                    completedTime += g_profile[i].minTimeMs / 1000;
-                }
-            }
-
-            unsigned long stepElapsed = (now - g_stepStartTime) / 1000;
+        if (c.currentState == ProcessState::RUNNING_AUTO) {
+            unsigned long stepElapsed = (now - c.stepStartTime) / 1000;
             unsigned long stepTotal = 0;
-            if (g_currentStep >= 0 && g_currentStep < g_stepCount) {
-                stepTotal = g_profile[g_currentStep].minTimeMs / 1000;
+            if (c.currentStep >= 0 && c.currentStep < c.stepCount) {
+                stepTotal = c.profile[c.currentStep].minTimeMs / 1000;
             }
             unsigned long stepRemaining = (stepTotal > stepElapsed) ? (stepTotal - stepElapsed) : 0;
 
             unsigned long futureTime = 0;
-            for (int i = g_currentStep + 1; i < g_stepCount; i++) {
-                futureTime += g_profile[i].minTimeMs / 1000;
+            for (int i = c.currentStep + 1; i < c.stepCount; i++) {
+                futureTime += c.profile[i].minTimeMs / 1000;
             }
 
-            g_processStats.remainingProcessTimeSec = stepRemaining + futureTime;
+            c.processStats.remainingProcessTimeSec = stepRemaining + futureTime;
+            // [NEW] Kroki z useMeatTemp trwają do dojścia mięsa – prognoza z meat_eta.cpp
+            if (c.eta.processSec >= 0) {
+                c.processStats.remainingProcessTimeSec = c.eta.processSec;
+            }
         } else {
-            g_processStats.remainingProcessTimeSec = 0;
+            c.processStats.remainingProcessTimeSec = 0;
         }
     }
 
-    g_processStats.lastUpdate = now;
+    c.processStats.lastUpdate = now;
     state_unlock();
 }
 
-static void adaptPidParameters() {
-    unsigned long now = millis();
-    if (now - adaptivePid.lastAdaptation < PID_ADAPTATION_INTERVAL) return;
+// [NEW] Nastawy = tablica (pasmo setpointu, tryb mocy) x mnożniki z wariancji;
+// SetTunings tylko przy zmianie – zmiana kroku/trybu działa od razu
+static void applyGainSchedule(Chamber& c) {
+    if (!state_lock()) return;
+    GainSet g = gain_table_lookup(c.gains, c.tSet, c.powerMode);
+    state_unlock();
 
-    double currentError = pidSetpoint - pidInput;
+    double kp = g.kp * c.adaptive.mulKp;
+    double ki = g.ki * c.adaptive.mulKi;
+    double kd = g.kd * c.adaptive.mulKd;
+    if (kp == c.adaptive.currentKp && ki == c.adaptive.currentKi && kd == c.adaptive.currentKd) return;
 
-    adaptivePid.errorHistory[adaptivePid.historyIndex] = currentError;
-    adaptivePid.historyIndex = (adaptivePid.historyIndex + 1) % 10;
+    c.adaptive.currentKp = kp;
+    c.adaptive.currentKi = ki;
+    c.adaptive.currentKd = kd;
+    c.pid.SetTunings(kp, ki, kd);
+}
+
+// [NEW] PID z modelem FOPDT: wejście z predyktora Smitha, wyjście + feed-forward
+static void computePid(Chamber& c) {
+    fopdt_prepare_pid(c);
+    c.pid.Compute();
+}
+
+// [FIX] Czas z parametru – bench.cpp wymusza adaptację bez czekania 60 s
+void adaptPidParameters(Chamber& c, unsigned long now) {
+    if (now - c.adaptive.lastAdaptation < PID_ADAPTATION_INTERVAL) {
+        applyGainSchedule(c);
+        return;
+    }
+
+    double currentError = c.pidSetpoint - c.pidInput;
+
+    c.adaptive.errorHistory[c.adaptive.historyIndex] = currentError;
+    c.adaptive.historyIndex = (c.adaptive.historyIndex + 1) % 10;
 
     double errorMean = 0;
     double errorVariance = 0;
     int validCount = 0;
 
     for (int i = 0; i < 10; i++) {
-        if (fabs(adaptivePid.errorHistory[i]) < 50) {
-            errorMean += adaptivePid.errorHistory[i];
+        if (fabs(c.adaptive.errorHistory[i]) < 50) {
+            errorMean += c.adaptive.errorHistory[i];
             validCount++;
         }
     }
@@ -221,95 +229,50 @@ static void adaptPidParameters() {
         errorMean /= validCount;
 
         for (int i = 0; i < 10; i++) {
-            if (fabs(adaptivePid.errorHistory[i]) < 50) {
-                errorVariance += pow(adaptivePid.errorHistory[i] - errorMean, 2);
+            if (fabs(c.adaptive.errorHistory[i]) < 50) {
+                errorVariance += pow(c.adaptive.errorHistory[i] - errorMean, 2);
             }
         }
         errorVariance /= validCount;
 
         if (errorVariance > 5.0) {
-            adaptivePid.currentKp = CFG_Kp * 0.8;
-            adaptivePid.currentKi = CFG_Ki * 0.5;
-            adaptivePid.currentKd = CFG_Kd * 1.2;
+            c.adaptive.mulKp = 0.8;
+            c.adaptive.mulKi = 0.5;
+            c.adaptive.mulKd = 1.2;
         } else if (errorVariance < 0.5 && fabs(currentError) < 2.0) {
-            adaptivePid.currentKp = CFG_Kp * 1.2;
-            adaptivePid.currentKi = CFG_Ki * 0.8;
-            adaptivePid.currentKd = CFG_Kd * 0.8;
+            c.adaptive.mulKp = 1.2;
+            c.adaptive.mulKi = 0.8;
+            c.adaptive.mulKd = 0.8;
         } else {
-            adaptivePid.currentKp = CFG_Kp;
-            adaptivePid.currentKi = CFG_Ki;
-            adaptivePid.currentKd = CFG_Kd;
+            c.adaptive.mulKp = 1.0;
+            c.adaptive.mulKi = 1.0;
+            c.adaptive.mulKd = 1.0;
         }
 
-        pid.SetTunings(adaptivePid.currentKp, adaptivePid.currentKi, adaptivePid.currentKd);
+        applyGainSchedule(c);
 
-        if (adaptivePid.lastAdaptation > 0) {
+        if (c.adaptive.lastAdaptation > 0) {
             LOG_FMT(LOG_LEVEL_DEBUG, "PID adapted: Kp=%.2f Ki=%.2f Kd=%.2f var=%.2f",
-                     adaptivePid.currentKp, adaptivePid.currentKi, adaptivePid.currentKd,
+                     c.adaptive.currentKp, c.adaptive.currentKi, c.adaptive.currentKd,
                      errorVariance);
         }
+    } else {
+        applyGainSchedule(c);
     }
 
-    adaptivePid.lastAdaptation = now;
-}
-
-// ======================================================
-// PREDYKCYJNE STEROWANIE WENTYLATOREM
-// ======================================================
-
-void predictiveFanControl() {
-    double currentTemp = 0;
-    if (state_lock()) {
-        currentTemp = g_tChamber;
-        state_unlock();
-    }
-
-    tempHistory[tempHistoryIndex] = currentTemp;
-    tempHistoryIndex = (tempHistoryIndex + 1) % 5;
-
-    double trend = 0;
-    int validSamples = 0;
-    for (int i = 1; i < 5; i++) {
-        int idx = (tempHistoryIndex - i + 5) % 5;
-        int prevIdx = (idx - 1 + 5) % 5;
-
-        if (tempHistory[idx] > 0 && tempHistory[prevIdx] > 0) {
-            trend += (tempHistory[idx] - tempHistory[prevIdx]);
-            validSamples++;
-        }
-    }
-
-    if (validSamples > 0) {
-        trend /= validSamples;
-
-        if (state_lock()) {
-            if (g_fanMode == 2) {
-                if (trend > 0.5) {
-                    g_fanOnTime = min((unsigned long)(g_fanOnTime * 1.5), 30000UL);
-                    g_fanOffTime = max((unsigned long)(g_fanOffTime * 0.7), 10000UL);
-                } else if (trend < -0.2) {
-                    g_fanOnTime = max((unsigned long)(g_fanOnTime * 0.7), 5000UL);
-                    g_fanOffTime = min((unsigned long)(g_fanOffTime * 1.3), 120000UL);
-                } else if (fabs(trend) < 0.1 && fabs(g_tChamber - g_tSet) < 3.0) {
-                    g_fanOnTime = 10000UL;
-                    g_fanOffTime = 60000UL;
-                }
-            }
-            state_unlock();
-        }
-    }
+    c.adaptive.lastAdaptation = now;
 }
 
 // ======================================================
 // TRYB AUTO
 // ======================================================
 
-static void handleAutoMode() {
+static void handleAutoMode(Chamber& c) {
     if (!state_lock()) return;
-    int step = g_currentStep;
-    int count = g_stepCount;
-    unsigned long stepStart = g_stepStartTime;
-    double meat = g_tMeat;
+    int step = c.currentStep;
+    int count = c.stepCount;
+    unsigned long stepStart = c.stepStartTime;
+    double meat = c.tMeat;
     state_unlock();
 
     if (step < 0 || step >= count) {
@@ -320,7 +283,7 @@ static void handleAutoMode() {
     // [FIX] Kopiujemy dane kroku pod lockiem, operujemy na kopii
     Step localStep;
     if (!state_lock()) return;
-    memcpy(&localStep, &g_profile[step], sizeof(Step));
+    memcpy(&localStep, &c.profile[step], sizeof(Step));
     state_unlock();
 
     unsigned long elapsed = millis() - stepStart;
@@ -331,46 +294,46 @@ static void handleAutoMode() {
     if (timeOk && meatOk) {
         // [FIX] g_currentStep++ chroniony mutexem
         if (!state_lock()) return;
-        g_currentStep++;
-        int newStep = g_currentStep;
-        int totalSteps = g_stepCount;
-        g_processStats.stepChanges++;
+        c.currentStep++;
+        int newStep = c.currentStep;
+        int totalSteps = c.stepCount;
+        c.processStats.stepChanges++;
         state_unlock();
 
         if (newStep >= totalSteps) {
             if (state_lock()) {
-                g_currentState = ProcessState::PAUSE_USER;
+                c.currentState = ProcessState::PAUSE_USER;
                 state_unlock();
             }
-            allOutputsOff();
+            chamberOutputsOff(c);
             buzzerBeep(3, 200, 200);
             log_msg(LOG_LEVEL_INFO, "Profile completed!");
         } else {
-            applyCurrentStep();
+            applyCurrentStep(c);
             // Reset monitora awarii grzałki przy zmianie kroku –
             // nowy krok może mieć inną temp. startową
-            resetHeaterFaultMonitor();
+            resetHeaterFaultMonitor(c);
             buzzerBeep(2, 100, 100);
             LOG_FMT(LOG_LEVEL_INFO, "Advanced to step %d", newStep);
         }
     }
 
-    predictiveFanControl();
-    handleFanLogic();
+    fan_sched_update(c, millis());
+    handleFanLogic(c);
 
     // [FIX] Odczyt step pod lockiem do sterowania smoke
     if (!state_lock()) return;
-    step = g_currentStep;
-    count = g_stepCount;
+    step = c.currentStep;
+    count = c.stepCount;
     int smokePwm = 0;
     if (step >= 0 && step < count) {
-        smokePwm = g_profile[step].smokePwm;
+        smokePwm = c.profile[step].smokePwm;
     }
     state_unlock();
 
     if (step >= 0 && step < count) {
         if (output_lock()) {
-            ledcWrite(PIN_SMOKE_FAN, smokePwm);
+            outputs_write_smoke(c, smokePwm);
             output_unlock();
         }
     }
@@ -380,16 +343,16 @@ static void handleAutoMode() {
 // TRYB MANUALNY
 // ======================================================
 
-static void handleManualMode() {
-    predictiveFanControl();
-    handleFanLogic();
+static void handleManualMode(Chamber& c) {
+    fan_sched_update(c, millis());
+    handleFanLogic(c);
 
     if (!state_lock()) return;
-    int smoke = g_manualSmokePwm;
+    int smoke = c.manualSmokePwm;
     state_unlock();
 
     if (output_lock()) {
-        ledcWrite(PIN_SMOKE_FAN, smoke);
+        outputs_write_smoke(c, smoke);
         output_unlock();
     }
 }
@@ -398,10 +361,10 @@ static void handleManualMode() {
 // ZASTOSOWANIE KROKU PROFILU
 // ======================================================
 
-void applyCurrentStep() {
+void applyCurrentStep(Chamber& c) {
     if (!state_lock()) return;
-    int step = g_currentStep;
-    int count = g_stepCount;
+    int step = c.currentStep;
+    int count = c.stepCount;
     state_unlock();
 
     if (step < 0 || step >= count) {
@@ -410,15 +373,15 @@ void applyCurrentStep() {
     }
 
     if (state_lock()) {
-        Step& s = g_profile[step];
-        g_tSet = s.tSet;
-        g_powerMode = s.powerMode;
-        g_manualSmokePwm = s.smokePwm;
-        g_fanMode = s.fanMode;
-        g_fanOnTime = s.fanOnTime;
-        g_fanOffTime = s.fanOffTime;
+        Step& s = c.profile[step];
+        c.tSet = s.tSet;
+        c.powerMode = s.powerMode;
+        c.manualSmokePwm = s.smokePwm;
+        c.fanMode = s.fanMode;
+        c.fanOnTime = s.fanOnTime;
+        c.fanOffTime = s.fanOffTime;
         // [FIX] g_stepStartTime ustawiane wewnątrz locka
-        g_stepStartTime = millis();
+        c.stepStartTime = millis();
         state_unlock();
     }
 
@@ -430,76 +393,87 @@ void applyCurrentStep() {
 // STARTY I WZNOWIENIE PROCESU
 // ======================================================
 
-void process_start_auto() {
+void process_start_auto(uint8_t chamberIdx) {
+    Chamber& c = chamber_get(chamberIdx);
     // [FIX] g_currentStep ustawiane pod lockiem
     if (state_lock()) {
-        g_currentStep = 0;
+        c.currentStep = 0;
         state_unlock();
     }
-    applyCurrentStep();
-    initHeaterEnable();
+    applyCurrentStep(c);
+    initHeaterEnable(c);
 
     if (state_lock()) {
-        g_processStartTime = millis();
-        g_currentState = ProcessState::RUNNING_AUTO;
-        g_lastRunMode = RunMode::MODE_AUTO;
-        g_processStats.totalRunTime = 0;
-        g_processStats.activeHeatingTime = 0;
-        g_processStats.stepChanges = 0;
-        g_processStats.pauseCount = 0;
-        g_processStats.avgTemp = 0.0;
-        g_processStats.lastUpdate = millis();
-        adaptivePid.currentKp = CFG_Kp;
-        adaptivePid.currentKi = CFG_Ki;
-        adaptivePid.currentKd = CFG_Kd;
-        pid.SetTunings(CFG_Kp, CFG_Ki, CFG_Kd);
+        c.processStartTime = millis();
+        c.currentState = ProcessState::RUNNING_AUTO;
+        c.lastRunMode = RunMode::MODE_AUTO;
+        c.processStats.totalRunTime = 0;
+        c.processStats.activeHeatingTime = 0;
+        c.processStats.stepChanges = 0;
+        c.processStats.pauseCount = 0;
+        c.processStats.avgTemp = 0.0;
+        c.processStats.lastUpdate = millis();
+        c.adaptive.mulKp = 1.0;
+        c.adaptive.mulKi = 1.0;
+        c.adaptive.mulKd = 1.0;
         state_unlock();
     }
+    // [NEW] Start z nastawami wyuczonymi dla pasma i trybu pierwszego kroku
+    applyGainSchedule(c);
 
     // [NEW] Reset monitora awarii grzałki przy starcie
-    resetHeaterFaultMonitor();
+    resetHeaterFaultMonitor(c);
+    heater_diag_reset(c);
 
     log_msg(LOG_LEVEL_INFO, "AUTO mode started");
 }
 
-void process_start_manual() {
+void process_start_manual(uint8_t chamberIdx) {
+    Chamber& c = chamber_get(chamberIdx);
     if (state_lock()) {
-        g_tSet = 70;
-        g_powerMode = 2;
-        g_manualSmokePwm = 0;
-        g_fanMode = 1;
+        c.tSet = 70;
+        c.powerMode = 2;
+        c.manualSmokePwm = 0;
+        c.fanMode = 1;
         state_unlock();
     }
-    initHeaterEnable();
+    initHeaterEnable(c);
 
     if (state_lock()) {
-        g_processStartTime = millis();
-        g_currentState = ProcessState::RUNNING_MANUAL;
-        g_lastRunMode = RunMode::MODE_MANUAL;
-        g_processStats.totalRunTime = 0;
-        g_processStats.activeHeatingTime = 0;
-        g_processStats.stepChanges = 0;
-        g_processStats.pauseCount = 0;
-        g_processStats.avgTemp = 0.0;
-        g_processStats.lastUpdate = millis();
+        c.processStartTime = millis();
+        c.currentState = ProcessState::RUNNING_MANUAL;
+        c.lastRunMode = RunMode::MODE_MANUAL;
+        c.processStats.totalRunTime = 0;
+        c.processStats.activeHeatingTime = 0;
+        c.processStats.stepChanges = 0;
+        c.processStats.pauseCount = 0;
+        c.processStats.avgTemp = 0.0;
+        c.processStats.lastUpdate = millis();
+        c.adaptive.mulKp = 1.0;
+        c.adaptive.mulKi = 1.0;
+        c.adaptive.mulKd = 1.0;
         state_unlock();
     }
+    applyGainSchedule(c);
 
     // [NEW] Reset monitora awarii grzałki przy starcie
-    resetHeaterFaultMonitor();
+    resetHeaterFaultMonitor(c);
+    heater_diag_reset(c);
 
     log_msg(LOG_LEVEL_INFO, "MANUAL mode started");
 }
 
-void process_resume() {
-    initHeaterEnable();
+void process_resume(uint8_t chamberIdx) {
+    Chamber& c = chamber_get(chamberIdx);
+    initHeaterEnable(c);
     if (state_lock()) {
-        g_currentState = ProcessState::SOFT_RESUME;
+        c.currentState = ProcessState::SOFT_RESUME;
         state_unlock();
     }
     // [NEW] Reset monitora awarii grzałki przy wznowieniu –
     // po pauzie temperatura może być inna niż przed pauzą
-    resetHeaterFaultMonitor();
+    resetHeaterFaultMonitor(c);
+    heater_diag_reset(c);
 
     log_msg(LOG_LEVEL_INFO, "Process resuming...");
 }
@@ -508,24 +482,45 @@ void process_resume() {
 // GŁÓWNA LOGIKA STEROWANIA (wywoływana co 100 ms z taskControl)
 // ======================================================
 
-void process_run_control_logic() {
-    extern double pidInput, pidSetpoint;
+void chamber_run_control_logic(Chamber& c) {
+    // [NEW] Czujnik komory padł – estymata do tChamber przed odczytem pidInput
+    sensor_failover_update(c, millis());
 
     if (!state_lock()) return;
-    ProcessState st = g_currentState;
-    pidInput = g_tChamber;
-    pidSetpoint = g_tSet;
-    unsigned long processStart = g_processStartTime;
+    ProcessState st = c.currentState;
+    c.pidInput = c.tChamber;
+    c.pidSetpoint = c.tSet;
+    unsigned long processStart = c.processStartTime;
+    int powerMode = c.powerMode;
+    bool autotuneOpen = autotune_active(c.autotune.phase);
     state_unlock();
 
+    // [NEW] Odpowiedź na skok setpointu → korekta tablicy nastaw
+    gain_sched_observe(c, st, powerMode, millis());
+    // [NEW] Identyfikacja modelu FOPDT (moc z poprzedniego taktu)
+    fopdt_update(c, millis());
+    // [NEW] Prognoza mięsa: stała czasowa wsadu, czas do tMeatTarget
+    meat_eta_update(c, millis());
+    // [NEW] Energia wsadu: migawki liczników na granicach wsadu i kroku
+    energy_update(c, millis());
+    // [NEW] Trend komory → redukcja mocy przed CFG_T_MAX_SOFT, zapis zdarzeń
+    overheat_update(c, millis());
+
+    // [NEW] Zmiana stanu procesu = punkt zapisu ustawień. Tylko żądanie –
+    // sam zapis flash wykona task Monitor, pętla sterowania nie czeka.
+    if (st != c.lastSeenState) {
+        c.lastSeenState = st;
+        storage_request_nvs_flush();
+    }
+
     // Sprawdzenie maksymalnego czasu procesu
     if ((st == ProcessState::RUNNING_AUTO || st == ProcessState::RUNNING_MANUAL) &&
         (millis() - processStart > CFG_MAX_PROCESS_TIME_MS)) {
         if (state_lock()) {
-            g_currentState = ProcessState::PAUSE_USER;
+            c.currentState = ProcessState::PAUSE_USER;
             state_unlock();
         }
-        allOutputsOff();
+        chamberOutputsOff(c);
         buzzerBeep(4, 150, 150);
         log_msg(LOG_LEVEL_WARN, "Max process time reached!");
         return;
@@ -533,32 +528,35 @@ void process_run_control_logic() {
 
     switch (st) {
         case ProcessState::RUNNING_AUTO:
-            adaptPidParameters();
-            pid.Compute();
-            applySoftEnable();
-            mapPowerToHeaters();
-            handleAutoMode();
-            updateProcessStats();
-            checkHeaterEfficiency();   // [NEW]
+            adaptPidParameters(c, millis());
+            computePid(c);
+            applySoftEnable(c);
+            mapPowerToHeaters(c);
+            handleAutoMode(c);
+            updateProcessStats(c);
+            checkHeaterEfficiency(c);   // [NEW]
+            heater_diag_update(c, millis());   // [NEW] residuum modelu, próby kanałów
             break;
 
         case ProcessState::RUNNING_MANUAL:
-            pid.Compute();
-            applySoftEnable();
-            mapPowerToHeaters();
-            handleManualMode();
-            updateProcessStats();
-            checkHeaterEfficiency();   // [NEW]
+            applyGainSchedule(c);   // [NEW] setpoint/tryb z WWW zmieniają pasmo
+            computePid(c);
+            applySoftEnable(c);
+            mapPowerToHeaters(c);
+            handleManualMode(c);
+            updateProcessStats(c);
+            checkHeaterEfficiency(c);   // [NEW]
+            heater_diag_update(c, millis());   // [NEW] residuum modelu, próby kanałów
             break;
 
         case ProcessState::SOFT_RESUME:
-            pid.Compute();
-            applySoftEnable();
-            mapPowerToHeaters();
+            computePid(c);
+            applySoftEnable(c);
+            mapPowerToHeaters(c);
 
-            if (areHeatersReady()) {
+            if (areHeatersReady(c)) {
                 if (state_lock()) {
-                    g_currentState = (g_lastRunMode == RunMode::MODE_AUTO)
+                    c.currentState = (c.lastRunMode == RunMode::MODE_AUTO)
                         ? ProcessState::RUNNING_AUTO
                         : ProcessState::RUNNING_MANUAL;
                     state_unlock();
@@ -567,6 +565,14 @@ void process_run_control_logic() {
             }
             break;
 
+        // [NEW] Przekaźnik zamiast PID, wentylator jak w trybie ręcznym
+        case ProcessState::AUTOTUNE:
+            autotune_process(c, millis());
+            applySoftEnable(c);
+            mapPowerToHeaters(c);
+            handleFanLogic(c);
+            break;
+
         case ProcessState::IDLE:
         case ProcessState::PAUSE_DOOR:
         case ProcessState::PAUSE_SENSOR:
@@ -574,63 +580,79 @@ void process_run_control_logic() {
         case ProcessState::PAUSE_USER:
         case ProcessState::PAUSE_HEATER_FAULT:   // [NEW]
         case ProcessState::ERROR_PROFILE:
-            allOutputsOff();
+            chamberOutputsOff(c);
+            // [NEW] Stop / pauza w trakcie autotune – wynik "przerwany"
+            if (autotuneOpen) autotune_abandon(c);
             break;
     }
 }
 
+void process_run_control_logic() {
+    for (uint8_t i = 0; i < CFG_CHAMBER_COUNT; i++) {
+        chamber_run_control_logic(g_chambers[i]);
+    }
+}
+
 // ======================================================
 // FUNKCJE POMOCNICZE
 // ======================================================
 
-void process_force_next_step() {
+void process_force_next_step(uint8_t chamberIdx) {
+    Chamber& c = chamber_get(chamberIdx);
     if (!state_lock()) return;
 
-    if (g_currentState != ProcessState::RUNNING_AUTO) {
+    if (c.currentState != ProcessState::RUNNING_AUTO) {
         log_msg(LOG_LEVEL_WARN, "Cannot skip step - not in AUTO mode");
         state_unlock();
         return;
     }
 
-    int nextStep = g_currentStep + 1;
-    if (nextStep >= g_stepCount) {
+    int nextStep = c.currentStep + 1;
+    if (nextStep >= c.stepCount) {
         log_msg(LOG_LEVEL_WARN, "Cannot skip step - already at last step");
         state_unlock();
         return;
     }
 
     // [FIX] g_currentStep ustawiane wewnątrz locka
-    g_currentStep = nextStep;
+    c.currentStep = nextStep;
     state_unlock();
 
-    applyCurrentStep();
+    applyCurrentStep(c);
     // [NEW] Reset monitora przy ręcznym przejściu do następnego kroku
-    resetHeaterFaultMonitor();
+    resetHeaterFaultMonitor(c);
 
     LOG_FMT(LOG_LEVEL_INFO, "Step skipped to %d", nextStep);
     buzzerBeep(1, 100, 0);
 }
 
-String getPidParameters() {
+String getPidParameters(uint8_t chamberIdx) {
+    const Chamber& c = chamber_get(chamberIdx);
+    GainSet base = {CFG_Kp, CFG_Ki, CFG_Kd};
+    if (state_lock()) {
+        base = gain_table_lookup(c.gains, c.tSet, c.powerMode);
+        state_unlock();
+    }
     char buffer[128];
     snprintf(buffer, sizeof(buffer),
-             "Kp=%.2f, Ki=%.2f, Kd=%.2f (base: %.1f,%.1f,%.1f)",
-             adaptivePid.currentKp, adaptivePid.currentKi, adaptivePid.currentKd,
-             CFG_Kp, CFG_Ki, CFG_Kd);
+             "Kp=%.2f, Ki=%.3f, Kd=%.1f (base: %.2f,%.3f,%.1f)",
+             c.adaptive.currentKp, c.adaptive.currentKi, c.adaptive.currentKd,
+             base.kp, base.ki, base.kd);
     return String(buffer);
 }
 
-void resetAdaptivePid() {
-    adaptivePid.currentKp = CFG_Kp;
-    adaptivePid.currentKi = CFG_Ki;
-    adaptivePid.currentKd = CFG_Kd;
-    pid.SetTunings(CFG_Kp, CFG_Ki, CFG_Kd);
+void resetAdaptivePid(uint8_t chamberIdx) {
+    Chamber& c = chamber_get(chamberIdx);
+    c.adaptive.mulKp = 1.0;
+    c.adaptive.mulKi = 1.0;
+    c.adaptive.mulKd = 1.0;
+    applyGainSchedule(c);
 
     for (int i = 0; i < 10; i++) {
-        adaptivePid.errorHistory[i] = 0;
+        c.adaptive.errorHistory[i] = 0;
     }
-    adaptivePid.historyIndex = 0;
-    adaptivePid.lastAdaptation = 0;
+    c.adaptive.historyIndex = 0;
+    c.adaptive.lastAdaptation = 0;
 
-    log_msg(LOG_LEVEL_INFO, "Adaptive PID reset to defaults");
+    log_msg(LOG_LEVEL_INFO, "Adaptive PID reset to scheduled gains");
 }
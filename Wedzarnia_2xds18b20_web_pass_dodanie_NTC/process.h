@@ -1,21 +1,29 @@
 // process.h - Zmodernizowana wersja
+// [NEW] Wielokomorowość: funkcje z indeksem komory (domyślnie 0 = dotychczasowa)
 #pragma once
-#include <Arduino.h>
+#include "hal.h"
+#include "chamber.h"
 
 // Główne funkcje procesu
-void process_run_control_logic();
-void process_start_auto();
-void process_start_manual();
-void process_resume();
-void applyCurrentStep();
+void process_run_control_logic();   // wszystkie komory
+void chamber_run_control_logic(Chamber& c);
+void process_start_auto(uint8_t chamberIdx = 0);
+void process_start_manual(uint8_t chamberIdx = 0);
+void process_resume(uint8_t chamberIdx = 0);
+void applyCurrentStep(Chamber& c);
 
 // Funkcje kontrolne
-void process_force_next_step();
+void process_force_next_step(uint8_t chamberIdx = 0);
 
 // Nowe funkcje dla adaptacyjnego PID
-String getPidParameters();
-void resetAdaptivePid();
+String getPidParameters(uint8_t chamberIdx = 0);
+void resetAdaptivePid(uint8_t chamberIdx = 0);
+
+// Kroki pętli sterowania wołane z process_run_control_logic()
+// (publiczne dla bench.cpp)
+void adaptPidParameters(Chamber& c, unsigned long now);
+void updateProcessStats(Chamber& c);
 
 // [NEW] Reset stanu zabezpieczenia awarii grzałki
 // Wywoływane przy process_start_auto(), process_start_manual() i process_resume()
-void resetHeaterFaultMonitor();
+void resetHeaterFaultMonitor(Chamber& c);
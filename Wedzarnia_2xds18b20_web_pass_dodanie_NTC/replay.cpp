@@ -0,0 +1,995 @@
+// replay.cpp - [NEW] Odtwarzanie nagranych przebiegów wędzenia na hoście
+// Wejście: ślad CSV z produkcji (temperatury, drzwi, akcje operatora).
+// Rdzeń (sensors → process_run_control_logic → outputs) chodzi na zegarze
+// wirtualnym hal_posix w takcie taskControl (100 ms), wynik to CSV decyzji:
+// wypełnienie SSR, wentylator, dym i przejścia stanów procesu.
+//
+// Budowa (host): CMakeLists.txt w katalogu repozytorium, cel replay
+//   cmake -S . -B build && cmake --build build
+//
+// Porównanie dwóch rewizji firmware – ten sam ślad, dwa binarki:
+//   ./replay_old trace.csv -o old.csv && ./replay_new trace.csv -o new.csv
+//   diff --side-by-side old.csv new.csv
+// Wynik jest deterministyczny (zegar wirtualny, brak wątków). Czas CPU
+// rdzenia sterowania (rzeczywisty, ns/takt) idzie na stderr, nie do CSV.
+//
+// Format śladu: t_ms,zdarzenie[,a[,b]]  ('#' = komentarz, czas niemalejący)
+//   T,komora,mieso       odczyt czujników DS18B20 (°C, -127 = odłączony)
+//   door,1|0             krańcówka drzwi: 1 = otwarte
+//   profile,/profiles/x.prof   ścieżka profilu (jak wybór w menu)
+//   auto | manual | stop | resume | next    akcje operatora (jak w WWW)
+//   tset,v | power,v | smoke,v | fan,v     ręczne nastawy
+//   autotune,setpoint,tryb   [NEW] autotune przekaźnikowy (jak /autotune/start)
+//   heater,n,sprawność   [NEW] --plant: grzałka n (1..3 = ssrPins) oddaje ułamek
+//                        mocy, 0 = przepalona / SSR nie załącza
+//   heat,W               [NEW] --plant: obce źródło ciepła w komorze (zajęte
+//                        zrębki, palenisko), 0 = koniec
+//   sensor,n,p           [NEW] --plant: czujnik n (1 = komora, 2 = mięso) daje
+//                        ważny odczyt z prawdopodobieństwem p, 0 = odłączony
+//   end                  koniec odtwarzania (domyślnie ostatnie zdarzenie)
+//
+// Różnica względem ESP32: zamknięcie drzwi działa bez 200 ms debounce ISR,
+// otwarcie od razu ustawia blokadę (inputs_door_interlock w host_stubs.cpp).
+//
+// [NEW] --plant: pętla zamknięta na modelu cieplnym komory zamiast nagranych
+// temperatur (T w śladzie = stan początkowy modelu). Na stderr czas
+// ustalenia każdego skoku setpointu w górę – porównanie nastaw PID, np.
+// harmonogramu z gain_sched.cpp: ślad z kilkoma cyklami 40 → 90 C.
+// Autotune end-to-end: "autotune,70,2", potem "manual" + skoki setpointu –
+// wynik (Ku, Tu, nastawy) w logu, ustalenie z nowymi nastawami na stderr.
+//
+// [NEW] --no-model: PID bez feed-forward i predyktora Smitha (fopdt.cpp) –
+// porównanie A/B na tym samym śladzie. Zidentyfikowany model na stderr.
+//
+// [NEW] --plant z profilem AUTO: po końcu kroku useMeatTemp i całego profilu
+// na stderr prognozy meat_eta.cpp zapisane co 30 min – błąd i trafienie w pasmo.
+//
+// [NEW] Grzałki przez ssr_tp.cpp na wirtualnym timerze hal_posix (takt co
+// półokres). Kolumny ssr1..3 = zadane wypełnienie; model --plant grzeje
+// czasem stanu wysokiego pinów. Na stderr średnie wypełnienie zadane vs
+// dostarczone (czas wysoki pinu) i licznik czasu ON silnika dla każdej grzałki.
+// [NEW] Obciążenie sieci: szczyt i średnia grzałek ON (A z CFG_SSR_HEATER_AMPS),
+// najwięcej załączeń w jednym półokresie, udział czasu z n grzałkami naraz;
+// --no-stagger = wspólny start okna (A/B).
+// [NEW] --plant: warstwa gorącego powietrza przy grzałkach – nadwyżka nad
+// komorą rośnie z mocą, wentylator ją rozbija (tylko wskaźnik równomierności,
+// bez sprzężenia do modelu). Na stderr udział ON i przełączenia wentylatora,
+// jego energia oraz średnia / max nadwyżka warstwy w pracy;
+// --no-fan-sched = stałe czasy cyklu z kroku (A/B harmonogramu fan_sched.cpp).
+// [NEW] Awaria grzałki (zdarzenie heater): na stderr alarmy detektora
+// heater_diag.cpp przed awarią (fałszywe), czas od pierwszego wypełnienia
+// uszkodzonego kanału do podejrzenia i do pauzy oraz wskazane kanały.
+// [NEW] Przegrzanie: na stderr szczyt odczytu (i powietrza) względem
+// CFG_T_MAX_SOFT, czas powyżej progu, zdarzenia overheat.cpp i czy doszło
+// do PAUSE_OVERHEAT; --no-ovh-guard = tylko próg twardy (A/B).
+// [NEW] Awaria czujnika (zdarzenie sensor): na stderr epizody i czas pracy
+// na estymacie sensor_failover.cpp, największy błąd estymaty względem
+// czujnika modelu, czas w PAUSE_SENSOR i udział pracy po awarii, zakres
+// powietrza względem tSet; --no-failover = PAUSE_SENSOR od razu (A/B).
+// [NEW] --expect metryka<=v (>=, ==): progi na wartościach raportów stderr,
+// kod wyjścia 1 przy niespełnionym lub brakującym – scenariusze awarii
+// z tests/scenarios jako testy ctest (CMakeLists.txt).
+#ifndef ARDUINO
+#include "config.h"
+#include "state.h"
+#include "process.h"
+#include "sensors.h"
+#include "outputs.h"
+#include "storage.h"
+#include "autotune.h"
+#include "fopdt.h"
+#include "ssr_tp.h"
+#include "energy.h"
+#include "fan_sched.h"
+#include "heater_diag.h"
+#include "overheat.h"
+#include "sensor_failover.h"
+#include <chrono>
+#include <map>
+#include <math.h>
+#include <string>
+#include <vector>
+
+static constexpr uint32_t REPLAY_TICK_MS = 100;   // okres taskControl/taskSensors
+
+// Model komory (--plant): grzałki z opóźnieniem → powietrze i ściany
+// (straty rosną z temperaturą) → czujnik w osłonie, mięso. Wzmocnienie
+// rośnie z liczbą grzałek, stała czasowa maleje z temperaturą.
+static constexpr double PLANT_HEATER_W = 1000.0;        // moc jednego SSR
+static constexpr double PLANT_HEATER_TAU_S = 60.0;
+static constexpr double PLANT_CAPACITY_J_K = 40000.0;
+static constexpr double PLANT_LOSS_W_K = 8.0;
+static constexpr double PLANT_LOSS_W_K2 = 0.08;         // konwekcja / promieniowanie
+static constexpr double PLANT_DOOR_LOSS_MUL = 4.0;
+static constexpr double PLANT_SENSOR_TAU_S = 30.0;
+static constexpr double PLANT_MEAT_TAU_S = 5400.0;
+static constexpr double PLANT_AMBIENT_C = 20.0;
+// Warstwa przy grzałkach: mieszanie z komorą bez / z wentylatorem
+static constexpr double PLANT_LAYER_J_K = 4000.0;
+static constexpr double PLANT_MIX_STILL_W_K = 40.0;
+static constexpr double PLANT_MIX_FAN_W_K = 200.0;
+static constexpr double PLANT_UNEVEN_C = 10.0;           // próg "nierównej" komory
+
+// Ustalenie = tyle czasu w paśmie (jak CFG_GAIN_SETTLE_*)
+static constexpr double SETTLE_BAND_C = 1.0;
+static constexpr uint32_t SETTLE_HOLD_MS = 300000;
+
+enum class ReplayEventType : uint8_t {
+    TEMP,
+    DOOR,
+    PROFILE,
+    START_AUTO,
+    START_MANUAL,
+    STOP,
+    RESUME,
+    NEXT_STEP,
+    SET_TSET,
+    SET_POWER,
+    SET_SMOKE,
+    SET_FAN,
+    AUTOTUNE,
+    HEATER,
+    EXT_HEAT,
+    SENSOR,
+    END
+};
+
+struct ReplayEvent {
+    uint32_t tMs;
+    ReplayEventType type;
+    double a;
+    double b;
+    char arg[64];
+};
+
+struct ReplayRow {
+    ProcessState state;
+    int step;
+    double tSet;
+    uint32_t ssr1, ssr2, ssr3, smoke;
+    bool fan;
+};
+
+struct PlantState {
+    double heatW;       // moc oddana do komory (po opóźnieniu grzałki)
+    double air;
+    double sensor;
+    double meat;
+    bool door;
+    double layer;       // [NEW] nadwyżka warstwy przy grzałkach nad komorą
+    double extW;        // [NEW] zdarzenie heat
+    double sensorOk[2]; // [NEW] zdarzenie sensor: P(ważny odczyt) komora, mięso
+};
+
+// [NEW] Awaria czujnika (--plant): praca na estymacie po zdarzeniu sensor
+struct SensorTrack {
+    uint32_t degradedMs;
+    double estErrMax;
+    uint32_t pauseMs;
+    uint32_t afterMs;
+    uint32_t runMs;
+    double airMin;
+    double airMax;
+};
+
+// [NEW] Przegrzanie (--plant): szczyt i czas powyżej CFG_T_MAX_SOFT
+struct OvhTrack {
+    double sensorPeak;
+    double airPeak;
+    uint32_t aboveMs;
+    bool hardTrip;
+};
+
+// [NEW] Wentylator i równomierność (--plant), sumy w czasie pracy
+struct FanTrack {
+    uint32_t runMs;
+    uint32_t onMs;
+    uint32_t switches;
+    double layerSum;    // C x ms
+    double layerMax;
+    uint32_t unevenMs;
+};
+
+// Prognoza mięsa zapisana w trakcie kroku (--plant)
+struct EtaSnapshot {
+    uint32_t tMs;
+    int step;
+    long predSec, loSec, hiSec;
+};
+
+// Skok setpointu w górę obserwowany przez --plant
+struct SettleTrack {
+    bool active;
+    double from;
+    double target;
+    int powerMode;
+    uint32_t startMs;
+    uint32_t inBandSince;
+    bool inBand;
+    bool reached;
+    double overshoot;
+};
+
+// [NEW] --expect nazwa<=v | nazwa>=v | nazwa==v: próg metryki raportu
+struct ReplayExpect {
+    std::string name;
+    char op;            // '<', '>', '='
+    double value;
+};
+
+struct ReplayCpuStats {
+    uint32_t ticks;
+    uint64_t totalNs;
+    uint64_t maxNs;
+    uint32_t transitions;
+};
+
+static const char* stateName(ProcessState s) {
+    switch (s) {
+        case ProcessState::IDLE:               return "IDLE";
+        case ProcessState::RUNNING_AUTO:       return "RUNNING_AUTO";
+        case ProcessState::RUNNING_MANUAL:     return "RUNNING_MANUAL";
+        case ProcessState::PAUSE_DOOR:         return "PAUSE_DOOR";
+        case ProcessState::PAUSE_SENSOR:       return "PAUSE_SENSOR";
+        case ProcessState::PAUSE_OVERHEAT:     return "PAUSE_OVERHEAT";
+        case ProcessState::PAUSE_USER:         return "PAUSE_USER";
+        case ProcessState::ERROR_PROFILE:      return "ERROR_PROFILE";
+        case ProcessState::SOFT_RESUME:        return "SOFT_RESUME";
+        case ProcessState::PAUSE_HEATER_FAULT: return "PAUSE_HEATER_FAULT";
+        case ProcessState::AUTOTUNE:           return "AUTOTUNE";
+        default:                               return "UNKNOWN";
+    }
+}
+
+// ======================================================
+// WCZYTANIE ŚLADU
+// ======================================================
+
+static bool parseEventType(const char* s, ReplayEventType& type) {
+    static const struct { const char* name; ReplayEventType type; } names[] = {
+        {"T",       ReplayEventType::TEMP},
+        {"door",    ReplayEventType::DOOR},
+        {"profile", ReplayEventType::PROFILE},
+        {"auto",    ReplayEventType::START_AUTO},
+        {"manual",  ReplayEventType::START_MANUAL},
+        {"stop",    ReplayEventType::STOP},
+        {"resume",  ReplayEventType::RESUME},
+        {"next",    ReplayEventType::NEXT_STEP},
+        {"tset",    ReplayEventType::SET_TSET},
+        {"power",   ReplayEventType::SET_POWER},
+        {"smoke",   ReplayEventType::SET_SMOKE},
+        {"fan",     ReplayEventType::SET_FAN},
+        {"autotune", ReplayEventType::AUTOTUNE},
+        {"heater",  ReplayEventType::HEATER},
+        {"heat",    ReplayEventType::EXT_HEAT},
+        {"sensor",  ReplayEventType::SENSOR},
+        {"end",     ReplayEventType::END}
+    };
+    for (const auto& n : names) {
+        if (strcmp(s, n.name) == 0) { type = n.type; return true; }
+    }
+    return false;
+}
+
+static bool loadTrace(const char* path, std::vector<ReplayEvent>& events) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Cannot open trace: %s\n", path);
+        return false;
+    }
+
+    char line[256];
+    int lineNo = 0;
+    uint32_t lastT = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+
+        char* fields[4] = {nullptr, nullptr, nullptr, nullptr};
+        int fieldCount = 0;
+        char* token = strtok(line, ",");
+        while (token && fieldCount < 4) {
+            fields[fieldCount++] = token;
+            token = strtok(NULL, ",");
+        }
+
+        ReplayEvent ev = {};
+        if (fieldCount < 2 || !parseEventType(fields[1], ev.type)) {
+            fprintf(stderr, "%s:%d: invalid event\n", path, lineNo);
+            fclose(f);
+            return false;
+        }
+        ev.tMs = strtoul(fields[0], NULL, 10);
+        if (ev.tMs < lastT) {
+            fprintf(stderr, "%s:%d: time goes backwards\n", path, lineNo);
+            fclose(f);
+            return false;
+        }
+        lastT = ev.tMs;
+        if (fields[2]) {
+            ev.a = atof(fields[2]);
+            strncpy(ev.arg, fields[2], sizeof(ev.arg) - 1);
+        }
+        if (fields[3]) ev.b = atof(fields[3]);
+        events.push_back(ev);
+    }
+    fclose(f);
+    return true;
+}
+
+// ======================================================
+// [NEW] MODEL CIEPLNY KOMORY (--plant)
+// ======================================================
+
+static bool plantMode = false;
+static PlantState plant = {0.0, PLANT_AMBIENT_C, PLANT_AMBIENT_C, PLANT_AMBIENT_C, false, 0.0, 0.0,
+                           {1.0, 1.0}};
+static uint32_t sensorFaultMs = 0;                   // [NEW] pierwsze zdarzenie sensor
+static uint32_t sensorLcg = 12345;                   // deterministyczny – wynik powtarzalny
+
+// [NEW] Odczyt z prawdopodobieństwem sensorOk, inaczej -127 jak odłączony DS18B20
+static double plantSensorValue(double t, double pOk) {
+    if (pOk >= 1.0) return t;
+    sensorLcg = sensorLcg * 1103515245u + 12345u;
+    return (sensorLcg >> 8) / 16777216.0 < pOk ? t : -127.0;
+}
+
+static void plantPublish() {
+    hal_posix_set_temp(getChamberSensorIndex(), plantSensorValue(plant.sensor, plant.sensorOk[0]));
+    hal_posix_set_temp(getMeatSensorIndex(), plantSensorValue(plant.meat, plant.sensorOk[1]));
+}
+
+// Euler co takt – stałe czasowe modelu >> 100 ms. Moc = czas ON pinów SSR
+// w ostatnim takcie (półokresy z ssr_tp), nie zadane wypełnienie.
+static const uint8_t plantSsrPins[3] = {PIN_SSR1, PIN_SSR2, PIN_SSR3};
+static uint64_t plantHighUs[3] = {0, 0, 0};
+static double plantHealth[3] = {1.0, 1.0, 1.0};     // [NEW] zdarzenie heater
+static uint32_t faultMs = 0;                         // pierwsza wstrzyknięta awaria
+static bool faultDriven = false;                     // uszkodzony kanał dostał wypełnienie
+
+static void plantStep(double dtS) {
+    double duty = 0;
+    for (int i = 0; i < 3; i++) {
+        uint64_t high = hal_posix_gpio_high_us(plantSsrPins[i]);
+        duty += plantHealth[i] * (high - plantHighUs[i]) / (dtS * 1e6);
+        if (plantHealth[i] < 1.0 && high > plantHighUs[i]) faultDriven = true;
+        plantHighUs[i] = high;
+    }
+    plant.heatW += (duty * PLANT_HEATER_W - plant.heatW) * dtS / PLANT_HEATER_TAU_S;
+
+    double dT = plant.air - PLANT_AMBIENT_C;
+    double lossW = (PLANT_LOSS_W_K + PLANT_LOSS_W_K2 * fabs(dT)) * dT;
+    if (plant.door) lossW *= PLANT_DOOR_LOSS_MUL;
+
+    plant.air    += (plant.heatW + plant.extW - lossW) * dtS / PLANT_CAPACITY_J_K;
+    plant.sensor += (plant.air - plant.sensor) * dtS / PLANT_SENSOR_TAU_S;
+    plant.meat   += (plant.air - plant.meat) * dtS / PLANT_MEAT_TAU_S;
+
+    double mixWK = hal_posix_gpio(PIN_FAN) ? PLANT_MIX_FAN_W_K : PLANT_MIX_STILL_W_K;
+    plant.layer += (plant.heatW - mixWK * plant.layer) * dtS / PLANT_LAYER_J_K;
+    plantPublish();
+}
+
+// [NEW] Metryki raportów stderr (--plant) – sprawdzane przez --expect
+static std::map<std::string, double> metrics;
+
+static void metricSet(const char* name, double v) { metrics[name] = v; }
+
+static void metricMax(const char* name, double v) {
+    auto it = metrics.find(name);
+    if (it == metrics.end() || v > it->second) metrics[name] = v;
+}
+
+static void metricAdd(const char* name, double v) { metrics[name] += v; }
+
+static void settleReport(const SettleTrack& s, uint32_t now, bool settled) {
+    if (settled) {
+        metricAdd("settle.count", 1);
+        metricMax("settle.max_s", (s.inBandSince - s.startMs) / 1000.0);
+        metricMax("settle.overshoot_max", s.overshoot);
+        fprintf(stderr, "settle: t=%lus %.1f->%.1f pm=%d: %lus, overshoot %.1f C\n",
+                (unsigned long)(s.startMs / 1000), s.from, s.target, s.powerMode,
+                (unsigned long)((s.inBandSince - s.startMs) / 1000), s.overshoot);
+    } else {
+        metricAdd("settle.unsettled", 1);
+        fprintf(stderr, "settle: t=%lus %.1f->%.1f pm=%d: not settled after %lus\n",
+                (unsigned long)(s.startMs / 1000), s.from, s.target, s.powerMode,
+                (unsigned long)((now - s.startMs) / 1000));
+    }
+}
+
+// Start procesu lub setpoint w górę o >= 5 C w RUNNING_* otwiera pomiar; pauza / nowy setpoint
+// przed ustaleniem = "not settled"
+static bool isRunning(ProcessState st) {
+    return st == ProcessState::RUNNING_AUTO || st == ProcessState::RUNNING_MANUAL;
+}
+
+static void settleTrack(SettleTrack& s, uint32_t now, const ReplayRow& prev) {
+    ProcessState st;
+    double tSet, temp;
+    int pm;
+    if (!state_lock()) return;
+    st = g_currentState;
+    tSet = g_tSet;
+    temp = g_tChamber;
+    pm = g_powerMode;
+    state_unlock();
+
+    bool running = isRunning(st);
+    bool newTarget = running && (!isRunning(prev.state) || tSet != prev.tSet);
+    if (s.active && (!running || newTarget)) {
+        settleReport(s, now, false);
+        s.active = false;
+    }
+    if (newTarget && tSet - temp >= 5.0) {
+        s = SettleTrack{true, temp, tSet, pm, now, 0, false, false, 0.0};
+    }
+    if (!s.active) return;
+
+    double err = temp - s.target;
+    bool inBand = fabs(err) <= SETTLE_BAND_C;
+    if (inBand && !s.inBand) s.inBandSince = now;
+    if (inBand) s.reached = true;
+    s.inBand = inBand;
+    if (s.reached && err > s.overshoot) s.overshoot = err;
+    if (inBand && now - s.inBandSince >= SETTLE_HOLD_MS) {
+        settleReport(s, now, true);
+        s.active = false;
+    }
+}
+
+static constexpr uint32_t ETA_SNAPSHOT_MS = 1800000;
+static constexpr int ETA_PROCESS = -1;            // EtaSnapshot.step: reszta profilu
+static std::vector<EtaSnapshot> etaSnapshots;
+
+static void etaReport(uint32_t now, int step) {
+    bool first = true;
+    for (const EtaSnapshot& e : etaSnapshots) {
+        if (e.step != step) continue;
+        if (first) {
+            if (step == ETA_PROCESS) fprintf(stderr, "eta: profile done at t=%us\n", now / 1000);
+            else fprintf(stderr, "eta: step %d done at t=%us\n", step, now / 1000);
+            first = false;
+        }
+        double actualMin = (now - e.tMs) / 60000.0;
+        bool inBand = e.loSec / 60.0 <= actualMin && (e.hiSec < 0 || actualMin <= e.hiSec / 60.0);
+        char hi[16] = "inf";
+        if (e.hiSec >= 0) snprintf(hi, sizeof(hi), "%+.0f", e.hiSec / 60.0 - actualMin);
+        fprintf(stderr, "eta:   %5.0f min before: predicted %+5.0f min, band [%+.0f, %s] %s\n",
+                actualMin, e.predSec / 60.0 - actualMin, e.loSec / 60.0 - actualMin, hi,
+                inBand ? "in band" : "MISS");
+    }
+}
+
+// Prognozy meat_eta.cpp co 30 min; po końcu kroku / profilu błąd vs rzeczywistość
+static void etaTrack(uint32_t now, const ReplayRow& row, const ReplayRow& prev) {
+    if (prev.state == ProcessState::RUNNING_AUTO) {
+        if (row.step != prev.step) etaReport(now, prev.step);
+        if (row.state != ProcessState::RUNNING_AUTO) {
+            etaReport(now, ETA_PROCESS);
+            etaSnapshots.clear();
+        }
+    }
+    if (row.state != ProcessState::RUNNING_AUTO || now % ETA_SNAPSHOT_MS != 0) return;
+    if (!state_lock()) return;
+    const Chamber& c = g_chambers[0];
+    const MeatEta& eta = c.eta;
+    if (eta.stepSec > 0 && c.currentStep < c.stepCount) {
+        // Koniec kroku = max(minTime, dojście mięsa)
+        long elapsedSec = (long)((now - c.stepStartTime) / 1000);
+        long minSec = max(0L, (long)(c.profile[c.currentStep].minTimeMs / 1000) - elapsedSec);
+        etaSnapshots.push_back({now, row.step, max(minSec, eta.stepSec),
+                                max(minSec, eta.stepLoSec),
+                                eta.stepHiSec < 0 ? -1 : max(minSec, eta.stepHiSec)});
+    }
+    if (eta.processSec >= 0) {
+        etaSnapshots.push_back({now, ETA_PROCESS, eta.processSec, eta.processLoSec, eta.processHiSec});
+    }
+    state_unlock();
+}
+
+// ======================================================
+// ZDARZENIA → WEJŚCIA RDZENIA
+// ======================================================
+
+// Akcje operatora tą samą ścieżką co handlery WWW (/auto/start, /auto/stop, /mode/manual)
+static void applyEvent(const ReplayEvent& ev) {
+    switch (ev.type) {
+        case ReplayEventType::TEMP:
+            if (plantMode) {
+                plant.air = plant.sensor = ev.a;
+                plant.meat = ev.b;
+                plant.heatW = 0.0;
+                plantPublish();
+                break;
+            }
+            hal_posix_set_temp(getChamberSensorIndex(), ev.a);
+            hal_posix_set_temp(getMeatSensorIndex(), ev.b);
+            break;
+        case ReplayEventType::DOOR:
+            plant.door = ev.a != 0;
+            hal_posix_set_input(PIN_DOOR, ev.a != 0);
+            checkDoor();
+            break;
+        case ReplayEventType::PROFILE:
+            storage_save_profile_path_nvs(ev.arg);
+            break;
+        case ReplayEventType::START_AUTO:
+            if (storage_load_profile()) process_start_auto();
+            break;
+        case ReplayEventType::START_MANUAL:
+            process_start_manual();
+            break;
+        case ReplayEventType::STOP:
+            allOutputsOff();
+            if (state_lock()) { g_currentState = ProcessState::IDLE; state_unlock(); }
+            break;
+        case ReplayEventType::RESUME:
+            process_resume();
+            break;
+        case ReplayEventType::NEXT_STEP:
+            process_force_next_step();
+            break;
+        case ReplayEventType::SET_TSET:
+            if (state_lock()) { g_tSet = constrain(ev.a, CFG_T_MIN_SET, CFG_T_MAX_SET); state_unlock(); }
+            break;
+        case ReplayEventType::SET_POWER:
+            if (state_lock()) { g_powerMode = constrain((int)ev.a, CFG_POWERMODE_MIN, CFG_POWERMODE_MAX); state_unlock(); }
+            break;
+        case ReplayEventType::SET_SMOKE:
+            if (state_lock()) { g_manualSmokePwm = constrain((int)ev.a, CFG_SMOKE_PWM_MIN, CFG_SMOKE_PWM_MAX); state_unlock(); }
+            break;
+        case ReplayEventType::SET_FAN:
+            if (state_lock()) { g_fanMode = constrain((int)ev.a, 0, 2); state_unlock(); }
+            break;
+        case ReplayEventType::AUTOTUNE:
+            autotune_start(0, ev.a, ev.b != 0 ? (int)ev.b : 2);
+            break;
+        case ReplayEventType::HEATER:
+            if (ev.a >= 1 && ev.a <= 3) {
+                plantHealth[(int)ev.a - 1] = constrain(ev.b, 0.0, 1.0);
+                if (ev.b < 1.0 && faultMs == 0) faultMs = ev.tMs;
+            }
+            break;
+        case ReplayEventType::EXT_HEAT:
+            plant.extW = max(0.0, ev.a);
+            break;
+        case ReplayEventType::SENSOR:
+            if (ev.a >= 1 && ev.a <= 2) {
+                plant.sensorOk[(int)ev.a - 1] = constrain(ev.b, 0.0, 1.0);
+                if (ev.b < 1.0 && sensorFaultMs == 0) sensorFaultMs = ev.tMs;
+            }
+            break;
+        case ReplayEventType::END:
+            break;
+    }
+}
+
+// ======================================================
+// WYJŚCIE CSV
+// ======================================================
+
+static ReplayRow captureRow() {
+    ReplayRow row = {};
+    if (state_lock()) {
+        row.state = g_currentState;
+        row.step  = g_currentStep;
+        row.tSet  = g_tSet;
+        state_unlock();
+    }
+    row.ssr1  = ssr_tp_duty(PIN_SSR1);
+    row.ssr2  = ssr_tp_duty(PIN_SSR2);
+    row.ssr3  = ssr_tp_duty(PIN_SSR3);
+    row.smoke = hal_posix_pwm(PIN_SMOKE_FAN);
+    row.fan   = hal_posix_gpio(PIN_FAN);
+    return row;
+}
+
+// Zmiana decyzji = nowy wiersz; temperatury i wyjście PID zmieniają się
+// co odczyt, więc nie wyzwalają zapisu (okresowy wiersz co --every)
+static bool rowChanged(const ReplayRow& a, const ReplayRow& b) {
+    return a.state != b.state || a.step != b.step || a.tSet != b.tSet ||
+           a.ssr1 != b.ssr1 || a.ssr2 != b.ssr2 || a.ssr3 != b.ssr3 ||
+           a.smoke != b.smoke || a.fan != b.fan;
+}
+
+static void writeRow(FILE* out, uint32_t t, const ReplayRow& row) {
+    double tChamber = 0, tMeat = 0;
+    if (state_lock()) {
+        tChamber = g_tChamber;
+        tMeat    = g_tMeat;
+        state_unlock();
+    }
+    fprintf(out, "%lu,%s,%d,%.1f,%.2f,%.2f,%.2f,%lu,%lu,%lu,%d,%lu\n",
+            (unsigned long)t, stateName(row.state), row.step, row.tSet,
+            tChamber, tMeat, pidOutput,
+            (unsigned long)row.ssr1, (unsigned long)row.ssr2, (unsigned long)row.ssr3,
+            row.fan ? 1 : 0, (unsigned long)row.smoke);
+}
+
+// ======================================================
+// [NEW] DOKŁADNOŚĆ WYPEŁNIENIA SSR
+// ======================================================
+
+// Zadane wypełnienie całkowane po czasie obowiązywania (ms x 0..255)
+static double ssrCommanded[3] = {0, 0, 0};
+static uint32_t ssrAccountedMs = 0;
+
+// Wiersz z poprzedniego taktu obowiązywał do chwili nowMs (także delay() w rdzeniu)
+static void ssrAccumulate(const ReplayRow& row, uint32_t nowMs) {
+    uint32_t dtMs = nowMs - ssrAccountedMs;
+    ssrAccountedMs = nowMs;
+    ssrCommanded[0] += (double)row.ssr1 * dtMs;
+    ssrCommanded[1] += (double)row.ssr2 * dtMs;
+    ssrCommanded[2] += (double)row.ssr3 * dtMs;
+}
+
+static void ssrReport() {
+    uint32_t totalMs = ssrAccountedMs;
+    if (totalMs == 0) return;
+    for (int i = 0; i < 3; i++) {
+        uint8_t pin = plantSsrPins[i];
+        double commanded = 100.0 * ssrCommanded[i] / (255.0 * totalMs);
+        double delivered = 100.0 * hal_posix_gpio_high_us(pin) / (1000.0 * totalMs);
+        fprintf(stderr, "ssr: pin %u commanded %.3f%% delivered %.3f%% (diff %+.3f), on %.1f s\n",
+                (unsigned)pin, commanded, delivered, delivered - commanded,
+                ssr_tp_on_ms(pin) / 1000.0);
+    }
+
+    SsrLoad load;
+    ssr_tp_load(load);
+    char shares[96];
+    int offset = 0;
+    for (int n = 0; n <= SSR_CHANNELS; n++) {
+        offset += snprintf(shares + offset, sizeof(shares) - offset, "%s%d:%.1f%%",
+                           n ? " " : "", n, 100.0 * load.share[n]);
+    }
+    fprintf(stderr, "load: peak %u on (%.1f A), max %u switched on at once, avg %.3f on (%.2f A), "
+            "limit %u, denied %.1f s; time with n on %s\n",
+            (unsigned)load.peak, load.peak * CFG_SSR_HEATER_AMPS, (unsigned)load.peakSwitchOn,
+            load.average, load.average * CFG_SSR_HEATER_AMPS, (unsigned)load.limit,
+            load.denied * CFG_SSR_TICK_US / 1e6, shares);
+}
+
+// Wentylator: przełączenia zawsze, udział ON i warstwa tylko w RUNNING_*
+static void fanTrack(FanTrack& f, const ReplayRow& row, const ReplayRow& prev) {
+    if (row.fan != prev.fan) f.switches++;
+    if (!isRunning(row.state)) return;
+    f.runMs += REPLAY_TICK_MS;
+    if (row.fan) f.onMs += REPLAY_TICK_MS;
+    f.layerSum += plant.layer * REPLAY_TICK_MS;
+    if (plant.layer > f.layerMax) f.layerMax = plant.layer;
+    if (plant.layer > PLANT_UNEVEN_C) f.unevenMs += REPLAY_TICK_MS;
+}
+
+static void fanReport(const FanTrack& f) {
+    if (f.runMs == 0) return;
+    fprintf(stderr, "fan: on %.1f%% of run, %lu switches, %.0f Wh; layer mean %.2f C, max %.1f C, "
+            "> %.0f C for %.1f%%\n",
+            100.0 * f.onMs / f.runMs, (unsigned long)f.switches,
+            f.onMs / 3600000.0 * energy_get_config().fanW,
+            f.layerSum / f.runMs, f.layerMax, PLANT_UNEVEN_C, 100.0 * f.unevenMs / f.runMs);
+}
+
+// [NEW] Detektor awarii grzałek: alarmy przed / po awarii, czas wykrycia
+struct DiagTrack {
+    uint16_t suspectsBefore;
+    uint32_t drivenMs;
+    uint32_t suspectMs;
+    uint32_t pauseMs;
+    uint8_t mask;
+};
+
+static void diagTrack(DiagTrack& t, uint32_t now, const ReplayRow& row, const ReplayRow& prev) {
+    const HeaterDiag& d = chamber_get(0).diag;
+    if (faultMs == 0 || now < faultMs) {
+        t.suspectsBefore = d.suspects;
+        return;
+    }
+    // Nieużywana grzałka nie zmienia residuum – opóźnienie liczone od pierwszego wypełnienia
+    if (t.drivenMs == 0 && faultDriven) t.drivenMs = now;
+    if (t.suspectMs == 0 && d.suspects > t.suspectsBefore) t.suspectMs = now;
+    if (t.pauseMs == 0 && row.state == ProcessState::PAUSE_HEATER_FAULT &&
+        prev.state != ProcessState::PAUSE_HEATER_FAULT) {
+        t.pauseMs = now;
+        t.mask = d.failedMask;
+    }
+}
+
+static void diagReport(const DiagTrack& t) {
+    const HeaterDiag& d = chamber_get(0).diag;
+    uint16_t before = faultMs ? t.suspectsBefore : d.suspects;
+    metricSet("diag.false_alarms", before);
+    metricSet("diag.paused", t.pauseMs ? 1 : 0);
+    fprintf(stderr, "diag: %u false alarm(s) before fault", (unsigned)before);
+    if (faultMs == 0) {
+        fprintf(stderr, " (no fault injected)\n");
+        return;
+    }
+    fprintf(stderr, "; fault at t=%lus", (unsigned long)(faultMs / 1000));
+    if (t.drivenMs == 0) {
+        fprintf(stderr, ", heater never driven\n");
+        return;
+    }
+    fprintf(stderr, ", driven after %lus: ", (unsigned long)((t.drivenMs - faultMs) / 1000));
+    if (t.suspectMs) metricSet("diag.suspect_s", (t.suspectMs - t.drivenMs) / 1000.0);
+    if (t.pauseMs) metricSet("diag.pause_s", (t.pauseMs - t.drivenMs) / 1000.0);
+    if (t.pauseMs) metricSet("diag.heaters", t.mask);
+    if (t.suspectMs) fprintf(stderr, "suspected after %lus", (unsigned long)((t.suspectMs - t.drivenMs) / 1000));
+    else fprintf(stderr, "not suspected");
+    if (t.pauseMs) {
+        fprintf(stderr, ", paused after %lus, heaters", (unsigned long)((t.pauseMs - t.drivenMs) / 1000));
+        for (uint8_t i = 0; i < 3; i++) {
+            if (t.mask & (1 << i)) fprintf(stderr, " %u", (unsigned)i + 1);
+        }
+        fprintf(stderr, "\n");
+    } else {
+        fprintf(stderr, ", no pause\n");
+    }
+}
+
+static void ovhTrack(OvhTrack& t, const ReplayRow& row) {
+    double temp = g_tChamber;
+    t.sensorPeak = max(t.sensorPeak, temp);
+    t.airPeak = max(t.airPeak, plant.air);
+    if (temp > CFG_T_MAX_SOFT) t.aboveMs += REPLAY_TICK_MS;
+    if (row.state == ProcessState::PAUSE_OVERHEAT) t.hardTrip = true;
+}
+
+static void ovhReport(const OvhTrack& t) {
+    metricSet("ovh.peak", t.sensorPeak);
+    metricSet("ovh.hard_trip", t.hardTrip ? 1 : 0);
+    fprintf(stderr, "overheat: peak %.1f C (air %.1f C), %lus above %.0f C, %u guard event(s)%s\n",
+            t.sensorPeak, t.airPeak, (unsigned long)(t.aboveMs / 1000), CFG_T_MAX_SOFT,
+            (unsigned)chamber_get(0).ovh.count + (chamber_get(0).ovh.active ? 1 : 0),
+            t.hardTrip ? ", hard cutoff" : "");
+}
+
+static void sensorTrack(SensorTrack& t, uint32_t now, const ReplayRow& row) {
+    if (sensorFaultMs == 0 || now < sensorFaultMs) return;
+    const Chamber& c = chamber_get(0);
+    bool running = row.state == ProcessState::RUNNING_AUTO || row.state == ProcessState::RUNNING_MANUAL;
+    t.afterMs += REPLAY_TICK_MS;
+    if (running) t.runMs += REPLAY_TICK_MS;
+    if (row.state == ProcessState::PAUSE_SENSOR) t.pauseMs += REPLAY_TICK_MS;
+    if (sensor_failover_active(c)) {
+        double temp = g_tChamber;
+        t.degradedMs += REPLAY_TICK_MS;
+        t.estErrMax = max(t.estErrMax, fabs(temp - plant.sensor));
+    }
+    if (running) {
+        double dAir = plant.air - row.tSet;
+        if (t.runMs == REPLAY_TICK_MS) t.airMin = t.airMax = dAir;
+        t.airMin = min(t.airMin, dAir);
+        t.airMax = max(t.airMax, dAir);
+    }
+}
+
+static void sensorReport(const SensorTrack& t) {
+    if (sensorFaultMs == 0) return;
+    const SensorFailover& f = chamber_get(0).failover;
+    metricSet("sensor.episodes", f.episodes);
+    metricSet("sensor.degraded_s", t.degradedMs / 1000.0);
+    metricSet("sensor.est_err_max", t.estErrMax);
+    metricSet("sensor.hard_pauses", f.hardPauses);
+    metricSet("sensor.running_pct", t.afterMs ? 100.0 * t.runMs / t.afterMs : 0.0);
+    fprintf(stderr, "sensor: fault at t=%lus, %u episode(s), %lus degraded, estimate error max %.1f C, "
+            "%u hard pause(s), %lus in PAUSE_SENSOR, running %.1f%% after fault",
+            (unsigned long)(sensorFaultMs / 1000), (unsigned)f.episodes,
+            (unsigned long)(t.degradedMs / 1000), t.estErrMax, (unsigned)f.hardPauses,
+            (unsigned long)(t.pauseMs / 1000), t.afterMs ? 100.0 * t.runMs / t.afterMs : 0.0);
+    if (t.runMs) fprintf(stderr, ", air %+.1f..%+.1f C vs tset", t.airMin, t.airMax);
+    fprintf(stderr, "\n");
+}
+
+// Wynik autotune z logu jako metryki (bez osobnej linii na stderr)
+static void autotuneMetrics() {
+    const AutotuneRun& a = chamber_get(0).autotune;
+    if (a.phase == AutotunePhase::NONE) return;
+    metricSet("autotune.done", a.phase == AutotunePhase::DONE ? 1 : 0);
+    if (a.phase != AutotunePhase::DONE) return;
+    metricSet("autotune.ku", a.ku);
+    metricSet("autotune.tu_s", a.tuSec);
+}
+
+// Brak metryki = niespełnione (np. diag.pause_s, gdy pauzy nie było)
+static int checkExpects(const std::vector<ReplayExpect>& expects) {
+    int failed = 0;
+    for (const ReplayExpect& e : expects) {
+        auto it = metrics.find(e.name);
+        const char* opText = e.op == '<' ? "<=" : e.op == '>' ? ">=" : "==";
+        if (it == metrics.end()) {
+            fprintf(stderr, "expect: FAIL %s %s %g (no value)\n", e.name.c_str(), opText, e.value);
+            failed++;
+            continue;
+        }
+        double v = it->second;
+        bool ok = e.op == '<' ? v <= e.value : e.op == '>' ? v >= e.value : fabs(v - e.value) < 1e-9;
+        fprintf(stderr, "expect: %s %s=%g %s %g\n", ok ? "ok" : "FAIL", e.name.c_str(), v, opText, e.value);
+        if (!ok) failed++;
+    }
+    return failed;
+}
+
+static bool parseExpect(const char* spec, ReplayExpect& e) {
+    const char* op = strpbrk(spec, "<>=");
+    if (!op || op == spec || op[1] != '=') return false;
+    char* end;
+    e.value = strtod(op + 2, &end);
+    if (end == op + 2 || *end) return false;
+    e.name.assign(spec, op - spec);
+    e.op = op[0];
+    return true;
+}
+
+// ======================================================
+// PĘTLA ODTWARZANIA
+// ======================================================
+
+static void runReplay(const std::vector<ReplayEvent>& events, FILE* out,
+                      uint32_t everyMs, ReplayCpuStats& cpu) {
+    uint32_t endMs = events.empty() ? 0 : events.back().tMs;
+    for (const auto& ev : events) {
+        if (ev.type == ReplayEventType::END) { endMs = ev.tMs; break; }
+    }
+
+    fprintf(out, "t_ms,state,step,tset,t_chamber,t_meat,pid,ssr1,ssr2,ssr3,fan,smoke\n");
+
+    size_t next = 0;
+    ReplayRow last = captureRow();
+    uint32_t lastWritten = 0;
+    bool first = true;
+    SettleTrack settle = {};
+    FanTrack fan = {};
+    DiagTrack diag = {};
+    OvhTrack ovh = {};
+    SensorTrack sens = {};
+    if (plantMode) plantPublish();
+
+    for (uint32_t now = 0; now <= endMs; now += REPLAY_TICK_MS) {
+        // delay() w rdzeniu (np. ponowny odczyt 85.0) przesuwa zegar – nie cofamy go
+        uint32_t clock = hal_millis();
+        if (now > clock) hal_posix_advance_ms(now - clock);
+        ssrAccumulate(last, hal_millis());
+
+        while (next < events.size() && events[next].tMs <= now) {
+            applyEvent(events[next]);
+            next++;
+        }
+
+        if (plantMode && now > 0) plantStep(REPLAY_TICK_MS / 1000.0);
+
+        // Kolejność jak w taskSensors → taskControl
+        requestTemperature();
+        readTemperature();
+
+        auto t0 = std::chrono::steady_clock::now();
+        process_run_control_logic();
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - t0).count();
+        cpu.ticks++;
+        cpu.totalNs += ns;
+        if (ns > cpu.maxNs) cpu.maxNs = ns;
+
+        handleBuzzer();
+        energy_write_records();          // jak task Monitor – rekord wsadu na SD
+
+        ReplayRow row = captureRow();
+        if (row.state != last.state) cpu.transitions++;
+        if (plantMode) settleTrack(settle, now, last);
+        if (plantMode) etaTrack(now, row, last);
+        if (plantMode) fanTrack(fan, row, last);
+        if (plantMode) diagTrack(diag, now, row, last);
+        if (plantMode) ovhTrack(ovh, row);
+        if (plantMode) sensorTrack(sens, now, row);
+        if (first || rowChanged(row, last) || (everyMs && now - lastWritten >= everyMs)) {
+            writeRow(out, now, row);
+            lastWritten = now;
+            first = false;
+        }
+        last = row;
+    }
+    if (plantMode) fanReport(fan);
+    if (plantMode) diagReport(diag);
+    if (plantMode) ovhReport(ovh);
+    if (plantMode) sensorReport(sens);
+    if (plantMode) autotuneMetrics();
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: replay <trace.csv> [-o out.csv] [--sd dir] [--every ms] [--plant] [--no-model]\n"
+            "              [--no-stagger] [--no-fan-sched] [--no-ovh-guard]\n"
+            "              [--no-failover] [--expect metryka<=v ...]\n"
+            "  -o       wynik CSV (domyślnie stdout, razem z logami)\n"
+            "  --sd     katalog udający kartę SD z /profiles (domyślnie ./sd)\n"
+            "  --every  wiersz okresowy co ms nawet bez zmian (domyślnie 60000, 0 = wył.)\n"
+            "  --plant  temperatury z modelu komory, czasy ustalenia na stderr\n"
+            "  --no-model  PID bez feed-forward / predyktora Smitha\n"
+            "  --no-stagger  okresy ON grzałek od wspólnego startu okna\n"
+            "  --no-fan-sched  wentylator cykliczny ze stałymi czasami kroku\n"
+            "  --no-ovh-guard  bez redukcji mocy z trendu, tylko próg CFG_T_MAX_SOFT\n"
+            "  --no-failover  PAUSE_SENSOR od razu po błędach czujnika komory\n"
+            "  --expect  próg metryki (<=, >=, ==), powtarzalne; niespełniony = kod 1\n"
+            "            diag.false_alarms|suspect_s|pause_s|paused|heaters (maska),\n"
+            "            sensor.episodes|degraded_s|est_err_max|hard_pauses|running_pct,\n"
+            "            ovh.peak|hard_trip, settle.count|max_s|overshoot_max|unsettled,\n"
+            "            autotune.done|ku|tu_s\n");
+}
+
+int main(int argc, char** argv) {
+    const char* tracePath = nullptr;
+    const char* outPath = nullptr;
+    uint32_t everyMs = 60000;
+    std::vector<ReplayExpect> expects;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (strcmp(argv[i], "--sd") == 0 && i + 1 < argc) {
+            hal_posix_set_fs_root(argv[++i]);
+        } else if (strcmp(argv[i], "--every") == 0 && i + 1 < argc) {
+            everyMs = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--plant") == 0) {
+            plantMode = true;
+        } else if (strcmp(argv[i], "--no-model") == 0) {
+            fopdt_set_control(false);
+        } else if (strcmp(argv[i], "--no-stagger") == 0) {
+            ssr_tp_set_stagger(false);
+        } else if (strcmp(argv[i], "--no-fan-sched") == 0) {
+            fan_sched_set_enabled(false);
+        } else if (strcmp(argv[i], "--no-ovh-guard") == 0) {
+            overheat_set_enabled(false);
+        } else if (strcmp(argv[i], "--no-failover") == 0) {
+            sensor_failover_set_enabled(false);
+        } else if (strcmp(argv[i], "--expect") == 0 && i + 1 < argc) {
+            ReplayExpect e;
+            if (!parseExpect(argv[++i], e)) {
+                fprintf(stderr, "Bad --expect: %s\n", argv[i]);
+                return 2;
+            }
+            expects.push_back(e);
+        } else if (argv[i][0] != '-' && !tracePath) {
+            tracePath = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (!tracePath) {
+        usage();
+        return 2;
+    }
+
+    std::vector<ReplayEvent> events;
+    if (!loadTrace(tracePath, events)) return 1;
+
+    FILE* out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Cannot create output: %s\n", outPath);
+        return 1;
+    }
+
+    hal_posix_set_time_ms(0);
+    hal_posix_kv_clear();
+    init_state();
+    storage_load_config_nvs();
+    ssr_tp_init();
+
+    ReplayCpuStats cpu = {};
+    runReplay(events, out, everyMs, cpu);
+    if (out != stdout) fclose(out);
+
+    fprintf(stderr, "replay: %zu events, %lu ticks, %lu state transitions\n",
+            events.size(), (unsigned long)cpu.ticks, (unsigned long)cpu.transitions);
+    fprintf(stderr, "control: %.0f ns/tick avg, %llu ns max\n",
+            cpu.ticks ? (double)cpu.totalNs / cpu.ticks : 0.0,
+            (unsigned long long)cpu.maxNs);
+    fprintf(stderr, "model: %s\n", fopdt_json(0).c_str());
+    ssrReport();
+    fprintf(stderr, "energy: %s\n", energy_json(0).c_str());
+    return checkExpects(expects) ? 1 : 0;
+}
+
+#endif // !ARDUINO
@@ -0,0 +1,288 @@
+// sd_clock.cpp - [NEW] Zegar SPI karty SD (opis w sd_clock.h)
+#include "sd_clock.h"
+#include "config.h"
+#include "hal.h"
+#include <SD.h>
+#include <SPI.h>
+#include <esp_rom_crc.h>
+#include <algorithm>
+
+static constexpr const char* SD_CLOCK_TEST_PATH = "/.sdclock.tmp";
+static constexpr const char* SD_BENCH_PATH = "/.sdbench.tmp";
+static constexpr uint8_t SD_CLOCK_STEP_COUNT = sizeof(CFG_SD_CLOCK_STEPS_HZ) / sizeof(CFG_SD_CLOCK_STEPS_HZ[0]);
+static constexpr size_t SD_BLOCK = 4096;
+static constexpr size_t SD_RANDOM_BLOCK = 512;
+static constexpr uint16_t SD_SEQ_BLOCKS = CFG_SD_BENCH_BYTES / SD_BLOCK;
+
+static uint32_t clockHz = CFG_SD_CLOCK_BASE_HZ;
+static uint32_t storedHz = 0;
+static int8_t probeResult[SD_CLOCK_STEP_COUNT];      // 1 = OK, 0 = błąd, -1 = nie próbowano
+static uint8_t errorCount = 0;
+static unsigned long errorWindowStart = 0;
+static uint16_t stepDowns = 0;
+static bool busy = false;                            // negocjacja / spadek / pomiar
+static portMUX_TYPE clockMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Bufor próby zegara i pomiaru – statyczny, bez sterty w tasku Web
+static uint8_t ioBuf[SD_BLOCK];
+static uint32_t seqWriteUs[SD_SEQ_BLOCKS];
+static uint32_t seqReadUs[SD_SEQ_BLOCKS];
+static uint32_t randomUs[CFG_SD_BENCH_RANDOM_READS];
+
+static bool tryLock() {
+    portENTER_CRITICAL(&clockMux);
+    bool ok = !busy;
+    busy = true;
+    portEXIT_CRITICAL(&clockMux);
+    return ok;
+}
+
+static void unlock() {
+    portENTER_CRITICAL(&clockMux);
+    busy = false;
+    portEXIT_CRITICAL(&clockMux);
+}
+
+static void fillPattern(uint32_t& seed, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        seed = seed * 1103515245u + 12345u;
+        ioBuf[i] = (uint8_t)(seed >> 16);
+    }
+}
+
+static bool mountAt(uint32_t hz) {
+    SD.end();
+    if (!SD.begin(PIN_SD_CS, SPI, hz) || SD.cardType() == CARD_NONE) return false;
+    clockHz = hz;
+    return true;
+}
+
+// Zapis wzorca i odczyt – CRC32 obu stron musi się zgadzać
+static bool verifyIo(uint32_t seed) {
+    uint32_t crcWrite = 0, crcRead = 0;
+    File f = SD.open(SD_CLOCK_TEST_PATH, FILE_WRITE);
+    if (!f) return false;
+    bool ok = true;
+    for (size_t done = 0; done < CFG_SD_CLOCK_TEST_BYTES && ok; done += SD_BLOCK) {
+        fillPattern(seed, SD_BLOCK);
+        crcWrite = esp_rom_crc32_le(crcWrite, ioBuf, SD_BLOCK);
+        ok = f.write(ioBuf, SD_BLOCK) == SD_BLOCK;
+    }
+    f.close();
+
+    if (ok) {
+        f = SD.open(SD_CLOCK_TEST_PATH, FILE_READ);
+        ok = f && f.size() == CFG_SD_CLOCK_TEST_BYTES;
+        for (size_t done = 0; done < CFG_SD_CLOCK_TEST_BYTES && ok; done += SD_BLOCK) {
+            ok = f.read(ioBuf, SD_BLOCK) == SD_BLOCK;
+            crcRead = esp_rom_crc32_le(crcRead, ioBuf, SD_BLOCK);
+        }
+        if (f) f.close();
+    }
+    SD.remove(SD_CLOCK_TEST_PATH);
+    return ok && crcRead == crcWrite;
+}
+
+static bool probe(uint32_t hz) {
+    bool ok = mountAt(hz) && verifyIo(hz);
+    LOG_FMT(ok ? LOG_LEVEL_INFO : LOG_LEVEL_WARN, "SD clock %lu kHz: %s",
+            (unsigned long)(hz / 1000), ok ? "OK" : "FAILED");
+    return ok;
+}
+
+static void persist(uint32_t hz) {
+    if (hz == storedHz) return;
+    hal_kv_t h;
+    if (!hal_kv_open("sd_clock", true, &h)) return;
+    if (hal_kv_set_i32(h, "hz", (int32_t)hz) && hal_kv_commit(h)) storedHz = hz;
+    hal_kv_close(h);
+}
+
+static int stepIndex(uint32_t hz) {
+    for (uint8_t i = 0; i < SD_CLOCK_STEP_COUNT; i++) {
+        if (CFG_SD_CLOCK_STEPS_HZ[i] == hz) return i;
+    }
+    return -1;
+}
+
+uint32_t sd_clock_negotiate() {
+    // [FIX] Kolejne montaże pod blokadą karty – inne taski czekają w hal_fs_*
+    if (!hal_fs_lock(CFG_SD_LOCK_TIMEOUT_MS)) return clockHz;
+    if (!tryLock()) {
+        hal_fs_unlock();
+        return clockHz;
+    }
+    for (uint8_t i = 0; i < SD_CLOCK_STEP_COUNT; i++) probeResult[i] = -1;
+
+    hal_kv_t h;
+    int32_t saved = 0;
+    if (hal_kv_open("sd_clock", false, &h)) {
+        if (hal_kv_get_i32(h, "hz", &saved)) storedHz = (uint32_t)saved;
+        hal_kv_close(h);
+    }
+
+    // Zapamiętany stopień – jedna próba zamiast całej drabiny
+    uint32_t good = CFG_SD_CLOCK_BASE_HZ;
+    int saveIdx = stepIndex(storedHz);
+    bool quick = saveIdx >= 0 && probe(storedHz);
+    if (saveIdx >= 0) probeResult[saveIdx] = quick ? 1 : 0;
+    if (quick) {
+        good = storedHz;
+    } else {
+        for (uint8_t i = 0; i < SD_CLOCK_STEP_COUNT; i++) {
+            bool ok = probe(CFG_SD_CLOCK_STEPS_HZ[i]);
+            probeResult[i] = ok ? 1 : 0;
+            if (!ok) break;
+            good = CFG_SD_CLOCK_STEPS_HZ[i];
+        }
+        if (clockHz != good && !mountAt(good)) mountAt(CFG_SD_CLOCK_BASE_HZ);
+    }
+    persist(clockHz);
+    unlock();
+    hal_fs_unlock();
+
+    LOG_FMT(LOG_LEVEL_INFO, "SD clock: %lu kHz%s", (unsigned long)(clockHz / 1000),
+            quick ? " (saved)" : "");
+    return clockHz;
+}
+
+uint32_t sd_clock_hz() {
+    return clockHz;
+}
+
+void sd_clock_note_error() {
+    unsigned long now = millis();
+    portENTER_CRITICAL(&clockMux);
+    if (errorCount == 0 || now - errorWindowStart > CFG_SD_CLOCK_ERROR_WINDOW_MS) {
+        errorWindowStart = now;
+        errorCount = 0;
+    }
+    if (errorCount < 255) errorCount++;
+    portEXIT_CRITICAL(&clockMux);
+}
+
+void sd_clock_service() {
+    portENTER_CRITICAL(&clockMux);
+    bool due = errorCount >= CFG_SD_CLOCK_ERROR_LIMIT;
+    portEXIT_CRITICAL(&clockMux);
+    if (!due || clockHz <= CFG_SD_CLOCK_BASE_HZ) return;
+    // Ponowny montaż unieważnia otwarte uchwyty – poczekaj, aż się zamkną.
+    // [FIX] Licznik uchwytów HAL nie widzi sekcji SD.* w innych taskach –
+    // sprawdzany pod blokadą karty, bez czekania (ponowienie w następnym takcie)
+    if (!hal_fs_lock(0)) return;
+    if (hal_fs_open_count() > 0 || !tryLock()) {
+        hal_fs_unlock();
+        return;
+    }
+
+    uint32_t from = clockHz;
+    int idx = stepIndex(from);
+    uint32_t lower = idx > 0 ? CFG_SD_CLOCK_STEPS_HZ[idx - 1] : CFG_SD_CLOCK_BASE_HZ;
+    if (!(mountAt(lower) && verifyIo(lower))) {
+        lower = CFG_SD_CLOCK_BASE_HZ;
+        mountAt(lower);
+    }
+    persist(clockHz);
+    stepDowns++;
+    portENTER_CRITICAL(&clockMux);
+    errorCount = 0;
+    portEXIT_CRITICAL(&clockMux);
+    unlock();
+    hal_fs_unlock();
+
+    LOG_FMT(LOG_LEVEL_WARN, "SD I/O errors - clock %lu -> %lu kHz",
+            (unsigned long)(from / 1000), (unsigned long)(clockHz / 1000));
+}
+
+// Percentyl z posortowanej tablicy
+static uint32_t pct(const uint32_t* v, size_t n, uint8_t p) {
+    return n ? v[std::min(n - 1, n * p / 100)] : 0;
+}
+
+static int latencyJson(char* out, size_t size, uint32_t* v, size_t n) {
+    std::sort(v, v + n);
+    return snprintf(out, size, "{\"p50\":%lu,\"p95\":%lu,\"p99\":%lu,\"max\":%lu}",
+                    (unsigned long)pct(v, n, 50), (unsigned long)pct(v, n, 95),
+                    (unsigned long)pct(v, n, 99), (unsigned long)(n ? v[n - 1] : 0));
+}
+
+String sd_clock_bench_json() {
+    if (SD.cardType() == CARD_NONE) return String("{\"ok\":false,\"message\":\"no card\"}");
+    if (!hal_fs_lock(CFG_SD_LOCK_TIMEOUT_MS)) return String("{\"ok\":false,\"message\":\"busy\"}");
+    if (!tryLock()) {
+        hal_fs_unlock();
+        return String("{\"ok\":false,\"message\":\"busy\"}");
+    }
+
+    // Zapis sekwencyjny (ten sam blok – wzorzec poza pomiarem)
+    uint32_t seed = micros();
+    fillPattern(seed, SD_BLOCK);
+    uint32_t t0 = micros();
+    File f = SD.open(SD_BENCH_PATH, FILE_WRITE);
+    bool ok = (bool)f;
+    for (uint16_t i = 0; i < SD_SEQ_BLOCKS && ok; i++) {
+        uint32_t t = micros();
+        ok = f.write(ioBuf, SD_BLOCK) == SD_BLOCK;
+        seqWriteUs[i] = micros() - t;
+    }
+    if (f) f.close();
+    uint32_t writeUs = micros() - t0;
+
+    // Odczyt sekwencyjny
+    uint32_t readUs = 0;
+    uint32_t randomTotalUs = 0;
+    if (ok) {
+        t0 = micros();
+        f = SD.open(SD_BENCH_PATH, FILE_READ);
+        ok = (bool)f;
+        for (uint16_t i = 0; i < SD_SEQ_BLOCKS && ok; i++) {
+            uint32_t t = micros();
+            ok = f.read(ioBuf, SD_BLOCK) == SD_BLOCK;
+            seqReadUs[i] = micros() - t;
+        }
+        readUs = micros() - t0;
+
+        // Odczyty w losowych miejscach (seek + 512 B)
+        for (uint16_t i = 0; i < CFG_SD_BENCH_RANDOM_READS && ok; i++) {
+            seed = seed * 1103515245u + 12345u;
+            uint32_t offset = (seed >> 8) % (CFG_SD_BENCH_BYTES / SD_RANDOM_BLOCK) * SD_RANDOM_BLOCK;
+            uint32_t t = micros();
+            ok = f.seek(offset) && f.read(ioBuf, SD_RANDOM_BLOCK) == SD_RANDOM_BLOCK;
+            randomUs[i] = micros() - t;
+            randomTotalUs += randomUs[i];
+        }
+        if (f) f.close();
+    }
+    SD.remove(SD_BENCH_PATH);
+    if (!ok) {
+        unlock();
+        hal_fs_unlock();
+        sd_clock_note_error();
+        return String("{\"ok\":false,\"message\":\"I/O error\"}");
+    }
+
+    char json[768];
+    int offset = snprintf(json, sizeof(json),
+        "{\"ok\":true,\"clockHz\":%lu,\"storedHz\":%lu,\"stepDowns\":%u,\"probe\":[",
+        (unsigned long)clockHz, (unsigned long)storedHz, (unsigned)stepDowns);
+    for (uint8_t i = 0; i < SD_CLOCK_STEP_COUNT; i++) {
+        offset += snprintf(json + offset, sizeof(json) - offset, "%s{\"hz\":%lu,\"ok\":%s}",
+            i ? "," : "", (unsigned long)CFG_SD_CLOCK_STEPS_HZ[i],
+            probeResult[i] < 0 ? "null" : probeResult[i] ? "true" : "false");
+    }
+    offset += snprintf(json + offset, sizeof(json) - offset,
+        "],\"bytes\":%lu,\"seqWriteKBs\":%.0f,\"seqReadKBs\":%.0f,\"randomIops\":%.0f,\"writeUs\":",
+        (unsigned long)CFG_SD_BENCH_BYTES,
+        writeUs ? CFG_SD_BENCH_BYTES * 1e6 / 1024.0 / writeUs : 0.0,
+        readUs ? CFG_SD_BENCH_BYTES * 1e6 / 1024.0 / readUs : 0.0,
+        randomTotalUs ? CFG_SD_BENCH_RANDOM_READS * 1e6 / randomTotalUs : 0.0);
+    offset += latencyJson(json + offset, sizeof(json) - offset, seqWriteUs, SD_SEQ_BLOCKS);
+    offset += snprintf(json + offset, sizeof(json) - offset, ",\"readUs\":");
+    offset += latencyJson(json + offset, sizeof(json) - offset, seqReadUs, SD_SEQ_BLOCKS);
+    offset += snprintf(json + offset, sizeof(json) - offset, ",\"randomUs\":");
+    offset += latencyJson(json + offset, sizeof(json) - offset, randomUs, CFG_SD_BENCH_RANDOM_READS);
+    snprintf(json + offset, sizeof(json) - offset, "}");
+    unlock();
+    hal_fs_unlock();
+    return String(json);
+}
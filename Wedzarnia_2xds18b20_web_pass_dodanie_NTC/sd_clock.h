@@ -0,0 +1,36 @@
+// sd_clock.h - [NEW] Zegar SPI karty SD: negocjacja i test przepustowości
+// hardware_init_sd() montował kartę na sztywno na 1 MHz (pewność przy
+// długich przewodach) – logi, profile, lista kopii i spool MQTT czekały
+// na ~100 KB/s. Teraz po montażu na CFG_SD_CLOCK_BASE_HZ:
+//   - zapamiętany w NVS ("sd_clock"/"hz") zegar sprawdzany jako pierwszy,
+//   - inaczej kolejne stopnie CFG_SD_CLOCK_STEPS_HZ (4/10/20/40 MHz):
+//     ponowny montaż, zapis CFG_SD_CLOCK_TEST_BYTES wzorca, odczyt i
+//     porównanie CRC32; pierwszy błąd kończy próby,
+//   - najwyższy stabilny stopień zostaje i idzie do NVS.
+// Błędy I/O w pracy (krótki zapis, nieudane otwarcie do zapisu – hal_esp32)
+// liczone w oknie CFG_SD_CLOCK_ERROR_WINDOW_MS; CFG_SD_CLOCK_ERROR_LIMIT
+// = stopień niżej (task Monitor, tylko bez otwartych plików), też do NVS.
+// [FIX] Każdy ponowny montaż i pomiar pod blokadą karty (hal_fs_lock) –
+// samo zero uchwytów HAL nie wykluczało SD.* w tasku Web czy skanu FAT.
+//
+// /sd/bench: zapis i odczyt sekwencyjny CFG_SD_BENCH_BYTES blokami 4 KB,
+// CFG_SD_BENCH_RANDOM_READS odczytów 512 B w losowych miejscach – KB/s,
+// IOPS i percentyle opóźnień bloku. Plik testowy usuwany po pomiarze.
+#pragma once
+#include <Arduino.h>
+
+// Po udanym montażu na CFG_SD_CLOCK_BASE_HZ; zwraca zegar, na którym karta
+// zostaje zamontowana
+uint32_t sd_clock_negotiate();
+
+// Bieżący zegar (hal_fs_remount)
+uint32_t sd_clock_hz();
+
+// Błąd I/O karty (hal_esp32.cpp)
+void sd_clock_note_error();
+
+// Task Monitor: spadek o stopień po serii błędów
+void sd_clock_service();
+
+// Pomiar dla /sd/bench (blokuje na kilka sekund – task Web)
+String sd_clock_bench_json();
@@ -0,0 +1,144 @@
+// sd_stats.cpp - [NEW] Pojemność i zajętość karty SD z pamięci podręcznej (opis w sd_stats.h)
+#include "sd_stats.h"
+#include "config.h"
+#include "hal.h"
+#include <SD.h>
+
+static uint64_t scanTotal = 0;
+static uint64_t scanUsed = 0;
+static uint64_t writtenSinceScan = 0;
+static uint64_t removedSinceScan = 0;
+static unsigned long lastScanMs = 0;
+static unsigned long lastAttemptMs = 0;
+static uint32_t lastScanDurationMs = 0;
+static uint32_t scanGen = 0;             // ++ przy invalidate – stary skan do kosza
+static bool statsValid = false;
+static bool scanning = false;
+static bool scanRequested = false;
+static hal_signal_t scanSignal = NULL;
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+void sd_stats_init() {
+    if (!scanSignal) scanSignal = hal_signal_create();
+    sd_stats_request_scan();
+}
+
+void sd_stats_note_write(size_t bytes) {
+    portENTER_CRITICAL(&statsMux);
+    writtenSinceScan += bytes;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+void sd_stats_note_remove(size_t bytes) {
+    portENTER_CRITICAL(&statsMux);
+    removedSinceScan += bytes;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+void sd_stats_invalidate() {
+    portENTER_CRITICAL(&statsMux);
+    scanGen++;
+    statsValid = false;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+void sd_stats_request_scan() {
+    portENTER_CRITICAL(&statsMux);
+    scanRequested = true;
+    portEXIT_CRITICAL(&statsMux);
+    if (scanSignal) hal_signal_give(scanSignal);
+}
+
+static void runScan() {
+    portENTER_CRITICAL(&statsMux);
+    uint32_t gen = scanGen;
+    uint64_t written = writtenSinceScan;
+    uint64_t removed = removedSinceScan;
+    scanning = true;
+    lastAttemptMs = millis();
+    portEXIT_CRITICAL(&statsMux);
+
+    // Oba wołają f_getfree() – przy nieważnym FSINFO przejście całej FAT
+    unsigned long t0 = millis();
+    uint64_t total = SD.totalBytes();
+    uint64_t used = SD.usedBytes();
+    uint32_t durationMs = millis() - t0;
+
+    // Karta odmontowana w trakcie (formatowanie, zmiana zegara) – 0 / śmieci
+    bool ok = total > 0 && used <= total;
+    portENTER_CRITICAL(&statsMux);
+    scanning = false;
+    bool current = gen == scanGen;
+    if (ok && current) {
+        scanTotal = total;
+        scanUsed = used;
+        // Zapisy w trakcie skanu zostają w bilansie
+        writtenSinceScan -= written;
+        removedSinceScan -= removed;
+        lastScanMs = millis();
+        lastScanDurationMs = durationMs;
+        statsValid = true;
+    }
+    portEXIT_CRITICAL(&statsMux);
+
+    if (!ok) {
+        LOG_FMT(LOG_LEVEL_WARN, "SD stats scan failed after %lu ms", (unsigned long)durationMs);
+        return;
+    }
+    if (!current) return;
+    LOG_FMT(LOG_LEVEL_INFO, "SD stats: %llu of %llu MB used, scan %lu ms",
+            used / (1024 * 1024), total / (1024 * 1024), (unsigned long)durationMs);
+}
+
+void sd_stats_process(uint32_t waitMs) {
+    if (!scanSignal) scanSignal = hal_signal_create();
+    if (scanSignal) hal_signal_wait(scanSignal, waitMs);
+    else            delay(waitMs);
+
+    unsigned long now = millis();
+    portENTER_CRITICAL(&statsMux);
+    bool requested = scanRequested;
+    scanRequested = false;
+    unsigned long age = now - lastScanMs;
+    uint64_t churn = writtenSinceScan + removedSinceScan;
+    // Bez ważnego wyniku (brak karty, błąd skanu) ponowienie co MIN_GAP
+    bool due = requested ||
+               (statsValid ? age >= CFG_SD_STATS_RESCAN_MS ||
+                             (churn >= CFG_SD_STATS_DRIFT_BYTES && age >= CFG_SD_STATS_MIN_GAP_MS)
+                           : now - lastAttemptMs >= CFG_SD_STATS_MIN_GAP_MS);
+    portEXIT_CRITICAL(&statsMux);
+
+    if (!due) return;
+    if (SD.cardType() == CARD_NONE) return;
+    // [FIX] Skan pod blokadą karty – zmiana zegara ani formatowanie nie
+    // odmontują jej w trakcie f_getfree; zajęta = ponowienie w następnym obiegu
+    if (!hal_fs_lock(CFG_SD_LOCK_TIMEOUT_MS)) {
+        portENTER_CRITICAL(&statsMux);
+        scanRequested = true;
+        portEXIT_CRITICAL(&statsMux);
+        return;
+    }
+    runScan();
+    hal_fs_unlock();
+}
+
+SdStats sd_stats_get() {
+    SdStats s;
+    portENTER_CRITICAL(&statsMux);
+    uint64_t total = scanTotal;
+    uint64_t used = scanUsed;
+    uint64_t written = writtenSinceScan;
+    uint64_t removed = removedSinceScan;
+    s.valid = statsValid;
+    s.scanning = scanning;
+    s.scanAgeSec = statsValid ? (millis() - lastScanMs) / 1000 : 0;
+    s.scanMs = lastScanDurationMs;
+    portEXIT_CRITICAL(&statsMux);
+
+    used += written;
+    used = removed < used ? used - removed : 0;
+    s.totalBytes = s.valid ? total : 0;
+    s.usedBytes = s.valid ? (used < total ? used : total) : 0;
+    s.estimated = s.valid && (written || removed);
+    return s;
+}
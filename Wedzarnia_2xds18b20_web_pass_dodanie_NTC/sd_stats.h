@@ -0,0 +1,45 @@
+// sd_stats.h - [NEW] Pojemność i zajętość karty SD z pamięci podręcznej
+// /api/sysinfo (strona odpytuje co 5 s) i /sd/info wołały SD.totalBytes()
+// i SD.usedBytes() przy każdym żądaniu – f_getfree() przechodzi całą FAT,
+// na karcie 32 GB to kilka sekund blokady taska Web i wolumenu.
+// Teraz:
+//   - pełny skan (total + used) w tasku SdStats o najniższym priorytecie:
+//     po montażu, po formatowaniu, co CFG_SD_STATS_RESCAN_MS i wcześniej,
+//     gdy zapisy + usunięcia od skanu przekroczą CFG_SD_STATS_DRIFT_BYTES
+//     (nie częściej niż co CFG_SD_STATS_MIN_GAP_MS),
+//   - między skanami zajętość = wynik skanu + bajty zapisane - usunięte
+//     (hal_esp32.cpp, logToFile); zaokrąglenia do klastrów i zapisy poza
+//     hal_fs_* poprawia następny skan,
+//   - handlery WWW czytają kopię spod portMUX – mikrosekundy.
+// Wynik skanu rozpoczętego przed sd_stats_invalidate() jest odrzucany.
+#pragma once
+#include <Arduino.h>
+
+struct SdStats {
+    bool valid;              // był udany skan od montażu
+    bool scanning;
+    bool estimated;          // od skanu były zapisy / usunięcia
+    uint64_t totalBytes;
+    uint64_t usedBytes;      // skan + bilans zapisów
+    uint32_t scanAgeSec;
+    uint32_t scanMs;         // czas ostatniego skanu
+};
+
+// Po montażu karty (taskBootStorage) – pierwszy skan w tle
+void sd_stats_init();
+
+// Task SdStats: czeka max waitMs na żądanie, skanuje gdy trzeba
+void sd_stats_process(uint32_t waitMs);
+
+// Bilans między skanami (hal_esp32.cpp, logToFile)
+void sd_stats_note_write(size_t bytes);
+void sd_stats_note_remove(size_t bytes);
+
+// Przed SD.end() (formatowanie) – dane nieważne do następnego skanu
+void sd_stats_invalidate();
+
+// Skan najszybciej jak się da (np. po ponownym montażu)
+void sd_stats_request_scan();
+
+// Kopia dla /api/sysinfo i /sd/info
+SdStats sd_stats_get();
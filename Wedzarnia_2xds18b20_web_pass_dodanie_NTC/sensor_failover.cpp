@@ -0,0 +1,237 @@
+// sensor_failover.cpp - [NEW] Praca bez czujnika komory (opis w sensor_failover.h)
+#include "sensor_failover.h"
+#include "config.h"
+#include "state.h"
+#include "outputs.h"
+#include "fopdt.h"
+
+static bool failoverEnabled = CFG_FAILOVER_ENABLE;
+
+static bool runningState(ProcessState st) {
+    return st == ProcessState::RUNNING_AUTO || st == ProcessState::RUNNING_MANUAL;
+}
+
+// Wołać pod state_lock
+static void endEpisode(Chamber& c, unsigned long now) {
+    SensorFailover& f = c.failover;
+    f.active = false;
+    f.degradedMs += now - f.startMs;
+}
+
+bool sensor_failover_begin(Chamber& c, unsigned long now) {
+    SensorFailover& f = c.failover;
+    if (!failoverEnabled || !state_lock()) return false;
+    bool fresh = c.cachedChamber.valid && now - c.cachedChamber.timestamp <= CFG_FAILOVER_ANCHOR_MS;
+    bool ok = runningState(c.currentState) && c.model.valid && fresh;
+    if (ok) {
+        f.active = true;
+        f.startMs = now;
+        f.anchorMs = c.cachedChamber.timestamp;
+        f.lastStepMs = now;
+        f.estimate = c.cachedChamber.value;
+        f.validStreak = 0;
+        f.meatWinSum = 0;
+        f.meatWinCount = 0;
+        f.meatHavePrev = false;
+        f.meatSlopeValid = false;
+        f.meatAided = false;
+        f.episodes++;
+        c.errorSensor = true;
+        c.tChamber = f.estimate;
+    }
+    state_unlock();
+
+    if (ok) {
+        LOG_FMT(LOG_LEVEL_ERROR, "Sensor error K%u - degraded mode on model estimate %.1f C",
+                (unsigned)c.id, f.estimate);
+        buzzerBeep(3, 300, 150);
+    }
+    return ok;
+}
+
+void sensor_failover_read(Chamber& c, bool valid, double t, unsigned long now) {
+    SensorFailover& f = c.failover;
+    if (!state_lock()) return;
+    if (!f.active) {
+        state_unlock();
+        return;
+    }
+    bool recovered = false;
+    if (!valid) {
+        f.validStreak = 0;
+    } else {
+        f.estimate = t;
+        f.anchorMs = now;
+        if (++f.validStreak >= CFG_FAILOVER_RECOVER_READS) {
+            endEpisode(c, now);
+            c.errorSensor = false;
+            recovered = true;
+        }
+    }
+    unsigned long episodeMs = now - f.startMs;
+    state_unlock();
+
+    if (recovered) {
+        LOG_FMT(LOG_LEVEL_WARN, "Sensor K%u back after %lu s in degraded mode",
+                (unsigned)c.id, episodeMs / 1000);
+    }
+}
+
+// [FIX] Limit wyjścia z powrotem na 0..100. SetOutputLimits(0, 0) PID
+// ignoruje (min >= max), więc cap 0 trzyma wyjście na 0 w trybie MANUAL.
+static void releaseCap(Chamber& c) {
+    SensorFailover& f = c.failover;
+    if (f.outputHeld) {
+        c.pid.SetMode(PidController::AUTOMATIC);
+        f.outputHeld = false;
+    }
+    if (f.capApplied) {
+        c.pid.SetOutputLimits(0, 100);
+        f.capApplied = false;
+    }
+}
+
+static void applyCap(Chamber& c, double cap) {
+    SensorFailover& f = c.failover;
+    if (cap <= 0) {
+        c.pid.SetMode(PidController::MANUAL);
+        c.pidOutput = 0;
+        f.outputHeld = true;
+        return;
+    }
+    if (f.outputHeld) {
+        c.pid.SetMode(PidController::AUTOMATIC);   // bez skoku – od wyjścia 0
+        f.outputHeld = false;
+    }
+    c.pid.SetOutputLimits(0, cap);
+    f.capApplied = true;
+}
+
+// Pochodna mięsa ze średnich kolejnych okien (C/s)
+static void meatSample(SensorFailover& f, double tMeat) {
+    f.meatWinSum += tMeat;
+    if (++f.meatWinCount < CFG_FAILOVER_MEAT_WINDOW_S) return;
+    double mean = f.meatWinSum / f.meatWinCount;
+    f.meatWinSum = 0;
+    f.meatWinCount = 0;
+    if (f.meatHavePrev) {
+        f.meatSlope = (mean - f.meatPrevMean) / CFG_FAILOVER_MEAT_WINDOW_S;
+        f.meatSlopeValid = true;
+    }
+    f.meatPrevMean = mean;
+    f.meatHavePrev = true;
+}
+
+void sensor_failover_update(Chamber& c, unsigned long now) {
+    SensorFailover& f = c.failover;
+    if (!f.active) {
+        releaseCap(c);
+        return;
+    }
+    if (now - f.lastStepMs < 1000) return;
+    f.lastStepMs = now;
+
+    if (!state_lock()) return;
+    ProcessState st = c.currentState;
+    double est = f.estimate;
+    unsigned long anchorMs = f.anchorMs;
+    unsigned long startMs = f.startMs;
+    bool meatOk = c.cachedMeat.valid && now - c.cachedMeat.timestamp <= 5 * TEMP_REQUEST_INTERVAL;
+    double tMeat = c.tMeat;
+    bool kValid = c.eta.valid && c.eta.k > 0;
+    double k = c.eta.k;
+    double tSet = c.tSet;
+    int pm = c.powerMode;
+    state_unlock();
+
+    // Stop / pauza (drzwi, użytkownik) – koniec epizodu; po wznowieniu
+    // bez świeżego odczytu sensors.cpp da PAUSE_SENSOR
+    if (!runningState(st)) {
+        if (state_lock()) {
+            endEpisode(c, now);
+            state_unlock();
+        }
+        LOG_FMT(LOG_LEVEL_INFO, "Degraded mode K%u ended - process not running", (unsigned)c.id);
+        return;
+    }
+
+    bool modelOk = fopdt_estimate_step(c, est);
+    if (meatOk) {
+        meatSample(f, tMeat);
+    } else {
+        f.meatWinSum = 0;
+        f.meatWinCount = 0;
+        f.meatHavePrev = false;
+        f.meatSlopeValid = false;
+    }
+    bool meatAided = meatOk && kValid && f.meatSlopeValid;
+    if (meatAided) {
+        double tkMeat = tMeat + f.meatSlope / k;
+        est += (tkMeat - est) / CFG_FAILOVER_MEAT_TAU_S;
+    }
+
+    unsigned long limitMs = meatAided ? CFG_FAILOVER_MAX_MS : CFG_FAILOVER_MODEL_MAX_MS;
+    unsigned long blindMs = now - anchorMs;
+    // [FIX] Limit na cały epizod – pojedyncze ważne odczyty luźnego styku
+    // przesuwają kotwicę, ale nie przedłużają pracy bez czujnika
+    unsigned long episodeMs = now - startMs;
+    if (!modelOk || blindMs > limitMs || episodeMs > limitMs) {
+        if (state_lock()) {
+            endEpisode(c, now);
+            f.hardPauses++;
+            c.currentState = ProcessState::PAUSE_SENSOR;
+            c.processStats.pauseCount++;
+            state_unlock();
+        }
+        releaseCap(c);
+        chamberOutputsOff(c);
+        buzzerBeep(5, 300, 200);
+        LOG_FMT(LOG_LEVEL_ERROR, "Sensor error K%u - %s after %lu s (%lu s blind), pausing",
+                (unsigned)c.id, modelOk ? "degraded mode limit" : "model lost",
+                episodeMs / 1000, blindMs / 1000);
+        return;
+    }
+
+    double hold = fopdt_hold_output(c, tSet, pm);
+    double cap = constrain(hold * CFG_FAILOVER_HOLD_MUL, 0.0, 100.0);
+    applyCap(c, cap);
+
+    if (!state_lock()) return;
+    // Ważny odczyt mógł przyjść w międzyczasie – wtedy kotwica wygrywa
+    if (f.active && f.anchorMs == anchorMs) {
+        f.estimate = est;
+        c.tChamber = est;
+    }
+    f.powerCap = cap;
+    f.meatAided = meatAided;
+    state_unlock();
+}
+
+bool sensor_failover_active(const Chamber& c) {
+    return c.failover.active;
+}
+
+void sensor_failover_set_enabled(bool enabled) {
+    failoverEnabled = enabled;
+}
+
+String sensor_failover_json(uint8_t chamberIdx) {
+    const Chamber& c = chamber_get(chamberIdx);
+    if (!state_lock()) return String("{}");
+    SensorFailover f = c.failover;
+    state_unlock();
+
+    unsigned long now = millis();
+    unsigned long limitMs = f.meatAided ? CFG_FAILOVER_MAX_MS : CFG_FAILOVER_MODEL_MAX_MS;
+    unsigned long degradedMs = f.degradedMs + (f.active ? now - f.startMs : 0);
+    char json[384];
+    snprintf(json, sizeof(json),
+        "{\"chamber\":%u,\"enabled\":%s,\"active\":%s,\"meatAided\":%s,"
+        "\"estimate\":%.2f,\"blindSec\":%lu,\"limitSec\":%lu,\"powerCap\":%.1f,"
+        "\"validStreak\":%u,\"episodes\":%u,\"hardPauses\":%u,\"degradedSec\":%lu}",
+        (unsigned)c.id, failoverEnabled ? "true" : "false", f.active ? "true" : "false",
+        f.meatAided ? "true" : "false", f.estimate,
+        f.active ? (now - f.anchorMs) / 1000 : 0UL, limitMs / 1000, f.active ? f.powerCap : 100.0,
+        (unsigned)f.validStreak, (unsigned)f.episodes, (unsigned)f.hardPauses, degradedMs / 1000);
+    return String(json);
+}
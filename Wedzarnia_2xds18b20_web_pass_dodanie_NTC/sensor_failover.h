@@ -0,0 +1,42 @@
+// sensor_failover.h - [NEW] Praca awaryjna bez czujnika komory
+// Po SENSOR_ERROR_THRESHOLD błędnych odczytach readChamberTemperature()
+// przełączało proces na PAUSE_SENSOR – jeden luźny przewód w nocy kończył
+// 16-godzinny wsad. Teraz, jeśli model FOPDT jest ważny, proces trwa na
+// estymacie:
+//   - co 1 s krok modelu od ostatniego ważnego odczytu z mocą sprzed L
+//     (fopdt_estimate_step), RLS modelu wstrzymany
+//   - gdy mięso jest czytane i k z meat_eta.cpp ważne: Tk z mięsa
+//     = Tm + dTm/dt / k (pochodna z okien CFG_FAILOVER_MEAT_WINDOW_S),
+//     estymata dociągana ze stałą CFG_FAILOVER_MEAT_TAU_S
+//   - wyjście PID ograniczone do mocy utrzymania tSet z modelu
+//     (x CFG_FAILOVER_HOLD_MUL) – bez nagrzewania ponad setpoint,
+//     skok w górę dochodzi wolno
+//   - alarm: errorSensor, brzęczyk, log ERROR, /api/failover
+// Ważny odczyt w trakcie = nowy punkt startu estymaty; CFG_FAILOVER_RECOVER_READS
+// kolejnych kończy tryb (luźny styk nie kończy wsadu). Bez ważnego odczytu
+// albo w trybie awaryjnym łącznie dłużej niż CFG_FAILOVER_MAX_MS (z mięsem)
+// / CFG_FAILOVER_MODEL_MAX_MS (sam model) – PAUSE_SENSOR jak dawniej.
+// Limit mocy 0 = PID w MANUAL z wyjściem 0. Bez ważnego modelu, świeżego odczytu
+// lub poza RUNNING_* – od razu PAUSE_SENSOR.
+#pragma once
+#include "chamber.h"
+#include "hal.h"
+
+// Z readChamberTemperature() po SENSOR_ERROR_THRESHOLD; false = PAUSE_SENSOR
+bool sensor_failover_begin(Chamber& c, unsigned long now);
+
+// Każdy odczyt komory w trybie awaryjnym (ważny = nowa kotwica estymaty)
+void sensor_failover_read(Chamber& c, bool valid, double t, unsigned long now);
+
+// Co takt na początku chamber_run_control_logic – estymata do tChamber,
+// limit wyjścia PID, limit czasu
+void sensor_failover_update(Chamber& c, unsigned long now);
+
+// Tryb awaryjny trwa (odczyt bez locka – flaga)
+bool sensor_failover_active(const Chamber& c);
+
+// Tryb awaryjny wł./wył. (replay --no-failover = PAUSE_SENSOR jak dawniej)
+void sensor_failover_set_enabled(bool enabled);
+
+// Estymata, czas bez odczytu, limit mocy i liczniki dla /api/failover
+String sensor_failover_json(uint8_t chamberIdx);
@@ -1,28 +1,20 @@
 // sensors.cpp - [FIX] Poprawiony readTempWithTimeout, snprintf w logach
+// [NEW] Odczyt i cache per komora; przypisanie czujników z NVS/WWW dotyczy
+//       komory 0, kolejne komory mają stałe indeksy z CFG_CHAMBER_HW
 #include "sensors.h"
 #include "config.h"
 #include "state.h"
 #include "outputs.h"
-#include <nvs_flash.h>
-#include <nvs.h>
-
-struct CachedReading {
-    double value;
-    unsigned long timestamp;
-    bool valid;
-    int readAttempts;
-};
+#include "storage.h"
+#include "sensor_failover.h"
 
 static unsigned long lastTempRequest = 0;
 static unsigned long lastTempReadPossible = 0;
-static CachedReading cachedChamber = {25.0, 0, false, 0};
-static CachedReading cachedMeat = {25.0, 0, false, 0};
-static int sensorErrorCount = 0;
 
 uint8_t sensorAddresses[2][8];
 bool sensorsIdentified = false;
-int chamberSensorIndex = DEFAULT_CHAMBER_SENSOR;
-int meatSensorIndex = DEFAULT_MEAT_SENSOR;
+int& chamberSensorIndex = g_chambers[0].chamberSensor;
+int& meatSensorIndex = g_chambers[0].meatSensor;
 
 // ======================================================
 // FUNKCJE DO IDENTYFIKACJI I PRZYPISYWANIA CZUJNIKÓW
@@ -31,12 +23,12 @@ int meatSensorIndex = DEFAULT_MEAT_SENSOR;
 void identifyAndAssignSensors() {
     if (sensorsIdentified) return;
 
-    int deviceCount = sensors.getDeviceCount();
+    int deviceCount = hal_temp_count();
     LOG_FMT(LOG_LEVEL_INFO, "Identifying %d sensor(s)...", deviceCount);
 
     if (deviceCount >= 2) {
         for (int i = 0; i < deviceCount && i < 2; i++) {
-            if (sensors.getAddress(sensorAddresses[i], i)) {
+            if (hal_temp_address(i, sensorAddresses[i])) {
                 char addrStr[24];
                 snprintf(addrStr, sizeof(addrStr), "%02X%02X%02X%02X%02X%02X%02X%02X",
                         sensorAddresses[i][0], sensorAddresses[i][1],
@@ -47,31 +39,27 @@ void identifyAndAssignSensors() {
             }
         }
 
-        nvs_handle_t nvsHandle;
-        if (nvs_open("sensor_config", NVS_READONLY, &nvsHandle) == ESP_OK) {
+        hal_kv_t nvsHandle;
+        if (hal_kv_open("sensor_config", false, &nvsHandle)) {
             uint8_t savedChamberIndex, savedMeatIndex;
-            if (nvs_get_u8(nvsHandle, "chamber_idx", &savedChamberIndex) == ESP_OK &&
-                nvs_get_u8(nvsHandle, "meat_idx", &savedMeatIndex) == ESP_OK) {
+            if (hal_kv_get_u8(nvsHandle, "chamber_idx", &savedChamberIndex) &&
+                hal_kv_get_u8(nvsHandle, "meat_idx", &savedMeatIndex)) {
 
                 chamberSensorIndex = savedChamberIndex;
                 meatSensorIndex = savedMeatIndex;
                 sensorsIdentified = true;
                 log_msg(LOG_LEVEL_INFO, "Loaded sensor assignments from NVS");
-                nvs_close(nvsHandle);
+                hal_kv_close(nvsHandle);
                 return;
             }
-            nvs_close(nvsHandle);
+            hal_kv_close(nvsHandle);
         }
 
         chamberSensorIndex = DEFAULT_CHAMBER_SENSOR;
         meatSensorIndex = DEFAULT_MEAT_SENSOR;
 
-        if (nvs_open("sensor_config", NVS_READWRITE, &nvsHandle) == ESP_OK) {
-            nvs_set_u8(nvsHandle, "chamber_idx", chamberSensorIndex);
-            nvs_set_u8(nvsHandle, "meat_idx", meatSensorIndex);
-            nvs_commit(nvsHandle);
-            nvs_close(nvsHandle);
-        }
+        // [NEW] Zapis przez write-back cache NVS (storage.cpp)
+        storage_save_sensor_assignment_nvs(chamberSensorIndex, meatSensorIndex);
 
         sensorsIdentified = true;
         LOG_FMT(LOG_LEVEL_INFO, "Assigned: Sensor %d = CHAMBER", chamberSensorIndex);
@@ -93,13 +81,8 @@ void reassignSensors(int newChamberIndex, int newMeatIndex) {
     chamberSensorIndex = newChamberIndex;
     meatSensorIndex = newMeatIndex;
 
-    nvs_handle_t nvsHandle;
-    if (nvs_open("sensor_config", NVS_READWRITE, &nvsHandle) == ESP_OK) {
-        nvs_set_u8(nvsHandle, "chamber_idx", chamberSensorIndex);
-        nvs_set_u8(nvsHandle, "meat_idx", meatSensorIndex);
-        nvs_commit(nvsHandle);
-        nvs_close(nvsHandle);
-    }
+    // [NEW] Zapis przez write-back cache NVS (storage.cpp)
+    storage_save_sensor_assignment_nvs(chamberSensorIndex, meatSensorIndex);
 
     LOG_FMT(LOG_LEVEL_INFO, "Reassigned sensors: Chamber=%d, Meat=%d",
             chamberSensorIndex, meatSensorIndex);
@@ -113,8 +96,7 @@ void reassignSensors(int newChamberIndex, int newMeatIndex) {
 void requestTemperature() {
     unsigned long now = millis();
     if (now - lastTempRequest >= TEMP_REQUEST_INTERVAL) {
-        sensors.setWaitForConversion(false);
-        if (sensors.requestTemperatures()) {
+        if (hal_temp_request()) {
             lastTempRequest = now;
             lastTempReadPossible = now + TEMP_CONVERSION_TIME;
         } else {
@@ -124,7 +106,7 @@ void requestTemperature() {
 }
 
 static bool isValidTemperature(double t) {
-    return (t != DEVICE_DISCONNECTED_C &&
+    return (t != HAL_TEMP_DISCONNECTED &&
             t != 85.0 &&
             t != 127.0 &&
             t >= -20.0 &&
@@ -134,131 +116,144 @@ static bool isValidTemperature(double t) {
 // [FIX] Uproszczony readTempWithTimeout - konwersja już się zakończyła,
 // wystarczy jeden odczyt. Pętla retry tylko jeśli pierwszy odczyt to 85.0 (power-on reset)
 static double readTempWithTimeout(uint8_t sensorIndex) {
-    double temp = sensors.getTempCByIndex(sensorIndex);
+    double temp = hal_temp_read(sensorIndex);
 
     // Jeśli odczytaliśmy 85.0 (power-on reset value), spróbuj jeszcze raz po chwili
     if (temp == 85.0) {
-        delay(10);
-        temp = sensors.getTempCByIndex(sensorIndex);
+        hal_delay_ms(10);
+        temp = hal_temp_read(sensorIndex);
     }
 
     return temp;
 }
 
-void readTemperature() {
-    unsigned long now = millis();
-    if (lastTempReadPossible == 0 || now < lastTempReadPossible) return;
-    lastTempReadPossible = 0;
-
-    if (!sensorsIdentified) {
-        identifyAndAssignSensors();
-        if (!sensorsIdentified) {
-            log_msg(LOG_LEVEL_WARN, "Sensors not identified, using defaults");
-            chamberSensorIndex = DEFAULT_CHAMBER_SENSOR;
-            meatSensorIndex = DEFAULT_MEAT_SENSOR;
-        }
-    }
-
-    double tChamber = readTempWithTimeout(chamberSensorIndex);
-    double tMeat = readTempWithTimeout(meatSensorIndex);
+static void readChamberTemperature(Chamber& c, unsigned long now) {
+    double tChamber = readTempWithTimeout(c.chamberSensor);
+    double tMeat = readTempWithTimeout(c.meatSensor);
 
     bool t1Valid = isValidTemperature(tChamber);
     bool t2Valid = isValidTemperature(tMeat);
 
     // Aktualizacja cache dla czujnika komory
     if (!t1Valid) {
-        sensorErrorCount++;
-        cachedChamber.readAttempts++;
-
-        if (sensorErrorCount >= SENSOR_ERROR_THRESHOLD) {
+        c.sensorErrorCount++;
+        c.cachedChamber.readAttempts++;
+
+        // [NEW] Tryb awaryjny trwa – estymata z sensor_failover.cpp zamiast cache
+        bool degraded = sensor_failover_active(c);
+        if (degraded) {
+            sensor_failover_read(c, false, 0, now);
+        } else if (c.sensorErrorCount >= SENSOR_ERROR_THRESHOLD &&
+                   !sensor_failover_begin(c, now)) {
             if (state_lock()) {
-                g_errorSensor = true;
-                if (g_currentState == ProcessState::RUNNING_AUTO ||
-                    g_currentState == ProcessState::RUNNING_MANUAL) {
-                    g_currentState = ProcessState::PAUSE_SENSOR;
+                c.errorSensor = true;
+                if (c.currentState == ProcessState::RUNNING_AUTO ||
+                    c.currentState == ProcessState::RUNNING_MANUAL) {
+                    c.currentState = ProcessState::PAUSE_SENSOR;
                     log_msg(LOG_LEVEL_ERROR, "Sensor error - pausing process");
                 }
                 state_unlock();
             }
         }
 
-        if (cachedChamber.valid) {
+        if (c.cachedChamber.valid && !sensor_failover_active(c)) {
             if (state_lock()) {
-                g_tChamber = cachedChamber.value;
+                c.tChamber = c.cachedChamber.value;
                 state_unlock();
             }
-            LOG_FMT(LOG_LEVEL_WARN, "Using cached chamber temp: %.1f", cachedChamber.value);
+            LOG_FMT(LOG_LEVEL_WARN, "Using cached chamber temp: %.1f", c.cachedChamber.value);
         }
     } else {
-        sensorErrorCount = 0;
-        cachedChamber.value = tChamber;
-        cachedChamber.timestamp = now;
-        cachedChamber.valid = true;
-        cachedChamber.readAttempts = 0;
+        c.sensorErrorCount = 0;
+        c.cachedChamber.value = tChamber;
+        c.cachedChamber.timestamp = now;
+        c.cachedChamber.valid = true;
+        c.cachedChamber.readAttempts = 0;
 
         if (state_lock()) {
-            g_tChamber = tChamber;
-            if (g_errorSensor && g_currentState == ProcessState::PAUSE_SENSOR) {
-                g_errorSensor = false;
+            c.tChamber = tChamber;
+            c.tChamberMs = now;
+            if (c.errorSensor && c.currentState == ProcessState::PAUSE_SENSOR) {
+                c.errorSensor = false;
                 log_msg(LOG_LEVEL_INFO, "Sensor recovered");
             }
             state_unlock();
         }
+        if (sensor_failover_active(c)) sensor_failover_read(c, true, tChamber, now);
     }
 
     // Aktualizacja cache dla czujnika mięsa
     if (!t2Valid) {
-        if (cachedMeat.valid) {
+        if (c.cachedMeat.valid) {
             if (state_lock()) {
-                g_tMeat = cachedMeat.value;
+                c.tMeat = c.cachedMeat.value;
                 state_unlock();
             }
         }
     } else {
-        cachedMeat.value = tMeat;
-        cachedMeat.timestamp = now;
-        cachedMeat.valid = true;
-        cachedMeat.readAttempts = 0;
+        c.cachedMeat.value = tMeat;
+        c.cachedMeat.timestamp = now;
+        c.cachedMeat.valid = true;
+        c.cachedMeat.readAttempts = 0;
 
         if (state_lock()) {
-            g_tMeat = tMeat;
+            c.tMeat = tMeat;
             state_unlock();
         }
     }
 
     // Sprawdzenie przegrzania (BEZ auto-recovery - zgodnie z wymaganiem)
     if (state_lock()) {
-        if (g_tChamber > CFG_T_MAX_SOFT) {
-            g_errorOverheat = true;
-            g_currentState = ProcessState::PAUSE_OVERHEAT;
-            LOG_FMT(LOG_LEVEL_ERROR, "OVERHEAT detected: %.1f C", g_tChamber);
+        if (c.tChamber > CFG_T_MAX_SOFT) {
+            c.errorOverheat = true;
+            c.currentState = ProcessState::PAUSE_OVERHEAT;
+            LOG_FMT(LOG_LEVEL_ERROR, "OVERHEAT detected: %.1f C", c.tChamber);
         }
         state_unlock();
     }
 }
 
-void checkDoor() {
-    bool nowOpen = (digitalRead(PIN_DOOR) == HIGH);
+void readTemperature() {
+    unsigned long now = millis();
+    if (lastTempReadPossible == 0 || now < lastTempReadPossible) return;
+    lastTempReadPossible = 0;
+
+    if (!sensorsIdentified) {
+        identifyAndAssignSensors();
+        if (!sensorsIdentified) {
+            log_msg(LOG_LEVEL_WARN, "Sensors not identified, using defaults");
+            chamberSensorIndex = DEFAULT_CHAMBER_SENSOR;
+            meatSensorIndex = DEFAULT_MEAT_SENSOR;
+        }
+    }
+
+    for (uint8_t i = 0; i < CFG_CHAMBER_COUNT; i++) {
+        readChamberTemperature(g_chambers[i], now);
+    }
+}
+
+static void checkChamberDoor(Chamber& c) {
+    bool nowOpen = hal_gpio_read(c.hw->doorPin);
     bool shouldTurnOff = false;
     bool shouldBeep = false;
     bool shouldResume = false;
 
     if (state_lock()) {
-        bool wasOpen = g_doorOpen;
+        bool wasOpen = c.doorOpen;
         if (nowOpen && !wasOpen) {
-            g_doorOpen = true;
-            if (g_currentState == ProcessState::RUNNING_AUTO ||
-                g_currentState == ProcessState::RUNNING_MANUAL) {
-                g_currentState = ProcessState::PAUSE_DOOR;
-                g_processStats.pauseCount++;
+            c.doorOpen = true;
+            if (c.currentState == ProcessState::RUNNING_AUTO ||
+                c.currentState == ProcessState::RUNNING_MANUAL) {
+                c.currentState = ProcessState::PAUSE_DOOR;
+                c.processStats.pauseCount++;
                 shouldTurnOff = true;
                 shouldBeep = true;
                 log_msg(LOG_LEVEL_INFO, "Door opened - pausing");
             }
         } else if (!nowOpen && wasOpen) {
-            g_doorOpen = false;
-            if (g_currentState == ProcessState::PAUSE_DOOR) {
-                g_currentState = ProcessState::SOFT_RESUME;
+            c.doorOpen = false;
+            if (c.currentState == ProcessState::PAUSE_DOOR) {
+                c.currentState = ProcessState::SOFT_RESUME;
                 shouldResume = true;
                 log_msg(LOG_LEVEL_INFO, "Door closed - resuming");
             }
@@ -266,13 +261,20 @@ void checkDoor() {
         state_unlock();
     }
 
-    if (shouldTurnOff) { allOutputsOff(); }
+    if (shouldTurnOff) { chamberOutputsOff(c); }
     if (shouldBeep) { buzzerBeep(2, 100, 100); }
-    if (shouldResume) { initHeaterEnable(); }
+    if (shouldResume) { initHeaterEnable(c); }
+}
+
+void checkDoor() {
+    for (uint8_t i = 0; i < CFG_CHAMBER_COUNT; i++) {
+        checkChamberDoor(g_chambers[i]);
+    }
 }
 
 unsigned long getSensorCacheAge() {
     unsigned long now = millis();
+    const CachedReading& cachedChamber = g_chambers[0].cachedChamber;
     return cachedChamber.valid ? (now - cachedChamber.timestamp) : 0xFFFFFFFF;
 }
 
@@ -282,6 +284,9 @@ void forceSensorRead() {
 }
 
 String getSensorDiagnostics() {
+    const Chamber& c = g_chambers[0];
+    const CachedReading& cachedChamber = c.cachedChamber;
+    const CachedReading& cachedMeat = c.cachedMeat;
     char buffer[256];
     snprintf(buffer, sizeof(buffer),
         "Chamber: %.1f C (sensor: %d, age: %lus, valid: %d)\n"
@@ -290,7 +295,7 @@ String getSensorDiagnostics() {
         cachedChamber.value, chamberSensorIndex, getSensorCacheAge()/1000, cachedChamber.valid,
         cachedMeat.value, meatSensorIndex, cachedMeat.valid ? (millis() - cachedMeat.timestamp)/1000 : 0,
         cachedMeat.valid,
-        sensorErrorCount,
+        c.sensorErrorCount,
         sensorsIdentified ? "YES" : "NO");
     return String(buffer);
 }
@@ -300,13 +305,13 @@ String getSensorAssignmentInfo() {
     char buffer[128];
     snprintf(buffer, sizeof(buffer),
         "Sensor Assignments:\n  Chamber: Sensor %d\n  Meat: Sensor %d\n  Total sensors: %d\n  Identified: %s",
-        chamberSensorIndex, meatSensorIndex, sensors.getDeviceCount(),
+        chamberSensorIndex, meatSensorIndex, hal_temp_count(),
         sensorsIdentified ? "YES" : "NO");
     return String(buffer);
 }
 
 bool autoDetectAndAssignSensors() {
-    int deviceCount = sensors.getDeviceCount();
+    int deviceCount = hal_temp_count();
     if (deviceCount < 2) {
         log_msg(LOG_LEVEL_ERROR, "Need at least 2 sensors for auto-detection");
         return false;
@@ -331,7 +336,7 @@ int getMeatSensorIndex() {
 }
 
 int getTotalSensorCount() {
-    return sensors.getDeviceCount();
+    return hal_temp_count();
 }
 
 bool areSensorsIdentified() {
@@ -1,6 +1,6 @@
 // sensors.h - Zmodernizowana wersja z funkcjami przypisywania
 #pragma once
-#include <Arduino.h>
+#include "hal.h"
 
 // Podstawowe funkcje
 void requestTemperature();
@@ -26,6 +26,6 @@ bool areSensorsIdentified();
 
 // Funkcje do zmiennych globalnych (jeśli potrzebne bezpośrednio)
 extern uint8_t sensorAddresses[2][8];
-extern int chamberSensorIndex;     // Dodajemy extern
-extern int meatSensorIndex;        // Dodajemy extern
+extern int& chamberSensorIndex;    // alias g_chambers[0].chamberSensor
+extern int& meatSensorIndex;       // alias g_chambers[0].meatSensor
 extern bool sensorsIdentified;     // Dodajemy extern
\ No newline at end of file
@@ -0,0 +1,333 @@
+// soak.cpp - [NEW] Przyspieszony test długiego wsadu (72 h)
+// Ruch: te same funkcje, które wołają handlery WWW i UI, w okresach jak przy
+// otwartej stronie statusu (odpytywanie co 2 s, lista profili co minutę...).
+// Co symulowaną godzinę: żywe/szczytowe bajty, alokacje, wolna sterta,
+// największy wolny blok i fragmentacja – trend pokazuje wyciek albo
+// rozdrobnienie sterty zanim po ~3 dniach zabraknie bloku na bufor JSON.
+//
+// Host (CMakeLists.txt, cel soak – z alloc_track.cpp i -rdynamic dla nazw
+// funkcji w miejscach alokacji):
+//   ./soak [--hours 72] [--top 10] [--leak-bytes 2048]
+// Sterowanie chodzi na zegarze wirtualnym (takt 100 ms) z prostym modelem
+// cieplnym komory i mięsa; profil startuje od nowa po zakończeniu.
+// Kod wyjścia 1, gdy żywe bajty na końcu przekraczają stan po 1. godzinie
+// o więcej niż --leak-bytes. Sterta glibc nie ma "największego bloku" –
+// kolumna largest to szczyt areny (przybliżenie, patrz alloc_track.cpp).
+//
+// ESP32 (CFG_SOAK_MODE): task Soak generuje ruch CFG_SOAK_SPEEDUP razy
+// szybciej niż przeglądarka, sterowanie chodzi normalnie w czasie rzeczywistym.
+#include "soak.h"
+#include "config.h"
+#include "state.h"
+#include "process.h"
+#include "sensors.h"
+#include "storage.h"
+#include "web_server.h"
+#ifdef ARDUINO
+#include "ui.h"
+#else
+#include "outputs.h"
+#include "ssr_tp.h"
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static constexpr uint32_t SOAK_HOUR_MS = 3600000UL;
+static constexpr const char* SOAK_PROFILE_NAME = "soak.prof";
+
+static volatile uint32_t soakSink = 0;
+
+// ======================================================
+// RUCH WWW / UI
+// ======================================================
+
+struct SoakRequest {
+    const char* name;
+    uint32_t periodMs;         // okres w czasie symulowanym
+    void (*fn)();
+};
+
+static void soakSensorDiagnostics() { soakSink += getSensorDiagnostics().length(); }
+static void soakPidParameters()     { soakSink += getPidParameters().length(); }
+static void soakListProfiles()      { soakSink += storage_list_profiles_json().length(); }
+static void soakListBackups()       { soakSink += storage_list_backups_json().length(); }
+static void soakProfileJson()       { soakSink += storage_get_profile_as_json(SOAK_PROFILE_NAME).length(); }
+// Zmiana nastaw z UI/WWW – zapis przez write-back cache NVS
+static void soakSaveSettings()      { storage_save_manual_settings_nvs(); }
+// getStatusJSON/getSysInfoJSON piszą do bufora statycznego – równoległe
+// żądanie WWW w trybie soak może dostać wymieszaną odpowiedź (tylko test)
+static void soakStatusJson()        { soakSink += strlen(getStatusJSON()); }
+#ifdef ARDUINO
+static void soakSysInfoJson()       { soakSink += strlen(getSysInfoJSON()); }
+static void soakRedraw()            { ui_force_redraw(); }
+#endif
+
+static const SoakRequest soakRequests[] = {
+    {"status_json",       2000,   soakStatusJson},
+#ifdef ARDUINO
+    {"sysinfo_json",      10000,  soakSysInfoJson},
+    {"ui_redraw",         1000,   soakRedraw},
+#endif
+    {"sensor_diag",       5000,   soakSensorDiagnostics},
+    {"pid_params",        5000,   soakPidParameters},
+    {"profile_json",      10000,  soakProfileJson},
+    {"save_settings",     30000,  soakSaveSettings},
+    {"list_profiles",     60000,  soakListProfiles},
+    {"list_backups",      300000, soakListBackups}
+};
+static constexpr int SOAK_REQUEST_COUNT = sizeof(soakRequests) / sizeof(soakRequests[0]);
+
+static uint32_t soakLastRun[SOAK_REQUEST_COUNT];
+static uint32_t soakRequestCount = 0;
+
+// Wszystkie żądania, których okres minął do simMs (przy przyspieszeniu
+// kilka wywołań jednego żądania na takt)
+static void soakTraffic(uint32_t simMs) {
+    for (int i = 0; i < SOAK_REQUEST_COUNT; i++) {
+        while (simMs - soakLastRun[i] >= soakRequests[i].periodMs) {
+            soakRequests[i].fn();
+            soakLastRun[i] += soakRequests[i].periodMs;
+            soakRequestCount++;
+        }
+    }
+}
+
+static void soakHourReport(uint32_t hour, SoakHourReport& report) {
+    report.hour = hour;
+    report.requests = soakRequestCount;
+    alloc_track_snapshot(report.heap);
+}
+
+#ifdef ARDUINO
+// ======================================================
+// ESP32 – task Soak
+// ======================================================
+
+static constexpr uint32_t SOAK_TICK_MS = 100;
+static constexpr int SOAK_TOP_SITES = 5;
+
+static void logTopSites() {
+    AllocSite top[SOAK_TOP_SITES];
+    int n = alloc_track_top_sites(top, SOAK_TOP_SITES);
+    char name[24];
+    for (int i = 0; i < n; i++) {
+        alloc_track_site_name(top[i].pc, name, sizeof(name));
+        LOG_FMT(LOG_LEVEL_INFO, "[SOAK]   %s live %u B in %lu blocks",
+                name, (unsigned)top[i].liveBytes, (unsigned long)top[i].liveCount);
+    }
+}
+
+static void taskSoak(void* /*pv*/) {
+    LOG_FMT(LOG_LEVEL_WARN, "[SOAK] Start: %u h simulated, x%u traffic",
+            (unsigned)CFG_SOAK_HOURS, (unsigned)CFG_SOAK_SPEEDUP);
+    alloc_track_start();
+
+    uint32_t simMs = 0;
+    uint32_t hour = 0;
+    SoakHourReport first = {};
+    for (;;) {
+        simMs += SOAK_TICK_MS * CFG_SOAK_SPEEDUP;
+        soakTraffic(simMs);
+
+        if (simMs >= (hour + 1) * SOAK_HOUR_MS) {
+            hour++;
+            SoakHourReport r;
+            soakHourReport(hour, r);
+            if (hour == 1) first = r;
+            LOG_FMT(LOG_LEVEL_INFO,
+                    "[SOAK] h%lu: free %u, largest %u, frag %u%%, min %u, live %u (%+ld)",
+                    (unsigned long)hour, (unsigned)r.heap.freeBytes,
+                    (unsigned)r.heap.largestFreeBlock,
+                    alloc_track_fragmentation_pct(r.heap),
+                    (unsigned)r.heap.minFreeBytes, (unsigned)r.heap.liveBytes,
+                    (long)r.heap.liveBytes - (long)first.heap.liveBytes);
+            if (hour >= CFG_SOAK_HOURS) {
+                logTopSites();
+                LOG_FMT(LOG_LEVEL_WARN, "[SOAK] Done: %lu requests, largest block %u -> %u B",
+                        (unsigned long)r.requests, (unsigned)first.heap.largestFreeBlock,
+                        (unsigned)r.heap.largestFreeBlock);
+                alloc_track_stop();
+                vTaskDelete(NULL);
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(SOAK_TICK_MS));
+    }
+}
+
+void soak_start() {
+    // Core 0, najniższy priorytet – nie zabiera czasu Control/Sensors
+    hal_task_create(taskSoak, "Soak", 6144, NULL, 1, 0);
+}
+
+#else
+// ======================================================
+// HOST – 72 h na zegarze wirtualnym
+// ======================================================
+
+static constexpr uint32_t SOAK_TICK_MS = 100;    // okres taskControl/taskSensors
+static constexpr double SOAK_AMBIENT = 15.0;
+
+static const char* const SOAK_PROFILE_LINES[] = {
+    "# soak – cykl ~9 h, powtarzany do końca testu\n",
+    "Suszenie;60;0;120;2;0;1;10;30;0\n",
+    "Wedzenie;70;0;300;3;120;2;10;30;0\n",
+    "Parzenie;80;68;60;3;0;1;10;30;1\n"
+};
+
+// Model cieplny: komora dąży do ambient + 110 °C * moc grzałek (stała 10 min),
+// mięso do temperatury komory (stała 90 min)
+struct SoakThermal {
+    double chamber;
+    double meat;
+};
+
+static void soakThermalStep(SoakThermal& th, double dtSec) {
+    double heat = (ssr_tp_duty(PIN_SSR1) + ssr_tp_duty(PIN_SSR2) +
+                   ssr_tp_duty(PIN_SSR3)) / (3.0 * 255.0);
+    double target = SOAK_AMBIENT + 110.0 * heat;
+    th.chamber += (target - th.chamber) * dtSec / 600.0;
+    th.meat    += (th.chamber - th.meat) * dtSec / 5400.0;
+    hal_posix_set_temp(getChamberSensorIndex(), th.chamber);
+    hal_posix_set_temp(getMeatSensorIndex(), th.meat);
+}
+
+static bool writeSoakProfile(const char* sdRoot) {
+    std::string dir = std::string(sdRoot) + "/profiles";
+    mkdir(dir.c_str(), 0755);
+    FILE* f = fopen((dir + "/" + SOAK_PROFILE_NAME).c_str(), "w");
+    if (!f) return false;
+    for (const char* line : SOAK_PROFILE_LINES) fputs(line, f);
+    fclose(f);
+    return true;
+}
+
+static void removeSoakDir(const char* sdRoot) {
+    std::string dir = std::string(sdRoot) + "/profiles";
+    remove((dir + "/" + SOAK_PROFILE_NAME).c_str());
+    rmdir(dir.c_str());
+    rmdir(sdRoot);
+}
+
+static void startSoakProfile() {
+    if (storage_load_profile()) process_start_auto();
+}
+
+static void printTopSites(int count) {
+    AllocSite top[32];
+    if (count > 32) count = 32;
+    int n = alloc_track_top_sites(top, count);
+    printf("\n%-56s %10s %8s %10s %10s\n", "site", "live B", "blocks", "peak B", "allocs");
+    char name[128];
+    for (int i = 0; i < n; i++) {
+        alloc_track_site_name(top[i].pc, name, sizeof(name));
+        printf("%-56.56s %10zu %8lu %10zu %10lu\n", name, top[i].liveBytes,
+               (unsigned long)top[i].liveCount, top[i].peakLiveBytes,
+               (unsigned long)top[i].allocCount);
+    }
+}
+
+int main(int argc, char** argv) {
+    uint32_t hours = 72;
+    int topCount = 10;
+    long leakBytes = 2048;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--hours") == 0 && i + 1 < argc)           hours = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc)        topCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--leak-bytes") == 0 && i + 1 < argc) leakBytes = atol(argv[++i]);
+        else {
+            fprintf(stderr, "usage: soak [--hours 72] [--top 10] [--leak-bytes 2048]\n");
+            return 2;
+        }
+    }
+    if (hours == 0 || hours > 1000) {
+        fprintf(stderr, "--hours: 1..1000\n");
+        return 2;
+    }
+
+    char sdDir[] = "/tmp/wedzarnia_soak_XXXXXX";
+    if (!mkdtemp(sdDir) || !writeSoakProfile(sdDir)) {
+        fprintf(stderr, "Cannot create SD dir\n");
+        return 2;
+    }
+    hal_posix_set_fs_root(sdDir);
+    hal_posix_set_time_ms(0);
+    hal_posix_kv_clear();
+    init_state();
+    storage_load_config_nvs();
+    char profilePath[64];
+    snprintf(profilePath, sizeof(profilePath), "/profiles/%s", SOAK_PROFILE_NAME);
+    storage_save_profile_path_nvs(profilePath);
+
+    SoakThermal th = {SOAK_AMBIENT, SOAK_AMBIENT};
+    soakThermalStep(th, 0);
+    requestTemperature();
+    readTemperature();
+    startSoakProfile();
+
+    if (!alloc_track_start()) {
+        fprintf(stderr, "alloc_track_start failed\n");
+        return 2;
+    }
+
+    printf("%5s %9s %10s %10s %8s %10s %10s %10s %5s\n", "hour", "requests", "live B",
+           "peak B", "blocks", "allocs/h", "free B", "largest B", "frag");
+    SoakHourReport first = {};
+    SoakHourReport prev = {};
+    SoakHourReport last = {};
+    uint32_t cycles = 1;
+    uint32_t endMs = hours * SOAK_HOUR_MS;
+
+    for (uint32_t now = SOAK_TICK_MS; now <= endMs; now += SOAK_TICK_MS) {
+        uint32_t clock = hal_millis();
+        if (now > clock) hal_posix_advance_ms(now - clock);
+
+        // Kolejność jak w taskSensors → taskControl; Monitor co 1 s (NVS)
+        soakThermalStep(th, SOAK_TICK_MS / 1000.0);
+        requestTemperature();
+        readTemperature();
+        process_run_control_logic();
+        handleBuzzer();
+        if (now % 1000 == 0) storage_nvs_service(0);
+        soakTraffic(now);
+
+        // Koniec profilu = PAUSE_USER; operator zatrzymuje i startuje od nowa
+        if (g_currentState == ProcessState::PAUSE_USER) {
+            if (state_lock()) { g_currentState = ProcessState::IDLE; state_unlock(); }
+            startSoakProfile();
+            cycles++;
+        }
+
+        if (now % SOAK_HOUR_MS == 0) {
+            soakHourReport(now / SOAK_HOUR_MS, last);
+            if (last.hour == 1) first = last;
+            printf("%5lu %9lu %10zu %10zu %8lu %10lu %10zu %10zu %4u%%\n",
+                   (unsigned long)last.hour, (unsigned long)last.requests,
+                   last.heap.liveBytes, last.heap.peakLiveBytes,
+                   (unsigned long)last.heap.liveCount,
+                   (unsigned long)(last.heap.allocCount - prev.heap.allocCount),
+                   last.heap.freeBytes, last.heap.largestFreeBlock,
+                   alloc_track_fragmentation_pct(last.heap));
+            fflush(stdout);
+            prev = last;
+        }
+    }
+    alloc_track_stop();
+
+    printTopSites(topCount);
+    allOutputsOff();
+    removeSoakDir(sdDir);
+
+    long growth = (long)last.heap.liveBytes - (long)first.heap.liveBytes;
+    printf("\n%lu h, %lu profile cycles, %lu requests, live bytes h1 -> h%lu: %+ld B\n",
+           (unsigned long)hours, (unsigned long)cycles, (unsigned long)last.requests,
+           (unsigned long)last.hour, growth);
+    if (growth > leakBytes) {
+        printf("LEAK? live bytes grew more than %ld B\n", leakBytes);
+        return 1;
+    }
+    return 0;
+}
+
+#endif // ARDUINO
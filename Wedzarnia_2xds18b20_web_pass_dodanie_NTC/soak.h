@@ -0,0 +1,20 @@
+// soak.h - [NEW] Przyspieszony test długiego wsadu (wycieki, fragmentacja sterty)
+// Ruch WWW/UI jak przy otwartej stronie statusu, symulowany CFG_SOAK_SPEEDUP
+// razy szybciej; co symulowaną godzinę raport sterty z alloc_track.
+// Host: osobny program soak.cpp (jak replay.cpp) – pełne 72 h na zegarze
+// wirtualnym z modelem cieplnym komory i miejscami alokacji.
+// ESP32: CFG_SOAK_MODE – task Soak obok normalnych tasków (raport w logu).
+#pragma once
+#include "hal.h"
+#include "alloc_track.h"
+
+struct SoakHourReport {
+    uint32_t hour;             // godzina symulowana
+    uint32_t requests;         // żądania od startu
+    HeapSnapshot heap;
+};
+
+#ifdef ARDUINO
+// Tworzy task Soak (wołane z tasks_create_all, gdy CFG_SOAK_MODE)
+void soak_start();
+#endif
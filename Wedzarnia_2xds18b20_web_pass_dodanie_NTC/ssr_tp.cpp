@@ -0,0 +1,214 @@
+// ssr_tp.cpp - [NEW] Silnik proporcjonowania czasu SSR (opis w ssr_tp.h)
+#include "ssr_tp.h"
+
+struct SsrChannel {
+    uint8_t target;        // zadane wypełnienie 0..255
+    uint16_t onTicks;      // półokresy ON w bieżącym oknie
+    uint16_t start;        // początek okresu ON w oknie (przeplot)
+    uint8_t carryIn;       // reszta z poprzedniego okna
+    uint8_t carry;         // reszta bieżącego okna → następne okno
+    bool level;
+    uint64_t onTotal;      // półokresy ON od startu
+    uint64_t denied;       // półokresy odcięte limitem prądu
+};
+
+// Grzałek naraz przy limicie zasilania – wszystkie kanały płytki razem
+// (static_assert w config.h: co najmniej jedna)
+static constexpr int SSR_MAX_ON = CFG_SSR_SUPPLY_AMPS > 0
+    ? (int)(CFG_SSR_SUPPLY_AMPS / CFG_SSR_HEATER_AMPS) : SSR_CHANNELS;
+
+static SsrChannel channels[SSR_CHANNELS];
+static uint16_t phase = 0;
+static bool running = false;
+static bool stagger = CFG_SSR_STAGGER;
+static int maxOn = SSR_MAX_ON;                   // ssr_tp_set_max_on (testy hosta)
+static uint64_t loadTicks[SSR_CHANNELS + 1];   // takty z n grzałkami ON
+static uint8_t peakOn = 0;
+static uint8_t peakSwitchOn = 0;                 // załączeń w jednym półokresie (udar)
+static portMUX_TYPE ssrMux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline uint8_t channelPin(int idx) {
+    return CFG_CHAMBER_HW[idx / 3].ssrPins[idx % 3];
+}
+
+static int channelIndex(uint8_t pin) {
+    for (int i = 0; i < SSR_CHANNELS; i++) {
+        if (channelPin(i) == pin) return i;
+    }
+    return -1;
+}
+
+// Półokresy ON w bieżącym oknie; wołać w sekcji krytycznej
+static inline void IRAM_ATTR computeOnTicks(SsrChannel& ch) {
+    uint32_t acc = (uint32_t)ch.target * CFG_SSR_WINDOW_TICKS + ch.carryIn;
+    ch.onTicks = acc / 255;
+    ch.carry = acc % 255;
+}
+
+// Początek okna: półokresy ON i przeplot – okres ON kanału zaczyna się tam,
+// gdzie skończył się poprzedni (z zawinięciem). Naraz pracuje wtedy
+// ceil(suma ON / okno) grzałek – minimum możliwe przy tym wypełnieniu.
+static void IRAM_ATTR startWindow() {
+    uint32_t offset = 0;
+    for (int i = 0; i < SSR_CHANNELS; i++) {
+        SsrChannel& ch = channels[i];
+        ch.carryIn = ch.carry;
+        computeOnTicks(ch);
+        ch.start = stagger ? (uint16_t)offset : 0;
+        offset = (offset + ch.onTicks) % CFG_SSR_WINDOW_TICKS;
+    }
+}
+
+// ISR co półokres: na początku okna przeliczenie ON, potem stan pinów.
+// Z przeplotem najwyżej jedno załączenie na półokres (udar, migotanie).
+// Limit prądu twardy: zmiana wypełnienia w środku okna może nałożyć okresy
+// ON – nadmiarowy kanał czeka (półokres przepada, licznik denied).
+static void IRAM_ATTR ssrTick() {
+    portENTER_CRITICAL_ISR(&ssrMux);
+    if (phase == 0) startWindow();
+    uint8_t onCount = 0;
+    uint8_t switchOn = 0;
+    for (int i = 0; i < SSR_CHANNELS; i++) {
+        SsrChannel& ch = channels[i];
+        uint32_t rel = (phase + CFG_SSR_WINDOW_TICKS - ch.start) % CFG_SSR_WINDOW_TICKS;
+        bool on = ch.target > 0 && rel < ch.onTicks;
+        if (on && onCount >= maxOn) {
+            on = false;
+            ch.denied++;
+        } else if (on && !ch.level && stagger && switchOn > 0) {
+            // Start z 0 w środku okna trafia na wspólny offset – drugi
+            // kanał załącza półokres później (przesunięty cały okres ON)
+            on = false;
+            ch.start = (ch.start + 1) % CFG_SSR_WINDOW_TICKS;
+        }
+        if (on != ch.level) {
+            hal_gpio_write_isr(channelPin(i), on);
+            ch.level = on;
+            if (on) switchOn++;
+        }
+        if (on) {
+            ch.onTotal++;
+            onCount++;
+        }
+    }
+    loadTicks[onCount]++;
+    if (onCount > peakOn) peakOn = onCount;
+    if (switchOn > peakSwitchOn) peakSwitchOn = switchOn;
+    if (++phase >= CFG_SSR_WINDOW_TICKS) phase = 0;
+    portEXIT_CRITICAL_ISR(&ssrMux);
+}
+
+bool ssr_tp_init() {
+    if (running) return true;
+    running = hal_timer_start(CFG_SSR_TICK_US, ssrTick);
+    if (running) {
+        LOG_FMT(LOG_LEVEL_INFO, "SSR: %u channels, window %lu ms / %lu half-cycles, max %d on",
+                (unsigned)SSR_CHANNELS, (unsigned long)CFG_SSR_WINDOW_MS,
+                (unsigned long)CFG_SSR_WINDOW_TICKS, maxOn);
+    } else {
+        log_msg(LOG_LEVEL_ERROR, "SSR: timer start failed");
+    }
+    return running;
+}
+
+void ssr_tp_write(uint8_t pin, uint32_t duty) {
+    int idx = channelIndex(pin);
+    if (idx < 0) return;
+    if (duty > 255) duty = 255;
+    portENTER_CRITICAL(&ssrMux);
+    SsrChannel& ch = channels[idx];
+    ch.target = (uint8_t)duty;
+    if (duty > 0) {
+        // Zmiana w środku okna działa od razu: skrócenie wyłącza w najbliższym
+        // półokresie, wydłużenie trzyma ON dłużej – średnia bez opóźnienia okna
+        computeOnTicks(ch);
+    } else {
+        // Bez czekania na koniec okna; reszta bez znaczenia po wyłączeniu
+        ch.onTicks = 0;
+        ch.carryIn = ch.carry = 0;
+        if (ch.level) {
+            hal_gpio_write_isr(pin, false);
+            ch.level = false;
+        }
+    }
+    portEXIT_CRITICAL(&ssrMux);
+}
+
+uint32_t ssr_tp_duty(uint8_t pin) {
+    int idx = channelIndex(pin);
+    return idx < 0 ? 0 : channels[idx].target;
+}
+
+uint64_t ssr_tp_on_ms(uint8_t pin) {
+    int idx = channelIndex(pin);
+    if (idx < 0) return 0;
+    portENTER_CRITICAL(&ssrMux);
+    uint64_t ticks = channels[idx].onTotal;
+    portEXIT_CRITICAL(&ssrMux);
+    return ticks * CFG_SSR_TICK_US / 1000;
+}
+
+void ssr_tp_set_stagger(bool enabled) {
+    portENTER_CRITICAL(&ssrMux);
+    stagger = enabled;
+    portEXIT_CRITICAL(&ssrMux);
+}
+
+void ssr_tp_set_max_on(uint8_t n) {
+    portENTER_CRITICAL(&ssrMux);
+    maxOn = n > 0 ? n : 1;
+    portEXIT_CRITICAL(&ssrMux);
+}
+
+void ssr_tp_load(SsrLoad& out) {
+    uint64_t hist[SSR_CHANNELS + 1];
+    out = SsrLoad();
+    portENTER_CRITICAL(&ssrMux);
+    memcpy(hist, loadTicks, sizeof(hist));
+    out.limit = maxOn;
+    out.peak = peakOn;
+    out.peakSwitchOn = peakSwitchOn;
+    for (int i = 0; i < SSR_CHANNELS; i++) out.denied += channels[i].denied;
+    portEXIT_CRITICAL(&ssrMux);
+
+    uint64_t ticks = 0;
+    double sum = 0;
+    for (int n = 0; n <= SSR_CHANNELS; n++) {
+        ticks += hist[n];
+        sum += (double)n * hist[n];
+    }
+    if (ticks == 0) return;
+    out.average = sum / ticks;
+    for (int n = 0; n <= SSR_CHANNELS; n++) out.share[n] = (double)hist[n] / ticks;
+}
+
+String ssr_tp_json() {
+    SsrChannel snap[SSR_CHANNELS];
+    portENTER_CRITICAL(&ssrMux);
+    memcpy(snap, channels, sizeof(snap));
+    portEXIT_CRITICAL(&ssrMux);
+    SsrLoad load;
+    ssr_tp_load(load);
+
+    char json[256 + SSR_CHANNELS * 128];
+    int offset = snprintf(json, sizeof(json),
+        "{\"running\":%s,\"mainsHz\":%lu,\"windowMs\":%lu,\"windowTicks\":%lu,"
+        "\"stagger\":%s,\"maxOn\":%u,\"peakOn\":%u,\"avgOn\":%.2f,"
+        "\"peakSwitchOn\":%u,\"peakAmps\":%.1f,\"avgAmps\":%.2f,\"channels\":[",
+        running ? "true" : "false", (unsigned long)CFG_SSR_MAINS_HZ,
+        (unsigned long)CFG_SSR_WINDOW_MS, (unsigned long)CFG_SSR_WINDOW_TICKS,
+        stagger ? "true" : "false", (unsigned)load.limit, (unsigned)load.peak, load.average,
+        (unsigned)load.peakSwitchOn,
+        load.peak * CFG_SSR_HEATER_AMPS, load.average * CFG_SSR_HEATER_AMPS);
+    for (int i = 0; i < SSR_CHANNELS; i++) {
+        offset += snprintf(json + offset, sizeof(json) - offset,
+            "%s{\"chamber\":%d,\"heater\":%d,\"pin\":%u,\"duty\":%u,\"onTicks\":%u,"
+            "\"start\":%u,\"onSec\":%llu,\"deniedSec\":%llu}",
+            i ? "," : "", i / 3, i % 3 + 1, (unsigned)channelPin(i), (unsigned)snap[i].target,
+            (unsigned)snap[i].onTicks, (unsigned)snap[i].start,
+            (unsigned long long)(snap[i].onTotal * CFG_SSR_TICK_US / 1000000ULL),
+            (unsigned long long)(snap[i].denied * CFG_SSR_TICK_US / 1000000ULL));
+    }
+    snprintf(json + offset, sizeof(json) - offset, "]}");
+    return String(json);
+}
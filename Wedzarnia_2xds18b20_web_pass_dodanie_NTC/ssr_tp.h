@@ -0,0 +1,53 @@
+// ssr_tp.h - [NEW] Grzałki: proporcjonowanie czasu zamiast PWM 5 kHz
+// SSR z przejściem przez zero nie nadąża za LEDC 5 kHz – moc wychodziła
+// nieliniowa. Tu wyjście grzałki to okno CFG_SSR_WINDOW_MS podzielone na
+// półokresy sieci (CFG_SSR_WINDOW_TICKS): na początku okna liczba
+// półokresów ON = wypełnienie x okno, z przeniesieniem reszty do
+// następnego okna – średnia długoterminowa dokładna co do 1/255.
+// Takt z timera sprzętowego (hal_timer_start, ISR co półokres); timer nie
+// jest zsynchronizowany z siecią – SSR i tak załącza w najbliższym zerze.
+//
+// Kanały = wszystkie ssrPins z CFG_CHAMBER_HW. Wypełnienie 0 wyłącza pin
+// od razu (drzwi, awaria), nie czekając na koniec okna.
+//
+// [NEW] Przeplot (CFG_SSR_STAGGER): okresy ON kanałów ułożone w oknie jeden
+// za drugim zamiast wspólnego startu – 2 grzałki po 50% to jedna naraz,
+// nie dwie przez pół okna. Limit CFG_SSR_SUPPLY_AMPS nigdy nie jest
+// przekroczony (kanał ponad limit czeka). Statystyka obciążenia w ssr_tp_load.
+#pragma once
+#include "config.h"
+
+constexpr int SSR_CHANNELS = CFG_CHAMBER_COUNT * 3;
+
+// Obciążenie od startu (liczby grzałek ON w półokresach)
+struct SsrLoad {
+    uint8_t limit = 0;                    // grzałek naraz przy limicie prądu
+    uint8_t peak = 0;
+    uint8_t peakSwitchOn = 0;             // najwięcej załączeń w jednym półokresie
+    double average = 0;
+    double share[SSR_CHANNELS + 1] = {0}; // udział czasu z n grzałkami ON
+    uint64_t denied = 0;                  // półokresy odcięte limitem
+};
+
+// Start taktu (hardware_init_ledc); piny już jako OUTPUT
+bool ssr_tp_init();
+
+// Wypełnienie 0..255 grzałki na pinie (zamiast hal_pwm_write); > 255 = 255
+void ssr_tp_write(uint8_t pin, uint32_t duty);
+
+// Zadane wypełnienie 0..255
+uint32_t ssr_tp_duty(uint8_t pin);
+
+// Łączny czas ON pinu od startu (ms, z liczby półokresów)
+uint64_t ssr_tp_on_ms(uint8_t pin);
+
+// Przeplot wł./wył. w czasie pracy (replay --no-stagger)
+void ssr_tp_set_stagger(bool enabled);
+
+// Grzałek naraz zamiast limitu z CFG_SSR_SUPPLY_AMPS (testy hosta), min. 1
+void ssr_tp_set_max_on(uint8_t n);
+
+void ssr_tp_load(SsrLoad& out);
+
+// GET /api/ssr – okno, obciążenie i kanały z czasem ON
+String ssr_tp_json();
@@ -1,49 +1,91 @@
 // state.cpp - Zoptymalizowana wersja z timeoutami i statystykami
 #include "state.h"
+#include "gain_sched.h"
 
 // Definicje obiektów globalnych
+#ifdef ARDUINO
 Adafruit_ST7735 display(TFT_CS, TFT_DC, TFT_RST);
 WebServer server(80);
 OneWire oneWire(PIN_ONEWIRE);
 DallasTemperature sensors(&oneWire);
+#endif
 
-double pidInput, pidSetpoint;
-double pidOutput = 0;
-PID pid(&pidInput, &pidOutput, &pidSetpoint, CFG_Kp, CFG_Ki, CFG_Kd, DIRECT);
-
-SemaphoreHandle_t stateMutex = NULL;
-SemaphoreHandle_t outputMutex = NULL;
-SemaphoreHandle_t heaterMutex = NULL;
-
-// Definicje zmiennych stanu
-volatile ProcessState g_currentState = ProcessState::IDLE;
-RunMode g_lastRunMode = RunMode::MODE_AUTO;
-volatile double g_tSet = 70.0;
-volatile double g_tChamber = 25.0;
-volatile double g_tMeat = 25.0;
-volatile int g_powerMode = 1;
-volatile int g_manualSmokePwm = 0;
-volatile int g_fanMode = 1;
-volatile unsigned long g_fanOnTime = CFG_FAN_ON_DEFAULT_MS;
-volatile unsigned long g_fanOffTime = CFG_FAN_OFF_DEFAULT_MS;
-volatile bool g_doorOpen = false;
-volatile bool g_errorSensor = false;
-volatile bool g_errorOverheat = false;
-volatile bool g_errorProfile = false;
-
-Step g_profile[MAX_STEPS];
-int g_stepCount = 0;
-int g_currentStep = 0;
-unsigned long g_processStartTime = 0;
-unsigned long g_stepStartTime = 0;
+hal_mutex_t stateMutex = NULL;
+hal_mutex_t outputMutex = NULL;
+hal_mutex_t heaterMutex = NULL;
+
+// [NEW] Komory – każda z własnym PID, profilem, statystykami i mapą grzałek
+Chamber g_chambers[CFG_CHAMBER_COUNT];
+
+Chamber::Chamber()
+    : pid(&pidInput, &pidOutput, &pidSetpoint, CFG_Kp, CFG_Ki, CFG_Kd, PidController::DIRECT) {}
+
+Chamber& chamber_get(uint8_t idx) {
+    return g_chambers[idx < CFG_CHAMBER_COUNT ? idx : 0];
+}
+
+bool chamber_all_idle() {
+    for (uint8_t i = 0; i < CFG_CHAMBER_COUNT; i++) {
+        if (g_chambers[i].currentState != ProcessState::IDLE) return false;
+    }
+    return true;
+}
+
+void chamber_init(Chamber& c, uint8_t id, const ChamberHw* hw) {
+    c.id = id;
+    c.hw = hw;
+    if (hw->chamberSensor >= 0) c.chamberSensor = hw->chamberSensor;
+    if (hw->meatSensor >= 0)    c.meatSensor    = hw->meatSensor;
+
+    c.pid.SetMode(PidController::AUTOMATIC);
+    c.pid.SetOutputLimits(0, 100);
+    c.pid.SetTunings(CFG_Kp, CFG_Ki, CFG_Kd);
+    c.pid.SetSampleTime(1000);
+    gain_table_defaults(c.gains);   // [NEW] NVS nadpisze w storage_load_config_nvs()
+
+    c.processStats.lastUpdate = millis();
+}
+
+void chamber_init_all() {
+    for (uint8_t i = 0; i < CFG_CHAMBER_COUNT; i++) {
+        chamber_init(g_chambers[i], i, &CFG_CHAMBER_HW[i]);
+    }
+}
+
+// Aliasy komory 0 (state.h)
+PidController& pid = g_chambers[0].pid;
+double& pidInput    = g_chambers[0].pidInput;
+double& pidSetpoint = g_chambers[0].pidSetpoint;
+double& pidOutput   = g_chambers[0].pidOutput;
+
+volatile ProcessState& g_currentState = g_chambers[0].currentState;
+RunMode& g_lastRunMode = g_chambers[0].lastRunMode;
+volatile double& g_tSet = g_chambers[0].tSet;
+volatile double& g_tChamber = g_chambers[0].tChamber;
+volatile double& g_tMeat = g_chambers[0].tMeat;
+volatile int& g_powerMode = g_chambers[0].powerMode;
+volatile int& g_manualSmokePwm = g_chambers[0].manualSmokePwm;
+volatile int& g_fanMode = g_chambers[0].fanMode;
+volatile unsigned long& g_fanOnTime = g_chambers[0].fanOnTime;
+volatile unsigned long& g_fanOffTime = g_chambers[0].fanOffTime;
+volatile bool& g_doorOpen = g_chambers[0].doorOpen;
+volatile bool& g_errorSensor = g_chambers[0].errorSensor;
+volatile bool& g_errorOverheat = g_chambers[0].errorOverheat;
+volatile bool& g_errorProfile = g_chambers[0].errorProfile;
+
+Step (&g_profile)[MAX_STEPS] = g_chambers[0].profile;
+int& g_stepCount = g_chambers[0].stepCount;
+int& g_currentStep = g_chambers[0].currentStep;
+unsigned long& g_processStartTime = g_chambers[0].processStartTime;
+unsigned long& g_stepStartTime = g_chambers[0].stepStartTime;
 
 // Statystyki procesu
-ProcessStats g_processStats = {0, 0, 0, 0, 0.0, 0, 0, 0};
+ProcessStats& g_processStats = g_chambers[0].processStats;
 
 // Funkcje blokowania z timeoutami
 bool state_lock(TickType_t timeout_ms) {
     if (!stateMutex) return false;
-    if (xSemaphoreTake(stateMutex, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+    if (!hal_mutex_take(stateMutex, timeout_ms)) {
         log_msg(LOG_LEVEL_WARN, "state_lock timeout!");
         return false;
     }
@@ -51,12 +93,12 @@ bool state_lock(TickType_t timeout_ms) {
 }
 
 void state_unlock() {
-    if (stateMutex) xSemaphoreGive(stateMutex);
+    hal_mutex_give(stateMutex);
 }
 
 bool output_lock(TickType_t timeout_ms) {
     if (!outputMutex) return false;
-    if (xSemaphoreTake(outputMutex, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+    if (!hal_mutex_take(outputMutex, timeout_ms)) {
         log_msg(LOG_LEVEL_WARN, "output_lock timeout!");
         return false;
     }
@@ -64,12 +106,12 @@ bool output_lock(TickType_t timeout_ms) {
 }
 
 void output_unlock() {
-    if (outputMutex) xSemaphoreGive(outputMutex);
+    hal_mutex_give(outputMutex);
 }
 
 bool heater_lock(TickType_t timeout_ms) {
     if (!heaterMutex) return false;
-    if (xSemaphoreTake(heaterMutex, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+    if (!hal_mutex_take(heaterMutex, timeout_ms)) {
         log_msg(LOG_LEVEL_WARN, "heater_lock timeout!");
         return false;
     }
@@ -77,31 +119,21 @@ bool heater_lock(TickType_t timeout_ms) {
 }
 
 void heater_unlock() {
-    if (heaterMutex) xSemaphoreGive(heaterMutex);
+    hal_mutex_give(heaterMutex);
 }
 
 void init_state() {
-    stateMutex = xSemaphoreCreateMutex();
-    outputMutex = xSemaphoreCreateMutex();
-    heaterMutex = xSemaphoreCreateMutex();
+    stateMutex = hal_mutex_create();
+    outputMutex = hal_mutex_create();
+    heaterMutex = hal_mutex_create();
     
     if (!stateMutex || !outputMutex || !heaterMutex) {
         log_msg(LOG_LEVEL_ERROR, "FATAL: Mutex creation failed!");
         while (1) delay(1000);
     }
 
-    pid.SetMode(AUTOMATIC);
-    pid.SetOutputLimits(0, 100);
-    pid.SetTunings(CFG_Kp, CFG_Ki, CFG_Kd);
-    pid.SetSampleTime(1000);
-    
-    // Inicjalizacja statystyk
-    g_processStats.totalRunTime = 0;
-    g_processStats.activeHeatingTime = 0;
-    g_processStats.stepChanges = 0;
-    g_processStats.pauseCount = 0;
-    g_processStats.avgTemp = 0.0;
-    g_processStats.lastUpdate = millis();
+    // [NEW] Nastawy PID i statystyki każdej komory
+    chamber_init_all();
     
     log_msg(LOG_LEVEL_INFO, "State initialized successfully");
 }
@@ -1,50 +1,59 @@
 // state.h - Zoptymalizowana wersja
 #pragma once
+#ifdef ARDUINO
 #include <Adafruit_ST7735.h>
 #include <DallasTemperature.h>
-#include <PID_v1.h>
 #include <WebServer.h>
+#endif
 #include "config.h"
+#include "pid_ctrl.h"
+#include "chamber.h"
 
-// Deklaracje extern dla obiektów globalnych
+#ifdef ARDUINO
+// Deklaracje extern dla obiektów globalnych (tylko ESP32 – na hoście
+// wyświetlacz, serwer i magistrala OneWire są za HAL)
 extern Adafruit_ST7735 display;
 extern WebServer server;
 extern OneWire oneWire;
 extern DallasTemperature sensors;
-extern PID pid;
-extern SemaphoreHandle_t stateMutex;
-extern SemaphoreHandle_t outputMutex;
-extern SemaphoreHandle_t heaterMutex;
+#endif
+extern hal_mutex_t stateMutex;
+extern hal_mutex_t outputMutex;
+extern hal_mutex_t heaterMutex;
+
+// [NEW] Stan procesu jest w obiektach Chamber (chamber.h). Poniższe nazwy
+// to aliasy komory 0 – UI, WWW i storage dla jednej komory bez zmian.
+extern PidController& pid;
 
 // PID output
-extern double pidOutput;
-extern double pidInput;
-extern double pidSetpoint;
+extern double& pidOutput;
+extern double& pidInput;
+extern double& pidSetpoint;
 
 // Deklaracje extern dla zmiennych stanu
-extern volatile ProcessState g_currentState;
-extern RunMode g_lastRunMode;
-extern volatile double g_tSet;
-extern volatile double g_tChamber;
-extern volatile double g_tMeat;
-extern volatile int g_powerMode;
-extern volatile int g_manualSmokePwm;
-extern volatile int g_fanMode;
-extern volatile unsigned long g_fanOnTime;
-extern volatile unsigned long g_fanOffTime;
-extern volatile bool g_doorOpen;
-extern volatile bool g_errorSensor;
-extern volatile bool g_errorOverheat;
-extern volatile bool g_errorProfile;
+extern volatile ProcessState& g_currentState;
+extern RunMode& g_lastRunMode;
+extern volatile double& g_tSet;
+extern volatile double& g_tChamber;
+extern volatile double& g_tMeat;
+extern volatile int& g_powerMode;
+extern volatile int& g_manualSmokePwm;
+extern volatile int& g_fanMode;
+extern volatile unsigned long& g_fanOnTime;
+extern volatile unsigned long& g_fanOffTime;
+extern volatile bool& g_doorOpen;
+extern volatile bool& g_errorSensor;
+extern volatile bool& g_errorOverheat;
+extern volatile bool& g_errorProfile;
 
-extern Step g_profile[MAX_STEPS];
-extern int g_stepCount;
-extern int g_currentStep;
-extern unsigned long g_processStartTime;
-extern unsigned long g_stepStartTime;
+extern Step (&g_profile)[MAX_STEPS];
+extern int& g_stepCount;
+extern int& g_currentStep;
+extern unsigned long& g_processStartTime;
+extern unsigned long& g_stepStartTime;
 
 // Statystyki procesu
-extern ProcessStats g_processStats;
+extern ProcessStats& g_processStats;
 
 // Funkcje pomocnicze do blokowania z timeoutami
 bool state_lock(TickType_t timeout_ms = CFG_MUTEX_TIMEOUT_MS);
@@ -1,18 +1,20 @@
 // storage.cpp - [FIX] snprintf w logach, mniej fragmentacji String
 // [NEW]  Funkcje storage_get/save/reset_auth_nvs dla HTTP Basic Auth
+// [NEW]  Write-back cache NVS: settery tylko oznaczają klucze jako brudne,
+//        zapis (jeden commit na namespace) robi storage_nvs_service()
+// [NEW]  NVS i karta SD przez hal_kv_* / hal_fs_* (hal.h) – moduł kompiluje się też na hoście
 #include "storage.h"
 #include "config.h"
 #include "state.h"
-#include <SD.h>
-#include <nvs_flash.h>
-#include <nvs.h>
-#include "FS.h"
-#include <WiFi.h>
-#include <HTTPClient.h>
-#include <WiFiClientSecure.h>
 #include <ArduinoJson.h>
-
-static char lastProfilePath[64] = "/profiles/test.prof";
+#include <functional>
+#include "github_client.h"
+#include "gain_sched.h"
+#include "energy.h"
+
+// [FIX] Ścieżka profilu osobno dla każdej komory (wybór w komorze 1 nie
+// zmienia tego, od czego komora 0 wznawia po restarcie)
+static char lastProfilePath[CFG_CHAMBER_COUNT][64];
 static char wifiStaSsid[32] = "";
 static char wifiStaPass[64] = "";
 
@@ -23,11 +25,101 @@ static char authPass[64] = "";
 static int backupCounter = 0;
 static constexpr int MAX_BACKUPS = 5;
 
+// ======================================================
+// [NEW] WRITE-BACK CACHE NVS
+// ======================================================
+// Każdy setter = dawniej osobny cykl open/set/commit/close (kasowanie strony
+// flash), często seriami przy klikaniu +/- w trybie manualnym. Teraz settery
+// zapisują wartości do RAM i ustawiają bit w dirtyMask; flush następuje po
+// CFG_NVS_FLUSH_QUIET_MS ciszy, najpóźniej po CFG_NVS_FLUSH_MAX_AGE_MS,
+// a natychmiast przy zmianie stanu procesu i przed restartem.
+enum NvsDirtyKey : uint16_t {
+    NVS_DIRTY_WIFI    = 1 << 0,
+    NVS_DIRTY_PROFILE = 1 << 1,
+    NVS_DIRTY_MANUAL  = 1 << 2,
+    NVS_DIRTY_AUTH    = 1 << 3,
+    NVS_DIRTY_SENSORS = 1 << 4,
+    NVS_DIRTY_GAINS   = 1 << 5,
+    NVS_DIRTY_ENERGY  = 1 << 6
+};
+
+struct NvsCache {
+    uint16_t dirtyMask;
+    unsigned long firstChange;
+    unsigned long lastChange;
+    bool flushRequested;
+    // Migawka ustawień manualnych z chwili wywołania settera
+    double manualTSet;
+    int32_t manualPower;
+    int32_t manualSmoke;
+    int32_t manualFan;
+    uint8_t chamberIdx;
+    uint8_t meatIdx;
+    uint8_t gainChambers;       // bit i = tablica nastaw komory i
+    uint8_t profileChambers;    // bit i = ścieżka profilu komory i
+    // [FIX] Napisy też jako migawka – bufory globalne zmieniają taski Web/UI
+    // w trakcie flusha (task Monitor)
+    char wifiSsid[32];
+    char wifiPass[64];
+    char profilePath[CFG_CHAMBER_COUNT][64];
+    char authUser[32];
+    char authPass[64];
+    // Statystyki: requested = ile commitów zrobiłby stary kod
+    uint32_t requestedTotal;
+    uint32_t commitsTotal;
+    uint32_t requestedHour;
+    uint32_t commitsHour;
+    uint32_t requestedLastHour;
+    uint32_t commitsLastHour;
+    unsigned long hourStart;
+    bool fullHourSeen;
+};
+
+static_assert(CFG_CHAMBER_COUNT <= 8, "NvsCache::gainChambers/profileChambers: bit na komorę");
+
+static NvsCache nvsCache = {};
+static portMUX_TYPE nvsCacheMux = portMUX_INITIALIZER_UNLOCKED;
+static hal_signal_t nvsFlushSignal = NULL;
+
+static void nvsMarkDirty(uint16_t key) {
+    unsigned long now = millis();
+    portENTER_CRITICAL(&nvsCacheMux);
+    if (nvsCache.dirtyMask == 0) nvsCache.firstChange = now;
+    nvsCache.dirtyMask |= key;
+    nvsCache.lastChange = now;
+    nvsCache.requestedTotal++;
+    nvsCache.requestedHour++;
+    portEXIT_CRITICAL(&nvsCacheMux);
+}
+
+static void nvsCountCommit() {
+    portENTER_CRITICAL(&nvsCacheMux);
+    nvsCache.commitsTotal++;
+    nvsCache.commitsHour++;
+    portEXIT_CRITICAL(&nvsCacheMux);
+}
+
+// Wołać pod nvsCacheMux
+static void copyStr(char* dst, const char* src, size_t size) {
+    snprintf(dst, size, "%s", src);
+}
+
 static bool parseBool(const char* s) {
     return (strcmp(s, "1") == 0 || strcasecmp(s, "true") == 0);
 }
 
-const char* storage_get_profile_path() { return lastProfilePath; }
+static constexpr const char* DEFAULT_PROFILE_PATH = "/profiles/test.prof";
+
+// Klucz NVS ścieżki profilu: komora 0 zostaje na "profile" (zgodność
+// z zapisanymi urządzeniami), dalsze "profile1", "profile2"...
+static void profileKey(uint8_t chamberIdx, char* key, size_t size) {
+    if (chamberIdx == 0) snprintf(key, size, "profile");
+    else                 snprintf(key, size, "profile%u", (unsigned)chamberIdx);
+}
+
+const char* storage_get_profile_path(uint8_t chamberIdx) {
+    return lastProfilePath[chamberIdx < CFG_CHAMBER_COUNT ? chamberIdx : 0];
+}
 const char* storage_get_wifi_ssid()    { return wifiStaSsid; }
 const char* storage_get_wifi_pass()    { return wifiStaPass; }
 
@@ -44,7 +136,7 @@ const char* storage_get_auth_pass() {
     return (authPass[0] != '\0') ? authPass : CFG_AUTH_DEFAULT_PASS;
 }
 
-static bool parseProfileLine(char* line, Step& step) {
+bool parseProfileLine(char* line, Step& step) {
     while (*line == ' ' || *line == '\t') line++;
 
     int len = strlen(line);
@@ -82,126 +174,182 @@ static bool parseProfileLine(char* line, Step& step) {
     return true;
 }
 
-bool storage_load_profile() {
-    if (strncmp(lastProfilePath, "github:", 7) == 0) {
-        return storage_load_github_profile(lastProfilePath + 7);
-    } else {
-        if (!SD.exists(lastProfilePath)) {
-            LOG_FMT(LOG_LEVEL_ERROR, "Profile not found on SD: %s", lastProfilePath);
-            if (state_lock()) {
-                g_errorProfile = true;
-                state_unlock();
-            }
-            return false;
+// Wczytuje kroki z pliku profilu na SD do profilu komory c
+static bool loadProfileFromFile(Chamber& c, const char* path) {
+    hal_file_t f = hal_fs_open(path, HalFileMode::READ);
+    if (f < 0) {
+        LOG_FMT(LOG_LEVEL_ERROR, "Cannot open profile file: %s", path);
+        if (state_lock()) {
+            c.errorProfile = true;
+            state_unlock();
+        }
+        return false;
+    }
+
+    int loadedStepCount = 0;
+    char lineBuf[256];
+
+    while (loadedStepCount < MAX_STEPS &&
+           hal_fs_read_line(f, lineBuf, sizeof(lineBuf)) >= 0) {
+        if (parseProfileLine(lineBuf, c.profile[loadedStepCount])) {
+            loadedStepCount++;
         }
+    }
+    hal_fs_close(f);
 
-        storage_backup_config();
+    if (state_lock()) {
+        c.stepCount    = loadedStepCount;
+        c.errorProfile = (c.stepCount == 0);
 
-        File f = SD.open(lastProfilePath, "r");
-        if (!f) {
-            log_msg(LOG_LEVEL_ERROR, "Cannot open profile file");
+        c.processStats.totalProcessTimeSec = 0;
+        for (int i = 0; i < c.stepCount; i++) {
+            c.processStats.totalProcessTimeSec += c.profile[i].minTimeMs / 1000;
+        }
+
+        state_unlock();
+    }
+
+    return !c.errorProfile;
+}
+
+bool storage_load_profile(uint8_t chamberIdx) {
+    Chamber& c = chamber_get(chamberIdx);
+    // Kopia – Web/UI mogą w tym czasie wybrać kolejny profil
+    char path[sizeof(lastProfilePath[0])];
+    memcpy(path, storage_get_profile_path(chamberIdx), sizeof(path));
+    path[sizeof(path) - 1] = '\0';
+    if (strncmp(path, "github:", 7) == 0) {
+        return storage_load_github_profile(path + 7, chamberIdx);
+    } else {
+        if (!hal_fs_exists(path)) {
+            LOG_FMT(LOG_LEVEL_ERROR, "Profile not found on SD: %s", path);
             if (state_lock()) {
-                g_errorProfile = true;
+                c.errorProfile = true;
                 state_unlock();
             }
             return false;
         }
 
-        int loadedStepCount = 0;
-        char lineBuf[256];
-
-        while (f.available() && loadedStepCount < MAX_STEPS) {
-            int len = f.readBytesUntil('\n', lineBuf, sizeof(lineBuf) - 1);
-            lineBuf[len] = '\0';
+        storage_backup_config();
 
-            if (parseProfileLine(lineBuf, g_profile[loadedStepCount])) {
-                loadedStepCount++;
-            }
+        if (!loadProfileFromFile(c, path)) {
+            LOG_FMT(LOG_LEVEL_ERROR, "Failed to load profile: %s", path);
+            return false;
         }
-        f.close();
-
-        if (state_lock()) {
-            g_stepCount    = loadedStepCount;
-            g_errorProfile = (g_stepCount == 0);
 
-            g_processStats.totalProcessTimeSec = 0;
-            for (int i = 0; i < g_stepCount; i++) {
-                g_processStats.totalProcessTimeSec += g_profile[i].minTimeMs / 1000;
-            }
+        LOG_FMT(LOG_LEVEL_INFO, "Profile loaded from SD: %d steps", c.stepCount);
+        return true;
+    }
+}
 
-            state_unlock();
+// [NEW] Tablice nastaw PID (gain_sched.cpp) – osobny namespace, klucz na komorę
+static void loadGainTablesNvs() {
+    hal_kv_t nvsHandle;
+    if (!hal_kv_open("pid_gains", false, &nvsHandle)) return;
+
+    for (uint8_t i = 0; i < CFG_CHAMBER_COUNT; i++) {
+        char key[8];
+        snprintf(key, sizeof(key), "k%u", (unsigned)i);
+        GainTable t;
+        size_t len = sizeof(t);
+        if (!hal_kv_get_blob(nvsHandle, key, &t, &len)) continue;
+        if (len != sizeof(t) || !gain_table_restore(i, t)) {
+            LOG_FMT(LOG_LEVEL_WARN, "Gain table K%u in NVS invalid - using defaults", (unsigned)i);
+            continue;
         }
+        LOG_FMT(LOG_LEVEL_INFO, "Gain table K%u loaded from NVS", (unsigned)i);
+    }
+    hal_kv_close(nvsHandle);
+}
 
-        if (g_errorProfile) {
-            LOG_FMT(LOG_LEVEL_ERROR, "Failed to load profile: %s", lastProfilePath);
+// [NEW] Moce wyjść i taryfa (energy.cpp)
+static void loadEnergyConfigNvs() {
+    hal_kv_t nvsHandle;
+    if (!hal_kv_open("energy", false, &nvsHandle)) return;
+    EnergyConfig cfg;
+    size_t len = sizeof(cfg);
+    if (hal_kv_get_blob(nvsHandle, "cfg", &cfg, &len)) {
+        if (len == sizeof(cfg) && energy_config_restore(cfg)) {
+            log_msg(LOG_LEVEL_INFO, "Energy config loaded from NVS");
         } else {
-            LOG_FMT(LOG_LEVEL_INFO, "Profile loaded from SD: %d steps", g_stepCount);
+            log_msg(LOG_LEVEL_WARN, "Energy config in NVS invalid - using defaults");
         }
-
-        return !g_errorProfile;
     }
+    hal_kv_close(nvsHandle);
 }
 
 void storage_load_config_nvs() {
-    nvs_handle_t nvsHandle;
-    if (nvs_open("wedzarnia", NVS_READONLY, &nvsHandle) != ESP_OK) {
+    loadGainTablesNvs();
+    loadEnergyConfigNvs();
+
+    for (uint8_t i = 0; i < CFG_CHAMBER_COUNT; i++) {
+        strcpy(lastProfilePath[i], DEFAULT_PROFILE_PATH);
+    }
+
+    hal_kv_t nvsHandle;
+    if (!hal_kv_open("wedzarnia", false, &nvsHandle)) {
         log_msg(LOG_LEVEL_INFO, "No saved config in NVS");
         return;
     }
 
     size_t len;
     len = sizeof(wifiStaSsid);
-    if (nvs_get_str(nvsHandle, "wifi_ssid", wifiStaSsid, &len) != ESP_OK)
+    if (!hal_kv_get_str(nvsHandle, "wifi_ssid", wifiStaSsid, &len))
         wifiStaSsid[0] = '\0';
 
     len = sizeof(wifiStaPass);
-    if (nvs_get_str(nvsHandle, "wifi_pass", wifiStaPass, &len) != ESP_OK)
+    if (!hal_kv_get_str(nvsHandle, "wifi_pass", wifiStaPass, &len))
         wifiStaPass[0] = '\0';
 
-    len = sizeof(lastProfilePath);
-    if (nvs_get_str(nvsHandle, "profile", lastProfilePath, &len) != ESP_OK) {
-        strcpy(lastProfilePath, "/profiles/test.prof");
+    for (uint8_t i = 0; i < CFG_CHAMBER_COUNT; i++) {
+        char key[12];
+        profileKey(i, key, sizeof(key));
+        len = sizeof(lastProfilePath[i]);
+        if (!hal_kv_get_str(nvsHandle, key, lastProfilePath[i], &len)) {
+            strcpy(lastProfilePath[i], DEFAULT_PROFILE_PATH);
+        }
     }
 
     // [NEW] Wczytaj dane autoryzacji
     len = sizeof(authUser);
-    if (nvs_get_str(nvsHandle, "auth_user", authUser, &len) != ESP_OK)
+    if (!hal_kv_get_str(nvsHandle, "auth_user", authUser, &len))
         authUser[0] = '\0';  // puste = użyj domyślnego z config.h
 
     len = sizeof(authPass);
-    if (nvs_get_str(nvsHandle, "auth_pass", authPass, &len) != ESP_OK)
+    if (!hal_kv_get_str(nvsHandle, "auth_pass", authPass, &len))
         authPass[0] = '\0';
 
     if (state_lock()) {
         double tmp_d;
         len = sizeof(tmp_d);
-        if (nvs_get_blob(nvsHandle, "manual_tset", &tmp_d, &len) == ESP_OK)
+        if (hal_kv_get_blob(nvsHandle, "manual_tset", &tmp_d, &len))
             g_tSet = tmp_d;
 
         int32_t tmp_i;
-        if (nvs_get_i32(nvsHandle, "manual_pow", &tmp_i) == ESP_OK)
+        if (hal_kv_get_i32(nvsHandle, "manual_pow", &tmp_i))
             g_powerMode = tmp_i;
 
-        if (nvs_get_i32(nvsHandle, "manual_smoke", &tmp_i) == ESP_OK)
+        if (hal_kv_get_i32(nvsHandle, "manual_smoke", &tmp_i))
             g_manualSmokePwm = tmp_i;
 
-        if (nvs_get_i32(nvsHandle, "manual_fan", &tmp_i) == ESP_OK)
+        if (hal_kv_get_i32(nvsHandle, "manual_fan", &tmp_i))
             g_fanMode = tmp_i;
 
         state_unlock();
     }
 
-    nvs_close(nvsHandle);
+    hal_kv_close(nvsHandle);
     log_msg(LOG_LEVEL_INFO, "NVS config loaded");
 }
 
-static void nvs_save_generic(std::function<void(nvs_handle_t)> action) {
-    nvs_handle_t nvsHandle;
-    if (nvs_open("wedzarnia", NVS_READWRITE, &nvsHandle) == ESP_OK) {
-        action(nvsHandle);
-        nvs_commit(nvsHandle);
-        nvs_close(nvsHandle);
-    }
+static bool nvs_save_generic(const char* ns, std::function<void(hal_kv_t)> action) {
+    hal_kv_t nvsHandle;
+    if (!hal_kv_open(ns, true, &nvsHandle)) return false;
+    action(nvsHandle);
+    bool ok = hal_kv_commit(nvsHandle);
+    hal_kv_close(nvsHandle);
+    nvsCountCommit();
+    return ok;
 }
 
 void storage_save_wifi_nvs(const char* ssid, const char* pass) {
@@ -210,23 +358,32 @@ void storage_save_wifi_nvs(const char* ssid, const char* pass) {
     strncpy(wifiStaPass, pass, sizeof(wifiStaPass) - 1);
     wifiStaPass[sizeof(wifiStaPass) - 1] = '\0';
 
-    nvs_save_generic([&](nvs_handle_t handle){
-        nvs_set_str(handle, "wifi_ssid", wifiStaSsid);
-        nvs_set_str(handle, "wifi_pass", wifiStaPass);
-    });
+    portENTER_CRITICAL(&nvsCacheMux);
+    copyStr(nvsCache.wifiSsid, ssid, sizeof(nvsCache.wifiSsid));
+    copyStr(nvsCache.wifiPass, pass, sizeof(nvsCache.wifiPass));
+    portEXIT_CRITICAL(&nvsCacheMux);
+
+    // Dane logowania – rzadka zmiana, zapis od razu przez task Monitor
+    nvsMarkDirty(NVS_DIRTY_WIFI);
+    storage_request_nvs_flush();
 
     log_msg(LOG_LEVEL_INFO, "WiFi credentials saved to NVS");
 }
 
-void storage_save_profile_path_nvs(const char* path) {
-    strncpy(lastProfilePath, path, sizeof(lastProfilePath) - 1);
-    lastProfilePath[sizeof(lastProfilePath) - 1] = '\0';
+void storage_save_profile_path_nvs(const char* path, uint8_t chamberIdx) {
+    if (chamberIdx >= CFG_CHAMBER_COUNT) return;
+    // Kopia przez bufor – wywołanie z własną ścieżką (restore) nie nakłada buforów
+    char copy[sizeof(lastProfilePath[0])];
+    snprintf(copy, sizeof(copy), "%s", path);
+    memcpy(lastProfilePath[chamberIdx], copy, sizeof(copy));
 
-    nvs_save_generic([&](nvs_handle_t handle){
-        nvs_set_str(handle, "profile", lastProfilePath);
-    });
+    portENTER_CRITICAL(&nvsCacheMux);
+    copyStr(nvsCache.profilePath[chamberIdx], copy, sizeof(nvsCache.profilePath[0]));
+    nvsCache.profileChambers |= (uint8_t)(1u << chamberIdx);
+    portEXIT_CRITICAL(&nvsCacheMux);
+    nvsMarkDirty(NVS_DIRTY_PROFILE);
 
-    LOG_FMT(LOG_LEVEL_INFO, "Profile path saved: %s", path);
+    LOG_FMT(LOG_LEVEL_INFO, "Profile path K%u saved: %s", (unsigned)chamberIdx, copy);
 }
 
 void storage_save_manual_settings_nvs() {
@@ -238,14 +395,38 @@ void storage_save_manual_settings_nvs() {
     int fm    = g_fanMode;
     state_unlock();
 
-    nvs_save_generic([=](nvs_handle_t handle){
-        nvs_set_blob(handle, "manual_tset", &ts, sizeof(ts));
-        nvs_set_i32(handle, "manual_pow",   pm);
-        nvs_set_i32(handle, "manual_smoke", sm);
-        nvs_set_i32(handle, "manual_fan",   fm);
-    });
+    portENTER_CRITICAL(&nvsCacheMux);
+    nvsCache.manualTSet  = ts;
+    nvsCache.manualPower = pm;
+    nvsCache.manualSmoke = sm;
+    nvsCache.manualFan   = fm;
+    portEXIT_CRITICAL(&nvsCacheMux);
+    nvsMarkDirty(NVS_DIRTY_MANUAL);
+
+    log_msg(LOG_LEVEL_DEBUG, "Manual settings queued for NVS");
+}
+
+// [NEW] Przypisanie czujników (namespace "sensor_config") – przez ten sam cache
+void storage_save_sensor_assignment_nvs(uint8_t chamberIdx, uint8_t meatIdx) {
+    portENTER_CRITICAL(&nvsCacheMux);
+    nvsCache.chamberIdx = chamberIdx;
+    nvsCache.meatIdx    = meatIdx;
+    portEXIT_CRITICAL(&nvsCacheMux);
+    nvsMarkDirty(NVS_DIRTY_SENSORS);
+}
+
+// [NEW] Wyuczona tablica nastaw – zapis po każdej obserwacji, więc przez cache
+void storage_save_gain_table_nvs(uint8_t chamberIdx) {
+    if (chamberIdx >= CFG_CHAMBER_COUNT) return;
+    portENTER_CRITICAL(&nvsCacheMux);
+    nvsCache.gainChambers |= (uint8_t)(1u << chamberIdx);
+    portEXIT_CRITICAL(&nvsCacheMux);
+    nvsMarkDirty(NVS_DIRTY_GAINS);
+}
 
-    log_msg(LOG_LEVEL_DEBUG, "Manual settings saved to NVS");
+// [NEW] Moce wyjść i taryfa – zmiana z WWW, zapis przez cache
+void storage_save_energy_config_nvs() {
+    nvsMarkDirty(NVS_DIRTY_ENERGY);
 }
 
 // ======================================================
@@ -265,74 +446,212 @@ void storage_save_auth_nvs(const char* user, const char* pass) {
     strncpy(authPass, pass, sizeof(authPass) - 1);
     authPass[sizeof(authPass) - 1] = '\0';
 
-    nvs_save_generic([&](nvs_handle_t handle){
-        nvs_set_str(handle, "auth_user", authUser);
-        nvs_set_str(handle, "auth_pass", authPass);
-    });
+    portENTER_CRITICAL(&nvsCacheMux);
+    copyStr(nvsCache.authUser, user, sizeof(nvsCache.authUser));
+    copyStr(nvsCache.authPass, pass, sizeof(nvsCache.authPass));
+    portEXIT_CRITICAL(&nvsCacheMux);
+    nvsMarkDirty(NVS_DIRTY_AUTH);
+    storage_request_nvs_flush();
 
     log_msg(LOG_LEVEL_INFO, "Auth credentials saved to NVS");
 }
 
 void storage_reset_auth_nvs() {
-    // Wyczyść bufory – storage_get_auth_*() wróci do domyślnych z config.h
+    // Wyczyść bufory – storage_get_auth_*() wróci do domyślnych z config.h,
+    // flush skasuje klucze z NVS (puste bufory = erase)
     authUser[0] = '\0';
     authPass[0] = '\0';
 
-    nvs_handle_t nvsHandle;
-    if (nvs_open("wedzarnia", NVS_READWRITE, &nvsHandle) == ESP_OK) {
-        nvs_erase_key(nvsHandle, "auth_user");
-        nvs_erase_key(nvsHandle, "auth_pass");
-        nvs_commit(nvsHandle);
-        nvs_close(nvsHandle);
-    }
+    portENTER_CRITICAL(&nvsCacheMux);
+    nvsCache.authUser[0] = '\0';
+    nvsCache.authPass[0] = '\0';
+    portEXIT_CRITICAL(&nvsCacheMux);
+    nvsMarkDirty(NVS_DIRTY_AUTH);
+    storage_request_nvs_flush();
 
     LOG_FMT(LOG_LEVEL_INFO, "Auth reset to defaults (user=%s)", CFG_AUTH_DEFAULT_USER);
 }
 
+// ======================================================
+// [NEW] FLUSH CACHE NVS
+// ======================================================
+
+bool storage_flush_nvs() {
+    // Migawka pod spinlockiem, zapis do flash już bez blokady
+    portENTER_CRITICAL(&nvsCacheMux);
+    uint16_t mask = nvsCache.dirtyMask;
+    NvsCache snap = nvsCache;
+    nvsCache.dirtyMask = 0;
+    nvsCache.gainChambers = 0;
+    nvsCache.profileChambers = 0;
+    nvsCache.flushRequested = false;
+    portEXIT_CRITICAL(&nvsCacheMux);
+
+    if (mask == 0) return true;
+
+    bool ok = true;
+    if (mask & (NVS_DIRTY_WIFI | NVS_DIRTY_PROFILE | NVS_DIRTY_MANUAL | NVS_DIRTY_AUTH)) {
+        ok &= nvs_save_generic("wedzarnia", [&](hal_kv_t handle){
+            if (mask & NVS_DIRTY_WIFI) {
+                hal_kv_set_str(handle, "wifi_ssid", snap.wifiSsid);
+                hal_kv_set_str(handle, "wifi_pass", snap.wifiPass);
+            }
+            if (mask & NVS_DIRTY_PROFILE) {
+                for (uint8_t i = 0; i < CFG_CHAMBER_COUNT; i++) {
+                    if (!(snap.profileChambers & (1u << i))) continue;
+                    char key[12];
+                    profileKey(i, key, sizeof(key));
+                    hal_kv_set_str(handle, key, snap.profilePath[i]);
+                }
+            }
+            if (mask & NVS_DIRTY_MANUAL) {
+                hal_kv_set_blob(handle, "manual_tset", &snap.manualTSet, sizeof(snap.manualTSet));
+                hal_kv_set_i32(handle, "manual_pow",   snap.manualPower);
+                hal_kv_set_i32(handle, "manual_smoke", snap.manualSmoke);
+                hal_kv_set_i32(handle, "manual_fan",   snap.manualFan);
+            }
+            if (mask & NVS_DIRTY_AUTH) {
+                if (snap.authUser[0] != '\0') {
+                    hal_kv_set_str(handle, "auth_user", snap.authUser);
+                    hal_kv_set_str(handle, "auth_pass", snap.authPass);
+                } else {
+                    hal_kv_erase(handle, "auth_user");
+                    hal_kv_erase(handle, "auth_pass");
+                }
+            }
+        });
+    }
+    if (mask & NVS_DIRTY_SENSORS) {
+        ok &= nvs_save_generic("sensor_config", [&](hal_kv_t handle){
+            hal_kv_set_u8(handle, "chamber_idx", snap.chamberIdx);
+            hal_kv_set_u8(handle, "meat_idx",    snap.meatIdx);
+        });
+    }
+    if (mask & NVS_DIRTY_GAINS) {
+        ok &= nvs_save_generic("pid_gains", [&](hal_kv_t handle){
+            for (uint8_t i = 0; i < CFG_CHAMBER_COUNT; i++) {
+                if (!(snap.gainChambers & (1u << i))) continue;
+                GainTable t;
+                if (!gain_table_copy(i, t)) continue;
+                char key[8];
+                snprintf(key, sizeof(key), "k%u", (unsigned)i);
+                hal_kv_set_blob(handle, key, &t, sizeof(t));
+            }
+        });
+    }
+    if (mask & NVS_DIRTY_ENERGY) {
+        ok &= nvs_save_generic("energy", [&](hal_kv_t handle){
+            EnergyConfig cfg = energy_get_config();
+            hal_kv_set_blob(handle, "cfg", &cfg, sizeof(cfg));
+        });
+    }
+
+    if (!ok) {
+        // Nieudany zapis – klucze wracają do kolejki
+        portENTER_CRITICAL(&nvsCacheMux);
+        nvsCache.dirtyMask |= mask;
+        nvsCache.gainChambers |= snap.gainChambers;
+        nvsCache.profileChambers |= snap.profileChambers;
+        portEXIT_CRITICAL(&nvsCacheMux);
+        log_msg(LOG_LEVEL_ERROR, "NVS flush failed!");
+    } else {
+        LOG_FMT(LOG_LEVEL_DEBUG, "NVS flushed (mask=0x%02X)", mask);
+    }
+    return ok;
+}
+
+void storage_request_nvs_flush() {
+    portENTER_CRITICAL(&nvsCacheMux);
+    bool pending = nvsCache.dirtyMask != 0;
+    if (pending) nvsCache.flushRequested = true;
+    portEXIT_CRITICAL(&nvsCacheMux);
+    if (pending && nvsFlushSignal) hal_signal_give(nvsFlushSignal);
+}
+
+void storage_nvs_service(TickType_t waitTicks) {
+    if (!nvsFlushSignal) nvsFlushSignal = hal_signal_create();
+    if (nvsFlushSignal) hal_signal_wait(nvsFlushSignal, waitTicks * portTICK_PERIOD_MS);
+    else                vTaskDelay(waitTicks);
+
+    unsigned long now = millis();
+
+    portENTER_CRITICAL(&nvsCacheMux);
+    if (nvsCache.hourStart == 0) nvsCache.hourStart = now;
+    if (now - nvsCache.hourStart >= 3600000UL) {
+        nvsCache.requestedLastHour = nvsCache.requestedHour;
+        nvsCache.commitsLastHour   = nvsCache.commitsHour;
+        nvsCache.requestedHour = 0;
+        nvsCache.commitsHour   = 0;
+        nvsCache.hourStart     = now;
+        nvsCache.fullHourSeen  = true;
+    }
+    bool due = nvsCache.dirtyMask != 0 &&
+               (nvsCache.flushRequested ||
+                now - nvsCache.lastChange  >= CFG_NVS_FLUSH_QUIET_MS ||
+                now - nvsCache.firstChange >= CFG_NVS_FLUSH_MAX_AGE_MS);
+    portEXIT_CRITICAL(&nvsCacheMux);
+
+    if (due) storage_flush_nvs();
+}
+
+NvsWriteStats storage_get_nvs_write_stats() {
+    NvsWriteStats stats;
+    portENTER_CRITICAL(&nvsCacheMux);
+    stats.requestedTotal = nvsCache.requestedTotal;
+    stats.commitsTotal   = nvsCache.commitsTotal;
+    // Przed upływem pierwszej godziny – bieżące (niepełne) okno
+    stats.requestedLastHour = nvsCache.fullHourSeen ? nvsCache.requestedLastHour : nvsCache.requestedHour;
+    stats.commitsLastHour   = nvsCache.fullHourSeen ? nvsCache.commitsLastHour   : nvsCache.commitsHour;
+    stats.pendingMask    = nvsCache.dirtyMask;
+    portEXIT_CRITICAL(&nvsCacheMux);
+    return stats;
+}
+
 // ======================================================
 // PROFILES JSON
 // ======================================================
 
+// Lista nazw plików o danym rozszerzeniu jako tablica JSON (hal_fs_list)
+struct JsonNameList {
+    char* json;
+    size_t size;
+    int offset;
+    const char* ext;
+    int reserve;        // zapas na końcu bufora – po jego przekroczeniu stop
+    bool first;
+};
+
+static bool appendJsonName(const char* fileName, void* ctx) {
+    JsonNameList* list = (JsonNameList*)ctx;
+    int nameLen = strlen(fileName);
+    int extLen  = strlen(list->ext);
+    if (nameLen <= extLen || strcmp(fileName + nameLen - extLen, list->ext) != 0) return true;
+
+    if (!list->first) {
+        list->offset += snprintf(list->json + list->offset, list->size - list->offset, ",");
+    }
+    list->offset += snprintf(list->json + list->offset, list->size - list->offset, "\"%s\"", fileName);
+    list->first = false;
+    return list->offset < (int)list->size - list->reserve;
+}
+
 String storage_list_profiles_json() {
     char json[512];
-    int offset = 0;
-    offset += snprintf(json + offset, sizeof(json) - offset, "[");
+    JsonNameList list = { json, sizeof(json), 0, ".prof", 20, true };
+    list.offset += snprintf(json, sizeof(json), "[");
 
-    File root = SD.open("/profiles");
-    if (!root || !root.isDirectory()) {
+    if (!hal_fs_list("/profiles", appendJsonName, &list)) {
         log_msg(LOG_LEVEL_WARN, "Cannot open /profiles directory");
         return "[]";
     }
-
-    bool first = true;
-    File file = root.openNextFile();
-    while (file) {
-        if (!file.isDirectory()) {
-            const char* fileName = file.name();
-            int nameLen = strlen(fileName);
-            if (nameLen > 5 && strcmp(fileName + nameLen - 5, ".prof") == 0) {
-                if (!first) {
-                    offset += snprintf(json + offset, sizeof(json) - offset, ",");
-                }
-                offset += snprintf(json + offset, sizeof(json) - offset, "\"%s\"", fileName);
-                first = false;
-                if (offset >= (int)sizeof(json) - 20) break;
-            }
-        }
-        file = root.openNextFile();
-    }
-    root.close();
-    snprintf(json + offset, sizeof(json) - offset, "]");
+    snprintf(json + list.offset, sizeof(json) - list.offset, "]");
 
     return String(json);
 }
 
 bool storage_reinit_sd() {
     log_msg(LOG_LEVEL_INFO, "Re-initializing SD card...");
-    SD.end();
-    delay(200);
-
-    if (SD.begin(PIN_SD_CS)) {
+    if (hal_fs_remount()) {
         log_msg(LOG_LEVEL_INFO, "SD card re-initialized successfully");
         return true;
     } else {
@@ -345,13 +664,13 @@ String storage_get_profile_as_json(const char* profileName) {
     char path[96];
     snprintf(path, sizeof(path), "/profiles/%s", profileName);
 
-    if (!SD.exists(path)) {
+    if (!hal_fs_exists(path)) {
         LOG_FMT(LOG_LEVEL_WARN, "Profile not found: %s", path);
         return "[]";
     }
 
-    File f = SD.open(path, "r");
-    if (!f) {
+    hal_file_t f = hal_fs_open(path, HalFileMode::READ);
+    if (f < 0) {
         LOG_FMT(LOG_LEVEL_ERROR, "Cannot open profile: %s", path);
         return "[]";
     }
@@ -362,13 +681,10 @@ String storage_get_profile_as_json(const char* profileName) {
     bool firstStep = true;
     char lineBuf[256];
 
-    while (f.available()) {
-        int len = f.readBytesUntil('\n', lineBuf, sizeof(lineBuf) - 1);
-        lineBuf[len] = '\0';
-
+    while (hal_fs_read_line(f, lineBuf, sizeof(lineBuf)) >= 0) {
         char* line = lineBuf;
         while (*line == ' ' || *line == '\t') line++;
-        len = strlen(line);
+        int len = strlen(line);
         while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == '\n' || line[len - 1] == ' ')) {
             line[--len] = '\0';
         }
@@ -401,153 +717,39 @@ String storage_get_profile_as_json(const char* profileName) {
 
         if (offset >= (int)sizeof(json) - 50) break;
     }
-    f.close();
-    snprintf(json + offset, sizeof(json) - offset, "]");
-
-    return String(json);
-}
-
-String storage_list_github_profiles_json() {
-    if (WiFi.status() != WL_CONNECTED) {
-        log_msg(LOG_LEVEL_WARN, "WiFi not connected - cannot list GitHub profiles");
-        return "[\"Brak WiFi\"]";
-    }
-
-    HTTPClient http;
-    WiFiClientSecure secureClient;
-    secureClient.setInsecure();
-
-    http.begin(secureClient, CFG_GITHUB_API_URL);
-    http.addHeader("User-Agent", "ESP32-Wedzarnia/3.4");
-    http.setTimeout(10000);
-    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
-    int httpCode = http.GET();
-
-    if (httpCode != HTTP_CODE_OK) {
-        LOG_FMT(LOG_LEVEL_ERROR, "GitHub API list error: %d", httpCode);
-        http.end();
-        return "[\"Blad API GitHub\"]";
-    }
-
-    // getString() zamiast getStream() – niezawodne dla HTTPS na ESP32
-    String responseBody = http.getString();
-    http.end();
-
-    // Zwiększony bufor – API GitHub zwraca ~300 bajtów na plik
-    StaticJsonDocument<4096> doc;
-    DeserializationError error = deserializeJson(doc, responseBody);
-
-    if (error) {
-        LOG_FMT(LOG_LEVEL_ERROR, "GitHub JSON parse error: %s", error.c_str());
-        return "[\"Blad parsowania\"]";
-    }
-
-    char json[512];
-    int offset = 0;
-    offset += snprintf(json + offset, sizeof(json) - offset, "[");
-    bool first = true;
-
-    for (JsonVariant value : doc.as<JsonArray>()) {
-        const char* filename = value["name"];
-        if (!filename) continue;
-        int nameLen = strlen(filename);
-        if (nameLen > 5 && strcmp(filename + nameLen - 5, ".prof") == 0) {
-            if (!first) {
-                offset += snprintf(json + offset, sizeof(json) - offset, ",");
-            }
-            offset += snprintf(json + offset, sizeof(json) - offset, "\"%s\"", filename);
-            first = false;
-            if (offset >= (int)sizeof(json) - 50) break;
-        }
-    }
+    hal_fs_close(f);
     snprintf(json + offset, sizeof(json) - offset, "]");
 
     return String(json);
 }
 
-bool storage_load_github_profile(const char* profileName) {
-    if (WiFi.status() != WL_CONNECTED) {
-        LOG_FMT(LOG_LEVEL_ERROR, "WiFi not connected - cannot load from GitHub");
-        if (state_lock()) { g_errorProfile = true; state_unlock(); }
-        return false;
-    }
-
-    HTTPClient http;
-    // raw.githubusercontent.com wymaga HTTPS – użyj WiFiClientSecure
-    WiFiClientSecure secureClient;
-    secureClient.setInsecure(); // pomijamy weryfikację certyfikatu (brak CA store na ESP32)
-
-    char url[192];
-    snprintf(url, sizeof(url), "%s%s", CFG_GITHUB_PROFILES_BASE_URL, profileName);
-    LOG_FMT(LOG_LEVEL_INFO, "Loading GitHub profile: %s", url);
-
-    http.begin(secureClient, url);
-    http.setTimeout(15000);
-    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
-    http.addHeader("User-Agent", "ESP32-Wedzarnia/3.4");
-    http.addHeader("Accept",     "text/plain");
-
-    int httpCode = http.GET();
+// [NEW] Profil GitHub jest wczytywany z kopii na SD – pobiera ją task Github
+// (github_request_profile), więc ta funkcja nie dotyka sieci i działa offline.
+bool storage_load_github_profile(const char* profileName, uint8_t chamberIdx) {
+    Chamber& c = chamber_get(chamberIdx);
+    char cachePath[96];
+    github_cache_path(profileName, cachePath, sizeof(cachePath));
 
-    if (httpCode != HTTP_CODE_OK) {
-        LOG_FMT(LOG_LEVEL_ERROR, "GitHub GET failed HTTP %d: %s", httpCode, url);
-        http.end();
-        if (state_lock()) { g_errorProfile = true; state_unlock(); }
+    if (!hal_fs_exists(cachePath)) {
+        LOG_FMT(LOG_LEVEL_ERROR, "No cached GitHub profile: %s", profileName);
+        if (state_lock()) { c.errorProfile = true; state_unlock(); }
         return false;
     }
 
-    // WAŻNE: stream->available() na ESP32+HTTPS często zwraca 0 mimo że dane
-    // jeszcze przychodzą (znany bug biblioteki). getString() czeka na pełną
-    // odpowiedź i jest niezawodne dla małych plików (<10 kB jak nasze profile).
-    String body = http.getString();
-    http.end();
-
-    if (body.length() == 0) {
-        LOG_FMT(LOG_LEVEL_ERROR, "Empty response from GitHub for: %s", profileName);
-        if (state_lock()) { g_errorProfile = true; state_unlock(); }
+    if (!loadProfileFromFile(c, cachePath)) {
+        LOG_FMT(LOG_LEVEL_ERROR, "No valid steps in GitHub profile: %s", profileName);
         return false;
     }
 
-    LOG_FMT(LOG_LEVEL_DEBUG, "GitHub body: %d bytes", body.length());
-
-    // Parsuj linia po linii z String zamiast ze streamu
-    int loadedStepCount = 0;
-    int pos = 0;
-    int bodyLen = body.length();
-
-    while (pos < bodyLen && loadedStepCount < MAX_STEPS) {
-        int eol = body.indexOf('\n', pos);
-        if (eol < 0) eol = bodyLen;
-
-        char lineBuf[256];
-        int lineLen = min((int)(eol - pos), (int)(sizeof(lineBuf) - 1));
-        body.substring(pos, pos + lineLen).toCharArray(lineBuf, sizeof(lineBuf));
-        lineBuf[lineLen] = '\0';
-
-        if (parseProfileLine(lineBuf, g_profile[loadedStepCount])) {
-            loadedStepCount++;
-        }
-        pos = eol + 1;
-    }
-
-    if (state_lock()) {
-        g_stepCount    = loadedStepCount;
-        g_errorProfile = (g_stepCount == 0);
-
-        g_processStats.totalProcessTimeSec = 0;
-        for (int i = 0; i < g_stepCount; i++) {
-            g_processStats.totalProcessTimeSec += g_profile[i].minTimeMs / 1000;
-        }
-        state_unlock();
-    }
+    LOG_FMT(LOG_LEVEL_INFO, "GitHub profile '%s' OK: %d steps", profileName, c.stepCount);
+    return true;
+}
 
-    if (g_errorProfile) {
-        LOG_FMT(LOG_LEVEL_ERROR, "No valid steps in GitHub profile: %s", profileName);
-    } else {
-        LOG_FMT(LOG_LEVEL_INFO, "GitHub profile '%s' OK: %d steps", profileName, g_stepCount);
-    }
+static constexpr size_t BACKUP_JSON_SIZE = 416 + 96 * CFG_CHAMBER_COUNT;
 
-    return !g_errorProfile;
+static void backupProfileKey(uint8_t chamberIdx, char* key, size_t size) {
+    if (chamberIdx == 0) snprintf(key, size, "profile_path");
+    else                 snprintf(key, size, "profile_path%u", (unsigned)chamberIdx);
 }
 
 void storage_backup_config() {
@@ -557,54 +759,63 @@ void storage_backup_config() {
     char backupPath[64];
     snprintf(backupPath, sizeof(backupPath), "/backup/config_%lu.bak", millis() / 1000);
 
-    if (!SD.exists("/backup")) {
-        if (!SD.mkdir("/backup")) {
+    if (!hal_fs_exists("/backup")) {
+        if (!hal_fs_mkdir("/backup")) {
             log_msg(LOG_LEVEL_ERROR, "Failed to create backup directory");
             return;
         }
     }
 
-    File backupFile = SD.open(backupPath, FILE_WRITE);
-    if (!backupFile) {
+    hal_file_t backupFile = hal_fs_open(backupPath, HalFileMode::WRITE);
+    if (backupFile < 0) {
         log_msg(LOG_LEVEL_ERROR, "Failed to create backup file");
         return;
     }
 
-    StaticJsonDocument<512> doc;
-    doc["profile_path"]      = lastProfilePath;
+    StaticJsonDocument<BACKUP_JSON_SIZE> doc;
+    // Komora 0 pod "profile_path" (stare kopie), dalsze "profile_path1"...
+    char keys[CFG_CHAMBER_COUNT][16];
+    for (uint8_t i = 0; i < CFG_CHAMBER_COUNT; i++) {
+        backupProfileKey(i, keys[i], sizeof(keys[i]));
+        doc[keys[i]] = lastProfilePath[i];
+    }
     doc["wifi_ssid"]         = wifiStaSsid;
     doc["backup_timestamp"]  = millis() / 1000;
 
-    serializeJson(doc, backupFile);
-    backupFile.close();
+    char jsonBuf[BACKUP_JSON_SIZE];
+    size_t jsonLen = serializeJson(doc, jsonBuf, sizeof(jsonBuf));
+    hal_fs_write(backupFile, jsonBuf, jsonLen);
+    hal_fs_close(backupFile);
 
     LOG_FMT(LOG_LEVEL_INFO, "Config backup created: %s", backupPath);
 
     cleanupOldBackups();
 }
 
-void cleanupOldBackups() {
-    File backupDir = SD.open("/backup");
-    if (!backupDir) return;
-
-    char backupFiles[MAX_BACKUPS + 5][64];
-    int fileCount = 0;
-
-    while (File entry = backupDir.openNextFile()) {
-        if (!entry.isDirectory()) {
-            const char* fileName = entry.name();
-            int nameLen = strlen(fileName);
-            if (nameLen > 4 && strcmp(fileName + nameLen - 4, ".bak") == 0) {
-                if (fileCount < (int)(sizeof(backupFiles) / sizeof(backupFiles[0]))) {
-                    strncpy(backupFiles[fileCount], fileName, sizeof(backupFiles[0]) - 1);
-                    backupFiles[fileCount][sizeof(backupFiles[0]) - 1] = '\0';
-                    fileCount++;
-                }
-            }
+struct BackupNames {
+    char files[MAX_BACKUPS + 5][64];
+    int count;
+};
+
+static bool collectBackupName(const char* fileName, void* ctx) {
+    BackupNames* names = (BackupNames*)ctx;
+    int nameLen = strlen(fileName);
+    if (nameLen > 4 && strcmp(fileName + nameLen - 4, ".bak") == 0) {
+        if (names->count < (int)(sizeof(names->files) / sizeof(names->files[0]))) {
+            strncpy(names->files[names->count], fileName, sizeof(names->files[0]) - 1);
+            names->files[names->count][sizeof(names->files[0]) - 1] = '\0';
+            names->count++;
         }
-        entry.close();
     }
-    backupDir.close();
+    return true;
+}
+
+void cleanupOldBackups() {
+    BackupNames names = {};
+    if (!hal_fs_list("/backup", collectBackupName, &names)) return;
+
+    char (*backupFiles)[64] = names.files;
+    int fileCount = names.count;
 
     if (fileCount > MAX_BACKUPS) {
         for (int i = 0; i < fileCount - 1; i++) {
@@ -620,7 +831,7 @@ void cleanupOldBackups() {
 
         int filesToDelete = fileCount - MAX_BACKUPS;
         for (int i = 0; i < filesToDelete; i++) {
-            if (SD.remove(backupFiles[i])) {
+            if (hal_fs_remove(backupFiles[i])) {
                 LOG_FMT(LOG_LEVEL_INFO, "Deleted old backup: %s", backupFiles[i]);
             }
         }
@@ -628,33 +839,40 @@ void cleanupOldBackups() {
 }
 
 bool storage_restore_backup(const char* backupPath) {
-    if (!SD.exists(backupPath)) {
+    if (!hal_fs_exists(backupPath)) {
         LOG_FMT(LOG_LEVEL_ERROR, "Backup file not found: %s", backupPath);
         return false;
     }
 
-    File backupFile = SD.open(backupPath, "r");
-    if (!backupFile) {
+    hal_file_t backupFile = hal_fs_open(backupPath, HalFileMode::READ);
+    if (backupFile < 0) {
         log_msg(LOG_LEVEL_ERROR, "Cannot open backup file");
         return false;
     }
 
-    StaticJsonDocument<512> doc;
-    DeserializationError error = deserializeJson(doc, backupFile);
-    backupFile.close();
+    char jsonBuf[BACKUP_JSON_SIZE];
+    int jsonLen = hal_fs_read(backupFile, jsonBuf, sizeof(jsonBuf) - 1);
+    hal_fs_close(backupFile);
+    jsonBuf[jsonLen > 0 ? jsonLen : 0] = '\0';
+
+    StaticJsonDocument<BACKUP_JSON_SIZE> doc;
+    DeserializationError error = deserializeJson(doc, jsonBuf);
 
     if (error) {
         LOG_FMT(LOG_LEVEL_ERROR, "Failed to parse backup JSON: %s", error.c_str());
         return false;
     }
 
-    const char* profilePath = doc["profile_path"];
     const char* wifiSsid    = doc["wifi_ssid"];
     unsigned long timestamp = doc["backup_timestamp"];
 
-    if (profilePath) {
-        strncpy(lastProfilePath, profilePath, sizeof(lastProfilePath) - 1);
-        LOG_FMT(LOG_LEVEL_INFO, "Restored profile path: %s", profilePath);
+    for (uint8_t i = 0; i < CFG_CHAMBER_COUNT; i++) {
+        char key[16];
+        backupProfileKey(i, key, sizeof(key));
+        const char* profilePath = doc[key];
+        if (!profilePath) continue;
+        storage_save_profile_path_nvs(profilePath, i);
+        LOG_FMT(LOG_LEVEL_INFO, "Restored profile path K%u: %s", (unsigned)i, profilePath);
     }
 
     if (wifiSsid && strlen(wifiSsid) > 0) {
@@ -662,7 +880,6 @@ bool storage_restore_backup(const char* backupPath) {
         LOG_FMT(LOG_LEVEL_INFO, "Restored WiFi SSID: %s", wifiSsid);
     }
 
-    storage_save_profile_path_nvs(lastProfilePath);
     storage_save_wifi_nvs(wifiStaSsid, wifiStaPass);
 
     LOG_FMT(LOG_LEVEL_INFO, "Backup restored (timestamp: %lu)", timestamp);
@@ -670,37 +887,18 @@ bool storage_restore_backup(const char* backupPath) {
 }
 
 String storage_list_backups_json() {
-    if (!SD.exists("/backup")) {
-        return "[]";
-    }
-
-    File backupDir = SD.open("/backup");
-    if (!backupDir || !backupDir.isDirectory()) {
+    if (!hal_fs_exists("/backup")) {
         return "[]";
     }
 
     char json[512];
-    int offset = 0;
-    offset += snprintf(json + offset, sizeof(json) - offset, "[");
-    bool first = true;
-
-    while (File entry = backupDir.openNextFile()) {
-        if (!entry.isDirectory()) {
-            const char* fileName = entry.name();
-            int nameLen = strlen(fileName);
-            if (nameLen > 4 && strcmp(fileName + nameLen - 4, ".bak") == 0) {
-                if (!first) {
-                    offset += snprintf(json + offset, sizeof(json) - offset, ",");
-                }
-                offset += snprintf(json + offset, sizeof(json) - offset, "\"%s\"", fileName);
-                first = false;
-                if (offset >= (int)sizeof(json) - 50) break;
-            }
-        }
-        entry.close();
+    JsonNameList list = { json, sizeof(json), 0, ".bak", 50, true };
+    list.offset += snprintf(json, sizeof(json), "[");
+
+    if (!hal_fs_list("/backup", appendJsonName, &list)) {
+        return "[]";
     }
-    backupDir.close();
-    snprintf(json + offset, sizeof(json) - offset, "]");
+    snprintf(json + list.offset, sizeof(json) - list.offset, "]");
 
     return String(json);
 }
\ No newline at end of file
@@ -1,23 +1,58 @@
 // storage.h - Zmodernizowana wersja
 #pragma once
-#include <Arduino.h>
+#include "hal.h"
 
 // Podstawowe funkcje
-const char* storage_get_profile_path();
+const char* storage_get_profile_path(uint8_t chamberIdx = 0);   // [FIX] per komora
 const char* storage_get_wifi_ssid();
 const char* storage_get_wifi_pass();
-bool storage_load_profile();
+bool storage_load_profile(uint8_t chamberIdx = 0);   // profil z NVS do komory
 void storage_load_config_nvs();
 void storage_save_wifi_nvs(const char* ssid, const char* pass);
-void storage_save_profile_path_nvs(const char* path);
+void storage_save_profile_path_nvs(const char* path, uint8_t chamberIdx = 0);
 void storage_save_manual_settings_nvs();
 String storage_list_profiles_json();
 bool storage_reinit_sd();
 String storage_get_profile_as_json(const char* profileName);
 
-// Funkcje GitHub
-String storage_list_github_profiles_json();
-bool storage_load_github_profile(const char* profileName);
+// Jedna linia profilu "nazwa;tSet;tMeat;min;moc;dym;went;on;off;mieso"
+// (modyfikuje line – strtok); false = komentarz/pusta/błędna
+struct Step;
+bool parseProfileLine(char* line, Step& step);
+
+// ======================================================
+// [NEW] Write-back cache NVS
+// ======================================================
+struct NvsWriteStats {
+    uint32_t requestedTotal;     // wywołania setterów (= commity bez cache)
+    uint32_t commitsTotal;       // rzeczywiste nvs_commit
+    uint32_t requestedLastHour;
+    uint32_t commitsLastHour;
+    uint16_t pendingMask;        // klucze czekające na zapis
+};
+
+void storage_save_sensor_assignment_nvs(uint8_t chamberIdx, uint8_t meatIdx);
+
+// [NEW] Tablica nastaw PID komory (gain_sched.cpp) do zapisu w namespace "pid_gains"
+void storage_save_gain_table_nvs(uint8_t chamberIdx);
+
+// [NEW] Moce wyjść i taryfa (energy.cpp) do namespace "energy"
+void storage_save_energy_config_nvs();
+
+// Zapis wszystkich brudnych kluczy teraz (np. przed ESP.restart())
+bool storage_flush_nvs();
+
+// Nieblokujące żądanie flush – wykona je task Monitor (zmiana stanu procesu)
+void storage_request_nvs_flush();
+
+// Wywoływane cyklicznie z taskMonitor: czeka na żądanie max waitTicks,
+// flush po okresie ciszy
+void storage_nvs_service(TickType_t waitTicks);
+
+NvsWriteStats storage_get_nvs_write_stats();
+
+// Funkcje GitHub – lista i pobieranie w github_client.h (task Github)
+bool storage_load_github_profile(const char* profileName, uint8_t chamberIdx = 0);
 
 // Funkcje backup
 void storage_backup_config();
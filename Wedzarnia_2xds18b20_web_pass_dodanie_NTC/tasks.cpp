@@ -17,6 +17,20 @@
 #include "outputs.h"
 #include "web_server.h"
 #include "wifimanager.h"
+#include "github_client.h"
+#include "mqtt_telemetry.h"
+#include "storage.h"
+#include "framebuffer.h"
+#include "inputs.h"
+#include "alloc_track.h"
+#include "soak.h"
+#include "energy.h"
+#include "hardware.h"
+#include "boot_prof.h"
+#include "sd_clock.h"
+#include "sd_stats.h"
+#include <SD.h>
+#include <WiFi.h>
 #include <esp_task_wdt.h>
 
 
@@ -32,9 +46,17 @@ static TaskWatchdog taskWatchdogs[] = {
     {0, false, "UI"},
     {0, false, "Web"},
     {0, false, "WiFi"},
-    {0, false, "Monitor"}
+    {0, false, "Monitor"},
+    {0, false, "Safety"}
 };
 
+static constexpr int TASK_WATCHDOG_COUNT = sizeof(taskWatchdogs) / sizeof(taskWatchdogs[0]);
+
+// [NEW] Ekran i SD dzielą magistralę SPI, a hardware_init_sd() robi
+// SPI.end()/begin() – UI rysuje dopiero po starcie karty (taskBootStorage)
+static volatile bool uiReady = false;
+static SemaphoreHandle_t storageReady = NULL;
+
 static void watchdog_init() {
     esp_task_wdt_config_t wdt_config = {
         .timeout_ms = WDT_TIMEOUT * 1000,
@@ -47,6 +69,8 @@ static void watchdog_init() {
 
 static void checkTaskWatchdog(int taskIndex) {
     TaskWatchdog& wd = taskWatchdogs[taskIndex];
+    // [NEW] Taski sieci i UI startują w tle – jeszcze nie ruszyły
+    if (wd.lastReset == 0) return;
     TickType_t now = xTaskGetTickCount();
     if (now - wd.lastReset > pdMS_TO_TICKS(TASK_WATCHDOG_TIMEOUT)) {
         if (!wd.timeoutDetected) {
@@ -54,7 +78,12 @@ static void checkTaskWatchdog(int taskIndex) {
             LOG_FMT(LOG_LEVEL_ERROR, "%s task timeout detected!", wd.taskName);
             if (taskIndex == 0) {
                 allOutputsOff();
-                if (state_lock()) { g_currentState = ProcessState::IDLE; state_unlock(); }
+                if (state_lock()) {
+                    for (uint8_t c = 0; c < CFG_CHAMBER_COUNT; c++) {
+                        g_chambers[c].currentState = ProcessState::IDLE;
+                    }
+                    state_unlock();
+                }
             }
         }
     } else {
@@ -67,10 +96,15 @@ void taskControl(void* pv) {
     int taskIndex = 0;
     taskWatchdogs[taskIndex].lastReset = xTaskGetTickCount();
     log_msg(LOG_LEVEL_INFO, "Control task started");
+    bool firstTick = true;
     for (;;) {
         esp_task_wdt_reset();
         taskWatchdogs[taskIndex].lastReset = xTaskGetTickCount();
         process_run_control_logic();
+        if (firstTick) {
+            boot_prof_control_ready();
+            firstTick = false;
+        }
         checkTaskWatchdog(taskIndex);
         vTaskDelay(pdMS_TO_TICKS(100));
     }
@@ -86,12 +120,27 @@ void taskSensors(void* pv) {
         taskWatchdogs[taskIndex].lastReset = xTaskGetTickCount();
         requestTemperature();
         readTemperature();
-        checkDoor();
+        // [NEW] checkDoor() przeniesione do taskSafety (przerwanie drzwi)
         checkTaskWatchdog(taskIndex);
         vTaskDelay(pdMS_TO_TICKS(100));
     }
 }
 
+// [NEW] Najwyższy priorytet: budzony z ISR krańcówki drzwi, wyłącza SSR
+// bez czekania na 100 ms pętlę Sensors/Control
+void taskSafety(void* pv) {
+    esp_task_wdt_add(NULL);
+    int taskIndex = 6;
+    taskWatchdogs[taskIndex].lastReset = xTaskGetTickCount();
+    log_msg(LOG_LEVEL_INFO, "Safety task started");
+    for (;;) {
+        esp_task_wdt_reset();
+        taskWatchdogs[taskIndex].lastReset = xTaskGetTickCount();
+        inputs_door_process(pdMS_TO_TICKS(CFG_DOOR_RECHECK_MS));
+        checkTaskWatchdog(taskIndex);
+    }
+}
+
 void taskUI(void* pv) {
     esp_task_wdt_add(NULL);
     int taskIndex = 2;
@@ -100,9 +149,11 @@ void taskUI(void* pv) {
     for (;;) {
         esp_task_wdt_reset();
         taskWatchdogs[taskIndex].lastReset = xTaskGetTickCount();
-        ui_handle_buttons();
         handleBuzzer();
-        ui_update_display();
+        if (uiReady) {
+            ui_handle_buttons();
+            ui_update_display();
+        }
         checkTaskWatchdog(taskIndex);
         vTaskDelay(pdMS_TO_TICKS(50));
     }
@@ -145,6 +196,33 @@ void taskWiFi(void* pv) {
     }
 }
 
+void taskGithub(void* pv) {
+    // [NEW] Worker HTTPS dla profili GitHub. Bez WDT (jak taskWeb):
+    // pojedyncze pobranie może trwać do CFG_GITHUB_TIMEOUT_MS (handshake TLS
+    // + transfer), a UI i web tylko odpytują github_*_state().
+    log_msg(LOG_LEVEL_INFO, "GitHub task started");
+    for (;;) {
+        github_client_process(1000);
+    }
+}
+
+void taskMqtt(void* pv) {
+    // [NEW] Telemetria MQTT. Bez WDT (jak taskGithub): zapis zaległości na SD
+    // i publikacja QoS 1 mogą chwilę blokować, sterowanie od tego nie zależy.
+    log_msg(LOG_LEVEL_INFO, "MQTT task started");
+    for (;;) {
+        mqtt_telemetry_process(100);
+    }
+}
+
+// [NEW] Skan zajętości karty (f_getfree przez całą FAT, sekundy na 32 GB).
+// Najniższy priorytet i bez WDT – WWW czyta tylko kopię z sd_stats_get()
+static void taskSdStats(void* pv) {
+    for (;;) {
+        sd_stats_process(10000);
+    }
+}
+
 void taskMonitor(void* pv) {
     esp_task_wdt_add(NULL);
     int taskIndex = 5;
@@ -159,17 +237,25 @@ void taskMonitor(void* pv) {
         unsigned long now = millis();
         if (now - lastHeapLog > 60000) {
             lastHeapLog = now;
-            uint32_t freeHeap = ESP.getFreeHeap();
-            uint32_t minHeap  = ESP.getMinFreeHeap();
-            LOG_FMT(LOG_LEVEL_INFO, "[HEAP] Free: %u B, Min: %u B", freeHeap, minHeap);
-            if (freeHeap < HEAP_WARNING_THRESHOLD) {
+            // [NEW] Największy wolny blok – przy długim wsadzie sterta może mieć
+            // dość wolnej pamięci, ale zbyt rozdrobnionej na bufor JSON/TLS
+            HeapSnapshot heap;
+            alloc_track_snapshot(heap);
+            uint8_t fragPct = alloc_track_fragmentation_pct(heap);
+            LOG_FMT(LOG_LEVEL_INFO, "[HEAP] Free: %u B, Min: %u B, Largest: %u B, Frag: %u%%",
+                    (unsigned)heap.freeBytes, (unsigned)heap.minFreeBytes,
+                    (unsigned)heap.largestFreeBlock, fragPct);
+            if (heap.freeBytes < HEAP_WARNING_THRESHOLD) {
                 log_msg(LOG_LEVEL_WARN, "!!! LOW MEMORY WARNING !!!");
                 buzzerBeep(2, 100, 100);
+            } else if (heap.largestFreeBlock < HEAP_LARGEST_BLOCK_WARNING ||
+                       fragPct > HEAP_FRAGMENTATION_WARNING_PCT) {
+                log_msg(LOG_LEVEL_WARN, "!!! HEAP FRAGMENTATION WARNING !!!");
             }
         }
         if (now - lastWatchdogCheck > 10000) {
             lastWatchdogCheck = now;
-            for (int i = 0; i < 6; i++) {
+            for (int i = 0; i < TASK_WATCHDOG_COUNT; i++) {
                 checkTaskWatchdog(i);
                 if (taskWatchdogs[i].timeoutDetected)
                     LOG_FMT(LOG_LEVEL_ERROR, "%s task is hung!", taskWatchdogs[i].taskName);
@@ -177,18 +263,30 @@ void taskMonitor(void* pv) {
         }
         if (now - lastStatsLog > 300000) {
             lastStatsLog = now;
-            if (state_lock()) {
-                ProcessStats stats = g_processStats;
+            // [NEW] Statystyki każdej komory (K1, K2...)
+            for (uint8_t c = 0; c < CFG_CHAMBER_COUNT; c++) {
+                if (!state_lock()) break;
+                ProcessStats stats = g_chambers[c].processStats;
                 state_unlock();
                 if (stats.totalRunTime > 0) {
                     unsigned long runHours    = stats.totalRunTime / 3600000;
                     unsigned long runMins     = (stats.totalRunTime % 3600000) / 60000;
                     unsigned long heatPercent = (stats.activeHeatingTime * 100) / stats.totalRunTime;
-                    LOG_FMT(LOG_LEVEL_INFO, "[STATS] Runtime: %luh %lum", runHours, runMins);
-                    LOG_FMT(LOG_LEVEL_INFO, "[STATS] Heating: %lu%%, Avg: %.1f C", heatPercent, stats.avgTemp);
-                    LOG_FMT(LOG_LEVEL_INFO, "[STATS] Steps: %d, Pauses: %d", stats.stepChanges, stats.pauseCount);
+                    LOG_FMT(LOG_LEVEL_INFO, "[STATS K%u] Runtime: %luh %lum", c + 1, runHours, runMins);
+                    LOG_FMT(LOG_LEVEL_INFO, "[STATS K%u] Heating: %lu%%, Avg: %.1f C", c + 1, heatPercent, stats.avgTemp);
+                    LOG_FMT(LOG_LEVEL_INFO, "[STATS K%u] Steps: %d, Pauses: %d", c + 1, stats.stepChanges, stats.pauseCount);
                 }
             }
+            // [NEW] Zapisy NVS: żądane przez settery vs rzeczywiste commity
+            NvsWriteStats nvsStats = storage_get_nvs_write_stats();
+            LOG_FMT(LOG_LEVEL_INFO, "[NVS] Writes/h: requested %lu, committed %lu (total %lu/%lu)",
+                    (unsigned long)nvsStats.requestedLastHour, (unsigned long)nvsStats.commitsLastHour,
+                    (unsigned long)nvsStats.requestedTotal, (unsigned long)nvsStats.commitsTotal);
+            // [NEW] Koszt odświeżania TFT przez bufor ramki
+            FrameStats fbStats = framebuffer_get_stats();
+            LOG_FMT(LOG_LEVEL_INFO, "[UI] Frame avg %lu us, max %lu us, SPI %lu B/s",
+                    (unsigned long)fbStats.avgFrameUs, (unsigned long)fbStats.maxFrameUs,
+                    (unsigned long)fbStats.spiBytesPerSec);
             if (wifi_is_connected()) {
                 WiFiStats wifiStats = wifi_get_stats();
                 LOG_FMT(LOG_LEVEL_INFO, "[WiFi] Up: %luh, Down: %luh, Disconnects: %d",
@@ -196,33 +294,109 @@ void taskMonitor(void* pv) {
             }
         }
         checkTaskWatchdog(taskIndex);
-        vTaskDelay(pdMS_TO_TICKS(5000));
+        // [NEW] Rekordy energii zakończonych wsadów – SD poza taktem sterowania
+        energy_write_records();
+        // [NEW] Seria błędów I/O karty → wolniejszy zegar SPI
+        sd_clock_service();
+        // [NEW] Zamiast vTaskDelay(5000): obsługa write-back cache NVS.
+        // Czeka na żądanie flush (zmiana stanu, WiFi/auth) max 1 s.
+        storage_nvs_service(pdMS_TO_TICKS(1000));
     }
 }
 
+// [NEW] Start w tle: ekran → SD → UI. Bez WDT (jak taskGithub) – plansza
+// startowa i ponowienia SD trwają dłużej niż WDT_TIMEOUT
+static void taskBootStorage(void* pv) {
+    uint32_t t = boot_prof_now();
+    hardware_init_display();
+    boot_prof_stage("display", t);
+
+    t = boot_prof_now();
+    hardware_init_sd();
+    boot_prof_stage("sd", t);
+
+    sd_stats_init();
+    xTaskCreatePinnedToCore(taskSdStats, "SdStats", 3072, NULL, tskIDLE_PRIORITY, NULL, 0);
+
+    uiReady = true;
+    xSemaphoreGive(storageReady);
+    vTaskDelete(NULL);
+}
+
+// [NEW] Start w tle: WiFi → (po SD) WWW → GitHub → MQTT. Negocjacja zegara
+// SD montuje kartę kilka razy – handlery WWW i spool MQTT dopiero po niej
+static void taskBootNet(void* pv) {
+    uint32_t t = boot_prof_now();
+    hardware_init_wifi();
+    xTaskCreatePinnedToCore(taskWiFi,    "WiFi",    4096,  NULL, 1, NULL, 0);
+    boot_prof_stage("wifi", t);
+
+    // [FIX] Po limicie WWW startuje i tak – jego dostęp do karty czeka na
+    // blokadę (hal_fs_lock) trzymaną przez montaż i negocjację zegara
+    if (xSemaphoreTake(storageReady, pdMS_TO_TICKS(CFG_BOOT_STORAGE_WAIT_MS)) != pdTRUE) {
+        log_msg(LOG_LEVEL_WARN, "[BOOT] SD init still running - starting web without it");
+    }
+
+    t = boot_prof_now();
+    web_server_init();
+    // [OTA FIX] taskWeb bez WDT – patrz komentarz w taskWeb()
+    xTaskCreatePinnedToCore(taskWeb,     "Web",     10240, NULL, 1, NULL, 0);
+    boot_prof_stage("web", t);
+
+    // [NEW] WiFiClientSecure wymaga ~8KB stosu – tylko tutaj
+    t = boot_prof_now();
+    xTaskCreatePinnedToCore(taskGithub,  "Github",  8192,  NULL, 1, NULL, 0);
+    boot_prof_stage("github", t);
+
+    t = boot_prof_now();
+    mqtt_telemetry_init();
+    // [NEW] Próbki, kolejka offline i komendy MQTT (klient esp-mqtt ma własny task)
+    xTaskCreatePinnedToCore(taskMqtt,    "Mqtt",    4096,  NULL, 1, NULL, 0);
+    boot_prof_stage("mqtt", t);
+
+    LOG_FMT(LOG_LEVEL_INFO, "[SYS] Free heap: %u bytes, min %u bytes, CPU %u MHz",
+            (unsigned)ESP.getFreeHeap(), (unsigned)ESP.getMinFreeHeap(), (unsigned)ESP.getCpuFreqMHz());
+    LOG_FMT(LOG_LEVEL_INFO, "[SYS] SD Card: %s, Sensors: %d, WiFi: %s",
+            SD.cardType() != CARD_NONE ? "OK" : "ERROR", sensors.getDeviceCount(),
+            WiFi.status() == WL_CONNECTED ? "CONNECTED" : "AP MODE");
+    boot_prof_finish();
+    buzzerBeep(3, 150, 100);
+    vTaskDelete(NULL);
+}
+
 void tasks_create_all() {
     watchdog_init();
+    // Kolejka zleceń przed startem WWW i UI (github_request_*)
+    github_client_init();
+    // [NEW] Przerwania przycisków i drzwi – przed startem UI i Safety
+    inputs_init();
+    storageReady = xSemaphoreCreateBinary();
 
     // Core 1: zadania krytyczne
+    // [NEW] Safety: tylko obsługa drzwi, priorytet ponad Control
+    xTaskCreatePinnedToCore(taskSafety,  "Safety",  3072,  NULL, 4, NULL, 1);
     xTaskCreatePinnedToCore(taskControl, "Control", 4096,  NULL, 3, NULL, 1);
     xTaskCreatePinnedToCore(taskSensors, "Sensors", 5120,  NULL, 2, NULL, 1);
-    // [FIX] 4096 → 10240: WiFiClientSecure (HTTPS) dla GitHub wymaga ~8KB stosu.
-    xTaskCreatePinnedToCore(taskUI,      "UI",      10240, NULL, 2, NULL, 1);
+    // [FIX] 10240 → 5120: HTTPS dla GitHub przeniesione do taskGithub
+    // [NEW] Od razu – brzęczyk; przyciski i ekran po taskBootStorage
+    xTaskCreatePinnedToCore(taskUI,      "UI",      5120,  NULL, 2, NULL, 1);
 
-    // Core 0: sieć i monitoring
-    // [OTA FIX] taskWeb bez WDT – patrz komentarz w taskWeb()
-    xTaskCreatePinnedToCore(taskWeb,     "Web",     10240, NULL, 1, NULL, 0);
-    xTaskCreatePinnedToCore(taskWiFi,    "WiFi",    4096,  NULL, 1, NULL, 0);
-    xTaskCreatePinnedToCore(taskMonitor, "Monitor", 4096,  NULL, 1, NULL, 0);
+    // Core 0: monitoring, reszta startu w tle
+    // [NEW] 4096 → 5120: Monitor wykonuje też flush write-back cache NVS
+    xTaskCreatePinnedToCore(taskMonitor, "Monitor", 5120,  NULL, 1, NULL, 0);
+    xTaskCreatePinnedToCore(taskBootStorage, "BootSD",  4096, NULL, 1, NULL, 0);
+    xTaskCreatePinnedToCore(taskBootNet,     "BootNet", 6144, NULL, 1, NULL, 0);
+    // [NEW] Test długiego wsadu – tylko przy CFG_SOAK_MODE
+    if (CFG_SOAK_MODE) soak_start();
 
-    log_msg(LOG_LEVEL_INFO, "All tasks created successfully");
+    log_msg(LOG_LEVEL_INFO, "Critical tasks created, storage and network starting in background");
 }
 
 String getTaskWatchdogStatus() {
     char buffer[384];
     int offset = 0;
     offset += snprintf(buffer + offset, sizeof(buffer) - offset, "Task Watchdogs:\n");
-    for (int i = 0; i < 6; i++) {
+    for (int i = 0; i < TASK_WATCHDOG_COUNT; i++) {
         TickType_t now = xTaskGetTickCount();
         unsigned long age = (now - taskWatchdogs[i].lastReset) * portTICK_PERIOD_MS;
         offset += snprintf(buffer + offset, sizeof(buffer) - offset,
@@ -0,0 +1,205 @@
+// trend.cpp - [NEW] Zdecymowana historia temperatur + rysowanie wykresu
+// – temperatury kwantowane do 0.5 C w uint8_t (0 = brak danych, max 127.5 C)
+// – każda kolumna trzyma min/max komory i mięsa oraz ostatnią wartość zadaną,
+//   więc oscylacje krótsze niż okres kolumny nadal są widoczne jako pionowa kreska
+// – przy nowej kolumnie fragment bufora ramki jest przesuwany w lewo
+//   i dorysowywane są tylko ostatnie kolumny (framebuffer_scroll_left)
+#include "trend.h"
+#include "config.h"
+#include "framebuffer.h"
+#include <Adafruit_ST7735.h>
+#include <math.h>
+
+static constexpr int TREND_COLUMNS = 128;
+static constexpr uint16_t TREND_GRID_COLOR = 0x2104;
+
+struct TrendColumn {
+    uint8_t chamberMin;
+    uint8_t chamberMax;
+    uint8_t meatMin;
+    uint8_t meatMax;
+    uint8_t set;
+};
+
+struct TrendSeries {
+    uint32_t periodMs;                 // czas jednej kolumny
+    TrendColumn cols[TREND_COLUMNS];
+    uint8_t head;                      // pozycja następnej zatwierdzonej kolumny
+    uint8_t count;
+    TrendColumn acc;                   // kolumna w trakcie zbierania (prawa krawędź)
+    unsigned long accStart;
+    bool started;
+    uint32_t committed;                // licznik zatwierdzonych kolumn
+};
+
+static TrendSeries series[(int)TrendWindow::COUNT] = {
+    { 15UL * 60UL * 1000UL / TREND_COLUMNS, {}, 0, 0, {}, 0, false, 0 },
+    { 60UL * 60UL * 1000UL / TREND_COLUMNS, {}, 0, 0, {}, 0, false, 0 },
+    { 6UL * 60UL * 60UL * 1000UL / TREND_COLUMNS, {}, 0, 0, {}, 0, false, 0 }
+};
+
+static const char* const windowLabels[(int)TrendWindow::COUNT] = {"15min", "1h", "6h"};
+
+// Stan ostatnio narysowanego wykresu (rysowanie przyrostowe)
+struct TrendView {
+    TrendWindow win;
+    uint32_t committed;
+    int16_t lo, hi;
+    int16_t x, y, w, h;
+};
+
+static TrendView view = {TrendWindow::COUNT, 0, 0, 0, 0, 0, 0, 0};
+
+// ======================================================
+// ZBIERANIE PRÓBEK
+// ======================================================
+
+static uint8_t quantize(double t) {
+    if (isnan(t) || t < 0.5) return 0;
+    if (t >= 127.5) return 255;
+    return (uint8_t)(t * 2.0 + 0.5);
+}
+
+static void accumulate(uint8_t& mn, uint8_t& mx, uint8_t q) {
+    if (!q) return;
+    if (!mn || q < mn) mn = q;
+    if (q > mx) mx = q;
+}
+
+static void commitColumn(TrendSeries& s) {
+    s.cols[s.head] = s.acc;
+    s.head = (s.head + 1) % TREND_COLUMNS;
+    if (s.count < TREND_COLUMNS) s.count++;
+    s.committed++;
+    memset(&s.acc, 0, sizeof(s.acc));
+}
+
+void trend_add_sample(double tChamber, double tMeat, double tSet) {
+    unsigned long now = millis();
+    uint8_t qc = quantize(tChamber);
+    uint8_t qm = quantize(tMeat);
+    uint8_t qs = quantize(tSet);
+
+    for (TrendSeries& s : series) {
+        if (!s.started) {
+            s.accStart = now;
+            s.started = true;
+        }
+        // Przerwa w próbkach (blokujący ekran ustawień) = puste kolumny
+        int guard = 0;
+        while (now - s.accStart >= s.periodMs) {
+            if (guard++ >= TREND_COLUMNS) {
+                s.accStart = now;
+                break;
+            }
+            commitColumn(s);
+            s.accStart += s.periodMs;
+        }
+        accumulate(s.acc.chamberMin, s.acc.chamberMax, qc);
+        accumulate(s.acc.meatMin, s.acc.meatMax, qm);
+        if (qs) s.acc.set = qs;
+    }
+}
+
+// ======================================================
+// RYSOWANIE
+// ======================================================
+
+// Kolumna na pozycji p (0..w-1); p = w-1 to kolumna bieżąca
+static const TrendColumn* columnAt(const TrendSeries& s, int16_t w, int16_t p) {
+    static const TrendColumn empty = {0, 0, 0, 0, 0};
+    if (p == w - 1) return &s.acc;
+    int back = (w - 2) - p;
+    if (back >= s.count) return &empty;
+    return &s.cols[(s.head - 1 - back + TREND_COLUMNS) % TREND_COLUMNS];
+}
+
+static void computeRange(const TrendSeries& s, int16_t w, int16_t& lo, int16_t& hi) {
+    uint8_t mn = 255, mx = 0;
+    for (int16_t p = 0; p < w; p++) {
+        const TrendColumn* c = columnAt(s, w, p);
+        const uint8_t lows[] = {c->chamberMin, c->meatMin, c->set};
+        const uint8_t highs[] = {c->chamberMax, c->meatMax, c->set};
+        for (uint8_t v : lows) if (v && v < mn) mn = v;
+        for (uint8_t v : highs) if (v > mx) mx = v;
+    }
+    if (mx == 0) {
+        lo = 20;
+        hi = 80;
+        return;
+    }
+    // Skala w pełnych 10 C – zmienia się rzadko, więc rzadko wymusza pełne rysowanie
+    lo = ((mn / 2) / 10) * 10;
+    hi = ((mx / 2 + 9) / 10) * 10;
+    if (hi - lo < 10) hi = lo + 10;
+}
+
+static int16_t valueToY(int16_t halfDeg, const TrendView& v) {
+    // halfDeg – wartość w jednostkach 0.5 C
+    int32_t span = (int32_t)(v.hi - v.lo) * 2;
+    int32_t off = (int32_t)halfDeg - v.lo * 2;
+    int16_t yy = v.y + v.h - 1 - (int16_t)(off * (v.h - 1) / span);
+    if (yy < v.y) yy = v.y;
+    if (yy > v.y + v.h - 1) yy = v.y + v.h - 1;
+    return yy;
+}
+
+static void drawRange(Adafruit_GFX& gfx, int16_t px, uint8_t mn, uint8_t mx,
+                      const TrendView& v, uint16_t color) {
+    if (!mn) return;
+    int16_t yTop = valueToY(mx, v);
+    int16_t yBottom = valueToY(mn, v);
+    gfx.drawFastVLine(px, yTop, yBottom - yTop + 1, color);
+}
+
+static void drawColumn(Adafruit_GFX& gfx, const TrendColumn* c, int16_t p, const TrendView& v) {
+    int16_t px = v.x + p;
+    gfx.drawFastVLine(px, v.y, v.h, ST77XX_BLACK);
+    for (int16_t g = v.lo + 10; g < v.hi; g += 10) {
+        gfx.drawPixel(px, valueToY(g * 2, v), TREND_GRID_COLOR);
+    }
+    drawRange(gfx, px, c->meatMin, c->meatMax, v, ST77XX_YELLOW);
+    drawRange(gfx, px, c->chamberMin, c->chamberMax, v, ST77XX_ORANGE);
+    if (c->set) gfx.drawPixel(px, valueToY(c->set, v), ST77XX_CYAN);
+}
+
+void trend_draw(Adafruit_GFX& gfx, TrendWindow win,
+                int16_t x, int16_t y, int16_t w, int16_t h, bool full) {
+    if (win >= TrendWindow::COUNT) return;
+    if (w > TREND_COLUMNS) w = TREND_COLUMNS;
+    if (w < 2 || h < 2) return;
+
+    const TrendSeries& s = series[(int)win];
+    TrendView next = {win, s.committed, 0, 0, x, y, w, h};
+    computeRange(s, w, next.lo, next.hi);
+
+    bool redrawAll = full || view.win != win || view.lo != next.lo || view.hi != next.hi ||
+                     view.x != x || view.y != y || view.w != w || view.h != h;
+    uint32_t added = s.committed - view.committed;
+
+    int16_t from = w - 1;   // domyślnie tylko bieżąca kolumna
+    if (!redrawAll && added > 0) {
+        if (added >= (uint32_t)(w - 1) || !framebuffer_scroll_left(x, y, w, h, (int16_t)added)) {
+            redrawAll = true;
+        } else {
+            // Kolumny zatwierdzone od ostatniej ramki (w tym dotychczasowa bieżąca)
+            from = w - 1 - (int16_t)added;
+        }
+    }
+    if (redrawAll) from = 0;
+
+    for (int16_t p = from; p < w; p++) {
+        drawColumn(gfx, columnAt(s, w, p), p, next);
+    }
+    view = next;
+}
+
+void trend_legend(TrendWindow win, char* out, size_t outSize) {
+    if (win >= TrendWindow::COUNT) {
+        snprintf(out, outSize, "-");
+        return;
+    }
+    int16_t lo = view.lo, hi = view.hi;
+    if (view.win != win) computeRange(series[(int)win], TREND_COLUMNS, lo, hi);
+    snprintf(out, outSize, "%s %d-%dC", windowLabels[(int)win], lo, hi);
+}
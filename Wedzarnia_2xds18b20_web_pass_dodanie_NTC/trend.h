@@ -0,0 +1,24 @@
+// trend.h - [NEW] Wykres trendu temperatur na TFT (sparkline)
+// Każde okno (15 min / 1 h / 6 h) ma 128 kolumn min/max po 5 B (640 B),
+// próbki są decymowane na bieżąco, a wykres przesuwany o nowe kolumny.
+#pragma once
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+
+enum class TrendWindow : uint8_t {
+    MIN_15,
+    HOUR_1,
+    HOUR_6,
+    COUNT
+};
+
+// Próbka z taska UI (NAN / wartość < 0.5 C = brak danych, np. setpoint w IDLE)
+void trend_add_sample(double tChamber, double tMeat, double tSet);
+
+// Rysuje wykres w prostokącie (w <= 128). full=false – przesunięcie o kolumny
+// dodane od ostatniego wywołania i dorysowanie tylko ich
+void trend_draw(Adafruit_GFX& gfx, TrendWindow win,
+                int16_t x, int16_t y, int16_t w, int16_t h, bool full);
+
+// Opis okna i zakres osi Y ostatnio narysowanego wykresu, np. "1h 40-90C"
+void trend_legend(TrendWindow win, char* out, size_t outSize);
@@ -7,6 +7,11 @@
 #include "storage.h"
 #include "process.h"
 #include "sensors.h"
+#include "github_client.h"
+#include "framebuffer.h"
+#include "trend.h"
+#include "inputs.h"
+#include "energy.h"
 #include <climits>
 #include <vector>
 #include <ArduinoJson.h>
@@ -24,6 +29,11 @@ static constexpr int SOURCE_MENU_ITEMS = 2;
 static std::vector<String> profileList;
 static int profileMenuIndex = 0;
 static bool profilesLoading = false;
+// [NEW] Stan zleceń do taska Github (UI tylko odpytuje, nie blokuje)
+static bool githubListRequested = false;
+static bool githubFetchPending = false;
+static uint8_t githubFetchChamber = 0;   // [FIX] komora, do której idzie profil
+static bool githubFetchFailed = false;
 static int manualEditIndex = 0;
 static constexpr int MANUAL_EDIT_ITEMS = 5;
 static bool editingFanOnTime = true;
@@ -31,6 +41,12 @@ static bool confirmSelection = false;
 static bool force_redraw = true;
 static unsigned long lastFullRedraw = 0;
 static unsigned long lastUserActivity = 0;
+// [NEW] Cel rysowania: bufor ramki (framebuffer.h) albo awaryjnie sam display
+static Adafruit_GFX* tft = &display;
+// [NEW] Wykres trendu na dashboardzie: 0 = wyłączony, 1..3 = TrendWindow + 1
+static int trendView = 0;
+// [NEW] Komora pokazywana i sterowana z panelu (długie ENTER na ekranie głównym)
+static uint8_t uiChamber = 0;
 
 // Nowe zmienne dla menu ustawien systemowych
 static int systemSettingsIndex = 0;
@@ -50,10 +66,13 @@ struct DisplayCache {
     double chamberTemp = -99.0;
     double meatTemp = -99.0;
     double setTemp = -99.0;
-    String stateString = "";
-    String stepName = "";
-    String elapsedStr = "";
-    String remainingStr = "";
+    // [FIX] Bufory stałe zamiast String – brak alokacji na stercie co klatkę
+    char stateString[24] = "";
+    char stepName[48] = "";
+    char elapsedStr[24] = "";
+    char remainingStr[24] = "";
+    char etaStr[24] = "";
+    char energyStr[24] = "";
     unsigned long lastUpdate = 0;
     bool needsRedraw = true;
 };
@@ -64,49 +83,51 @@ static DisplayCache displayCache;
 // FUNKCJE POMOCNICZE DLA WYSWIETLACZA
 // ============================================================
 
-static int calculateTextWidth(const String& text, int size) {
-    return text.length() * (size == 1 ? 6 : 12);
+static int calculateTextWidth(const char* text, int size) {
+    return strlen(text) * (size == 1 ? 6 : 12);
 }
 
 static void updateTextAutoSize(int16_t x, int16_t y, int16_t maxWidth, 
-                              const String& oldText, const String& newText, 
+                              const char* oldText, const char* newText, 
                               uint16_t color) {
-    if (oldText == newText && !force_redraw && !displayCache.needsRedraw) return;
+    if (strcmp(oldText, newText) == 0 && !force_redraw && !displayCache.needsRedraw) return;
     
-    int textWidth = newText.length() * 12;
+    int textWidth = calculateTextWidth(newText, 2);
     uint8_t textSize = 1;
     uint8_t textHeight = 8;
     
-    if (textWidth <= maxWidth && newText.length() <= 10) {
+    if (textWidth <= maxWidth && strlen(newText) <= 10) {
         textSize = 2;
         textHeight = 16;
     }
     
-    display.setTextSize(textSize);
-    display.fillRect(x, y, maxWidth, textHeight, ST77XX_BLACK);
-    display.setCursor(x, y);
-    display.setTextColor(color);
-    display.print(newText);
+    tft->setTextSize(textSize);
+    tft->fillRect(x, y, maxWidth, textHeight, ST77XX_BLACK);
+    tft->setCursor(x, y);
+    tft->setTextColor(color);
+    tft->print(newText);
 }
 
 static void updateText(int16_t x, int16_t y, int16_t w, int16_t h, 
-                      const String& oldText, const String& newText, 
+                      const char* oldText, const char* newText, 
                       uint16_t color, uint8_t textSize) {
-    if (oldText != newText || force_redraw || displayCache.needsRedraw) {
-        display.setTextSize(textSize);
-        display.fillRect(x, y, w, h, ST77XX_BLACK);
-        display.setCursor(x, y);
-        display.setTextColor(color);
-        display.print(newText);
+    if (strcmp(oldText, newText) != 0 || force_redraw || displayCache.needsRedraw) {
+        tft->setTextSize(textSize);
+        tft->fillRect(x, y, w, h, ST77XX_BLACK);
+        tft->setCursor(x, y);
+        tft->setTextColor(color);
+        tft->print(newText);
         
-        // Debug log
-        log_msg(LOG_LEVEL_DEBUG, 
-                String("updateText: ") + oldText + " -> " + newText + 
-                " size:" + textSize + " at (" + x + "," + y + ")");
+        // Debug log – [FIX] LOG_FMT: bez sklejania String, gdy DEBUG wyłączony nic się nie formatuje
+        LOG_FMT(LOG_LEVEL_DEBUG, "updateText: %s -> %s size:%u at (%d,%d)",
+                oldText, newText, textSize, x, y);
     }
 }
 
 void ui_init() {
+    // [NEW] Ekran składany w RAM, na TFT idą tylko zmienione kafelki
+    framebuffer_init();
+    tft = &framebuffer_gfx();
     lastUserActivity = millis();
     displayCache.lastUpdate = millis();
     systemSettingsIndex = 0;
@@ -131,6 +152,7 @@ const char* getStateStringForDisplay(ProcessState st) {
         case ProcessState::PAUSE_USER:         return "PAUZA";
         case ProcessState::ERROR_PROFILE:      return "Blad Profilu";
         case ProcessState::SOFT_RESUME:        return "Wznawianie...";
+        case ProcessState::AUTOTUNE:           return "Autotune";         // [NEW]
         default:                               return "Nieznany";
     }
 }
@@ -142,29 +164,20 @@ void formatTime(char* buf, size_t len, unsigned long totalSeconds) {
     snprintf(buf, len, "%02d:%02d:%02d", hours, minutes, seconds);
 }
 
-static void ui_transition_effect(bool forward) {
-    if (!force_redraw) return;
-    
-    for (int i = 0; i < SCREEN_WIDTH; i += 4) {
-        if (forward) {
-            display.drawFastVLine(i, 0, SCREEN_HEIGHT, ST77XX_BLACK);
-        } else {
-            display.drawFastVLine(SCREEN_WIDTH - i, 0, SCREEN_HEIGHT, ST77XX_BLACK);
-        }
-        delay(1);
-    }
-}
-
 static void showDiagnosticsScreen() {
-    display.setTextSize(1);
-    display.setCursor(0, 80);
-    display.printf("Pamiec: %d B", ESP.getFreeHeap());
-    display.setCursor(0, 95);
-    display.printf("WiFi: %s", WiFi.status() == WL_CONNECTED ? "OK" : "OFF");
-    display.setCursor(0, 110);
-    display.printf("Karta SD: %s", SD.cardType() != CARD_NONE ? "OK" : "ERR");
-    display.setCursor(0, 125);
-    display.printf("Czas pracy: %lu s", millis() / 1000);
+    tft->setTextSize(1);
+    tft->setCursor(0, 80);
+    tft->printf("Pamiec: %d B", ESP.getFreeHeap());
+    tft->setCursor(0, 95);
+    tft->printf("WiFi: %s", WiFi.status() == WL_CONNECTED ? "OK" : "OFF");
+    tft->setCursor(0, 110);
+    tft->printf("Karta SD: %s", SD.cardType() != CARD_NONE ? "OK" : "ERR");
+    tft->setCursor(0, 125);
+    tft->printf("Czas pracy: %lu s", millis() / 1000);
+    // [NEW] Koszt odświeżania ekranu (ostatnia ramka / transfer SPI)
+    FrameStats fs = framebuffer_get_stats();
+    tft->setCursor(0, 137);
+    tft->printf("Ramka:%luus %luB/s", (unsigned long)fs.avgFrameUs, (unsigned long)fs.spiBytesPerSec);
 }
 
 // ============================================================
@@ -201,16 +214,17 @@ static void checkAuthResetHold() {
             int progress = map(held, 1000, CFG_AUTH_RESET_HOLD_MS, 0, 100);
 
             // Narysuj pasek postępu w dolnej części ekranu
-            display.fillRect(0, 152, SCREEN_WIDTH, 8, ST77XX_BLACK);
-            display.fillRect(0, 152, (SCREEN_WIDTH * progress) / 100, 8, ST77XX_RED);
+            tft->fillRect(0, 152, SCREEN_WIDTH, 8, ST77XX_BLACK);
+            tft->fillRect(0, 152, (SCREEN_WIDTH * progress) / 100, 8, ST77XX_RED);
 
             // Etykieta tylko raz przy starcie
             if (held < 1100) {
-                display.setTextSize(1);
-                display.setTextColor(ST77XX_RED);
-                display.setCursor(15, 142);
-                display.print("Reset hasla...");
+                tft->setTextSize(1);
+                tft->setTextColor(ST77XX_RED);
+                tft->setCursor(15, 142);
+                tft->print("Reset hasla...");
             }
+            framebuffer_flush();
         }
 
         // Po upływie czasu – wykonaj reset
@@ -220,14 +234,15 @@ static void checkAuthResetHold() {
             storage_reset_auth_nvs();
 
             // Wyczyść obszar i pokaż komunikat
-            display.fillRect(0, 130, SCREEN_WIDTH, 30, ST77XX_BLACK);
-            display.setTextSize(1);
-            display.setTextColor(ST77XX_GREEN);
-            display.setCursor(5, 138);
-            display.print("Haslo zresetowane!");
-            display.setCursor(5, 150);
-            display.print("Login: ");
-            display.print(CFG_AUTH_DEFAULT_USER);
+            tft->fillRect(0, 130, SCREEN_WIDTH, 30, ST77XX_BLACK);
+            tft->setTextSize(1);
+            tft->setTextColor(ST77XX_GREEN);
+            tft->setCursor(5, 138);
+            tft->print("Haslo zresetowane!");
+            tft->setCursor(5, 150);
+            tft->print("Login: ");
+            tft->print(CFG_AUTH_DEFAULT_USER);
+            framebuffer_flush();
 
             buzzerBeep(3, 200, 100);
 
@@ -245,74 +260,77 @@ static void checkAuthResetHold() {
 
 
 static void handleSystemSettingsAction() {
-    display.fillScreen(ST77XX_BLACK);
-    display.setTextSize(1);
-    display.setTextColor(ST77XX_WHITE);
+    tft->fillScreen(ST77XX_BLACK);
+    tft->setTextSize(1);
+    tft->setTextColor(ST77XX_WHITE);
     
     char buffer[128];
     
     switch(systemSettingsIndex) {
         case 0: // WiFi
             log_msg(LOG_LEVEL_INFO, "Opening WiFi settings...");
-            display.setCursor(10, 20);
-            display.print("USTAWIENIA WiFi");
-            display.drawFastHLine(10, 35, 108, ST77XX_WHITE);
+            tft->setCursor(10, 20);
+            tft->print("USTAWIENIA WiFi");
+            tft->drawFastHLine(10, 35, 108, ST77XX_WHITE);
             
-            display.setCursor(10, 50);
+            tft->setCursor(10, 50);
             snprintf(buffer, sizeof(buffer), "Status: %s", 
                      WiFi.status() == WL_CONNECTED ? "Polaczono" : "Rozlaczono");
-            display.print(buffer);
+            tft->print(buffer);
             
             if (WiFi.status() == WL_CONNECTED) {
-                display.setCursor(10, 65);
-                display.print("IP: " + WiFi.localIP().toString());
-                display.setCursor(10, 80);
-                display.print("SSID: " + String(storage_get_wifi_ssid()));
+                tft->setCursor(10, 65);
+                tft->print("IP: " + WiFi.localIP().toString());
+                tft->setCursor(10, 80);
+                tft->print("SSID: " + String(storage_get_wifi_ssid()));
             }
             
-            display.setCursor(10, 100);
-            display.print("1. Zmien SSID/Haslo");
-            display.setCursor(10, 115);
-            display.print("2. Wlacz/Wylacz");
-            display.setCursor(10, 130);
-            display.print("3. Skanuj sieci");
+            tft->setCursor(10, 100);
+            tft->print("1. Zmien SSID/Haslo");
+            tft->setCursor(10, 115);
+            tft->print("2. Wlacz/Wylacz");
+            tft->setCursor(10, 130);
+            tft->print("3. Skanuj sieci");
             
-            display.setCursor(10, 150);
-            display.print("ENTER-wybierz  EXIT-powrot");
+            tft->setCursor(10, 150);
+            tft->print("ENTER-wybierz  EXIT-powrot");
             
             currentUiState = UiState::UI_STATE_WIFI_SETTINGS;
             wifiSettingsIndex = 0;
             inSubMenu = true;
+            framebuffer_flush();
             delay(100);
             break;
             
         case 1: // Kalibracja
             log_msg(LOG_LEVEL_INFO, "Starting sensor calibration...");
-            display.setCursor(10, 50);
-            display.print("KALIBRACJA");
-            display.drawFastHLine(10, 65, 108, ST77XX_YELLOW);
+            tft->setCursor(10, 50);
+            tft->print("KALIBRACJA");
+            tft->drawFastHLine(10, 65, 108, ST77XX_YELLOW);
             
-            display.setCursor(10, 85);
-            display.print("Identyfikacja czujnikow...");
+            tft->setCursor(10, 85);
+            tft->print("Identyfikacja czujnikow...");
+            framebuffer_flush();
             
             // Wymus ponowne przypisanie czujnikow
             identifyAndAssignSensors();
             
-            display.setCursor(10, 105);
+            tft->setCursor(10, 105);
             if (areSensorsIdentified()) {
-                display.print("Kalibracja OK!");
-                display.setCursor(10, 120);
-                display.print("Czujnik 0: Komora");
-                display.setCursor(10, 135);
-                display.print("Czujnik 1: Mieso");
+                tft->print("Kalibracja OK!");
+                tft->setCursor(10, 120);
+                tft->print("Czujnik 0: Komora");
+                tft->setCursor(10, 135);
+                tft->print("Czujnik 1: Mieso");
                 buzzerBeep(3, 100, 100);
             } else {
-                display.print("Blad kalibracji!");
+                tft->print("Blad kalibracji!");
                 buzzerBeep(5, 100, 100);
             }
             
-            display.setCursor(10, 150);
-            display.print("EXIT - powrot");
+            tft->setCursor(10, 150);
+            tft->print("EXIT - powrot");
+            framebuffer_flush();
             delay(3000);
             force_redraw = true;
             displayCache.needsRedraw = true;
@@ -320,22 +338,24 @@ static void handleSystemSettingsAction() {
             
         case 2: // Backup
             log_msg(LOG_LEVEL_INFO, "Creating system backup...");
-            display.setCursor(10, 50);
-            display.print("BACKUP SYSTEMU");
-            display.drawFastHLine(10, 65, 108, ST77XX_GREEN);
+            tft->setCursor(10, 50);
+            tft->print("BACKUP SYSTEMU");
+            tft->drawFastHLine(10, 65, 108, ST77XX_GREEN);
             
-            display.setCursor(10, 85);
-            display.print("Tworzenie backup...");
+            tft->setCursor(10, 85);
+            tft->print("Tworzenie backup...");
+            framebuffer_flush();
             
             // Utworz backup konfiguracji
             storage_backup_config();
             
-            display.setCursor(10, 105);
-            display.print("Backup utworzony!");
-            display.setCursor(10, 120);
-            display.print("Plik: /backup/");
-            display.setCursor(10, 135);
-            display.print("Restore via web");
+            tft->setCursor(10, 105);
+            tft->print("Backup utworzony!");
+            tft->setCursor(10, 120);
+            tft->print("Plik: /backup/");
+            tft->setCursor(10, 135);
+            tft->print("Restore via web");
+            framebuffer_flush();
             
             buzzerBeep(2, 200, 100);
             delay(2500);
@@ -346,49 +366,54 @@ static void handleSystemSettingsAction() {
         case 3: // Reset statystyk
             {
                 log_msg(LOG_LEVEL_INFO, "Resetting statistics...");
-                display.setCursor(10, 50);
-                display.print("RESET STATYSTYK");
-                display.drawFastHLine(10, 65, 108, ST77XX_RED);
+                tft->setCursor(10, 50);
+                tft->print("RESET STATYSTYK");
+                tft->drawFastHLine(10, 65, 108, ST77XX_RED);
                 
-                display.setCursor(10, 85);
-                display.print("Czy na pewno?");
-                display.setCursor(10, 105);
-                display.print("[UP/DOWN] - TAK/NIE");
-                display.setCursor(10, 120);
-                display.print("[ENTER] - Potwierdz");
+                tft->setCursor(10, 85);
+                tft->print("Czy na pewno?");
+                tft->setCursor(10, 105);
+                tft->print("[UP/DOWN] - TAK/NIE");
+                tft->setCursor(10, 120);
+                tft->print("[ENTER] - Potwierdz");
                 
                 resetConfirmed = false;
                 resetTimeout = millis() + 10000;
                 
+                framebuffer_flush();
                 while (millis() < resetTimeout) {
                     if (digitalRead(PIN_BTN_UP) == LOW) {
                         resetConfirmed = true;
                         buzzerBeep(1, 50, 0);
-                        display.setCursor(10, 135);
-                        display.print("WYBRANO: TAK");
+                        tft->setCursor(10, 135);
+                        tft->print("WYBRANO: TAK");
+                        framebuffer_flush();
                         delay(500);
                         break;
                     }
                     if (digitalRead(PIN_BTN_DOWN) == LOW) {
                         resetConfirmed = false;
                         buzzerBeep(1, 50, 0);
-                        display.setCursor(10, 135);
-                        display.print("WYBRANO: NIE");
+                        tft->setCursor(10, 135);
+                        tft->print("WYBRANO: NIE");
+                        framebuffer_flush();
                         delay(500);
                         break;
                     }
                     if (digitalRead(PIN_BTN_ENTER) == LOW && resetConfirmed) {
                         if (state_lock()) {
-                            g_processStats.totalRunTime = 0;
-                            g_processStats.activeHeatingTime = 0;
-                            g_processStats.stepChanges = 0;
-                            g_processStats.pauseCount = 0;
-                            g_processStats.avgTemp = 0.0;
+                            ProcessStats& stats = chamber_get(uiChamber).processStats;
+                            stats.totalRunTime = 0;
+                            stats.activeHeatingTime = 0;
+                            stats.stepChanges = 0;
+                            stats.pauseCount = 0;
+                            stats.avgTemp = 0.0;
                             state_unlock();
                         }
                         buzzerBeep(3, 100, 100);
-                        display.setCursor(10, 135);
-                        display.print("STATYSTYKI ZRESETOWANE!");
+                        tft->setCursor(10, 135);
+                        tft->print("STATYSTYKI ZRESETOWANE!");
+                        framebuffer_flush();
                         delay(2000);
                         break;
                     }
@@ -407,30 +432,31 @@ static void handleSystemSettingsAction() {
         case 4: // Informacje systemowe
             {
                 log_msg(LOG_LEVEL_INFO, "Displaying system info...");
-                display.setCursor(10, 20);
-                display.print("INFORMACJE SYSTEMOWE");
-                display.drawFastHLine(10, 35, 108, ST77XX_CYAN);
+                tft->setCursor(10, 20);
+                tft->print("INFORMACJE SYSTEMOWE");
+                tft->drawFastHLine(10, 35, 108, ST77XX_CYAN);
                 
-                display.setCursor(10, 50);
-                display.print("Heap: " + String(ESP.getFreeHeap()) + " B");
-                display.setCursor(10, 65);
-                display.print("Uptime: " + String(millis() / 1000) + "s");
-                display.setCursor(10, 80);
-                display.print("SD: " + String(SD.cardType() != CARD_NONE ? "OK" : "ERR"));
-                display.setCursor(10, 95);
-                display.print("WiFi: " + String(WiFi.status() == WL_CONNECTED ? "OK" : "OFF"));
-                display.setCursor(10, 110);
-                display.print("Czujniki: " + String(sensors.getDeviceCount()));
-                display.setCursor(10, 125);
-                display.print("Wersja: " FW_VERSION);
-                display.setCursor(10, 140);
-                display.print("Autor: " FW_AUTHOR);
+                tft->setCursor(10, 50);
+                tft->print("Heap: " + String(ESP.getFreeHeap()) + " B");
+                tft->setCursor(10, 65);
+                tft->print("Uptime: " + String(millis() / 1000) + "s");
+                tft->setCursor(10, 80);
+                tft->print("SD: " + String(SD.cardType() != CARD_NONE ? "OK" : "ERR"));
+                tft->setCursor(10, 95);
+                tft->print("WiFi: " + String(WiFi.status() == WL_CONNECTED ? "OK" : "OFF"));
+                tft->setCursor(10, 110);
+                tft->print("Czujniki: " + String(sensors.getDeviceCount()));
+                tft->setCursor(10, 125);
+                tft->print("Wersja: " FW_VERSION);
+                tft->setCursor(10, 140);
+                tft->print("Autor: " FW_AUTHOR);
                 
-                display.setCursor(10, 155);
-                display.print("EXIT - powrot");
+                tft->setCursor(10, 155);
+                tft->print("EXIT - powrot");
                 
                 // Czekaj na EXIT
                 infoTimeout = millis() + 10000;
+                framebuffer_flush();
                 while (millis() < infoTimeout) {
                     if (digitalRead(PIN_BTN_EXIT) == LOW) {
                         buzzerBeep(1, 50, 0);
@@ -447,42 +473,44 @@ static void handleSystemSettingsAction() {
 }
 
 static void handleWiFiSettingsAction() {
-    display.fillScreen(ST77XX_BLACK);
-    display.setTextSize(1);
-    display.setTextColor(ST77XX_WHITE);
+    tft->fillScreen(ST77XX_BLACK);
+    tft->setTextSize(1);
+    tft->setTextColor(ST77XX_WHITE);
     
     switch(wifiSettingsIndex) {
         case 0: // Zmien SSID/Haslo
-            display.setCursor(10, 50);
-            display.print("ZMIANA WiFi");
-            display.setCursor(10, 70);
-            display.print("Uzyj strony web:");
-            display.setCursor(10, 85);
-            display.print("http://" + WiFi.softAPIP().toString());
-            display.setCursor(10, 100);
-            display.print("/wifi");
-            display.setCursor(10, 130);
-            display.print("EXIT - powrot");
+            tft->setCursor(10, 50);
+            tft->print("ZMIANA WiFi");
+            tft->setCursor(10, 70);
+            tft->print("Uzyj strony web:");
+            tft->setCursor(10, 85);
+            tft->print("http://" + WiFi.softAPIP().toString());
+            tft->setCursor(10, 100);
+            tft->print("/wifi");
+            tft->setCursor(10, 130);
+            tft->print("EXIT - powrot");
             break;
             
         case 1: // Wlacz/Wlacz WiFi
             {
-                display.setCursor(10, 50);
+                tft->setCursor(10, 50);
                 if (WiFi.status() == WL_CONNECTED) {
-                    display.print("WYLACZ WiFi?");
-                    display.setCursor(10, 70);
-                    display.print("[ENTER] - Wylacz");
-                    display.setCursor(10, 85);
-                    display.print("[EXIT] - Anuluj");
+                    tft->print("WYLACZ WiFi?");
+                    tft->setCursor(10, 70);
+                    tft->print("[ENTER] - Wylacz");
+                    tft->setCursor(10, 85);
+                    tft->print("[EXIT] - Anuluj");
                     
                     wifiTimeout = millis() + 5000;
+                    framebuffer_flush();
                     while (millis() < wifiTimeout) {
                         if (digitalRead(PIN_BTN_ENTER) == LOW) {
                             WiFi.disconnect();
                             WiFi.mode(WIFI_AP);
                             buzzerBeep(2, 100, 100);
-                            display.setCursor(10, 105);
-                            display.print("WiFi WYLACZONE!");
+                            tft->setCursor(10, 105);
+                            tft->print("WiFi WYLACZONE!");
+                            framebuffer_flush();
                             delay(2000);
                             break;
                         }
@@ -492,19 +520,21 @@ static void handleWiFiSettingsAction() {
                         delay(50);
                     }
                 } else {
-                    display.print("WLACZ WiFi?");
-                    display.setCursor(10, 70);
-                    display.print("[ENTER] - Wlacz");
-                    display.setCursor(10, 85);
-                    display.print("[EXIT] - Anuluj");
+                    tft->print("WLACZ WiFi?");
+                    tft->setCursor(10, 70);
+                    tft->print("[ENTER] - Wlacz");
+                    tft->setCursor(10, 85);
+                    tft->print("[EXIT] - Anuluj");
                     
                     wifiTimeout = millis() + 5000;
+                    framebuffer_flush();
                     while (millis() < wifiTimeout) {
                         if (digitalRead(PIN_BTN_ENTER) == LOW) {
                             WiFi.begin(storage_get_wifi_ssid(), storage_get_wifi_pass());
                             buzzerBeep(2, 100, 100);
-                            display.setCursor(10, 105);
-                            display.print("Laczenie...");
+                            tft->setCursor(10, 105);
+                            tft->print("Laczenie...");
+                            framebuffer_flush();
                             delay(3000);
                             break;
                         }
@@ -519,411 +549,413 @@ static void handleWiFiSettingsAction() {
             
         case 2: // Skanuj sieci
             {
-                display.setCursor(10, 50);
-                display.print("SKANOWANIE SIECI");
-                display.setCursor(10, 70);
-                display.print("Prosze czekac...");
+                tft->setCursor(10, 50);
+                tft->print("SKANOWANIE SIECI");
+                tft->setCursor(10, 70);
+                tft->print("Prosze czekac...");
+                framebuffer_flush();
                 
                 WiFi.scanNetworks(true);
                 delay(2000);
                 
                 int n = WiFi.scanComplete();
-                display.fillRect(0, 70, 128, 90, ST77XX_BLACK);
+                tft->fillRect(0, 70, 128, 90, ST77XX_BLACK);
                 
                 if (n > 0) {
-                    display.setCursor(10, 70);
-                    display.print("Znalezione: " + String(n));
+                    tft->setCursor(10, 70);
+                    tft->print("Znalezione: " + String(n));
                     for (int i = 0; i < min(3, n); i++) {
-                        display.setCursor(10, 85 + i * 15);
-                        display.print(WiFi.SSID(i).substring(0, 15));
+                        tft->setCursor(10, 85 + i * 15);
+                        tft->print(WiFi.SSID(i).substring(0, 15));
                     }
                 } else {
-                    display.setCursor(10, 85);
-                    display.print("Brak sieci");
+                    tft->setCursor(10, 85);
+                    tft->print("Brak sieci");
                 }
                 
-                display.setCursor(10, 130);
-                display.print("EXIT - powrot");
+                tft->setCursor(10, 130);
+                tft->print("EXIT - powrot");
             }
             break;
     }
     
-    display.setCursor(10, 150);
-    display.print("ENTER-wybierz  EXIT-powrot");
+    tft->setCursor(10, 150);
+    tft->print("ENTER-wybierz  EXIT-powrot");
+    framebuffer_flush();
+}
+
+// [NEW] Zakończenie pobierania profilu GitHub zleconego z menu
+static void pollGithubProfileFetch() {
+    if (!githubFetchPending) return;
+
+    GithubJobState st = github_profile_state();
+    if (st == GithubJobState::BUSY) return;
+
+    githubFetchPending = false;
+    if (st == GithubJobState::DONE) {
+        if (github_last_from_cache()) {
+            log_msg(LOG_LEVEL_INFO, "GitHub profile started from SD cache");
+        }
+        // Task Github wczytał profil do komory wybranej przy zleceniu
+        process_start_auto(githubFetchChamber);
+        currentUiState = UiState::UI_STATE_IDLE;
+    } else {
+        githubFetchFailed = true;
+        buzzerBeep(3, 200, 100);
+        log_msg(LOG_LEVEL_ERROR, "Failed to load GitHub profile");
+    }
+    force_redraw = true;
+    displayCache.needsRedraw = true;
 }
 
 // ============================================================
 // GLOWNA PETLA OBSLUGI PRZYCISKOW
 // ============================================================
-void ui_handle_buttons() {
-    struct Button { 
-        const uint8_t PIN; 
-        bool lastState; 
-        unsigned long lastPressTime; 
-    };
-    
-    static Button buttons[] = { 
-        {PIN_BTN_UP, HIGH, 0}, 
-        {PIN_BTN_DOWN, HIGH, 0}, 
-        {PIN_BTN_ENTER, HIGH, 0}, 
-        {PIN_BTN_EXIT, HIGH, 0} 
-    };
-    
-    const unsigned long DEBOUNCE_TIME = 200;
-    unsigned long now = millis();
-
-    for (int i = 0; i < 4; ++i) {
-        bool currentState = digitalRead(buttons[i].PIN);
-        if (currentState == LOW && buttons[i].lastState == HIGH && 
-            (now - buttons[i].lastPressTime > DEBOUNCE_TIME)) {
-            
-            buttons[i].lastPressTime = now;
-            buzzerBeep(1, 50, 0);
-            force_redraw = true;
-            displayCache.needsRedraw = true;
-            int pin = buttons[i].PIN;
+// [NEW] Reakcja na jedno naciśnięcie (PRESS z kolejki albo autorepeat UP/DOWN)
+static void handleButtonPress(int pin, bool beep) {
+    if (beep) buzzerBeep(1, 50, 0);
+    force_redraw = true;
+    displayCache.needsRedraw = true;
 
-            state_lock();
-            ProcessState proc_st = g_currentState;
-            state_unlock();
+    Chamber& c = chamber_get(uiChamber);
+    state_lock();
+    ProcessState proc_st = c.currentState;
+    state_unlock();
 
-            if (proc_st != ProcessState::IDLE && 
-                currentUiState != UiState::UI_STATE_IDLE && 
-                pin == PIN_BTN_EXIT && 
-                currentUiState != UiState::UI_STATE_SYSTEM_SETTINGS &&
-                currentUiState != UiState::UI_STATE_DIAGNOSTICS &&
-                currentUiState != UiState::UI_STATE_WIFI_SETTINGS) {
+    if (proc_st != ProcessState::IDLE && 
+        currentUiState != UiState::UI_STATE_IDLE && 
+        pin == PIN_BTN_EXIT && 
+        currentUiState != UiState::UI_STATE_SYSTEM_SETTINGS &&
+        currentUiState != UiState::UI_STATE_DIAGNOSTICS &&
+        currentUiState != UiState::UI_STATE_WIFI_SETTINGS) {
+        
+        currentUiState = UiState::UI_STATE_IDLE;
+    } else {
+        switch (currentUiState) {
+            case UiState::UI_STATE_IDLE:
+                if (pin == PIN_BTN_ENTER && proc_st == ProcessState::IDLE) {
+                    currentUiState = UiState::UI_STATE_MENU_MAIN;
+                    mainMenuIndex = 0;
+                }
+                if (pin == PIN_BTN_EXIT && proc_st != ProcessState::IDLE) {
+                    currentUiState = UiState::UI_STATE_CONFIRM_ACTION;
+                    mainMenuIndex = 2;
+                    confirmSelection = false;
+                }
+                if (pin == PIN_BTN_DOWN && proc_st == ProcessState::RUNNING_AUTO) {
+                    currentUiState = UiState::UI_STATE_CONFIRM_NEXT_STEP;
+                    confirmSelection = false;
+                }
+                // [NEW] Wykres trendu: wyl. -> 15 min -> 1 h -> 6 h -> wyl.
+                if (pin == PIN_BTN_UP) {
+                    trendView = (trendView + 1) % ((int)TrendWindow::COUNT + 1);
+                }
+                break;
                 
-                currentUiState = UiState::UI_STATE_IDLE;
-                ui_transition_effect(false);
-            } else {
-                switch (currentUiState) {
-case UiState::UI_STATE_IDLE:
-    if (pin == PIN_BTN_ENTER && proc_st == ProcessState::IDLE) {
-        currentUiState = UiState::UI_STATE_MENU_MAIN;
-        mainMenuIndex = 0;
-        ui_transition_effect(true);
-    }
-    if (pin == PIN_BTN_EXIT && proc_st != ProcessState::IDLE) {
-        currentUiState = UiState::UI_STATE_CONFIRM_ACTION;
-        mainMenuIndex = 2;
-        confirmSelection = false;
-        ui_transition_effect(true);
-    }
-    if (pin == PIN_BTN_DOWN && proc_st == ProcessState::RUNNING_AUTO) {
-        currentUiState = UiState::UI_STATE_CONFIRM_NEXT_STEP;
-        confirmSelection = false;
-        ui_transition_effect(true);
-    }
-    break;
-                        
-                    case UiState::UI_STATE_MENU_MAIN:
-                        if (pin == PIN_BTN_UP) {
-                            mainMenuIndex = (mainMenuIndex - 1 + MAIN_MENU_ITEMS) % MAIN_MENU_ITEMS;
-                        }
-                        else if (pin == PIN_BTN_DOWN) {
-                            mainMenuIndex = (mainMenuIndex + 1) % MAIN_MENU_ITEMS;
-                        }
-                        else if (pin == PIN_BTN_EXIT) { 
-                            currentUiState = UiState::UI_STATE_IDLE;
-                            ui_transition_effect(false);
-                        }
-                        else if (pin == PIN_BTN_ENTER) {
-                            if (mainMenuIndex == 0) { 
-                                currentUiState = UiState::UI_STATE_MENU_SOURCE; 
-                                sourceMenuIndex = 0; 
-                                ui_transition_effect(true);
-                            } 
-                            else if (mainMenuIndex == 1) { 
-                                currentUiState = UiState::UI_STATE_EDIT_MANUAL; 
-                                manualEditIndex = 0; 
-                                ui_transition_effect(true);
-                            } 
-                            else if (mainMenuIndex == 2) { 
-                                confirmSelection = false; 
-                                currentUiState = UiState::UI_STATE_CONFIRM_ACTION; 
-                                ui_transition_effect(true);
-                            }
-                            else if (mainMenuIndex == 3) { 
-                                currentUiState = UiState::UI_STATE_SYSTEM_SETTINGS; 
-                                systemSettingsIndex = 0;
-                                ui_transition_effect(true);
-                            }
-                            else if (mainMenuIndex == 4) { 
-                                currentUiState = UiState::UI_STATE_DIAGNOSTICS; 
-                                ui_transition_effect(true);
-                            }
-                            else if (mainMenuIndex == 5) { 
-                                // Kalibracja
-                                currentUiState = UiState::UI_STATE_IDLE;
-                                buzzerBeep(3, 100, 100);
-                                log_msg(LOG_LEVEL_INFO, "Calibration menu selected");
-                            }
-                        }
-                        break;
-                        
-                    case UiState::UI_STATE_MENU_SOURCE:
-                        if (pin == PIN_BTN_UP || pin == PIN_BTN_DOWN) {
-                            sourceMenuIndex = (sourceMenuIndex + 1) % SOURCE_MENU_ITEMS;
-                        }
-                        else if (pin == PIN_BTN_EXIT) {
-                            currentUiState = UiState::UI_STATE_MENU_MAIN;
-                            ui_transition_effect(false);
-                        }
-                        else if (pin == PIN_BTN_ENTER) { 
-                            profileMenuIndex = 0; 
-                            profilesLoading = true; 
-                            profileList.clear(); 
-                            currentUiState = UiState::UI_STATE_MENU_PROFILES; 
-                            ui_transition_effect(true);
-                        }
-                        break;
-                        
-                    case UiState::UI_STATE_MENU_PROFILES:
-                        { 
-                            if (profilesLoading) { 
-                                if (pin == PIN_BTN_EXIT) { 
-                                    currentUiState = UiState::UI_STATE_MENU_SOURCE; 
-                                    ui_transition_effect(false);
-                                } 
-                                break; 
-                            }
-                            
-                            int listSize = profileList.size();
-                            if (listSize == 0) { 
-                                if (pin == PIN_BTN_EXIT) { 
-                                    currentUiState = UiState::UI_STATE_MENU_SOURCE; 
-                                    ui_transition_effect(false);
-                                } 
-                                break; 
-                            }
-                            
-                            if (pin == PIN_BTN_UP) { 
-                                profileMenuIndex = (profileMenuIndex - 1 + listSize) % listSize; 
-                            }
-                            else if (pin == PIN_BTN_DOWN) { 
-                                profileMenuIndex = (profileMenuIndex + 1) % listSize; 
-                            }
-                            else if (pin == PIN_BTN_EXIT) { 
-                                currentUiState = UiState::UI_STATE_MENU_SOURCE; 
-                                ui_transition_effect(false);
-                            }
-                            else if (pin == PIN_BTN_ENTER) {
-                                String selectedProfile = profileList[profileMenuIndex];
-                                
-                                if (sourceMenuIndex == 0) {
-                                    // SD – załaduj i startuj
-                                    String path = "/profiles/" + selectedProfile;
-                                    storage_save_profile_path_nvs(path.c_str());
-                                    if (storage_load_profile()) {
-                                        process_start_auto();
-                                    } else {
-                                        buzzerBeep(3, 200, 100);
-                                        log_msg(LOG_LEVEL_ERROR, "Failed to load SD profile");
-                                    }
-                                } else {
-                                    // GitHub – pokaż "Pobieranie...", załaduj profil, potem startuj
-                                    display.fillRect(0, 74, SCREEN_WIDTH, SCREEN_HEIGHT - 74, ST77XX_BLACK);
-                                    display.setCursor(10, 95);
-                                    display.setTextColor(ST77XX_YELLOW);
-                                    display.print("Pobieranie...");
-                                    display.setCursor(10, 108);
-                                    display.print(selectedProfile.substring(0, 18));
-                                    
-                                    String path = "github:" + selectedProfile;
-                                    storage_save_profile_path_nvs(path.c_str());
-                                    
-                                    // Resetuj WDT – pobieranie może trwać kilka sekund
-                                    esp_task_wdt_reset();
-                                    bool ok = storage_load_github_profile(selectedProfile.c_str());
-                                    esp_task_wdt_reset();
-                                    
-                                    if (ok) {
-                                        process_start_auto();
-                                    } else {
-                                        buzzerBeep(3, 200, 100);
-                                        display.fillRect(0, 90, SCREEN_WIDTH, 30, ST77XX_BLACK);
-                                        display.setCursor(10, 95);
-                                        display.setTextColor(ST77XX_RED);
-                                        display.print("Blad! Brak WiFi?");
-                                        delay(2000);
-                                        log_msg(LOG_LEVEL_ERROR, "Failed to load GitHub profile: " + selectedProfile);
-                                    }
-                                }
-                                
-                                currentUiState = UiState::UI_STATE_IDLE;
-                                ui_transition_effect(false);
-                            }
+            case UiState::UI_STATE_MENU_MAIN:
+                if (pin == PIN_BTN_UP) {
+                    mainMenuIndex = (mainMenuIndex - 1 + MAIN_MENU_ITEMS) % MAIN_MENU_ITEMS;
+                }
+                else if (pin == PIN_BTN_DOWN) {
+                    mainMenuIndex = (mainMenuIndex + 1) % MAIN_MENU_ITEMS;
+                }
+                else if (pin == PIN_BTN_EXIT) { 
+                    currentUiState = UiState::UI_STATE_IDLE;
+                }
+                else if (pin == PIN_BTN_ENTER) {
+                    if (mainMenuIndex == 0) { 
+                        currentUiState = UiState::UI_STATE_MENU_SOURCE; 
+                        sourceMenuIndex = 0; 
+                    } 
+                    else if (mainMenuIndex == 1) { 
+                        currentUiState = UiState::UI_STATE_EDIT_MANUAL; 
+                        manualEditIndex = 0; 
+                    } 
+                    else if (mainMenuIndex == 2) { 
+                        confirmSelection = false; 
+                        currentUiState = UiState::UI_STATE_CONFIRM_ACTION; 
+                    }
+                    else if (mainMenuIndex == 3) { 
+                        currentUiState = UiState::UI_STATE_SYSTEM_SETTINGS; 
+                        systemSettingsIndex = 0;
+                    }
+                    else if (mainMenuIndex == 4) { 
+                        currentUiState = UiState::UI_STATE_DIAGNOSTICS; 
+                    }
+                    else if (mainMenuIndex == 5) { 
+                        // Kalibracja
+                        currentUiState = UiState::UI_STATE_IDLE;
+                        buzzerBeep(3, 100, 100);
+                        log_msg(LOG_LEVEL_INFO, "Calibration menu selected");
+                    }
+                }
+                break;
+                
+            case UiState::UI_STATE_MENU_SOURCE:
+                if (pin == PIN_BTN_UP || pin == PIN_BTN_DOWN) {
+                    sourceMenuIndex = (sourceMenuIndex + 1) % SOURCE_MENU_ITEMS;
+                }
+                else if (pin == PIN_BTN_EXIT) {
+                    currentUiState = UiState::UI_STATE_MENU_MAIN;
+                }
+                else if (pin == PIN_BTN_ENTER) { 
+                    profileMenuIndex = 0; 
+                    profilesLoading = true; 
+                    profileList.clear(); 
+                    currentUiState = UiState::UI_STATE_MENU_PROFILES; 
+                }
+                break;
+                
+            case UiState::UI_STATE_MENU_PROFILES:
+                { 
+                    if (githubFetchPending || githubFetchFailed) {
+                        if (pin == PIN_BTN_EXIT || (githubFetchFailed && pin == PIN_BTN_ENTER)) {
+                            // Pobieranie trwa dalej w tle, ale bez automatycznego startu
+                            githubFetchPending = false;
+                            githubFetchFailed = false;
+                            currentUiState = UiState::UI_STATE_MENU_SOURCE;
                         }
                         break;
-                        
-                    case UiState::UI_STATE_EDIT_MANUAL:
+                    }
+                    if (profilesLoading) { 
                         if (pin == PIN_BTN_EXIT) { 
-                            currentUiState = UiState::UI_STATE_MENU_MAIN; 
-                            ui_transition_effect(false);
-                        }
-                        else if (pin == PIN_BTN_ENTER) {
-                            if (manualEditIndex == MANUAL_EDIT_ITEMS - 1) { 
-                                process_start_manual(); 
-                                currentUiState = UiState::UI_STATE_IDLE; 
-                                ui_transition_effect(false);
-                            }
-                            else { 
-                                manualEditIndex = (manualEditIndex + 1) % MANUAL_EDIT_ITEMS; 
-                            }
+                            profilesLoading = false;
+                            githubListRequested = false;
+                            currentUiState = UiState::UI_STATE_MENU_SOURCE; 
                         } 
-                        else if (pin == PIN_BTN_UP || pin == PIN_BTN_DOWN) {
-                            int dir = (pin == PIN_BTN_UP) ? 1 : -1;
-                            state_lock();
-                            if (manualEditIndex == 0) g_tSet += dir;
-                            else if (manualEditIndex == 1) g_powerMode += dir;
-                            else if (manualEditIndex == 2) g_manualSmokePwm += dir * 5;
-                            else if (manualEditIndex == 3) {
-                                if (g_fanMode == 2) { 
-                                    if (editingFanOnTime) g_fanOnTime += dir * 1000; 
-                                    else g_fanOffTime += dir * 1000; 
-                                }
-                                else g_fanMode = (g_fanMode + dir + 3) % 3;
-                            }
-                            g_tSet = constrain(g_tSet, CFG_T_MIN_SET, CFG_T_MAX_SET);
-                            g_powerMode = constrain(g_powerMode, CFG_POWERMODE_MIN, CFG_POWERMODE_MAX);
-                            g_manualSmokePwm = constrain(g_manualSmokePwm, CFG_SMOKE_PWM_MIN, CFG_SMOKE_PWM_MAX);
-                            if(g_fanOnTime < 1000) g_fanOnTime = 1000;
-                            if(g_fanOffTime < 1000) g_fanOffTime = 1000;
-                            state_unlock();
-                        }
-                        break;
+                        break; 
+                    }
+                    
+                    int listSize = profileList.size();
+                    if (listSize == 0) { 
+                        if (pin == PIN_BTN_EXIT) { 
+                            currentUiState = UiState::UI_STATE_MENU_SOURCE; 
+                        } 
+                        break; 
+                    }
+                    
+                    if (pin == PIN_BTN_UP) { 
+                        profileMenuIndex = (profileMenuIndex - 1 + listSize) % listSize; 
+                    }
+                    else if (pin == PIN_BTN_DOWN) { 
+                        profileMenuIndex = (profileMenuIndex + 1) % listSize; 
+                    }
+                    else if (pin == PIN_BTN_EXIT) { 
+                        currentUiState = UiState::UI_STATE_MENU_SOURCE; 
+                    }
+                    else if (pin == PIN_BTN_ENTER) {
+                        String selectedProfile = profileList[profileMenuIndex];
                         
-                    case UiState::UI_STATE_CONFIRM_ACTION:
-                        if (pin == PIN_BTN_UP || pin == PIN_BTN_DOWN) { 
-                            confirmSelection = !confirmSelection; 
-                        }
-                        else if (pin == PIN_BTN_EXIT) { 
-                            currentUiState = (proc_st != ProcessState::IDLE) ? 
-                                UiState::UI_STATE_IDLE : UiState::UI_STATE_MENU_MAIN; 
-                            ui_transition_effect(false);
-                        }
-                        else if (pin == PIN_BTN_ENTER) {
-                            if (confirmSelection) { 
-                                allOutputsOff(); 
-                                state_lock(); 
-                                g_currentState = ProcessState::IDLE; 
-                                state_unlock(); 
+                        if (sourceMenuIndex == 0) {
+                            // SD – załaduj i startuj
+                            String path = "/profiles/" + selectedProfile;
+                            storage_save_profile_path_nvs(path.c_str(), uiChamber);
+                            if (storage_load_profile(uiChamber)) {
+                                process_start_auto(uiChamber);
+                            } else {
+                                buzzerBeep(3, 200, 100);
+                                log_msg(LOG_LEVEL_ERROR, "Failed to load SD profile");
                             }
-                            currentUiState = UiState::UI_STATE_IDLE;
-                            ui_transition_effect(false);
-                        }
-                        break;
-                        
-                    // NOWY STAN: Potwierdzenie przejscia do nastepnego kroku
-                    case UiState::UI_STATE_CONFIRM_NEXT_STEP:
-                        if (pin == PIN_BTN_UP || pin == PIN_BTN_DOWN) { 
-                            confirmSelection = !confirmSelection; 
-                        }
-                        else if (pin == PIN_BTN_EXIT) { 
-                            currentUiState = UiState::UI_STATE_IDLE;
-                            ui_transition_effect(false);
-                        }
-                        else if (pin == PIN_BTN_ENTER) {
-                            if (confirmSelection) { 
-                                process_force_next_step();
+                        } else {
+                            // [NEW] GitHub – zlecenie pobrania do taska Github; start procesu
+                            // w pollGithubProfileFetch() po zakończeniu pobierania
+                            String path = "github:" + selectedProfile;
+                            storage_save_profile_path_nvs(path.c_str(), uiChamber);
+                            
+                            if (github_request_profile(selectedProfile.c_str(), true, uiChamber)) {
+                                githubFetchPending = true;
+                                githubFetchChamber = uiChamber;
+                                githubFetchFailed = false;
+                            } else {
+                                buzzerBeep(3, 200, 100);
+                                log_msg(LOG_LEVEL_WARN, "GitHub fetch already in progress");
                             }
-                            currentUiState = UiState::UI_STATE_IDLE;
-                            ui_transition_effect(false);
-                        }
-                        break;
-                        
-                    case UiState::UI_STATE_SYSTEM_SETTINGS:
-                        if (pin == PIN_BTN_UP) {
-                            systemSettingsIndex = (systemSettingsIndex - 1 + SYSTEM_SETTINGS_ITEMS) % SYSTEM_SETTINGS_ITEMS;
-                            force_redraw = true;
-                            displayCache.needsRedraw = true;
-                            log_msg(LOG_LEVEL_DEBUG, "System Settings UP -> index: " + String(systemSettingsIndex));
-                        }
-                        else if (pin == PIN_BTN_DOWN) {
-                            systemSettingsIndex = (systemSettingsIndex + 1) % SYSTEM_SETTINGS_ITEMS;
-                            force_redraw = true;
-                            displayCache.needsRedraw = true;
-                            log_msg(LOG_LEVEL_DEBUG, "System Settings DOWN -> index: " + String(systemSettingsIndex));
-                        }
-                        else if (pin == PIN_BTN_ENTER) {
-                            log_msg(LOG_LEVEL_INFO, "System Settings ENTER -> action: " + String(systemSettingsIndex));
-                            handleSystemSettingsAction();
-                        }
-                        else if (pin == PIN_BTN_EXIT) { 
-                            currentUiState = UiState::UI_STATE_MENU_MAIN;
-                            systemSettingsIndex = 0;
-                            ui_transition_effect(false);
-                            log_msg(LOG_LEVEL_INFO, "System Settings EXIT to main menu");
-                        }
-                        break;
-                        
-                    case UiState::UI_STATE_WIFI_SETTINGS:
-                        if (pin == PIN_BTN_UP) {
-                            wifiSettingsIndex = (wifiSettingsIndex - 1 + WIFI_SETTINGS_ITEMS) % WIFI_SETTINGS_ITEMS;
-                            force_redraw = true;
-                            displayCache.needsRedraw = true;
-                        }
-                        else if (pin == PIN_BTN_DOWN) {
-                            wifiSettingsIndex = (wifiSettingsIndex + 1) % WIFI_SETTINGS_ITEMS;
-                            force_redraw = true;
-                            displayCache.needsRedraw = true;
-                        }
-                        else if (pin == PIN_BTN_ENTER) {
-                            handleWiFiSettingsAction();
-                        }
-                        else if (pin == PIN_BTN_EXIT) { 
-                            currentUiState = UiState::UI_STATE_SYSTEM_SETTINGS;
-                            wifiSettingsIndex = 0;
-                            inSubMenu = false;
-                            force_redraw = true;
-                            displayCache.needsRedraw = true;
-                            log_msg(LOG_LEVEL_INFO, "WiFi Settings EXIT to system settings");
+                            break;
                         }
-                        break;
                         
-                    case UiState::UI_STATE_DIAGNOSTICS:
-                        if (pin == PIN_BTN_EXIT) { 
-                            currentUiState = UiState::UI_STATE_MENU_MAIN;
-                            ui_transition_effect(false);
-                        }
-                        else if (pin == PIN_BTN_UP || pin == PIN_BTN_DOWN || pin == PIN_BTN_ENTER) {
-                            // Pozwol na interakcje z diagnostyka
-                            buzzerBeep(1, 30, 0);
-                            // Mozesz dodac przewijanie informacji diagnostycznych
+                        currentUiState = UiState::UI_STATE_IDLE;
+                    }
+                }
+                break;
+                
+            case UiState::UI_STATE_EDIT_MANUAL:
+                if (pin == PIN_BTN_EXIT) { 
+                    currentUiState = UiState::UI_STATE_MENU_MAIN; 
+                }
+                else if (pin == PIN_BTN_ENTER) {
+                    if (manualEditIndex == MANUAL_EDIT_ITEMS - 1) { 
+                        process_start_manual(uiChamber); 
+                        currentUiState = UiState::UI_STATE_IDLE; 
+                    }
+                    else { 
+                        manualEditIndex = (manualEditIndex + 1) % MANUAL_EDIT_ITEMS; 
+                    }
+                } 
+                else if (pin == PIN_BTN_UP || pin == PIN_BTN_DOWN) {
+                    int dir = (pin == PIN_BTN_UP) ? 1 : -1;
+                    state_lock();
+                    if (manualEditIndex == 0) c.tSet += dir;
+                    else if (manualEditIndex == 1) c.powerMode += dir;
+                    else if (manualEditIndex == 2) c.manualSmokePwm += dir * 5;
+                    else if (manualEditIndex == 3) {
+                        if (c.fanMode == 2) { 
+                            if (editingFanOnTime) c.fanOnTime += dir * 1000; 
+                            else c.fanOffTime += dir * 1000; 
                         }
-                        break;
+                        else c.fanMode = (c.fanMode + dir + 3) % 3;
+                    }
+                    c.tSet = constrain(c.tSet, CFG_T_MIN_SET, CFG_T_MAX_SET);
+                    c.powerMode = constrain(c.powerMode, CFG_POWERMODE_MIN, CFG_POWERMODE_MAX);
+                    c.manualSmokePwm = constrain(c.manualSmokePwm, CFG_SMOKE_PWM_MIN, CFG_SMOKE_PWM_MAX);
+                    if(c.fanOnTime < 1000) c.fanOnTime = 1000;
+                    if(c.fanOffTime < 1000) c.fanOffTime = 1000;
+                    state_unlock();
+                    // [NEW] Tani zapis – write-back cache NVS łączy serię kliknięć
+                    storage_save_manual_settings_nvs();
                 }
-            }
+                break;
+                
+            case UiState::UI_STATE_CONFIRM_ACTION:
+                if (pin == PIN_BTN_UP || pin == PIN_BTN_DOWN) { 
+                    confirmSelection = !confirmSelection; 
+                }
+                else if (pin == PIN_BTN_EXIT) { 
+                    currentUiState = (proc_st != ProcessState::IDLE) ? 
+                        UiState::UI_STATE_IDLE : UiState::UI_STATE_MENU_MAIN; 
+                }
+                else if (pin == PIN_BTN_ENTER) {
+                    if (confirmSelection) { 
+                        chamberOutputsOff(c); 
+                        state_lock(); 
+                        c.currentState = ProcessState::IDLE; 
+                        state_unlock(); 
+                    }
+                    currentUiState = UiState::UI_STATE_IDLE;
+                }
+                break;
+                
+            // NOWY STAN: Potwierdzenie przejscia do nastepnego kroku
+            case UiState::UI_STATE_CONFIRM_NEXT_STEP:
+                if (pin == PIN_BTN_UP || pin == PIN_BTN_DOWN) { 
+                    confirmSelection = !confirmSelection; 
+                }
+                else if (pin == PIN_BTN_EXIT) { 
+                    currentUiState = UiState::UI_STATE_IDLE;
+                }
+                else if (pin == PIN_BTN_ENTER) {
+                    if (confirmSelection) { 
+                        process_force_next_step(uiChamber);
+                    }
+                    currentUiState = UiState::UI_STATE_IDLE;
+                }
+                break;
+                
+            case UiState::UI_STATE_SYSTEM_SETTINGS:
+                if (pin == PIN_BTN_UP) {
+                    systemSettingsIndex = (systemSettingsIndex - 1 + SYSTEM_SETTINGS_ITEMS) % SYSTEM_SETTINGS_ITEMS;
+                    force_redraw = true;
+                    displayCache.needsRedraw = true;
+                    log_msg(LOG_LEVEL_DEBUG, "System Settings UP -> index: " + String(systemSettingsIndex));
+                }
+                else if (pin == PIN_BTN_DOWN) {
+                    systemSettingsIndex = (systemSettingsIndex + 1) % SYSTEM_SETTINGS_ITEMS;
+                    force_redraw = true;
+                    displayCache.needsRedraw = true;
+                    log_msg(LOG_LEVEL_DEBUG, "System Settings DOWN -> index: " + String(systemSettingsIndex));
+                }
+                else if (pin == PIN_BTN_ENTER) {
+                    log_msg(LOG_LEVEL_INFO, "System Settings ENTER -> action: " + String(systemSettingsIndex));
+                    handleSystemSettingsAction();
+                    inputs_discard();   // ekran blokujący czytał piny sam
+                }
+                else if (pin == PIN_BTN_EXIT) { 
+                    currentUiState = UiState::UI_STATE_MENU_MAIN;
+                    systemSettingsIndex = 0;
+                    log_msg(LOG_LEVEL_INFO, "System Settings EXIT to main menu");
+                }
+                break;
+                
+            case UiState::UI_STATE_WIFI_SETTINGS:
+                if (pin == PIN_BTN_UP) {
+                    wifiSettingsIndex = (wifiSettingsIndex - 1 + WIFI_SETTINGS_ITEMS) % WIFI_SETTINGS_ITEMS;
+                    force_redraw = true;
+                    displayCache.needsRedraw = true;
+                }
+                else if (pin == PIN_BTN_DOWN) {
+                    wifiSettingsIndex = (wifiSettingsIndex + 1) % WIFI_SETTINGS_ITEMS;
+                    force_redraw = true;
+                    displayCache.needsRedraw = true;
+                }
+                else if (pin == PIN_BTN_ENTER) {
+                    handleWiFiSettingsAction();
+                    inputs_discard();
+                }
+                else if (pin == PIN_BTN_EXIT) { 
+                    currentUiState = UiState::UI_STATE_SYSTEM_SETTINGS;
+                    wifiSettingsIndex = 0;
+                    inSubMenu = false;
+                    force_redraw = true;
+                    displayCache.needsRedraw = true;
+                    log_msg(LOG_LEVEL_INFO, "WiFi Settings EXIT to system settings");
+                }
+                break;
+                
+            case UiState::UI_STATE_DIAGNOSTICS:
+                if (pin == PIN_BTN_EXIT) { 
+                    currentUiState = UiState::UI_STATE_MENU_MAIN;
+                }
+                else if (pin == PIN_BTN_UP || pin == PIN_BTN_DOWN || pin == PIN_BTN_ENTER) {
+                    // Pozwol na interakcje z diagnostyka
+                    buzzerBeep(1, 30, 0);
+                    // Mozesz dodac przewijanie informacji diagnostycznych
+                }
+                break;
+        }
+    }
+}
+
+void ui_handle_buttons() {
+    pollGithubProfileFetch();
+
+    // [NEW] Zdarzenia z kolejki przerwań (inputs.cpp) zamiast odpytywania
+    // digitalRead co 50 ms – krótkie naciśnięcie w trakcie rysowania nie ginie
+    ButtonEvent ev;
+    while (inputs_poll(ev)) {
+        int pin = inputs_button_pin(ev.id);
+        if (ev.action == ButtonAction::PRESS) {
+            handleButtonPress(pin, true);
+        } else if (ev.action == ButtonAction::REPEAT) {
+            // Na ekranie głównym UP przełącza wykres – tam bez autorepeat
+            if (currentUiState != UiState::UI_STATE_IDLE) handleButtonPress(pin, false);
+        } else if (ev.action == ButtonAction::LONG_PRESS && ev.id == ButtonId::EXIT &&
+                   currentUiState != UiState::UI_STATE_IDLE &&
+                   currentUiState != UiState::UI_STATE_CONFIRM_ACTION) {
+            // Długie EXIT: powrót do ekranu głównego z dowolnego menu
+            currentUiState = UiState::UI_STATE_IDLE;
+            force_redraw = true;
+            displayCache.needsRedraw = true;
+        } else if (ev.action == ButtonAction::LONG_PRESS && ev.id == ButtonId::ENTER &&
+                   currentUiState == UiState::UI_STATE_IDLE && CFG_CHAMBER_COUNT > 1) {
+            // [NEW] Długie ENTER na ekranie głównym: następna komora
+            uiChamber = (uiChamber + 1) % CFG_CHAMBER_COUNT;
+            buzzerBeep(uiChamber + 1, 50, 80);
+            force_redraw = true;
+            displayCache.needsRedraw = true;
         }
-        buttons[i].lastState = currentState;
     }
 }
 
 // ============================================================
 // GLOWNA FUNKCJA ODSWIEZANIA WYSWIETLACZA
 // ============================================================
-void ui_update_display() {
-    static unsigned long lastDisplayUpdate = 0;
+// [NEW] Rysowanie ramki do bufora – wysyłka na TFT w ui_update_display()
+static void ui_draw_frame() {
     static UiState lastUiState = (UiState)-1;
     static ProcessState lastProcessState = (ProcessState)-1;
-    unsigned long now = millis();
-
-    if (now - lastFullRedraw > 60000) {
-        display.fillScreen(ST77XX_BLACK);
-        displayCache.needsRedraw = true;
-        force_redraw = true;
-        lastFullRedraw = now;
-    }
 
-    if (millis() - lastDisplayUpdate < 200 && !force_redraw && !displayCache.needsRedraw) {
-        return;
-    }
-    
-    lastDisplayUpdate = millis();
-    
+    const Chamber& c = chamber_get(uiChamber);
     state_lock();
-    ProcessState st = g_currentState;
+    ProcessState st = c.currentState;
     state_unlock();
 
     if (st != lastProcessState) {
@@ -940,130 +972,194 @@ void ui_update_display() {
     lastUiState = currentUiState;
 
     if (force_redraw || displayCache.needsRedraw) {
-        display.fillScreen(ST77XX_BLACK);
+        tft->fillScreen(ST77XX_BLACK);
         displayCache.chamberTemp = -99.0;
         displayCache.meatTemp = -99.0;
         displayCache.setTemp = -99.0;
-        displayCache.stateString = "";
-        displayCache.stepName = "";
-        displayCache.elapsedStr = "";
-        displayCache.remainingStr = "";
+        displayCache.stateString[0] = '\0';
+        displayCache.stepName[0] = '\0';
+        displayCache.elapsedStr[0] = '\0';
+        displayCache.remainingStr[0] = '\0';
+        displayCache.etaStr[0] = '\0';
+        displayCache.energyStr[0] = '\0';
     }
     
     state_lock();
-    double tc = g_tChamber;
-    double tm = g_tMeat;
-    double ts = g_tSet;
-    int pm = g_powerMode;
-    int fm = g_fanMode;
-    int smoke = g_manualSmokePwm;
-    unsigned long stepStartTime = g_stepStartTime;
-    unsigned long processStartTime = g_processStartTime;
-    int currentStep = g_currentStep;
-    int stepCount = g_stepCount;
+    double tc = c.tChamber;
+    double tm = c.tMeat;
+    double ts = c.tSet;
+    int pm = c.powerMode;
+    int fm = c.fanMode;
+    int smoke = c.manualSmokePwm;
+    unsigned long stepStartTime = c.stepStartTime;
+    unsigned long processStartTime = c.processStartTime;
+    int currentStep = c.currentStep;
+    int stepCount = c.stepCount;
     char stepName[32];
-    strncpy(stepName, (currentStep < stepCount) ? g_profile[currentStep].name : "", sizeof(stepName));
+    strncpy(stepName, (currentStep < stepCount) ? c.profile[currentStep].name : "", sizeof(stepName));
     stepName[sizeof(stepName)-1] = '\0';
-    unsigned long stepTotalTimeMs = (currentStep < stepCount) ? g_profile[currentStep].minTimeMs : 0;
+    unsigned long stepTotalTimeMs = (currentStep < stepCount) ? c.profile[currentStep].minTimeMs : 0;
+    AutotunePhase atPhase = c.autotune.phase;
+    uint8_t atCycles = c.autotune.cycles;
+    double atAmplitude = c.autotune.amplitude;
+    double atTuSec = c.autotune.tuSec;
+    unsigned long atStartMs = c.autotune.startMs;
+    long etaSec = c.eta.stepSec;
+    long etaLoSec = c.eta.stepLoSec;
+    long etaHiSec = c.eta.stepHiSec;
     state_unlock();
+    // [NEW] Energia wsadu – liczniki wyjść czytane poza blokadą stanu
+    EnergySummary energy = energy_summary(uiChamber);
+    char energyText[24] = "";
+    if (energy.valid && energy.active) {
+        snprintf(energyText, sizeof(energyText), "E: %.2fkWh %.2fzl", energy.batchWh / 1000.0f, energy.cost);
+    }
+    
+    // [NEW] Historia dla wykresu trendu (temperatura zadana tylko w trakcie procesu)
+    bool running = (st == ProcessState::RUNNING_AUTO || st == ProcessState::RUNNING_MANUAL ||
+                    st == ProcessState::AUTOTUNE);
+    trend_add_sample(tc, tm, running ? ts : NAN);
     
     char buf[32];
+    char oldText[16];
+    char newText[48];
     
     // Tlo i podstawowe etykiety (tylko jesli potrzebne)
     if (force_redraw || displayCache.needsRedraw) {
-        display.setTextWrap(false);
-        display.setTextSize(1);
-        display.setTextColor(ST77XX_WHITE);
-        display.setCursor(0, 5);  
-        display.print("T.kom:");
-        display.setCursor(0, 27); 
-        display.print("T.mie:");
-        display.drawFastHLine(0, 46, SCREEN_WIDTH, ST77XX_DARKGREY);
-        display.drawFastHLine(0, 72, SCREEN_WIDTH, ST77XX_DARKGREY);
+        tft->setTextWrap(false);
+        tft->setTextSize(1);
+        tft->setTextColor(ST77XX_WHITE);
+        tft->setCursor(0, 5);  
+        tft->print("T.kom:");
+        tft->setCursor(0, 27); 
+        tft->print("T.mie:");
+        if (CFG_CHAMBER_COUNT > 1) {
+            // [NEW] Numer komory pod etykietą T.kom
+            tft->setCursor(0, 15);
+            tft->setTextColor(ST77XX_DARKGREY);
+            tft->printf("K%u", (unsigned)uiChamber + 1);
+            tft->setTextColor(ST77XX_WHITE);
+        }
+        tft->drawFastHLine(0, 46, SCREEN_WIDTH, ST77XX_DARKGREY);
+        tft->drawFastHLine(0, 72, SCREEN_WIDTH, ST77XX_DARKGREY);
     }
     
     // Temperatura komory
-    updateTextAutoSize(48, 5, 80, 
-                      String(displayCache.chamberTemp, 1) + " C", 
-                      String(tc, 1) + " C", 
-                      ST77XX_ORANGE);
+    snprintf(oldText, sizeof(oldText), "%.1f C", displayCache.chamberTemp);
+    snprintf(newText, sizeof(newText), "%.1f C", tc);
+    updateTextAutoSize(48, 5, 80, oldText, newText, ST77XX_ORANGE);
     displayCache.chamberTemp = tc;
     
     // Temperatura miesa
-    updateTextAutoSize(48, 27, 80, 
-                      String(displayCache.meatTemp, 1) + " C", 
-                      String(tm, 1) + " C", 
-                      ST77XX_YELLOW);
+    snprintf(oldText, sizeof(oldText), "%.1f C", displayCache.meatTemp);
+    snprintf(newText, sizeof(newText), "%.1f C", tm);
+    updateTextAutoSize(48, 27, 80, oldText, newText, ST77XX_YELLOW);
     displayCache.meatTemp = tm;
     
     // Status i temperatura zadana
     const char* stateNameStr = getStateStringForDisplay(st);
-    if (st == ProcessState::RUNNING_AUTO || st == ProcessState::RUNNING_MANUAL) {
+    if (running) {
         if(force_redraw || displayCache.needsRedraw) { 
-            display.setTextSize(1); 
-            display.setCursor(0, 53); 
-            display.setTextColor(ST77XX_WHITE); 
-            display.print("T.set:"); 
+            tft->setTextSize(1); 
+            tft->setCursor(0, 53); 
+            tft->setTextColor(ST77XX_WHITE); 
+            tft->print("T.set:"); 
         }
-        updateTextAutoSize(50, 53, 70, 
-                          String(displayCache.setTemp, 1) + " C", 
-                          String(ts, 1) + " C", 
-                          ST77XX_CYAN);
+        snprintf(oldText, sizeof(oldText), "%.1f C", displayCache.setTemp);
+        snprintf(newText, sizeof(newText), "%.1f C", ts);
+        updateTextAutoSize(50, 53, 70, oldText, newText, ST77XX_CYAN);
         displayCache.setTemp = ts;
     } else {
         updateTextAutoSize(5, 53, 118, 
                           displayCache.stateString,
-                          String(stateNameStr), 
+                          stateNameStr, 
                           ST77XX_CYAN);
     }
-    displayCache.stateString = String(stateNameStr);
+    strncpy(displayCache.stateString, stateNameStr, sizeof(displayCache.stateString) - 1);
+    displayCache.stateString[sizeof(displayCache.stateString) - 1] = '\0';
     
     // Czyszczenie dolnej czesci ekranu przy zmianie stanu UI
     if (currentUiState != lastUiState || force_redraw || displayCache.needsRedraw) {
-        display.fillRect(0, 74, SCREEN_WIDTH, SCREEN_HEIGHT - 74, ST77XX_BLACK);
+        tft->fillRect(0, 74, SCREEN_WIDTH, SCREEN_HEIGHT - 74, ST77XX_BLACK);
     }
     
-    if (currentUiState == UiState::UI_STATE_IDLE) {
+    if (currentUiState == UiState::UI_STATE_IDLE && trendView > 0) {
+        // [NEW] Wykres trendu zamiast dolnej czesci dashboardu (UP - zmiana okna)
+        TrendWindow win = (TrendWindow)(trendView - 1);
+        trend_draw(*tft, win, 0, 78, SCREEN_WIDTH, 62, force_redraw || displayCache.needsRedraw);
+        
+        trend_legend(win, buf, sizeof(buf));
+        tft->fillRect(0, 146, SCREEN_WIDTH, 8, ST77XX_BLACK);
+        tft->setTextSize(1);
+        tft->setCursor(0, 146);
+        tft->setTextColor(ST77XX_WHITE);
+        tft->print(buf);
+        tft->setTextColor(ST77XX_ORANGE);
+        tft->print(" K");
+        tft->setTextColor(ST77XX_YELLOW);
+        tft->print(" M");
+        tft->setTextColor(ST77XX_CYAN);
+        tft->print(" Z");
+    } else if (currentUiState == UiState::UI_STATE_IDLE) {
         if (st != ProcessState::IDLE) {
-            display.setTextSize(1);
+            tft->setTextSize(1);
             if (st == ProcessState::RUNNING_AUTO) {
                 // Nazwa kroku
+                snprintf(newText, sizeof(newText), "Krok: %s", stepName);
                 updateText(0, 80, 128, 8, 
                           displayCache.stepName, 
-                          String("Krok: ") + stepName, 
+                          newText, 
                           ST77XX_WHITE, 1);
-                displayCache.stepName = String("Krok: ") + stepName;
+                strcpy(displayCache.stepName, newText);
 
                 // Czas uplyniety
                 unsigned long elapsedSec = (millis() - stepStartTime) / 1000;
                 formatTime(buf, sizeof(buf), elapsedSec);
+                snprintf(newText, sizeof(displayCache.elapsedStr), "Uplynelo: %s", buf);
                 updateText(0, 95, 128, 8, 
                           displayCache.elapsedStr, 
-                          String("Uplynelo: ") + buf, 
+                          newText, 
                           ST77XX_WHITE, 1);
-                displayCache.elapsedStr = String("Uplynelo: ") + buf;
+                strcpy(displayCache.elapsedStr, newText);
 
                 // Czas pozostaly
                 unsigned long totalSec = stepTotalTimeMs / 1000;
                 unsigned long remainingSec = (totalSec > elapsedSec) ? totalSec - elapsedSec : 0;
+                // [NEW] Krok z temperaturą mięsa – do prognozowanego dojścia
+                if (etaSec > 0 && (unsigned long)etaSec > remainingSec) remainingSec = etaSec;
                 formatTime(buf, sizeof(buf), remainingSec);
+                snprintf(newText, sizeof(displayCache.remainingStr), "Zostalo:  %s", buf);
                 updateText(0, 110, 128, 8, 
                           displayCache.remainingStr, 
-                          String("Zostalo:  ") + buf, 
+                          newText, 
                           ST77XX_WHITE, 1);
-                displayCache.remainingStr = String("Zostalo:  ") + buf;
+                strcpy(displayCache.remainingStr, newText);
+
+                // [NEW] Prognoza mięsa z pasmem (h:mm), pusto gdy brak
+                if (etaSec >= 0) {
+                    char hiBuf[8] = "?";
+                    if (etaHiSec >= 0) snprintf(hiBuf, sizeof(hiBuf), "%ld:%02ld", etaHiSec / 3600, (etaHiSec % 3600) / 60);
+                    snprintf(newText, sizeof(displayCache.etaStr), "Cel: %ld:%02ld (%ld:%02ld-%s)",
+                             etaSec / 3600, (etaSec % 3600) / 60,
+                             etaLoSec / 3600, (etaLoSec % 3600) / 60, hiBuf);
+                } else {
+                    newText[0] = '\0';
+                }
+                updateText(0, 120, 128, 8, displayCache.etaStr, newText, ST77XX_YELLOW, 1);
+                strcpy(displayCache.etaStr, newText);
                 
-                // DODANE: Instrukcje bez ikon dla trybu AUTO
-                display.setCursor(5, 130);
-                display.print("DOWN - Nastepny krok");
+                // [NEW] Energia i koszt wsadu
+                updateText(0, 130, 128, 8, displayCache.energyStr, energyText, ST77XX_GREEN, 1);
+                strcpy(displayCache.energyStr, energyText);
                 
-                display.setCursor(5, 145);
-                display.print("EXIT - Zatrzymaj");
+                // DODANE: Instrukcje bez ikon dla trybu AUTO
+                tft->setCursor(5, 145);
+                tft->print("DOWN-krok EXIT-stop");
 
 } else if (st == ProcessState::RUNNING_MANUAL) {
     if(force_redraw || displayCache.needsRedraw) { 
-        display.setCursor(0, 90); 
-        display.print("Czas pracy:"); 
+        tft->setCursor(0, 90); 
+        tft->print("Czas pracy:"); 
     }
     
     unsigned long elapsedSec = (millis() - processStartTime) / 1000;
@@ -1071,87 +1167,139 @@ void ui_update_display() {
 
     // --- KLUCZOWA POPRAWKA ---
     // 1. USTAW poprawny rozmiar czcionki dla licznika PRZED jego aktualizacją.
-    display.setTextSize(2); // Użyj rozmiaru, jaki chcesz mieć dla licznika (np. 2)
+    tft->setTextSize(2); // Użyj rozmiaru, jaki chcesz mieć dla licznika (np. 2)
 
     // 2. DOPIERO TERAZ wywołaj funkcję aktualizującą
     updateTextAutoSize(10, 105, 120, 
                        displayCache.elapsedStr, 
                        buf, 
                        ST77XX_GREEN);
-    displayCache.elapsedStr = buf;
+    strncpy(displayCache.elapsedStr, buf, sizeof(displayCache.elapsedStr) - 1);
+    displayCache.elapsedStr[sizeof(displayCache.elapsedStr) - 1] = '\0';
     
     // 3. Ustaw rozmiar czcionki dla reszty napisów
-    display.setTextSize(1);
+    tft->setTextSize(1);
+    
+    // [NEW] Energia i koszt wsadu
+    updateText(0, 130, 128, 8, displayCache.energyStr, energyText, ST77XX_GREEN, 1);
+    strcpy(displayCache.energyStr, energyText);
     
     // Wyczyść obszar instrukcji (dobre praktyki z poprzedniej odpowiedzi)
-    display.fillRect(0, 145, display.width(), 16, ST77XX_BLACK); 
-    display.setCursor(5, 145);
-    display.print("EXIT - Zatrzymaj");
+    tft->fillRect(0, 145, tft->width(), 16, ST77XX_BLACK); 
+    tft->setCursor(5, 145);
+    tft->print("EXIT - Zatrzymaj");
+} else if (st == ProcessState::AUTOTUNE) {
+                // [NEW] Postep autotune: faza/cykl, ostatnia amplituda i okres, czas
+                if (atPhase == AutotunePhase::RELAY) {
+                    snprintf(newText, sizeof(newText), "Autotune: cykl %u", (unsigned)(atCycles + 1));
+                } else {
+                    snprintf(newText, sizeof(newText), "Autotune: dojscie");
+                }
+                updateText(0, 80, 128, 8, displayCache.stepName, newText, ST77XX_WHITE, 1);
+                strcpy(displayCache.stepName, newText);
+
+                if (atCycles > 0) {
+                    snprintf(newText, sizeof(displayCache.elapsedStr), "A=%.2fC Tu=%.0fs", atAmplitude, atTuSec);
+                } else {
+                    snprintf(newText, sizeof(displayCache.elapsedStr), "A=--  Tu=--");
+                }
+                updateText(0, 95, 128, 8, displayCache.elapsedStr, newText, ST77XX_WHITE, 1);
+                strcpy(displayCache.elapsedStr, newText);
+
+                formatTime(buf, sizeof(buf), (millis() - atStartMs) / 1000);
+                snprintf(newText, sizeof(displayCache.remainingStr), "Czas: %s", buf);
+                updateText(0, 110, 128, 8, displayCache.remainingStr, newText, ST77XX_WHITE, 1);
+                strcpy(displayCache.remainingStr, newText);
+
+                tft->setCursor(5, 145);
+                tft->print("EXIT - Przerwij");
 }
 
         } else {
             // Ekran glowny (IDLE)
-            display.setTextSize(2);
-            display.setCursor(30, 90); 
-            display.print("Menu");
-            display.setCursor(25, 115);
-            display.print("ENTER");
+            tft->setTextSize(2);
+            tft->setCursor(30, 90); 
+            tft->print("Menu");
+            tft->setCursor(25, 115);
+            tft->print("ENTER");
+            tft->setTextSize(1);
+            tft->setCursor(25, 145);
+            tft->print("UP - Wykres");
         }
     } else {
-        display.setTextSize(1);
+        tft->setTextSize(1);
         switch (currentUiState) {
             case UiState::UI_STATE_MENU_MAIN:
-                display.setCursor(0, 80); 
-                display.setTextColor(mainMenuIndex == 0 ? ST77XX_GREEN : ST77XX_WHITE); 
-                display.print(">Start AUTO");
-                display.setCursor(0, 93); 
-                display.setTextColor(mainMenuIndex == 1 ? ST77XX_GREEN : ST77XX_WHITE); 
-                display.print(">Start MANUAL");
-                display.setCursor(0, 106); 
-                display.setTextColor(mainMenuIndex == 2 ? ST77XX_GREEN : ST77XX_WHITE); 
-                display.print(">Zatrzymaj");
-                display.setCursor(0, 119); 
-                display.setTextColor(mainMenuIndex == 3 ? ST77XX_GREEN : ST77XX_WHITE); 
-                display.print(">Ustawienia");
-                display.setCursor(70, 32); 
-                display.setTextColor(mainMenuIndex == 4 ? ST77XX_GREEN : ST77XX_WHITE); 
-                display.print(">D");
+                tft->setCursor(0, 80); 
+                tft->setTextColor(mainMenuIndex == 0 ? ST77XX_GREEN : ST77XX_WHITE); 
+                tft->print(">Start AUTO");
+                tft->setCursor(0, 93); 
+                tft->setTextColor(mainMenuIndex == 1 ? ST77XX_GREEN : ST77XX_WHITE); 
+                tft->print(">Start MANUAL");
+                tft->setCursor(0, 106); 
+                tft->setTextColor(mainMenuIndex == 2 ? ST77XX_GREEN : ST77XX_WHITE); 
+                tft->print(">Zatrzymaj");
+                tft->setCursor(0, 119); 
+                tft->setTextColor(mainMenuIndex == 3 ? ST77XX_GREEN : ST77XX_WHITE); 
+                tft->print(">Ustawienia");
+                tft->setCursor(70, 32); 
+                tft->setTextColor(mainMenuIndex == 4 ? ST77XX_GREEN : ST77XX_WHITE); 
+                tft->print(">D");
                 
                 // Dodaj napisy nawigacji
-                display.setCursor(10, 145);
-                display.print("UP/DOWN - Wybierz");
+                tft->setCursor(10, 145);
+                tft->print("UP/DOWN - Wybierz");
                 break;
                 
             case UiState::UI_STATE_MENU_SOURCE:
-                display.setCursor(10, 90); 
-                display.setTextColor(sourceMenuIndex == 0 ? ST77XX_GREEN : ST77XX_WHITE); 
-                display.print("Karta SD");
-                display.setCursor(10, 103); 
-                display.setTextColor(sourceMenuIndex == 1 ? ST77XX_GREEN : ST77XX_WHITE); 
-                display.print("GitHub");
+                tft->setCursor(10, 90); 
+                tft->setTextColor(sourceMenuIndex == 0 ? ST77XX_GREEN : ST77XX_WHITE); 
+                tft->print("Karta SD");
+                tft->setCursor(10, 103); 
+                tft->setTextColor(sourceMenuIndex == 1 ? ST77XX_GREEN : ST77XX_WHITE); 
+                tft->print("GitHub");
                 
-                display.setCursor(10, 145);
-                display.print("UP/DOWN - Wybierz");
+                tft->setCursor(10, 145);
+                tft->print("UP/DOWN - Wybierz");
                 break;
                 
             case UiState::UI_STATE_MENU_PROFILES:
+                if (githubFetchPending || githubFetchFailed) {
+                    tft->setCursor(10, 95);
+                    tft->setTextColor(githubFetchFailed ? ST77XX_RED : ST77XX_YELLOW);
+                    tft->print(githubFetchFailed ? "Blad! Brak WiFi?" : "Pobieranie...");
+                    if (profileMenuIndex < (int)profileList.size()) {
+                        tft->setCursor(10, 108);
+                        tft->print(profileList[profileMenuIndex].substring(0, 18));
+                    }
+                    tft->setTextColor(ST77XX_WHITE);
+                    tft->setCursor(10, 145);
+                    tft->print("EXIT - Anuluj");
+                    break;
+                }
                 if (profilesLoading) {
-                    display.setCursor(10, 95);
-                    display.print("Wczytywanie...");
+                    tft->setCursor(10, 95);
+                    tft->print("Wczytywanie...");
                     
                     String json_str;
                     if (sourceMenuIndex == 0) {
                         // SD – szybkie, bez problemu ze stosem
                         json_str = storage_list_profiles_json();
                     } else {
-                        // GitHub HTTPS – resetuj WDT przed i po, bo SSL może trwać kilka sekund
-                        esp_task_wdt_reset();
-                        json_str = storage_list_github_profiles_json();
-                        esp_task_wdt_reset();
+                        // [NEW] GitHub – lista pobierana przez task Github, tu tylko odpytanie
+                        if (!githubListRequested) {
+                            githubListRequested = github_request_list();
+                            if (githubListRequested) return;
+                        } else if (github_list_state() == GithubJobState::BUSY) {
+                            return;
+                        }
+                        githubListRequested = false;
+                        json_str = github_list_json();
                     }
                     
                     profileList.clear();
-                    DynamicJsonDocument doc(4096);  // zwiększony z 2048 – GitHub API zwraca więcej danych
+                    // [FIX] Lista GitHub do CFG_GITHUB_LIST_MAX nazw – pojemność z długości
+                    DynamicJsonDocument doc(JSON_ARRAY_SIZE(CFG_GITHUB_LIST_MAX) + json_str.length() + 1);
                     if (deserializeJson(doc, json_str) == DeserializationError::Ok) {
                         for (JsonVariant value : doc.as<JsonArray>()) { 
                             profileList.push_back(String(value.as<const char*>())); 
@@ -1160,97 +1308,97 @@ void ui_update_display() {
                     profilesLoading = false;
                     force_redraw = true;
                     displayCache.needsRedraw = true;
-                    ui_update_display(); 
+                    ui_draw_frame();
                     return;
                 }
                 if (profileList.empty()) {
-                    display.setCursor(10, 95);
-                    display.print("Brak profili!");
+                    tft->setCursor(10, 95);
+                    tft->print("Brak profili!");
                 } else {
-                    display.setTextSize(1);
+                    tft->setTextSize(1);
                     for (size_t i = 0; i < profileList.size(); i++) {
                         if (i < 6) {
-                            display.setCursor(0, 80 + i * 13);
+                            tft->setCursor(0, 80 + i * 13);
                             if ((int)i == profileMenuIndex) { 
-                                display.setTextColor(ST77XX_GREEN); 
-                                display.print("> "); 
+                                tft->setTextColor(ST77XX_GREEN); 
+                                tft->print("> "); 
                             }
                             else { 
-                                display.setTextColor(ST77XX_WHITE); 
-                                display.print("  "); 
+                                tft->setTextColor(ST77XX_WHITE); 
+                                tft->print("  "); 
                             }
-                            display.print(profileList[i]);
+                            tft->print(profileList[i]);
                         }
                     }
                 }
                 
-                display.setCursor(10, 145);
-                display.print("ENTER - Wybierz");
+                tft->setCursor(10, 145);
+                tft->print("ENTER - Wybierz");
                 break;
                 
             case UiState::UI_STATE_EDIT_MANUAL:
-                display.setTextSize(1);
-                display.setCursor(0, 80); 
-                display.setTextColor(manualEditIndex == 0 ? ST77XX_YELLOW : ST77XX_WHITE); 
-                display.print("Temp: " + String(ts, 1) + " C");
-                display.setCursor(0, 92); 
-                display.setTextColor(manualEditIndex == 1 ? ST77XX_YELLOW : ST77XX_WHITE); 
-                display.print("Moc: " + String(pm));
-                display.setCursor(0, 104); 
-                display.setTextColor(manualEditIndex == 2 ? ST77XX_YELLOW : ST77XX_WHITE); 
-                display.print("Dym: " + String(smoke));
-                display.setCursor(0, 116); 
-                display.setTextColor(manualEditIndex == 3 ? ST77XX_YELLOW : ST77XX_WHITE);
-                if(fm == 0) display.print("Went: OFF");
-                else if (fm == 1) display.print("Went: ON");
-                else display.print("Went: CYKL");
-                display.setTextSize(2);
-                display.setCursor(15, 135);
-                display.print("START");
+                tft->setTextSize(1);
+                tft->setCursor(0, 80); 
+                tft->setTextColor(manualEditIndex == 0 ? ST77XX_YELLOW : ST77XX_WHITE); 
+                tft->print("Temp: " + String(ts, 1) + " C");
+                tft->setCursor(0, 92); 
+                tft->setTextColor(manualEditIndex == 1 ? ST77XX_YELLOW : ST77XX_WHITE); 
+                tft->print("Moc: " + String(pm));
+                tft->setCursor(0, 104); 
+                tft->setTextColor(manualEditIndex == 2 ? ST77XX_YELLOW : ST77XX_WHITE); 
+                tft->print("Dym: " + String(smoke));
+                tft->setCursor(0, 116); 
+                tft->setTextColor(manualEditIndex == 3 ? ST77XX_YELLOW : ST77XX_WHITE);
+                if(fm == 0) tft->print("Went: OFF");
+                else if (fm == 1) tft->print("Went: ON");
+                else tft->print("Went: CYKL");
+                tft->setTextSize(2);
+                tft->setCursor(15, 135);
+                tft->print("START");
                 
                 // Dodaj legende klawiszy
-                display.setTextSize(1);
-                display.setCursor(0, 150);
-                display.print("UP/DOWN - Zmien");
+                tft->setTextSize(1);
+                tft->setCursor(0, 150);
+                tft->print("UP/DOWN - Zmien");
                 break;
                 
             case UiState::UI_STATE_CONFIRM_ACTION:
-                display.setCursor(15, 95);
-                display.print("Na pewno?");
-                display.setTextSize(1);
-                display.setCursor(10, 120); 
-                display.setTextColor(!confirmSelection ? ST77XX_GREEN : ST77XX_WHITE); 
-                display.print("NIE");
-                display.setCursor(70, 120); 
-                display.setTextColor(confirmSelection ? ST77XX_GREEN : ST77XX_WHITE); 
-                display.print("TAK");
+                tft->setCursor(15, 95);
+                tft->print("Na pewno?");
+                tft->setTextSize(1);
+                tft->setCursor(10, 120); 
+                tft->setTextColor(!confirmSelection ? ST77XX_GREEN : ST77XX_WHITE); 
+                tft->print("NIE");
+                tft->setCursor(70, 120); 
+                tft->setTextColor(confirmSelection ? ST77XX_GREEN : ST77XX_WHITE); 
+                tft->print("TAK");
                 
-                display.setCursor(10, 145);
-                display.print("ENTER - OK");
+                tft->setCursor(10, 145);
+                tft->print("ENTER - OK");
                 break;
                 
             // NOWY EKRAN: Potwierdzenie przejscia do nastepnego kroku
             case UiState::UI_STATE_CONFIRM_NEXT_STEP:
-                display.setCursor(10, 85);
-                display.print("Nastepny krok?");
-                display.setCursor(10, 100);
-                display.print("Pominac biezacy krok?");
-                display.setCursor(10, 120); 
-                display.setTextColor(!confirmSelection ? ST77XX_GREEN : ST77XX_WHITE); 
-                display.print("NIE");
-                display.setCursor(70, 120); 
-                display.setTextColor(confirmSelection ? ST77XX_GREEN : ST77XX_WHITE); 
-                display.print("TAK");
+                tft->setCursor(10, 85);
+                tft->print("Nastepny krok?");
+                tft->setCursor(10, 100);
+                tft->print("Pominac biezacy krok?");
+                tft->setCursor(10, 120); 
+                tft->setTextColor(!confirmSelection ? ST77XX_GREEN : ST77XX_WHITE); 
+                tft->print("NIE");
+                tft->setCursor(70, 120); 
+                tft->setTextColor(confirmSelection ? ST77XX_GREEN : ST77XX_WHITE); 
+                tft->print("TAK");
                 
-                display.setCursor(10, 145);
-                display.print("ENTER - OK");
+                tft->setCursor(10, 145);
+                tft->print("ENTER - OK");
                 break;
                 
             case UiState::UI_STATE_SYSTEM_SETTINGS:
                 {
-                    display.setCursor(10, 75);
-                    display.print("USTAWIENIA SYSTEMU");
-                    display.drawFastHLine(10, 85, 108, ST77XX_WHITE);
+                    tft->setCursor(10, 75);
+                    tft->print("USTAWIENIA SYSTEMU");
+                    tft->drawFastHLine(10, 85, 108, ST77XX_WHITE);
                     
                     // Lista opcji z podswietleniem
                     const char* settingsItems[] = {
@@ -1269,28 +1417,28 @@ void ui_update_display() {
                         int yPos = 95 + i * 15;
                         
                         if (itemIndex == systemSettingsIndex) {
-                            display.setTextColor(ST77XX_YELLOW);
-                            display.setCursor(5, yPos);
-                            display.print("> ");
+                            tft->setTextColor(ST77XX_YELLOW);
+                            tft->setCursor(5, yPos);
+                            tft->print("> ");
                         } else {
-                            display.setTextColor(ST77XX_WHITE);
-                            display.setCursor(5, yPos);
-                            display.print("  ");
+                            tft->setTextColor(ST77XX_WHITE);
+                            tft->setCursor(5, yPos);
+                            tft->print("  ");
                         }
                         
-                        display.print(settingsItems[itemIndex]);
+                        tft->print(settingsItems[itemIndex]);
                     }
                     
-                    display.setCursor(5, 145);
-                    display.print("ENTER - OK");
+                    tft->setCursor(5, 145);
+                    tft->print("ENTER - OK");
                 }
                 break;
                 
             case UiState::UI_STATE_WIFI_SETTINGS:
                 {
-                    display.setCursor(10, 75);
-                    display.print("USTAWIENIA WiFi");
-                    display.drawFastHLine(10, 85, 108, ST77XX_WHITE);
+                    tft->setCursor(10, 75);
+                    tft->print("USTAWIENIA WiFi");
+                    tft->drawFastHLine(10, 85, 108, ST77XX_WHITE);
                     
                     // Opcje WiFi
                     const char* wifiItems[] = {
@@ -1303,27 +1451,27 @@ void ui_update_display() {
                         int yPos = 95 + i * 15;
                         
                         if (i == wifiSettingsIndex) {
-                            display.setTextColor(ST77XX_YELLOW);
-                            display.setCursor(5, yPos);
-                            display.print("> ");
+                            tft->setTextColor(ST77XX_YELLOW);
+                            tft->setCursor(5, yPos);
+                            tft->print("> ");
                         } else {
-                            display.setTextColor(ST77XX_WHITE);
-                            display.setCursor(5, yPos);
-                            display.print("  ");
+                            tft->setTextColor(ST77XX_WHITE);
+                            tft->setCursor(5, yPos);
+                            tft->print("  ");
                         }
                         
-                        display.print(wifiItems[i]);
+                        tft->print(wifiItems[i]);
                     }
                     
-                    display.setCursor(5, 145);
-                    display.print("ENTER - Wybierz");
+                    tft->setCursor(5, 145);
+                    tft->print("ENTER - Wybierz");
                 }
                 break;
                 
             case UiState::UI_STATE_DIAGNOSTICS:
                 showDiagnosticsScreen();
-                display.setCursor(10, 150);
-                display.print("EXIT - Powrot");
+                tft->setCursor(10, 150);
+                tft->print("EXIT - Powrot");
                 break;
         }
     }
@@ -1334,6 +1482,28 @@ void ui_update_display() {
     displayCache.lastUpdate = millis();
 }
 
+void ui_update_display() {
+    static unsigned long lastDisplayUpdate = 0;
+    unsigned long now = millis();
+
+    // [FIX] Zamiast fillScreen co 60 s (miganie) – ponowne wysłanie całej
+    // ramki z bufora, co odtwarza obraz po ewentualnych zakłóceniach TFT
+    if (now - lastFullRedraw > 60000) {
+        framebuffer_invalidate();
+        lastFullRedraw = now;
+    }
+
+    if (millis() - lastDisplayUpdate < 200 && !force_redraw && !displayCache.needsRedraw) {
+        return;
+    }
+
+    lastDisplayUpdate = millis();
+    uint32_t frameStartUs = micros();
+
+    ui_draw_frame();
+    framebuffer_end_frame(frameStartUs);
+}
+
 void updateUserActivity() {
     lastUserActivity = millis();
 }
\ No newline at end of file
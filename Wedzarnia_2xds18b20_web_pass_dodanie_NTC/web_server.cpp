@@ -1,6 +1,7 @@
 // web_server.cpp - [NEW] HTTP Basic Auth dla endpointów akcji
 // Podgląd temperatury (/status, /) – dostępny bez logowania.
 // Wszystkie akcje (start/stop/OTA/ustawienia/profile/sensory/wifi) – wymagają autoryzacji.
+// [NEW] Akcje procesu i /status przyjmują ?ch=<komora> (brak = komora 0)
 #include <ff.h>
 #include "web_server.h"
 #include "config.h"
@@ -9,6 +10,22 @@
 #include "process.h"
 #include "outputs.h"
 #include "sensors.h"
+#include "github_client.h"
+#include "mqtt_telemetry.h"
+#include "gain_sched.h"
+#include "autotune.h"
+#include "fopdt.h"
+#include "ssr_tp.h"
+#include "energy.h"
+#include "fan_sched.h"
+#include "heater_diag.h"
+#include "overheat.h"
+#include "sensor_failover.h"
+#include "boot_prof.h"
+#include "sd_clock.h"
+#include "sd_stats.h"
+#include "framebuffer.h"
+#include "inputs.h"
 #include <WiFi.h>
 #include <Update.h>
 #include "FS.h"
@@ -29,6 +46,13 @@ static bool requireAuth() {
     return true;
 }
 
+// [NEW] Indeks komory z argumentu ?ch= (brak/poza zakresem → 0)
+static uint8_t requestChamber() {
+    if (!server.hasArg("ch")) return 0;
+    long ch = server.arg("ch").toInt();
+    return (ch >= 0 && ch < CFG_CHAMBER_COUNT) ? (uint8_t)ch : 0;
+}
+
 
 // =================================================================
 // GŁÓWNA STRONA "/"
@@ -222,8 +246,11 @@ button{padding:10px 15px;font-size:0.9em;}
 <div class="timer-item" id="process-total-section">
 <div class="label">⏱️ Do końca</div>
 <div class="time time-remaining" id="process-remaining">--:--:--</div>
+<div class="label" id="process-band"></div>
 </div>
 </div>
+<div style="text-align:center;margin-top:6px;display:none;" id="energy-section">⚡ Energia wsadu <strong id="energy-kwh">0.00 kWh</strong> <span id="energy-cost"></span></div>
+<div style="text-align:center;margin-top:6px;display:none;" id="meat-eta-section">🍖 Mięso u celu za <strong id="meat-eta">--:--:--</strong> <span id="meat-eta-band"></span></div>
 <div style="text-align:center;margin-top:10px;">
 <button class="btn-action" onclick="authAction('/timer/reset','Resetuj czas?')">↻ Resetuj Czas</button>
 <button class="btn-action" id="nextStepBtn" style="display:none;" onclick="authAction('/auto/next_step','Pominąć krok?')">⏭️ Następny krok</button>
@@ -290,6 +317,29 @@ button{padding:10px 15px;font-size:0.9em;}
 <button class="btn-action" onclick="setF()">✅ Ustaw</button>
 </div>
 </div>
+<div class="section">
+<h3>🎯 Autotune PID</h3>
+<div class="control-group">
+<label>Temperatura:</label>
+<input id="atSet" type="number" value="70" min="20" max="120"><span>°C</span>
+</div>
+<div class="control-group">
+<label>Moc grzałek:</label>
+<select id="atPm">
+<option value="1">1 grzałka</option>
+<option value="2" selected>2 grzałki</option>
+<option value="3">3 grzałki</option>
+</select>
+<select id="atRule">
+<option value="tl" selected>Tyreus–Luyben</option>
+<option value="zn">Ziegler–Nichols</option>
+</select>
+</div>
+<div style="text-align:center;">
+<button class="btn-action" onclick="startAutotune()">🎯 Start autotune</button>
+</div>
+<div class="profile-info" id="at-info">-</div>
+</div>
 <div class="footer">
 <div class="footer-grid">
 <a class="footer-link" href="/creator"><span class="fi">📝</span>Nowy Profil</a>
@@ -335,7 +385,7 @@ let statusText = data.mode;
 if(data.mode.includes('PAUZA')|| data.mode.includes('AWARIA')){statusClass = 'status-pause';statusText = data.mode;}
 else if(data.mode.includes('ERROR')){statusClass = 'status-error';statusText = 'BŁĄD';}
 else if(data.mode === 'AUTO'){statusClass = 'status-auto';}
-else if(data.mode === 'MANUAL'){statusClass = 'status-manual';}
+else if(data.mode === 'MANUAL'|| data.mode === 'AUTOTUNE'){statusClass = 'status-manual';}
 const badge = document.getElementById('status-badge');
 badge.className = 'status-badge '+statusClass;
 badge.textContent = statusText;
@@ -355,6 +405,7 @@ const ps = document.getElementById('process-total-section');
 if(data.remainingProcessTimeSec>0){
 ps.style.display = 'block';
 document.getElementById('process-remaining').textContent = formatTime(data.remainingProcessTimeSec);
+document.getElementById('process-band').textContent = data.remainingLoSec>=0 ? formatTime(data.remainingLoSec)+' – '+(data.remainingHiSec>=0 ? formatTime(data.remainingHiSec) : '?') : '';
 }else{ps.style.display = 'none';}
 }else{
 document.getElementById('step-name').textContent = 'Tryb Manualny';
@@ -364,11 +415,46 @@ document.getElementById('nextStepBtn').style.display = 'none';
 }else{
 timerSection.classList.remove('active');
 }
+const me = document.getElementById('meat-eta-section');
+if(data.meatEtaSec>=0){
+me.style.display = 'block';
+document.getElementById('meat-eta').textContent = formatTime(data.meatEtaSec);
+document.getElementById('meat-eta-band').textContent = '('+formatTime(data.meatEtaLoSec)+' – '+(data.meatEtaHiSec>=0 ? formatTime(data.meatEtaHiSec) : '?')+', τ '+data.meatTauMin+' min)';
+}else{me.style.display = 'none';}
+const es = document.getElementById('energy-section');
+if(data.energyValid){
+es.style.display = 'block';
+document.getElementById('energy-kwh').textContent = data.energyKwh.toFixed(2)+' kWh';
+document.getElementById('energy-cost').textContent = '('+data.energyCost.toFixed(2)+' zł'+(data.energyStepKwh>0 ? ', krok '+data.energyStepKwh.toFixed(2)+' kWh' : '')+')';
+}else{es.style.display = 'none';}
+if(data.mode === 'AUTOTUNE' || atPoll){fetchAutotune();}
 let profileName = data.activeProfile.replace('/profiles/','').replace('github:','[GitHub] ');
 document.getElementById('active-profile').textContent = profileName;
 })
 .catch(e =>console.error('Status fetch error:',e));
 }
+let atPoll = true;
+function fetchAutotune(){
+fetch('/api/autotune').then(r =>r.json()).then(a =>{
+const el = document.getElementById('at-info');
+atPoll = (a.phase === 'heating' || a.phase === 'relay');
+if(a.phase === 'none'){el.textContent = '-';return;}
+if(a.phase === 'heating'){el.textContent = 'Dojście do '+a.setpoint.toFixed(1)+'°C, wyjście '+a.output+'% ('+formatTime(a.elapsedSec)+')';}
+else if(a.phase === 'relay'){el.textContent = 'Cykl '+a.cycle+' (min '+a.minCycles+', max '+a.maxCycles+'), wyjście '+a.output+'%, A='+a.amplitude.toFixed(2)+'°C, Tu='+a.tu+'s, Ku='+a.ku.toFixed(2)+' ('+formatTime(a.elapsedSec)+')';}
+else if(a.phase === 'done'){el.textContent = 'Gotowe ('+a.setpoint.toFixed(0)+'°C, moc '+a.pm+'): Kp='+a.kp.toFixed(2)+' Ki='+a.ki.toFixed(4)+' Kd='+a.kd.toFixed(1)+' (Ku='+a.ku.toFixed(2)+', Tu='+a.tu+'s)';}
+else{el.textContent = 'Przerwany: '+a.message+' (cykl '+a.cycle+')';}
+}).catch(e =>console.error(e));
+}
+function startAutotune(){
+const v = document.getElementById('atSet').value;
+if(!confirm('Autotune przy '+v+'°C? Komora będzie oscylować wokół tej temperatury przez 1-3 h.'))return;
+atPoll = true;
+fetch('/autotune/start?tSet='+v+'&pm='+document.getElementById('atPm').value+'&rule='+document.getElementById('atRule').value).then(r =>{
+if(r.status === 401){alert('Wymagane zalogowanie. Odśwież stronę i zaloguj się.');}
+else if(!r.ok){r.text().then(t =>alert(t));}
+fetchStatus();
+}).catch(e =>console.error(e));
+}
 function startManual(){authAction('/mode/manual');}
 function startAuto(){authAction('/auto/start');}
 function stopProcess(){authAction('/auto/stop','Zatrzymać proces?');}
@@ -385,11 +471,20 @@ currentProfileSource = document.getElementById('profileSource').value;
 document.getElementById('reloadSdBtn').style.display = currentProfileSource === 'sd' ? 'inline-block':'none';
 loadProfiles();
 }
-function loadProfiles(){
-const url = currentProfileSource === 'sd' ? '/api/profiles':'/api/github_profiles';
-fetch(url).then(r =>r.json()).then(profiles =>{
+function loadProfiles(poll){
+const url = currentProfileSource === 'sd' ? '/api/profiles':'/api/github_profiles'+(poll ? '?poll=1':'');
+fetch(url).then(r =>{
+if(r.status === 202){setTimeout(() =>loadProfiles(true),1000);return null;}
+return r.json();
+}).then(profiles =>{
+if(!profiles)return;
 const list = document.getElementById('profileList');
 list.innerHTML = '';
+if(!profiles.length && currentProfileSource === 'github'){
+const opt = document.createElement('option');
+opt.value = '';opt.textContent = 'Brak WiFi / błąd API GitHub';
+list.appendChild(opt);
+}
 profiles.forEach(p =>{
 const name = p.replace('/profiles/','');
 const opt = document.createElement('option');
@@ -404,10 +499,18 @@ if(!name)return;
 fetch('/profile/select?name='+name+'&source='+currentProfileSource)
 .then(r =>{
 if(r.status === 401){alert('Wymagane zalogowanie.');return;}
+if(r.status === 202){waitGithubProfile(name);return;}
 return r.text();
 })
 .then(msg =>{if(msg){alert(msg);fetchStatus();}});
 }
+function waitGithubProfile(name){
+fetch('/api/github_status').then(r =>r.json()).then(s =>{
+if(s.profile === 'busy'){setTimeout(() =>waitGithubProfile(name),1000);return;}
+alert(s.profile === 'done' ? 'OK, profil '+name+' załadowany'+(s.cache ? ' (kopia z karty SD).':'.') : 'Błąd ładowania profilu.');
+fetchStatus();
+});
+}
 function editProfile(){
 const name = document.getElementById('profileList').value;
 if(!name)return;
@@ -769,96 +872,7 @@ loadInfo();
 // FUNKCJE POMOCNICZE
 // =================================================================
 
-static const char* getStateString(ProcessState st) {
-    switch (st) {
-        case ProcessState::IDLE:               return "IDLE";
-        case ProcessState::RUNNING_AUTO:       return "AUTO";
-        case ProcessState::RUNNING_MANUAL:     return "MANUAL";
-        case ProcessState::PAUSE_DOOR:         return "PAUZA: DRZWI";
-        case ProcessState::PAUSE_SENSOR:       return "PAUZA: CZUJNIK";
-        case ProcessState::PAUSE_OVERHEAT:     return "PAUZA: PRZEGRZANIE";
-        case ProcessState::PAUSE_HEATER_FAULT: return "AWARIA: GRZALKA";
-        case ProcessState::PAUSE_USER:         return "PAUZA UZYTK.";
-        case ProcessState::ERROR_PROFILE:      return "ERROR_PROFILE";
-        case ProcessState::SOFT_RESUME:        return "Wznawianie...";
-        default:                               return "UNKNOWN";
-    }
-}
-
-static const char* getStatusJSON() {
-    static char jsonBuffer[600];
-    double tc, tm, ts;
-    int pm, fm, sm;
-    ProcessState st;
-    unsigned long elapsedSec = 0;
-    unsigned long stepTotalSec = 0;
-    const char* stepName = "";
-    unsigned long remainingProcessTimeSec = 0;
-    char activeProfile[64] = "Brak";
-
-    state_lock();
-    st   = g_currentState;
-    tc   = g_tChamber;
-    tm   = g_tMeat;
-    ts   = g_tSet;
-    pm   = g_powerMode;
-    fm   = g_fanMode;
-    sm   = g_manualSmokePwm;
-    remainingProcessTimeSec = g_processStats.remainingProcessTimeSec;
-    strncpy(activeProfile, storage_get_profile_path(), sizeof(activeProfile) - 1);
-    activeProfile[sizeof(activeProfile) - 1] = '\0';
-
-    if (st == ProcessState::RUNNING_MANUAL) {
-        elapsedSec = (millis() - g_processStartTime) / 1000;
-    } else if (st == ProcessState::RUNNING_AUTO) {
-        elapsedSec = (millis() - g_stepStartTime) / 1000;
-        if (g_currentStep < g_stepCount) {
-            stepName     = g_profile[g_currentStep].name;
-            stepTotalSec = g_profile[g_currentStep].minTimeMs / 1000;
-        }
-    }
-    state_unlock();
-
-    const char* powerModeStr;
-    switch (pm) {
-        case 1: powerModeStr = "1-grzalka";  break;
-        case 2: powerModeStr = "2-grzalki";  break;
-        case 3: powerModeStr = "3-grzalki";  break;
-        default: powerModeStr = "Brak";      break;
-    }
-    const char* fanModeStr;
-    switch (fm) {
-        case 0: fanModeStr = "OFF";         break;
-        case 1: fanModeStr = "ON";          break;
-        case 2: fanModeStr = "Cyklicznie";  break;
-        default: fanModeStr = "Brak";       break;
-    }
-
-    char cleanProfileName[64];
-    strncpy(cleanProfileName, activeProfile, sizeof(cleanProfileName));
-    if (strstr(cleanProfileName, "/profiles/") != NULL) {
-        strcpy(cleanProfileName, strstr(cleanProfileName, "/profiles/") + 10);
-    } else if (strstr(cleanProfileName, "github:") != NULL) {
-        memmove(cleanProfileName, cleanProfileName + 7, strlen(cleanProfileName) - 6);
-    }
-
-    snprintf(jsonBuffer, sizeof(jsonBuffer),
-        "{\"tChamber\":%.1f,\"tMeat\":%.1f,\"tSet\":%.1f,"
-        "\"powerMode\":%d,\"fanMode\":%d,\"smokePwm\":%d,"
-        "\"mode\":\"%s\",\"state\":%d,"
-        "\"powerModeText\":\"%s\",\"fanModeText\":\"%s\","
-        "\"elapsedTimeSec\":%lu,\"stepName\":\"%s\","
-        "\"stepTotalTimeSec\":%lu,\"activeProfile\":\"%s\","
-        "\"remainingProcessTimeSec\":%lu}",
-        tc, tm, ts, pm, fm, sm,
-        getStateString(st), (int)st,
-        powerModeStr, fanModeStr,
-        elapsedSec, stepName,
-        stepTotalSec, cleanProfileName,
-        remainingProcessTimeSec);
-
-    return jsonBuffer;
-}
+// getStatusJSON() – web_status.cpp (buduje się też na hoście)
 
 // =================================================================
 // INFORMACJE SYSTEMOWE /sysinfo – dane identyczne z ekranem TFT
@@ -977,6 +991,18 @@ static const char HTML_SYSINFO[] PROGMEM = R"rawliteral(<!DOCTYPE html>
 <span class="lbl">💡 Flash size</span>
 <span class="val" id="flash_size">...</span>
 </div>
+<div class="row">
+<span class="lbl">💾 Zapisy NVS/h</span>
+<span class="val" id="nvs_writes">...</span>
+</div>
+<div class="row">
+<span class="lbl">🖥️ Ramka TFT</span>
+<span class="val" id="fb_frame">...</span>
+</div>
+<div class="row">
+<span class="lbl">🚪 Drzwi → SSR off</span>
+<span class="val" id="door_latency">...</span>
+</div>
 </div>
 <button class="btn-refresh" onclick="loadInfo()">🔄 Odśwież dane</button>
 <div class="updated" id="updated_at"></div>
@@ -1026,7 +1052,7 @@ d.cpu_temp>70 ? 'err':d.cpu_temp>55 ? 'warn':'');
 setVal('reset_reason',d.reset_reason);
 const sdOk = d.sd_ok;
 setVal('sd_status',sdOk ? '✅ OK('+d.sd_type+')':'❌ Brak karty',sdOk ? 'ok':'err');
-setVal('sd_size',sdOk ? fmtBytes(d.sd_total)+' / wolne '+fmtBytes(d.sd_free):'-');
+setVal('sd_size',sdOk && d.sd_total>0 ? fmtBytes(d.sd_total)+' / wolne '+fmtBytes(d.sd_free):(sdOk ? '...':'-'));
 setVal('sensors',d.sensor_count+' szt.',d.sensor_count>0 ? 'ok':'warn');
 setVal('sensors_id',d.sensors_identified ? '✅ Tak':'⚠️ Nie',d.sensors_identified ? 'ok':'warn');
 const wOk = d.wifi_connected;
@@ -1042,6 +1068,9 @@ setVal('fw_author',d.fw_author);
 setVal('chip_model',d.chip_model);
 setVal('mac_addr',d.mac_addr);
 setVal('flash_size',fmtBytes(d.flash_size));
+setVal('nvs_writes',d.nvs_commit_hour+' / żądań '+d.nvs_req_hour+(d.nvs_pending ? ' ⏳':''));
+setVal('fb_frame',d.fb_active ? d.fb_frame_us+' µs, SPI '+fmtBytes(d.fb_spi_bps)+'/s' : 'bez bufora');
+setVal('door_latency',d.door_events ? d.door_latency_us+' µs (max '+d.door_latency_max_us+', '+d.door_events+'x)' : 'brak otwarć');
 document.getElementById('updated_at').textContent =
 'Odświeżono:'+new Date().toLocaleTimeString('pl-PL');
 })
@@ -1062,10 +1091,8 @@ static void handleSysInfoPage() {
     server.send_P(200, "text/html", HTML_SYSINFO);
 }
 
-// Handler JSON – dostarcza aktualne dane systemowe
-static void handleSysInfoJson() {
-    if (!requireAuth()) return;
-
+// [NEW] Budowa JSON wydzielona z handlera – mierzona przez bench.cpp
+const char* getSysInfoJSON() {
     // --- Pamięć ---
     uint32_t heapFree  = ESP.getFreeHeap();
     uint32_t heapTotal = ESP.getHeapSize();
@@ -1101,8 +1128,10 @@ static void handleSysInfoJson() {
 
     // --- SD ---
     bool sdOk = (SD.cardType() != CARD_NONE);
-    uint64_t sdTotal = sdOk ? SD.totalBytes() : 0;
-    uint64_t sdFree  = sdOk ? (SD.totalBytes() - SD.usedBytes()) : 0;
+    // [FIX] Z pamięci podręcznej – SD.usedBytes() to przejście całej FAT
+    SdStats sdStats = sd_stats_get();
+    uint64_t sdTotal = sdOk ? sdStats.totalBytes : 0;
+    uint64_t sdFree  = sdOk ? (sdStats.totalBytes - sdStats.usedBytes) : 0;
     const char* sdType;
     switch (sdOk ? SD.cardType() : CARD_NONE) {
         case CARD_MMC:  sdType = "MMC";   break;
@@ -1129,8 +1158,17 @@ static void handleSysInfoJson() {
     String macString = WiFi.macAddress();  // zwraca "XX:XX:XX:XX:XX:XX"
     const char* macStr = macString.c_str();
 
-    // --- Skonstruuj JSON (static bufor – wystarczy ok. 600 B) ---
-    static char json[900];
+    // --- [NEW] Zapisy NVS (write-back cache) ---
+    NvsWriteStats nvsStats = storage_get_nvs_write_stats();
+
+    // --- [NEW] Odświeżanie TFT (bufor ramki) ---
+    FrameStats fbStats = framebuffer_get_stats();
+
+    // --- [NEW] Opóźnienie zbocze drzwi → SSR wyłączone ---
+    DoorStats doorStats = inputs_get_door_stats();
+
+    // --- Skonstruuj JSON (static bufor – wystarczy ok. 1 KB) ---
+    static char json[1280];
     snprintf(json, sizeof(json),
         "{"
         "\"heap_free\":%u,"
@@ -1157,7 +1195,19 @@ static void handleSysInfoJson() {
         "\"fw_author\":\""   FW_AUTHOR   "\","  
         "\"chip_model\":\"%s\","
         "\"mac_addr\":\"%s\","
-        "\"flash_size\":%u"
+        "\"flash_size\":%u,"
+        "\"nvs_req_hour\":%lu,"
+        "\"nvs_commit_hour\":%lu,"
+        "\"nvs_req_total\":%lu,"
+        "\"nvs_commit_total\":%lu,"
+        "\"nvs_pending\":%s,"
+        "\"fb_active\":%s,"
+        "\"fb_frame_us\":%lu,"
+        "\"fb_frame_max_us\":%lu,"
+        "\"fb_spi_bps\":%lu,"
+        "\"door_events\":%lu,"
+        "\"door_latency_us\":%lu,"
+        "\"door_latency_max_us\":%lu"
         "}",
         heapFree, heapTotal, heapMin, psramTotal,
         uptimeSec,
@@ -1168,10 +1218,24 @@ static void handleSysInfoJson() {
         wifiConn  ? "true" : "false",
         wifiSsid.c_str(), wifiIp.c_str(), apIp.c_str(), wifiRssi,
         chipModel.c_str(), macStr,
-        flashSize
+        flashSize,
+        (unsigned long)nvsStats.requestedLastHour, (unsigned long)nvsStats.commitsLastHour,
+        (unsigned long)nvsStats.requestedTotal, (unsigned long)nvsStats.commitsTotal,
+        nvsStats.pendingMask ? "true" : "false",
+        fbStats.active ? "true" : "false",
+        (unsigned long)fbStats.avgFrameUs, (unsigned long)fbStats.maxFrameUs,
+        (unsigned long)fbStats.spiBytesPerSec,
+        (unsigned long)doorStats.openEvents, (unsigned long)doorStats.lastLatencyUs,
+        (unsigned long)doorStats.maxLatencyUs
     );
 
-    server.send(200, "application/json", json);
+    return json;
+}
+
+// Handler JSON – dostarcza aktualne dane systemowe
+static void handleSysInfoJson() {
+    if (!requireAuth()) return;
+    server.send(200, "application/json", getSysInfoJSON());
 }
 
 // =================================================================
@@ -1226,11 +1290,11 @@ static void handleSensorsPage() {
 
 static void handleSdInfo() {
     if (!requireAuth()) return;
-    char json[256];
+    char json[320];
     bool cardOk = (SD.cardType() != CARD_NONE);
     bool isIdle = false;
     if (state_lock()) {
-        isIdle = (g_currentState == ProcessState::IDLE);
+        isIdle = chamber_all_idle();
         state_unlock();
     }
     if (!cardOk) {
@@ -1239,8 +1303,10 @@ static void handleSdInfo() {
             "\"size\":\"-\",\"used\":\"-\",\"free\":\"-\"}",
             isIdle ? "true" : "false");
     } else {
-        uint64_t totalBytes = SD.totalBytes();
-        uint64_t usedBytes  = SD.usedBytes();
+        // [FIX] Z pamięci podręcznej (sd_stats.cpp) zamiast skanu FAT w tasku Web
+        SdStats sdStats = sd_stats_get();
+        uint64_t totalBytes = sdStats.totalBytes;
+        uint64_t usedBytes  = sdStats.usedBytes;
         uint64_t freeBytes  = totalBytes - usedBytes;
         const char* typeStr;
         switch (SD.cardType()) {
@@ -1258,14 +1324,24 @@ static void handleSdInfo() {
                 snprintf(buf, len, "%llu KB", bytes / 1024);
         };
         char sizeStr[16], usedStr[16], freeStr[16];
-        fmtSize(totalBytes, sizeStr, sizeof(sizeStr));
-        fmtSize(usedBytes,  usedStr, sizeof(usedStr));
-        fmtSize(freeBytes,  freeStr, sizeof(freeStr));
+        if (sdStats.valid) {
+            fmtSize(totalBytes, sizeStr, sizeof(sizeStr));
+            fmtSize(usedBytes,  usedStr, sizeof(usedStr));
+            fmtSize(freeBytes,  freeStr, sizeof(freeStr));
+        } else {
+            // Pierwszy skan jeszcze trwa
+            snprintf(sizeStr, sizeof(sizeStr), "...");
+            snprintf(usedStr, sizeof(usedStr), "...");
+            snprintf(freeStr, sizeof(freeStr), "...");
+        }
         snprintf(json, sizeof(json),
             "{\"ok\":true,\"idle\":%s,\"type\":\"%s\","
-            "\"size\":\"%s\",\"used\":\"%s\",\"free\":\"%s\"}",
+            "\"size\":\"%s\",\"used\":\"%s\",\"free\":\"%s\",\"clockKHz\":%lu,"
+            "\"statsAgeSec\":%lu,\"statsEstimated\":%s,\"scanMs\":%lu}",
             isIdle ? "true" : "false",
-            typeStr, sizeStr, usedStr, freeStr);
+            typeStr, sizeStr, usedStr, freeStr, (unsigned long)(sd_clock_hz() / 1000),
+            (unsigned long)sdStats.scanAgeSec, sdStats.estimated ? "true" : "false",
+            (unsigned long)sdStats.scanMs);
     }
     server.send(200, "application/json", json);
 }
@@ -1274,7 +1350,7 @@ static void handleSdFormat() {
     if (!requireAuth()) return;
     bool isIdle = false;
     if (state_lock()) {
-        isIdle = (g_currentState == ProcessState::IDLE);
+        isIdle = chamber_all_idle();
         state_unlock();
     }
     if (!isIdle) {
@@ -1287,7 +1363,16 @@ static void handleSdFormat() {
             "{\"ok\":false,\"message\":\"Brak karty SD!\"}");
         return;
     }
+    // [FIX] Formatowanie = odmontowanie – nikt nie może mieć otwartego pliku
+    bool locked = hal_fs_lock(CFG_SD_LOCK_TIMEOUT_MS);
+    if (!locked || hal_fs_open_count() > 0) {
+        if (locked) hal_fs_unlock();
+        server.send(200, "application/json",
+            "{\"ok\":false,\"message\":\"Karta SD zajęta – spróbuj ponownie.\"}");
+        return;
+    }
     LOG_FMT(LOG_LEVEL_WARN, "SD FORMAT requested via HTTP by authenticated user");
+    sd_stats_invalidate();
     SD.end();
     delay(500);
     esp_err_t ret = ESP_FAIL;
@@ -1299,9 +1384,14 @@ static void handleSdFormat() {
     FRESULT fr = f_mkfs("", &opt, workBuf, sizeof(workBuf));
     if (fr == FR_OK) {
         delay(200);
-        if (SD.begin(PIN_SD_CS)) {
+        bool mounted = SD.begin(PIN_SD_CS);
+        if (mounted) {
             SD.mkdir("/profiles");
             SD.mkdir("/backup");
+        }
+        hal_fs_unlock();
+        if (mounted) {
+            sd_stats_request_scan();
             LOG_FMT(LOG_LEVEL_INFO, "SD format OK, directories recreated");
             server.send(200, "application/json",
                 "{\"ok\":true,\"message\":\"Karta sformatowana! Utworzono /profiles i /backup.\"}");
@@ -1312,6 +1402,8 @@ static void handleSdFormat() {
         }
     } else {
         SD.begin(PIN_SD_CS);
+        hal_fs_unlock();
+        sd_stats_request_scan();
         LOG_FMT(LOG_LEVEL_ERROR, "SD format FAILED, FRESULT=%d", (int)fr);
         server.send(200, "application/json",
             "{\"ok\":false,\"message\":\"Formatowanie nieudane. Sprawdź kartę SD.\"}");
@@ -1352,13 +1444,106 @@ void web_server_init() {
         server.send_P(200, "text/html", HTML_TEMPLATE_MAIN);
     });
     server.on("/status", HTTP_GET, []() {
-        server.send(200, "application/json", getStatusJSON());
+        server.send(200, "application/json", getStatusJSON(requestChamber()));
+    });
+    // [NEW] Skrót wszystkich komór
+    server.on("/api/chambers", HTTP_GET, []() {
+        char json[96 * CFG_CHAMBER_COUNT + 8];
+        int offset = snprintf(json, sizeof(json), "[");
+        state_lock();
+        for (uint8_t i = 0; i < CFG_CHAMBER_COUNT; i++) {
+            const Chamber& c = g_chambers[i];
+            offset += snprintf(json + offset, sizeof(json) - offset,
+                "%s{\"id\":%u,\"state\":%d,\"tChamber\":%.1f,\"tMeat\":%.1f,\"tSet\":%.1f}",
+                i ? "," : "", (unsigned)i, (int)c.currentState,
+                (double)c.tChamber, (double)c.tMeat, (double)c.tSet);
+        }
+        state_unlock();
+        snprintf(json + offset, sizeof(json) - offset, "]");
+        server.send(200, "application/json", json);
     });
     server.on("/api/profiles", HTTP_GET, []() {
         server.send(200, "application/json", storage_list_profiles_json());
     });
+    // [NEW] Lista GitHub pobierana w tle – 202 = jeszcze trwa, klient ponawia
     server.on("/api/github_profiles", HTTP_GET, []() {
-        server.send(200, "application/json", storage_list_github_profiles_json());
+        if (github_list_state() != GithubJobState::BUSY && !server.hasArg("poll")) {
+            github_request_list();
+        }
+        if (github_list_state() == GithubJobState::BUSY) {
+            server.send(202, "application/json", "[]");
+            return;
+        }
+        server.send(200, "application/json", github_list_json());
+    });
+    server.on("/api/github_status", HTTP_GET, []() {
+        server.send(200, "application/json", github_status_json());
+    });
+    // [NEW] Stan telemetrii MQTT i kolejki offline
+    server.on("/api/mqtt", HTTP_GET, []() {
+        server.send(200, "application/json", mqtt_status_json());
+    });
+    // [NEW] Wyuczona tablica nastaw PID komory (?ch=) i jej reset
+    server.on("/api/pid/gains", HTTP_GET, []() {
+        server.send(200, "application/json", gain_table_json(requestChamber()));
+    });
+    server.on("/api/pid/gains/reset", HTTP_POST, []() {
+        if (!requireAuth()) return;
+        gain_sched_reset(requestChamber());
+        server.send(200, "text/plain", "OK");
+    });
+    // [NEW] Postęp / wynik autotune przekaźnikowego komory (?ch=)
+    server.on("/api/autotune", HTTP_GET, []() {
+        server.send(200, "application/json", autotune_status_json(requestChamber()));
+    });
+    // [NEW] Zidentyfikowany model FOPDT komory, feed-forward i korekta Smitha (?ch=)
+    server.on("/api/model", HTTP_GET, []() {
+        server.send(200, "application/json", fopdt_json(requestChamber()));
+    });
+    // [NEW] Okno SSR, zadane wypełnienie i łączny czas ON każdej grzałki
+    server.on("/api/ssr", HTTP_GET, []() {
+        server.send(200, "application/json", ssr_tp_json());
+    });
+    // [NEW] Detektor awarii grzałek komory (?ch=): CUSUM residuum, sprawność kanałów
+    server.on("/api/heaters", HTTP_GET, []() {
+        server.send(200, "application/json", heater_diag_json(requestChamber()));
+    });
+    // [NEW] Ochrona przed przegrzaniem komory (?ch=): trend, mnożnik mocy, zdarzenia
+    server.on("/api/overheat", HTTP_GET, []() {
+        server.send(200, "application/json", overheat_json(requestChamber()));
+    });
+    // [NEW] Praca awaryjna bez czujnika komory (?ch=): estymata, limit mocy, czas
+    server.on("/api/failover", HTTP_GET, []() {
+        server.send(200, "application/json", sensor_failover_json(requestChamber()));
+    });
+    // [NEW] Etapy startu: czas do pętli sterowania i do pełnego startu
+    server.on("/api/boot", HTTP_GET, []() {
+        server.send(200, "application/json", boot_prof_json());
+    });
+    // [NEW] Harmonogram wentylatora komory (?ch=): trend, udział ON, czasy cyklu
+    server.on("/api/fan", HTTP_GET, []() {
+        server.send(200, "application/json", fan_sched_json(requestChamber()));
+    });
+    // [NEW] Energia i koszt wsadu komory (?ch=), per krok i per wyjście
+    server.on("/api/energy", HTTP_GET, []() {
+        server.send(200, "application/json", energy_json(requestChamber()));
+    });
+    // [NEW] Moce grzałek / wentylatora / dymu [W] i taryfa [zł/kWh] – do NVS
+    server.on("/api/energy/config", HTTP_POST, []() {
+        if (!requireAuth()) return;
+        EnergyConfig cfg = energy_get_config();
+        static const char* heaterArgs[3] = {"heater1", "heater2", "heater3"};
+        for (uint8_t i = 0; i < 3; i++) {
+            if (server.hasArg(heaterArgs[i])) cfg.heaterW[i] = server.arg(heaterArgs[i]).toFloat();
+        }
+        if (server.hasArg("fan"))    cfg.fanW   = server.arg("fan").toFloat();
+        if (server.hasArg("smoke"))  cfg.smokeW = server.arg("smoke").toFloat();
+        if (server.hasArg("tariff")) cfg.tariff = server.arg("tariff").toFloat();
+        if (energy_set_config(cfg)) {
+            server.send(200, "text/plain", "OK");
+        } else {
+            server.send(400, "text/plain", "Nieprawidłowe moce lub taryfa.");
+        }
     });
 
     // ----------------------------------------------------------
@@ -1367,6 +1552,11 @@ void web_server_init() {
     server.on("/sd",        HTTP_GET,  handleSdPage);
     server.on("/sd/info",   HTTP_GET,  handleSdInfo);
     server.on("/sd/format", HTTP_POST, handleSdFormat);
+    // [NEW] Zegar SPI karty, przepustowość i percentyle opóźnień (kilka sekund)
+    server.on("/sd/bench",  HTTP_GET,  []() {
+        if (!requireAuth()) return;
+        server.send(200, "application/json", sd_clock_bench_json());
+    });
 
     // ----------------------------------------------------------
     // AUTORYZACJA
@@ -1446,13 +1636,26 @@ void web_server_init() {
             String source      = server.arg("source");
             bool success = false;
             if (source == "sd") {
+                uint8_t ch = requestChamber();
                 String fullPath = "/profiles/" + profileName;
-                storage_save_profile_path_nvs(fullPath.c_str());
-                success = storage_load_profile();
+                storage_save_profile_path_nvs(fullPath.c_str(), ch);
+                success = storage_load_profile(ch);
             } else if (source == "github") {
+                // [FIX] Nazwa trafia do ścieżki cache na SD i do URL
+                if (!github_profile_name_valid(profileName.c_str())) {
+                    server.send(400, "text/plain", "Nieprawidłowa nazwa profilu.");
+                    return;
+                }
+                // [NEW] Pobranie w tasku Github – stan w /api/github_status
+                uint8_t ch = requestChamber();
                 String githubPath = "github:" + profileName;
-                storage_save_profile_path_nvs(githubPath.c_str());
-                success = storage_load_github_profile(profileName.c_str());
+                storage_save_profile_path_nvs(githubPath.c_str(), ch);
+                if (github_request_profile(profileName.c_str(), true, ch)) {
+                    server.send(202, "text/plain", "Pobieranie profilu " + profileName + "...");
+                } else {
+                    server.send(409, "text/plain", "Pobieranie innego profilu w toku.");
+                }
+                return;
             }
             server.send(success ? 200 : 500, "text/plain",
                 success ? "OK, profil " + profileName + " załadowany." : "Błąd ładowania profilu.");
@@ -1463,9 +1666,10 @@ void web_server_init() {
 
     server.on("/auto/next_step", HTTP_GET, []() {
         if (!requireAuth()) return;
+        Chamber& c = chamber_get(requestChamber());
         state_lock();
-        if (g_currentState == ProcessState::RUNNING_AUTO && g_currentStep < g_stepCount) {
-            g_profile[g_currentStep].minTimeMs = 0;
+        if (c.currentState == ProcessState::RUNNING_AUTO && c.currentStep < c.stepCount) {
+            c.profile[c.currentStep].minTimeMs = 0;
         }
         state_unlock();
         server.send(200, "text/plain", "OK");
@@ -1473,11 +1677,12 @@ void web_server_init() {
 
     server.on("/timer/reset", HTTP_GET, []() {
         if (!requireAuth()) return;
+        Chamber& c = chamber_get(requestChamber());
         state_lock();
-        if (g_currentState == ProcessState::RUNNING_MANUAL) {
-            g_processStartTime = millis();
-        } else if (g_currentState == ProcessState::RUNNING_AUTO) {
-            g_stepStartTime = millis();
+        if (c.currentState == ProcessState::RUNNING_MANUAL) {
+            c.processStartTime = millis();
+        } else if (c.currentState == ProcessState::RUNNING_AUTO) {
+            c.stepStartTime = millis();
         }
         state_unlock();
         server.send(200, "text/plain", "Timer zresetowany");
@@ -1485,25 +1690,41 @@ void web_server_init() {
 
     server.on("/mode/manual", HTTP_GET, []() {
         if (!requireAuth()) return;
-        process_start_manual();
+        process_start_manual(requestChamber());
         server.send(200, "text/plain", "OK");
     });
 
     server.on("/auto/start", HTTP_GET, []() {
         if (!requireAuth()) return;
-        if (storage_load_profile()) {
-            process_start_auto();
+        uint8_t ch = requestChamber();
+        if (storage_load_profile(ch)) {
+            process_start_auto(ch);
             server.send(200, "text/plain", "OK");
         } else {
             server.send(500, "text/plain", "Profile error");
         }
     });
 
+    // [NEW] Autotune PID: ?tSet=70&pm=2&rule=tl|zn, przerwanie przez /auto/stop
+    server.on("/autotune/start", HTTP_GET, []() {
+        if (!requireAuth()) return;
+        double tSet = server.hasArg("tSet") ? server.arg("tSet").toFloat() : 70.0;
+        int pm = server.hasArg("pm") ? server.arg("pm").toInt() : 2;
+        AutotuneRule rule = (server.arg("rule") == "zn") ? AutotuneRule::ZIEGLER_NICHOLS
+                                                         : AutotuneRule::TYREUS_LUYBEN;
+        if (autotune_start(requestChamber(), tSet, pm, rule)) {
+            server.send(200, "text/plain", "OK");
+        } else {
+            server.send(409, "text/plain", "Komora zajęta – najpierw zatrzymaj proces.");
+        }
+    });
+
     server.on("/auto/stop", HTTP_GET, []() {
         if (!requireAuth()) return;
-        allOutputsOff();
+        Chamber& c = chamber_get(requestChamber());
+        chamberOutputsOff(c);
         state_lock();
-        g_currentState = ProcessState::IDLE;
+        c.currentState = ProcessState::IDLE;
         state_unlock();
         server.send(200, "text/plain", "OK");
     });
@@ -1529,10 +1750,17 @@ void web_server_init() {
         if (filename.isEmpty()) { server.send(400, "text/plain", "Pusta nazwa pliku."); return; }
         if (!filename.endsWith(".prof")) { filename += ".prof"; }
         String path = "/profiles/" + filename;
+        // [FIX] SD.* poza HAL – blokada karty jak w hal_fs_* (zmiana zegara)
+        if (!hal_fs_lock(CFG_SD_LOCK_TIMEOUT_MS)) { server.send(503, "text/plain", "Karta SD zajęta."); return; }
         File file = SD.open(path, FILE_WRITE);
-        if (!file) { server.send(500, "text/plain", "Nie można otworzyć pliku do zapisu."); return; }
+        if (!file) {
+            hal_fs_unlock();
+            server.send(500, "text/plain", "Nie można otworzyć pliku do zapisu.");
+            return;
+        }
         file.print(data);
         file.close();
+        hal_fs_unlock();
         server.send(200, "text/plain", "Profil '" + filename + "' zapisany!");
     });
 
@@ -1551,7 +1779,8 @@ void web_server_init() {
         if (!requireAuth()) return;
         if (server.hasArg("tSet")) {
             double val = constrain(server.arg("tSet").toFloat(), CFG_T_MIN_SET, CFG_T_MAX_SET);
-            state_lock(); g_tSet = val; state_unlock();
+            Chamber& c = chamber_get(requestChamber());
+            state_lock(); c.tSet = val; state_unlock();
             storage_save_manual_settings_nvs();
         }
         server.send(200, "text/plain", "OK");
@@ -1561,7 +1790,8 @@ void web_server_init() {
         if (!requireAuth()) return;
         if (server.hasArg("val")) {
             int val = constrain(server.arg("val").toInt(), CFG_POWERMODE_MIN, CFG_POWERMODE_MAX);
-            state_lock(); g_powerMode = val; state_unlock();
+            Chamber& c = chamber_get(requestChamber());
+            state_lock(); c.powerMode = val; state_unlock();
             storage_save_manual_settings_nvs();
         }
         server.send(200, "text/plain", "OK");
@@ -1571,7 +1801,8 @@ void web_server_init() {
         if (!requireAuth()) return;
         if (server.hasArg("val")) {
             int val = constrain(server.arg("val").toInt(), CFG_SMOKE_PWM_MIN, CFG_SMOKE_PWM_MAX);
-            state_lock(); g_manualSmokePwm = val; state_unlock();
+            Chamber& c = chamber_get(requestChamber());
+            state_lock(); c.manualSmokePwm = val; state_unlock();
             storage_save_manual_settings_nvs();
         }
         server.send(200, "text/plain", "OK");
@@ -1579,14 +1810,15 @@ void web_server_init() {
 
     server.on("/manual/fan", HTTP_GET, []() {
         if (!requireAuth()) return;
+        Chamber& c = chamber_get(requestChamber());
         if (server.hasArg("mode")) {
-            state_lock(); g_fanMode = constrain(server.arg("mode").toInt(), 0, 2); state_unlock();
+            state_lock(); c.fanMode = constrain(server.arg("mode").toInt(), 0, 2); state_unlock();
         }
         if (server.hasArg("on")) {
-            state_lock(); g_fanOnTime = max(1000UL, (unsigned long)server.arg("on").toInt() * 1000UL); state_unlock();
+            state_lock(); c.fanOnTime = max(1000UL, (unsigned long)server.arg("on").toInt() * 1000UL); state_unlock();
         }
         if (server.hasArg("off")) {
-            state_lock(); g_fanOffTime = max(1000UL, (unsigned long)server.arg("off").toInt() * 1000UL); state_unlock();
+            state_lock(); c.fanOffTime = max(1000UL, (unsigned long)server.arg("off").toInt() * 1000UL); state_unlock();
         }
         storage_save_manual_settings_nvs();
         server.send(200, "text/plain", "OK");
@@ -1635,6 +1867,7 @@ void web_server_init() {
             server.send(200, "text/plain", ok ? "OK" : Update.errorString());
             if (ok) {
                 Serial.println("[OTA] Update OK – restarting in 500ms");
+                storage_flush_nvs();   // [NEW] niezapisane ustawienia z cache NVS
                 delay(500);
                 ESP.restart();
             }
@@ -1,5 +1,10 @@
 // web_server.h
 #pragma once
+#include <cstdint>
 
 void web_server_init();
-void web_server_handle_client();
\ No newline at end of file
+void web_server_handle_client();
+
+// [NEW] Bufory JSON /api/status i /api/sysinfo (statyczne bufory modułu)
+const char* getStatusJSON(uint8_t chamberIdx = 0);
+const char* getSysInfoJSON();
\ No newline at end of file
@@ -0,0 +1,118 @@
+// web_status.cpp - [NEW] JSON statusu komory dla /api/status
+// Wydzielone z web_server.cpp: zależy tylko od stanu komory, storage i energy,
+// więc buduje się też na hoście (CMakeLists.txt) – bench i soak mierzą
+// dokładnie tę funkcję, którą woła handler WWW.
+#include "web_server.h"
+#include "config.h"
+#include "state.h"
+#include "storage.h"
+#include "energy.h"
+
+static const char* getStateString(ProcessState st) {
+    switch (st) {
+        case ProcessState::IDLE:               return "IDLE";
+        case ProcessState::RUNNING_AUTO:       return "AUTO";
+        case ProcessState::RUNNING_MANUAL:     return "MANUAL";
+        case ProcessState::PAUSE_DOOR:         return "PAUZA: DRZWI";
+        case ProcessState::PAUSE_SENSOR:       return "PAUZA: CZUJNIK";
+        case ProcessState::PAUSE_OVERHEAT:     return "PAUZA: PRZEGRZANIE";
+        case ProcessState::PAUSE_HEATER_FAULT: return "AWARIA: GRZALKA";
+        case ProcessState::PAUSE_USER:         return "PAUZA UZYTK.";
+        case ProcessState::ERROR_PROFILE:      return "ERROR_PROFILE";
+        case ProcessState::SOFT_RESUME:        return "Wznawianie...";
+        case ProcessState::AUTOTUNE:           return "AUTOTUNE";
+        default:                               return "UNKNOWN";
+    }
+}
+
+const char* getStatusJSON(uint8_t chamberIdx) {
+    const Chamber& c = chamber_get(chamberIdx);
+    static char jsonBuffer[896];
+    double tc, tm, ts;
+    int pm, fm, sm;
+    ProcessState st;
+    unsigned long elapsedSec = 0;
+    unsigned long stepTotalSec = 0;
+    const char* stepName = "";
+    unsigned long remainingProcessTimeSec = 0;
+    char activeProfile[64] = "Brak";
+    MeatEta eta;
+
+    state_lock();
+    st   = c.currentState;
+    tc   = c.tChamber;
+    tm   = c.tMeat;
+    ts   = c.tSet;
+    pm   = c.powerMode;
+    fm   = c.fanMode;
+    sm   = c.manualSmokePwm;
+    remainingProcessTimeSec = c.processStats.remainingProcessTimeSec;
+    eta = c.eta;
+    strncpy(activeProfile, storage_get_profile_path(chamberIdx), sizeof(activeProfile) - 1);
+    activeProfile[sizeof(activeProfile) - 1] = '\0';
+
+    if (st == ProcessState::RUNNING_MANUAL) {
+        elapsedSec = (millis() - c.processStartTime) / 1000;
+    } else if (st == ProcessState::RUNNING_AUTO) {
+        elapsedSec = (millis() - c.stepStartTime) / 1000;
+        if (c.currentStep < c.stepCount) {
+            stepName     = c.profile[c.currentStep].name;
+            stepTotalSec = c.profile[c.currentStep].minTimeMs / 1000;
+        }
+    }
+    state_unlock();
+    // [NEW] Energia wsadu – liczniki czytane poza blokadą stanu
+    EnergySummary energy = energy_summary(chamberIdx);
+
+    const char* powerModeStr;
+    switch (pm) {
+        case 1: powerModeStr = "1-grzalka";  break;
+        case 2: powerModeStr = "2-grzalki";  break;
+        case 3: powerModeStr = "3-grzalki";  break;
+        default: powerModeStr = "Brak";      break;
+    }
+    const char* fanModeStr;
+    switch (fm) {
+        case 0: fanModeStr = "OFF";         break;
+        case 1: fanModeStr = "ON";          break;
+        case 2: fanModeStr = "Cyklicznie";  break;
+        default: fanModeStr = "Brak";       break;
+    }
+
+    char cleanProfileName[64];
+    strncpy(cleanProfileName, activeProfile, sizeof(cleanProfileName));
+    if (strstr(cleanProfileName, "/profiles/") != NULL) {
+        strcpy(cleanProfileName, strstr(cleanProfileName, "/profiles/") + 10);
+    } else if (strstr(cleanProfileName, "github:") != NULL) {
+        memmove(cleanProfileName, cleanProfileName + 7, strlen(cleanProfileName) - 6);
+    }
+
+    snprintf(jsonBuffer, sizeof(jsonBuffer),
+        "{\"chamber\":%u,\"chambers\":%u,"
+        "\"tChamber\":%.1f,\"tMeat\":%.1f,\"tSet\":%.1f,"
+        "\"powerMode\":%d,\"fanMode\":%d,\"smokePwm\":%d,"
+        "\"mode\":\"%s\",\"state\":%d,"
+        "\"powerModeText\":\"%s\",\"fanModeText\":\"%s\","
+        "\"elapsedTimeSec\":%lu,\"stepName\":\"%s\","
+        "\"stepTotalTimeSec\":%lu,\"activeProfile\":\"%s\","
+        "\"remainingProcessTimeSec\":%lu,"
+        "\"remainingLoSec\":%ld,\"remainingHiSec\":%ld,"
+        "\"meatEtaSec\":%ld,\"meatEtaLoSec\":%ld,\"meatEtaHiSec\":%ld,"
+        "\"meatTauMin\":%.0f,"
+        "\"energyValid\":%s,\"energyActive\":%s,"
+        "\"energyKwh\":%.3f,\"energyCost\":%.2f,\"energyStepKwh\":%.3f}",
+        (unsigned)c.id, (unsigned)CFG_CHAMBER_COUNT,
+        tc, tm, ts, pm, fm, sm,
+        getStateString(st), (int)st,
+        powerModeStr, fanModeStr,
+        elapsedSec, stepName,
+        stepTotalSec, cleanProfileName,
+        remainingProcessTimeSec,
+        eta.processLoSec, eta.processHiSec,
+        eta.stepSec, eta.stepLoSec, eta.stepHiSec,
+        eta.valid ? 1.0 / eta.k / 60.0 : 0.0,
+        energy.valid ? "true" : "false", energy.active ? "true" : "false",
+        energy.batchWh / 1000.0f, energy.cost, energy.stepWh / 1000.0f);
+
+    return jsonBuffer;
+}
@@ -0,0 +1,315 @@
+// github_client_test.cpp - Klient GitHub (github_client.cpp) przeciw serwerowi zastępczemu
+// Wątek z gniazdem na 127.0.0.1 udaje API GitHub i raw.githubusercontent.com
+// (hal_posix_set_http_server przekierowuje wszystkie żądania), karta SD to
+// katalog tymczasowy. Zadania wykonuje github_client_process w wątku testu.
+//   github_client_test list         200: lista z ETagiem, kopia i .etag na SD
+//   github_client_test notmodified  drugie pobranie z If-None-Match -> 304, lista z cache
+//   github_client_test offline      brak WiFi: lista z cache bez żądania; bez cache FAILED
+//   github_client_test profile      200 do cache, 304, offline, 404 bez śladu na SD
+// Kod wyjścia 0 = OK, 1 = niespełniony warunek (opis na stderr).
+#include "config.h"
+#include "github_client.h"
+#include <arpa/inet.h>
+#include <filesystem>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static int failures = 0;
+
+#define EXPECT(cond, ...) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fprintf(stderr, "\n"); \
+        failures++; \
+    } \
+} while (0)
+
+// Odpowiedź API skrócona do pól, które czyta parser; "name" w "_links"
+// (zagnieżdżony obiekt) i pliki bez .prof nie mogą trafić na listę
+static const char* LIST_BODY =
+    "[{\"name\":\"boczek.prof\",\"path\":\"profiles/boczek.prof\",\"size\":512,"
+    "\"_links\":{\"self\":\"https://api.github.com/x\",\"name\":\"zagniezdzony.prof\"}},"
+    "{\"name\":\"README.md\",\"path\":\"profiles/README.md\",\"size\":90},"
+    "{\"name\":\"szynka \\\"wiejska\\\".prof\",\"size\":10},"
+    "{\"name\":\"szynka.prof\",\"path\":\"profiles/szynka.prof\",\"size\":640}]";
+static const char* LIST_JSON = "[\"boczek.prof\",\"szynka.prof\"]";
+static const char* LIST_ETAG = "\"list-v1\"";
+
+static const char* PROFILE_NAME = "boczek.prof";
+static const char* PROFILE_BODY = "Osuszanie;60;0;40;0;50;1;1\nWedzenie;70;0;120;0;60;1;1\n";
+static const char* PROFILE_ETAG = "\"boczek-v1\"";
+
+// ======================================================
+// SERWER ZASTĘPCZY – jedno połączenie naraz, HTTP/1.0
+// ======================================================
+
+struct ServerLog {
+    std::mutex m;
+    int requests = 0;
+    std::string lastPath;
+    std::string lastIfNoneMatch;
+};
+
+static ServerLog serverLog;
+
+static std::string requestHeader(const std::string& req, const char* name) {
+    std::string key = std::string("\r\n") + name + ": ";
+    size_t pos = req.find(key);
+    if (pos == std::string::npos) return "";
+    pos += key.size();
+    return req.substr(pos, req.find("\r\n", pos) - pos);
+}
+
+static std::string response(int code, const char* reason, const char* etag, const char* body) {
+    char head[192];
+    snprintf(head, sizeof(head), "HTTP/1.0 %d %s\r\nETag: %s\r\nContent-Length: %u\r\n\r\n",
+             code, reason, etag, (unsigned)strlen(body));
+    return std::string(head) + body;
+}
+
+static void serveOne(int fd) {
+    std::string req;
+    char buf[512];
+    while (req.find("\r\n\r\n") == std::string::npos) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return;
+        req.append(buf, (size_t)n);
+    }
+    size_t pathStart = req.find(' ') + 1;
+    std::string path = req.substr(pathStart, req.find(' ', pathStart) - pathStart);
+    std::string inm = requestHeader(req, "If-None-Match");
+    {
+        std::lock_guard<std::mutex> lock(serverLog.m);
+        serverLog.requests++;
+        serverLog.lastPath = path;
+        serverLog.lastIfNoneMatch = inm;
+    }
+
+    std::string resp;
+    std::string profilePath = std::string("/") + PROFILE_NAME;
+    if (path.size() > 18 && path.compare(path.size() - 18, 18, "/contents/profiles") == 0) {
+        resp = (inm == LIST_ETAG) ? response(304, "Not Modified", LIST_ETAG, "")
+                                  : response(200, "OK", LIST_ETAG, LIST_BODY);
+    } else if (path.size() > profilePath.size() &&
+               path.compare(path.size() - profilePath.size(), profilePath.size(), profilePath) == 0) {
+        resp = (inm == PROFILE_ETAG) ? response(304, "Not Modified", PROFILE_ETAG, "")
+                                     : response(200, "OK", PROFILE_ETAG, PROFILE_BODY);
+    } else {
+        resp = response(404, "Not Found", "\"none\"", "404: Not Found");
+    }
+    send(fd, resp.data(), resp.size(), MSG_NOSIGNAL);
+}
+
+// Zwraca port serwera (0 = błąd); wątek kończy się z procesem
+static uint16_t startServer() {
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) return 0;
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd, 4) != 0 ||
+        getsockname(listenFd, (sockaddr*)&addr, &len) != 0) {
+        close(listenFd);
+        return 0;
+    }
+    std::thread([listenFd] {
+        for (;;) {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0) continue;
+            serveOne(fd);
+            close(fd);
+        }
+    }).detach();
+    return ntohs(addr.sin_port);
+}
+
+static int serverRequests() {
+    std::lock_guard<std::mutex> lock(serverLog.m);
+    return serverLog.requests;
+}
+
+// ======================================================
+// POMOCNICZE
+// ======================================================
+
+static std::vector<std::string> sdDirs;
+
+// Pusta "karta SD" w katalogu tymczasowym
+static void freshSd() {
+    char dir[] = "/tmp/github_client_test_XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        exit(2);
+    }
+    sdDirs.push_back(dir);
+    hal_posix_set_fs_root(dir);
+}
+
+static std::string readSd(const char* path) {
+    std::string text;
+    hal_file_t f = hal_fs_open(path, HalFileMode::READ);
+    if (f < 0) return "<missing>";
+    char buf[256];
+    int n;
+    while ((n = hal_fs_read(f, buf, sizeof(buf))) > 0) text.append(buf, (size_t)n);
+    hal_fs_close(f);
+    return text;
+}
+
+// Zlecenie jest już w kolejce – worker nie czeka na sygnał
+static GithubJobState runList() {
+    EXPECT(github_request_list(), "list request not queued");
+    github_client_process(0);
+    return github_list_state();
+}
+
+static GithubJobState runProfile(const char* name) {
+    EXPECT(github_request_profile(name, false), "profile request %s not queued", name);
+    github_client_process(0);
+    return github_profile_state();
+}
+
+static void report() {
+    printf("status %s, list %s, requests %d\n", github_status_json().c_str(),
+           github_list_json().c_str(), serverRequests());
+}
+
+static void expectList(bool fromCache) {
+    EXPECT(github_list_json() == LIST_JSON, "list %s, expected %s",
+           github_list_json().c_str(), LIST_JSON);
+    EXPECT(github_last_from_cache() == fromCache, "fromCache %d, expected %d",
+           (int)github_last_from_cache(), (int)fromCache);
+}
+
+// ======================================================
+// SCENARIUSZE
+// ======================================================
+
+static void testList() {
+    GithubJobState st = runList();
+    report();
+    EXPECT(st == GithubJobState::DONE, "list state %d, expected DONE", (int)st);
+    expectList(false);
+    EXPECT(serverRequests() == 1, "%d requests, expected 1", serverRequests());
+    EXPECT(serverLog.lastIfNoneMatch.empty(), "If-None-Match '%s' without a cached ETag",
+           serverLog.lastIfNoneMatch.c_str());
+
+    char listPath[64];
+    snprintf(listPath, sizeof(listPath), "%s/_list.json", CFG_GITHUB_CACHE_DIR);
+    EXPECT(readSd(listPath) == LIST_JSON, "cached list '%s'", readSd(listPath).c_str());
+    strncat(listPath, ".etag", sizeof(listPath) - strlen(listPath) - 1);
+    EXPECT(readSd(listPath) == LIST_ETAG, "cached ETag '%s'", readSd(listPath).c_str());
+}
+
+static void testNotModified() {
+    runList();
+    GithubJobState st = runList();
+    report();
+    EXPECT(st == GithubJobState::DONE, "list state %d, expected DONE", (int)st);
+    EXPECT(serverRequests() == 2, "%d requests, expected 2", serverRequests());
+    EXPECT(serverLog.lastIfNoneMatch == LIST_ETAG, "If-None-Match '%s', expected %s",
+           serverLog.lastIfNoneMatch.c_str(), LIST_ETAG);
+    EXPECT(strstr(github_status_json().c_str(), "\"http\":304"), "no 304 in status");
+    expectList(true);
+}
+
+static void testOffline() {
+    runList();
+    hal_posix_set_net_connected(false);
+    GithubJobState st = runList();
+    report();
+    EXPECT(st == GithubJobState::DONE, "offline list state %d, expected DONE", (int)st);
+    EXPECT(serverRequests() == 1, "%d requests offline, expected 1", serverRequests());
+    expectList(true);
+
+    // Bez kopii na karcie nie ma czego pokazać
+    freshSd();
+    st = runList();
+    report();
+    EXPECT(st == GithubJobState::FAILED, "offline list without cache: state %d, expected FAILED",
+           (int)st);
+    EXPECT(github_list_json() == "[]", "list %s without cache", github_list_json().c_str());
+}
+
+static void testProfile() {
+    char cachePath[96];
+    github_cache_path(PROFILE_NAME, cachePath, sizeof(cachePath));
+    std::string etagPath = std::string(cachePath) + ".etag";
+    std::string tmpPath = std::string(cachePath) + ".tmp";
+
+    GithubJobState st = runProfile(PROFILE_NAME);
+    report();
+    EXPECT(st == GithubJobState::DONE, "profile state %d, expected DONE", (int)st);
+    EXPECT(!github_last_from_cache(), "fresh download reported as cached");
+    EXPECT(readSd(cachePath) == PROFILE_BODY, "cached profile '%s'", readSd(cachePath).c_str());
+    EXPECT(readSd(etagPath.c_str()) == PROFILE_ETAG, "profile ETag '%s'",
+           readSd(etagPath.c_str()).c_str());
+    EXPECT(!hal_fs_exists(tmpPath.c_str()), "temporary file left on SD");
+
+    st = runProfile(PROFILE_NAME);
+    report();
+    EXPECT(st == GithubJobState::DONE, "304 profile state %d, expected DONE", (int)st);
+    EXPECT(serverLog.lastIfNoneMatch == PROFILE_ETAG, "If-None-Match '%s', expected %s",
+           serverLog.lastIfNoneMatch.c_str(), PROFILE_ETAG);
+    EXPECT(github_last_from_cache(), "304 not reported as cached");
+    EXPECT(readSd(cachePath) == PROFILE_BODY, "304 changed the cached profile");
+    EXPECT(!hal_fs_exists(tmpPath.c_str()), "temporary file left after 304");
+
+    hal_posix_set_net_connected(false);
+    int before = serverRequests();
+    st = runProfile(PROFILE_NAME);
+    report();
+    EXPECT(st == GithubJobState::DONE, "offline profile state %d, expected DONE", (int)st);
+    EXPECT(serverRequests() == before, "request sent while offline");
+    EXPECT(github_last_from_cache(), "offline profile not reported as cached");
+
+    // 404 – bez kopii FAILED i bez pliku tymczasowego
+    hal_posix_set_net_connected(true);
+    st = runProfile("brak.prof");
+    report();
+    EXPECT(st == GithubJobState::FAILED, "missing profile state %d, expected FAILED", (int)st);
+    github_cache_path("brak.prof", cachePath, sizeof(cachePath));
+    tmpPath = std::string(cachePath) + ".tmp";
+    EXPECT(!hal_fs_exists(cachePath), "404 body cached");
+    EXPECT(!hal_fs_exists(tmpPath.c_str()), "temporary file left after 404");
+
+    EXPECT(!github_request_profile("../boczek.prof", false), "path traversal accepted");
+}
+
+int main(int argc, char** argv) {
+    const char* mode = argc > 1 ? argv[1] : "list";
+
+    uint16_t port = startServer();
+    if (port == 0) {
+        perror("stand-in server");
+        return 2;
+    }
+    hal_posix_set_http_server("127.0.0.1", port);
+    hal_posix_set_net_connected(true);
+    freshSd();
+    github_client_init();
+
+    if (strcmp(mode, "list") == 0) {
+        testList();
+    } else if (strcmp(mode, "notmodified") == 0) {
+        testNotModified();
+    } else if (strcmp(mode, "offline") == 0) {
+        testOffline();
+    } else if (strcmp(mode, "profile") == 0) {
+        testProfile();
+    } else {
+        fprintf(stderr, "usage: github_client_test [list|notmodified|offline|profile]\n");
+        return 2;
+    }
+
+    for (const std::string& dir : sdDirs) std::filesystem::remove_all(dir);
+    return failures ? 1 : 0;
+}
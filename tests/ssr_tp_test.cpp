@@ -0,0 +1,94 @@
+// ssr_tp_test.cpp - Silnik SSR (ssr_tp.cpp) na stałym wzorcu wypełnień
+// Zegar wirtualny hal_posix odpala takt półokresu; po TEST_RUN_MS
+// sprawdzane są szczyt i średnia liczby grzałek ON oraz limit prądu.
+//   ssr_tp_test stagger    3 x 50%, przeplot – szczyt 2, średnia 1.5
+//   ssr_tp_test nostagger  3 x 50%, wspólny start okna – szczyt 3
+//   ssr_tp_test cap        3 x 50%, limit 1 grzałki – szczyt 1, odcięcia
+// Kod wyjścia 0 = OK, 1 = niespełniony warunek (opis na stderr).
+#include "config.h"
+#include "ssr_tp.h"
+
+static constexpr uint32_t TEST_RUN_MS = 20000;     // 10 okien po 2 s
+static constexpr uint32_t TEST_DUTY = 128;         // 50.2%
+
+static int failures = 0;
+
+#define EXPECT(cond, ...) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fprintf(stderr, "\n"); \
+        failures++; \
+    } \
+} while (0)
+
+static void runPattern() {
+    hal_posix_set_time_ms(0);
+    const ChamberHw& hw = CFG_CHAMBER_HW[0];
+    for (uint8_t i = 0; i < 3; i++) ssr_tp_write(hw.ssrPins[i], TEST_DUTY);
+    EXPECT(ssr_tp_init(), "ssr_tp_init failed");
+    hal_posix_advance_ms(TEST_RUN_MS);
+}
+
+// Wypełnienie każdego pinu z czasu stanu wysokiego = zadane (co do 1%)
+static void expectDuty(double expect) {
+    const ChamberHw& hw = CFG_CHAMBER_HW[0];
+    for (uint8_t i = 0; i < 3; i++) {
+        double duty = hal_posix_gpio_high_us(hw.ssrPins[i]) / (TEST_RUN_MS * 1000.0);
+        EXPECT(fabs(duty - expect) <= 0.01, "heater %u duty %.3f, expected %.3f",
+               (unsigned)i + 1, duty, expect);
+    }
+}
+
+static void report(const SsrLoad& load) {
+    printf("peak %u, avg %.3f, peak switch-on %u, limit %u, denied %llu\n",
+           (unsigned)load.peak, load.average, (unsigned)load.peakSwitchOn,
+           (unsigned)load.limit, (unsigned long long)load.denied);
+}
+
+int main(int argc, char** argv) {
+    const char* mode = argc > 1 ? argv[1] : "stagger";
+    double duty = TEST_DUTY / 255.0;
+    SsrLoad load;
+
+    if (strcmp(mode, "stagger") == 0) {
+        ssr_tp_set_stagger(true);
+        runPattern();
+        ssr_tp_load(load);
+        report(load);
+        // 3 x 50% = 1.5 grzałki średnio; przeplot daje ceil(1.5) naraz
+        EXPECT(load.peak == 2, "peak %u on, expected 2", (unsigned)load.peak);
+        EXPECT(fabs(load.average - 3 * duty) <= 0.02, "average %.3f, expected %.3f",
+               load.average, 3 * duty);
+        EXPECT(load.peakSwitchOn <= 1, "%u heaters switched on in one half-cycle",
+               (unsigned)load.peakSwitchOn);
+        EXPECT(load.denied == 0, "%llu half-cycles denied without a limit",
+               (unsigned long long)load.denied);
+        expectDuty(duty);
+    } else if (strcmp(mode, "nostagger") == 0) {
+        ssr_tp_set_stagger(false);
+        runPattern();
+        ssr_tp_load(load);
+        report(load);
+        EXPECT(load.peak == 3, "peak %u on, expected 3", (unsigned)load.peak);
+        EXPECT(fabs(load.average - 3 * duty) <= 0.02, "average %.3f, expected %.3f",
+               load.average, 3 * duty);
+        expectDuty(duty);
+    } else if (strcmp(mode, "cap") == 0) {
+        // Zasilanie na jedną grzałkę: 1.5 grzałki zapotrzebowania się nie mieści
+        ssr_tp_set_stagger(true);
+        ssr_tp_set_max_on(1);
+        runPattern();
+        ssr_tp_load(load);
+        report(load);
+        EXPECT(load.limit == 1, "limit %u, expected 1", (unsigned)load.limit);
+        EXPECT(load.peak <= 1, "peak %u on over a limit of 1", (unsigned)load.peak);
+        EXPECT(load.average <= 1.0, "average %.3f over a limit of 1", load.average);
+        EXPECT(load.denied > 0, "no half-cycles denied at 150%% demand");
+    } else {
+        fprintf(stderr, "usage: ssr_tp_test [stagger|nostagger|cap]\n");
+        return 2;
+    }
+
+    return failures ? 1 : 0;
+}